@@ -1121,6 +1121,8 @@ void UBodyStateAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
 
 	if (BodyStateSkeleton)
 	{
+		// no-op unless this is a replicated skeleton
+		BodyStateSkeleton->UpdateFromJitterBuffer();
 		BodyStateSkeleton->bTrackingActive = !bFreezeTracking;
 		IsTracking = CalcIsTracking();
 	}
@@ -0,0 +1,482 @@
+/*************************************************************************************************************************************
+ *The MIT License(MIT)
+ *
+ *Copyright(c) 2016 Jan Kaniewski(Getnamo)
+ *Modified work Copyright(C) 2019 - 2021 Ultraleap, Inc.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ *files(the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify,
+ *merge, publish, distribute, sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is
+ *furnished to do so, subject to the following conditions :
+ *
+ *The above copyright notice and this permission notice shall be included in all copies or
+ *substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ *FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *************************************************************************************************************************************/
+
+#include "BodyStateReplicationComponent.h"
+
+#include "BodyStateBPLibrary.h"
+#include "BodyStateReplicationSubsystem.h"
+#include "BodyStateUtility.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+namespace
+{
+// seconds of budget that can be saved up for a burst
+const float MaxBudgetBurst = 0.25f;
+// outside this cone (cos of the half angle) the viewer is treated as not looking at the source
+const float InViewCos = 0.5f;
+const float OutOfViewPriority = 0.25f;
+// seconds for the motion energy of a player whose hands went static to fall by 1/e
+const float MotionEnergyDecayTime = 0.5f;
+// room for a full two hand skeleton, the writer grows past this for bigger skeletons
+const int64 InitialSerializedSkeletonBits = 16 * 1024;
+// largest skeleton that can be sent, an unreliable RPC this size is already split over many packets
+const int64 MaxSerializedSkeletonBits = 64 * 1024 * 8;
+// keyframes kept by the receiver, a delta sent just before a keyframe can arrive after it
+const int32 ReceivedKeyframeHistory = 2;
+
+bool IsFingerBone(const EBodyStateBasicBoneType Bone)
+{
+	return (Bone >= EBodyStateBasicBoneType::BONE_INDEX_0_METACARPAL_L && Bone <= EBodyStateBasicBoneType::BONE_THUMB_2_DISTAL_L) ||
+		   (Bone >= EBodyStateBasicBoneType::BONE_INDEX_0_METACARPAL_R && Bone <= EBodyStateBasicBoneType::BONE_THUMB_2_DISTAL_R);
+}
+
+// Replaces the skeleton with what the receiver decodes from it
+void Quantize(FNamedSkeletonData& Skeleton)
+{
+	FBitWriter Writer(InitialSerializedSkeletonBits, true);
+	bool bSuccess = true;
+	Skeleton.NetSerialize(Writer, nullptr, bSuccess);
+	if (!bSuccess || Writer.IsError())
+	{
+		return;
+	}
+	FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+	FNamedSkeletonData Quantized;
+	Quantized.NetSerialize(Reader, nullptr, bSuccess);
+	if (bSuccess && !Reader.IsError())
+	{
+		Skeleton = MoveTemp(Quantized);
+	}
+}
+}	 // namespace
+
+UBodyStateReplicationComponent::UBodyStateReplicationComponent(const FObjectInitializer& init) : UActorComponent(init)
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	bAutoActivate = true;
+	SetIsReplicatedByDefault(true);
+
+	SkeletonDeviceId = 0;
+	MaxSendRate = 30.f;
+	MinSendRate = 2.f;
+	NearDistance = 300.f;
+	FarDistance = 3000.f;
+	FingerDetailDistance = 1000.f;
+	ActiveHandSpeed = 50.f;
+	StaticThreshold = 0.2f;
+	StaticKeepAliveInterval = 1.f;
+	BandwidthBudget = 8000;
+	KeyframeInterval = 10;
+
+	RemoteSkeleton = nullptr;
+	LastLocalSendTime = 0;
+	LatestSequence = 0;
+	MotionEnergy = 0;
+	LatestReceiveTime = 0;
+	BudgetTokens = 0;
+	SentBytesThisWindow = 0;
+	ReceivedBytesThisWindow = 0;
+	ByteWindowStart = 0;
+}
+
+void UBodyStateReplicationComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	if (UBodyStateReplicationSubsystem* Subsystem = UWorld::GetSubsystem<UBodyStateReplicationSubsystem>(GetWorld()))
+	{
+		Subsystem->Register(this);
+	}
+}
+
+void UBodyStateReplicationComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UBodyStateReplicationSubsystem* Subsystem = UWorld::GetSubsystem<UBodyStateReplicationSubsystem>(GetWorld()))
+	{
+		Subsystem->Unregister(this);
+		for (const TWeakObjectPtr<UBodyStateReplicationComponent>& Other : Subsystem->GetComponents())
+		{
+			if (Other.IsValid())
+			{
+				Other->ForwardStates.Remove(this);
+			}
+		}
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+UBodyStateSkeleton* UBodyStateReplicationComponent::GetRemoteSkeleton()
+{
+	return RemoteSkeleton;
+}
+
+FBodyStateReplicationStats UBodyStateReplicationComponent::GetReplicationStats()
+{
+	return Stats;
+}
+
+void UBodyStateReplicationComponent::TickComponent(
+	float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const double Now = FPlatformTime::Seconds();
+	if (IsLocallyOwned())
+	{
+		SendLocalSkeleton(Now);
+	}
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		// no updates from the owner means its hands are static, let the forwarding rate fall
+		if (LatestSequence > 0 && Now - LatestReceiveTime > 1.0 / FMath::Max(MinSendRate, 0.1f))
+		{
+			MotionEnergy *= FMath::Exp(-DeltaTime / MotionEnergyDecayTime);
+		}
+		ScheduleForwarding(DeltaTime, Now);
+	}
+	UpdateByteRates(Now);
+}
+
+bool UBodyStateReplicationComponent::IsLocallyOwned() const
+{
+	const APawn* Pawn = Cast<APawn>(GetOwner());
+	if (Pawn)
+	{
+		return Pawn->IsLocallyControlled();
+	}
+	return GetOwner() && GetOwner()->HasLocalNetOwner();
+}
+
+bool UBodyStateReplicationComponent::GetViewPoint(FVector& OutLocation, FVector& OutDirection) const
+{
+	const APawn* Pawn = Cast<APawn>(GetOwner());
+	const APlayerController* PlayerController =
+		Pawn ? Cast<APlayerController>(Pawn->GetController()) : Cast<APlayerController>(GetOwner());
+	if (!PlayerController)
+	{
+		return false;
+	}
+	FRotator ViewRotation;
+	PlayerController->GetPlayerViewPoint(OutLocation, ViewRotation);
+	OutDirection = ViewRotation.Vector();
+	return true;
+}
+
+void UBodyStateReplicationComponent::SendLocalSkeleton(const double Now)
+{
+	if (Now - LastLocalSendTime < 1.0 / FMath::Max(MaxSendRate, 1.f))
+	{
+		return;
+	}
+	UBodyStateSkeleton* Skeleton = UBodyStateBPLibrary::SkeletonForDevice(this, SkeletonDeviceId);
+	if (!Skeleton)
+	{
+		return;
+	}
+	FNamedSkeletonData Data = Skeleton->GetMinimalNamedSkeletonData();
+
+	// Hands at rest cost nothing beyond an occasional keep alive
+	const bool bSameBones = Data.TrackedBasicBones.Num() == LastSentSkeleton.TrackedBasicBones.Num() &&
+							Data.TrackedAdvancedBones.Num() == LastSentSkeleton.TrackedAdvancedBones.Num();
+	if (bSameBones && GetMaxBoneDelta(LastSentSkeleton, Data) < StaticThreshold &&
+		(Now - LastLocalSendTime) < StaticKeepAliveInterval)
+	{
+		Stats.SkippedStaticUpdates++;
+		return;
+	}
+
+	// a listen server's own skeleton doesn't cross the network
+	if (GetOwnerRole() != ROLE_Authority)
+	{
+		FNamedSkeletonData Encoded = Data;
+		EncodeForSend(LocalKeyframes, Encoded);
+		ServerReceiveSkeleton(Encoded);
+		CommitSent(LocalKeyframes, Encoded);
+	}
+	else
+	{
+		ServerReceiveSkeleton(Data);
+	}
+	LastSentSkeleton = MoveTemp(Data);
+	LastLocalSendTime = Now;
+}
+
+bool UBodyStateReplicationComponent::ServerReceiveSkeleton_Validate(const FNamedSkeletonData& InSkeleton)
+{
+	return true;
+}
+
+void UBodyStateReplicationComponent::ServerReceiveSkeleton_Implementation(const FNamedSkeletonData& InSkeleton)
+{
+	FNamedSkeletonData Received = InSkeleton;
+	ReceivedBytesThisWindow += FMath::Max(GetSerializedSize(Received), 0);
+	if (!DecodeReceived(Received))
+	{
+		return;
+	}
+
+	const double Interval = Received.TimeStamp - LatestSkeleton.TimeStamp;
+	if (LatestSequence > 0 && Interval > 0)
+	{
+		// Smoothed so a single still frame doesn't drop the rate
+		const float Speed = GetMaxBoneDelta(LatestSkeleton, Received) / Interval;
+		MotionEnergy = FMath::Lerp(MotionEnergy, Speed, 0.3f);
+	}
+	LatestSkeleton = MoveTemp(Received);
+	LatestSequence++;
+	LatestReceiveTime = FPlatformTime::Seconds();
+}
+
+void UBodyStateReplicationComponent::ScheduleForwarding(const float DeltaTime, const double Now)
+{
+	FVector ViewLocation;
+	FVector ViewDirection;
+	if (!GetViewPoint(ViewLocation, ViewDirection))
+	{
+		return;
+	}
+
+	const float MaxBudgetTokens = BandwidthBudget * MaxBudgetBurst;
+	BudgetTokens = FMath::Min(BudgetTokens + BandwidthBudget * DeltaTime, MaxBudgetTokens);
+
+	struct FCandidate
+	{
+		UBodyStateReplicationComponent* Source;
+		float Priority;
+		bool bFingers;
+	};
+	TArray<FCandidate, TInlineAllocator<16>> Candidates;
+
+	UBodyStateReplicationSubsystem* Subsystem = UWorld::GetSubsystem<UBodyStateReplicationSubsystem>(GetWorld());
+	if (!Subsystem)
+	{
+		return;
+	}
+	for (const TWeakObjectPtr<UBodyStateReplicationComponent>& WeakSource : Subsystem->GetComponents())
+	{
+		UBodyStateReplicationComponent* Source = WeakSource.Get();
+		if (!Source || Source == this || Source->LatestSequence == 0 || !Source->GetOwner())
+		{
+			continue;
+		}
+		FForwardState& State = ForwardStates.FindOrAdd(Source);
+		if (State.LastSentSequence == Source->LatestSequence)
+		{
+			continue;
+		}
+
+		const FVector ToSource = Source->GetOwner()->GetActorLocation() - ViewLocation;
+		const float Distance = ToSource.Size();
+		const float DistanceFactor =
+			1.f - FMath::Clamp((Distance - NearDistance) / FMath::Max(FarDistance - NearDistance, 1.f), 0.f, 1.f);
+		const float ViewFactor =
+			(Distance < NearDistance || FVector::DotProduct(ToSource / Distance, ViewDirection) > InViewCos) ? 1.f
+																											 : OutOfViewPriority;
+		const float MotionFactor = FMath::Clamp(Source->MotionEnergy / FMath::Max(ActiveHandSpeed, 1.f), 0.f, 1.f);
+		const float Priority = DistanceFactor * ViewFactor * FMath::Lerp(OutOfViewPriority, 1.f, MotionFactor);
+
+		const float SendRate = FMath::Lerp(MinSendRate, MaxSendRate, Priority);
+		if (Now - State.LastSendTime < 1.0 / FMath::Max(SendRate, 0.1f))
+		{
+			continue;
+		}
+		Candidates.Add({Source, Priority, Distance <= FingerDetailDistance});
+	}
+
+	// Spend the budget on the most important sources first, the rest stay due for the next tick
+	Candidates.Sort([](const FCandidate& A, const FCandidate& B) { return A.Priority > B.Priority; });
+	bool bSentAny = false;
+	for (const FCandidate& Candidate : Candidates)
+	{
+		FNamedSkeletonData Data = Candidate.Source->LatestSkeleton;
+		if (!Candidate.bFingers)
+		{
+			StripFingerBones(Data);
+			Stats.ReducedDetailUpdates++;
+		}
+		// the host's own view is updated in place
+		FForwardState& State = ForwardStates.FindOrAdd(Candidate.Source);
+		const bool bEncode = !IsLocallyOwned();
+		if (bEncode)
+		{
+			EncodeForSend(State.Keyframes, Data);
+		}
+		const int32 Bytes = GetSerializedSize(Data);
+		if (Bytes == INDEX_NONE)
+		{
+			continue;
+		}
+		// A skeleton bigger than the whole burst allowance would never fit, so once the allowance is full the first
+		// due skeleton is sent regardless. The tokens go negative and the debt is paid back before the next send
+		if (Bytes > BudgetTokens && (bSentAny || BudgetTokens < MaxBudgetTokens))
+		{
+			Stats.BudgetDeferredUpdates++;
+			continue;
+		}
+		BudgetTokens -= Bytes;
+		SentBytesThisWindow += Bytes;
+		bSentAny = true;
+
+		ClientReceiveSkeleton(Candidate.Source, Data);
+		if (bEncode)
+		{
+			CommitSent(State.Keyframes, Data);
+		}
+
+		State.LastSendTime = Now;
+		State.LastSentSequence = Candidate.Source->LatestSequence;
+	}
+}
+
+void UBodyStateReplicationComponent::ClientReceiveSkeleton_Implementation(
+	UBodyStateReplicationComponent* Source, const FNamedSkeletonData& InSkeleton)
+{
+	if (!Source)
+	{
+		// source not relevant to this client (yet)
+		return;
+	}
+	FNamedSkeletonData Received = InSkeleton;
+	if (!Source->DecodeReceived(Received))
+	{
+		return;
+	}
+	if (!Source->RemoteSkeleton)
+	{
+		Source->RemoteSkeleton = NewObject<UBodyStateSkeleton>(Source);
+	}
+	Source->RemoteSkeleton->ApplyReceivedBodyState(Received);
+}
+
+void UBodyStateReplicationComponent::EncodeForSend(const FKeyframeState& State, FNamedSkeletonData& Data)
+{
+	if (State.LastKeyframeId != 0 && State.UpdatesSinceKeyframe < KeyframeInterval && Data.MakeDelta(State.Keyframe))
+	{
+		return;
+	}
+	// IDs wrap around skipping 0, which marks data that is not a keyframe
+	Data.KeyframeId = State.LastKeyframeId % 255 + 1;
+	Data.DeltaKeyframeId = 0;
+}
+
+void UBodyStateReplicationComponent::CommitSent(FKeyframeState& State, const FNamedSkeletonData& Data)
+{
+	if (Data.KeyframeId == 0)
+	{
+		State.UpdatesSinceKeyframe++;
+		Stats.DeltaUpdates++;
+		return;
+	}
+	// deltas are made against the keyframe as the receiver decoded it
+	State.Keyframe = Data;
+	Quantize(State.Keyframe);
+	State.LastKeyframeId = Data.KeyframeId;
+	State.UpdatesSinceKeyframe = 0;
+}
+
+bool UBodyStateReplicationComponent::DecodeReceived(FNamedSkeletonData& Data)
+{
+	if (Data.DeltaKeyframeId != 0)
+	{
+		const FNamedSkeletonData* Keyframe = ReceivedKeyframes.FindByPredicate(
+			[&Data](const FNamedSkeletonData& Candidate) { return Candidate.KeyframeId == Data.DeltaKeyframeId; });
+		if (!Keyframe || !Data.ApplyDelta(*Keyframe))
+		{
+			// its keyframe was lost or is yet to arrive, the next keyframe recovers
+			Stats.DroppedDeltaUpdates++;
+			return false;
+		}
+	}
+	else if (Data.KeyframeId != 0)
+	{
+		ReceivedKeyframes.RemoveAll([&Data](const FNamedSkeletonData& Keyframe) { return Keyframe.KeyframeId == Data.KeyframeId; });
+		if (ReceivedKeyframes.Num() >= ReceivedKeyframeHistory)
+		{
+			ReceivedKeyframes.RemoveAt(0);
+		}
+		ReceivedKeyframes.Add(Data);
+	}
+	Data.KeyframeId = 0;
+	return true;
+}
+
+void UBodyStateReplicationComponent::UpdateByteRates(const double Now)
+{
+	const double Elapsed = Now - ByteWindowStart;
+	if (Elapsed < 1.0)
+	{
+		return;
+	}
+	Stats.SentBytesPerSecond = SentBytesThisWindow / Elapsed;
+	Stats.ReceivedBytesPerSecond = ReceivedBytesThisWindow / Elapsed;
+	SentBytesThisWindow = 0;
+	ReceivedBytesThisWindow = 0;
+	ByteWindowStart = Now;
+
+	if (GetOwnerRole() == ROLE_Authority && (Stats.SentBytesPerSecond > 0 || Stats.ReceivedBytesPerSecond > 0))
+	{
+		UE_LOG(BodyStateLog, Verbose, TEXT("%s skeleton replication sent %1.0f B/s received %1.0f B/s"),
+			*GetNameSafe(GetOwner()), Stats.SentBytesPerSecond, Stats.ReceivedBytesPerSecond);
+	}
+}
+
+int32 UBodyStateReplicationComponent::GetSerializedSize(FNamedSkeletonData& Skeleton)
+{
+	// sizes are in bits
+	FBitWriter Writer(InitialSerializedSkeletonBits, true);
+	bool bSuccess = true;
+	Skeleton.NetSerialize(Writer, nullptr, bSuccess);
+	if (!bSuccess || Writer.IsError() || Writer.GetNumBits() > MaxSerializedSkeletonBits)
+	{
+		UE_LOG(BodyStateLog, Warning, TEXT("Skeleton with %d bones is larger than %lld bytes and can't be replicated"),
+			Skeleton.TrackedBasicBones.Num() + Skeleton.TrackedAdvancedBones.Num(), MaxSerializedSkeletonBits / 8);
+		return INDEX_NONE;
+	}
+	return Writer.GetNumBytes();
+}
+
+void UBodyStateReplicationComponent::StripFingerBones(FNamedSkeletonData& Skeleton)
+{
+	Skeleton.TrackedBasicBones.RemoveAll([](const FKeyedTransform& Bone) { return IsFingerBone(Bone.Name); });
+	Skeleton.TrackedAdvancedBones.RemoveAll([](const FNamedBoneData& Bone) { return IsFingerBone(Bone.Name); });
+	Skeleton.UniqueMetas.RemoveAll([](const FNamedBoneMeta& Meta) { return IsFingerBone(Meta.Name); });
+}
+
+float UBodyStateReplicationComponent::GetMaxBoneDelta(const FNamedSkeletonData& A, const FNamedSkeletonData& B)
+{
+	// Tracked bones are gathered in enum order, so matching indices are the same bone while the tracked set is unchanged
+	float MaxDeltaSquared = 0;
+	const int32 NumBasic = FMath::Min(A.TrackedBasicBones.Num(), B.TrackedBasicBones.Num());
+	for (int32 i = 0; i < NumBasic; i++)
+	{
+		MaxDeltaSquared = FMath::Max(MaxDeltaSquared,
+			FVector::DistSquared(A.TrackedBasicBones[i].Transform.GetTranslation(), B.TrackedBasicBones[i].Transform.GetTranslation()));
+	}
+	const int32 NumAdvanced = FMath::Min(A.TrackedAdvancedBones.Num(), B.TrackedAdvancedBones.Num());
+	for (int32 i = 0; i < NumAdvanced; i++)
+	{
+		MaxDeltaSquared = FMath::Max(MaxDeltaSquared, FVector::DistSquared(A.TrackedAdvancedBones[i].Data.Transform.GetTranslation(),
+														  B.TrackedAdvancedBones[i].Data.Transform.GetTranslation()));
+	}
+	return FMath::Sqrt(MaxDeltaSquared);
+}
@@ -0,0 +1,196 @@
+/*************************************************************************************************************************************
+ *The MIT License(MIT)
+ *
+ *Copyright(c) 2016 Jan Kaniewski(Getnamo)
+ *Modified work Copyright(C) 2019 - 2021 Ultraleap, Inc.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ *files(the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify,
+ *merge, publish, distribute, sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is
+ *furnished to do so, subject to the following conditions :
+ *
+ *The above copyright notice and this permission notice shall be included in all copies or
+ *substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ *FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *************************************************************************************************************************************/
+
+#include "BodyStateSkeletonJitterBuffer.h"
+
+#include "BodyStateUtility.h"
+
+namespace
+{
+// smoothing for upward clock offset corrections, downward corrections (a faster packet) are taken immediately
+const double ClockOffsetSmoothing = 0.01;
+// a jump this large means the sender restarted or its clock changed, start again
+const double ClockResetThreshold = 1.0;
+
+FTransform LerpTransform(const FTransform& A, const FTransform& B, float Alpha)
+{
+	return FTransform(FQuat::Slerp(A.GetRotation(), B.GetRotation(), Alpha),
+		FMath::Lerp(A.GetTranslation(), B.GetTranslation(), Alpha), FMath::Lerp(A.GetScale3D(), B.GetScale3D(), Alpha));
+}
+}	 // namespace
+
+void FBodyStateSkeletonJitterBuffer::AddSnapshot(const FNamedSkeletonData& Snapshot, double ArrivalTime)
+{
+	// Data without a sender time (e.g. set from blueprint) is treated as sent on arrival
+	const double SenderTime = Snapshot.TimeStamp > 0 ? Snapshot.TimeStamp : ArrivalTime;
+	const double OffsetSample = ArrivalTime - SenderTime;
+
+	if (bHasClockOffset && FMath::Abs(OffsetSample - ClockOffset) > ClockResetThreshold)
+	{
+		UE_LOG(BodyStateLog, Log, TEXT("Skeleton jitter buffer clock jump of %1.3fs, resetting"), OffsetSample - ClockOffset);
+		Reset();
+	}
+
+	// Track the least delayed packets, so jitter only ever adds to the delay
+	if (!bHasClockOffset || OffsetSample < ClockOffset)
+	{
+		ClockOffset = OffsetSample;
+		bHasClockOffset = true;
+	}
+	else
+	{
+		ClockOffset += (OffsetSample - ClockOffset) * ClockOffsetSmoothing;
+	}
+
+	// Already rendered past this point
+	if (SenderTime <= LastRenderTime)
+	{
+		Stats.LateSnapshots++;
+		return;
+	}
+
+	// Unreliable RPCs can arrive out of order
+	int32 InsertIndex = Snapshots.Num();
+	while (InsertIndex > 0 && Snapshots[InsertIndex - 1].SenderTime >= SenderTime)
+	{
+		InsertIndex--;
+	}
+	if (InsertIndex < Snapshots.Num() && Snapshots[InsertIndex].SenderTime == SenderTime)
+	{
+		// duplicate
+		return;
+	}
+	Snapshots.Insert(FSnapshot{SenderTime, Snapshot}, InsertIndex);
+
+	if (Snapshots.Num() > MaxSnapshots)
+	{
+		Snapshots.RemoveAt(0);
+		Stats.DroppedSnapshots++;
+	}
+	Stats.BufferDepth = Snapshots.Num();
+}
+
+bool FBodyStateSkeletonJitterBuffer::Sample(double Now, FNamedSkeletonData& OutSkeleton)
+{
+	if (Snapshots.Num() == 0)
+	{
+		return false;
+	}
+
+	// Clock offset corrections can pull the render time back, hold rather than rewind
+	const double RenderTime = FMath::Max(Now - ClockOffset - Delay, LastRenderTime);
+	LastRenderTime = RenderTime;
+
+	// Drop everything older than the snapshot just before the render time
+	while (Snapshots.Num() > 2 && Snapshots[1].SenderTime <= RenderTime)
+	{
+		Snapshots.RemoveAt(0);
+	}
+	Stats.BufferDepth = Snapshots.Num();
+	Stats.BufferedTime = (Snapshots.Last().SenderTime - RenderTime) * 1000.f;
+
+	const FSnapshot& First = Snapshots[0];
+	if (Snapshots.Num() == 1 || RenderTime <= First.SenderTime)
+	{
+		OutSkeleton = First.Data;
+		return true;
+	}
+
+	const FSnapshot& Second = Snapshots[1];
+	const double Interval = Second.SenderTime - First.SenderTime;
+	if (RenderTime <= Second.SenderTime)
+	{
+		InterpolateSkeleton(First.Data, Second.Data, (RenderTime - First.SenderTime) / Interval, OutSkeleton);
+		return true;
+	}
+
+	// Buffer has run dry, continue the last motion for a short while, then ease back over the same time
+	// and hold the last received pose so a stopped sender doesn't leave the skeleton overshooting
+	const double Overrun = RenderTime - Second.SenderTime;
+	if (Overrun >= 2.0 * MaxExtrapolation)
+	{
+		Stats.HeldFrames++;
+		OutSkeleton = Second.Data;
+		return true;
+	}
+	Stats.ExtrapolatedFrames++;
+	const double Extrapolation = Overrun <= MaxExtrapolation ? Overrun : 2.0 * MaxExtrapolation - Overrun;
+	InterpolateSkeleton(First.Data, Second.Data, 1.f + Extrapolation / Interval, OutSkeleton);
+	return true;
+}
+
+void FBodyStateSkeletonJitterBuffer::Reset()
+{
+	Snapshots.Empty();
+	bHasClockOffset = false;
+	LastRenderTime = -1;
+	Stats.BufferDepth = 0;
+	Stats.BufferedTime = 0;
+}
+
+void FBodyStateSkeletonJitterBuffer::InterpolateSkeleton(
+	const FNamedSkeletonData& A, const FNamedSkeletonData& B, float Alpha, FNamedSkeletonData& OutSkeleton)
+{
+	// B decides which bones and metas are present
+	OutSkeleton = B;
+	OutSkeleton.TimeStamp = FMath::Lerp(A.TimeStamp, B.TimeStamp, (double) Alpha);
+
+	int32 BasicIndexInA[(int32) EBodyStateBasicBoneType::BONES_COUNT];
+	int32 AdvancedIndexInA[(int32) EBodyStateBasicBoneType::BONES_COUNT];
+	for (int32 i = 0; i < (int32) EBodyStateBasicBoneType::BONES_COUNT; i++)
+	{
+		BasicIndexInA[i] = INDEX_NONE;
+		AdvancedIndexInA[i] = INDEX_NONE;
+	}
+	for (int32 i = 0; i < A.TrackedBasicBones.Num(); i++)
+	{
+		if (A.TrackedBasicBones[i].Name < EBodyStateBasicBoneType::BONES_COUNT)
+		{
+			BasicIndexInA[(int32) A.TrackedBasicBones[i].Name] = i;
+		}
+	}
+	for (int32 i = 0; i < A.TrackedAdvancedBones.Num(); i++)
+	{
+		if (A.TrackedAdvancedBones[i].Name < EBodyStateBasicBoneType::BONES_COUNT)
+		{
+			AdvancedIndexInA[(int32) A.TrackedAdvancedBones[i].Name] = i;
+		}
+	}
+
+	for (FKeyedTransform& Bone : OutSkeleton.TrackedBasicBones)
+	{
+		const int32 Index = Bone.Name < EBodyStateBasicBoneType::BONES_COUNT ? BasicIndexInA[(int32) Bone.Name] : INDEX_NONE;
+		if (Index != INDEX_NONE)
+		{
+			Bone.Transform = LerpTransform(A.TrackedBasicBones[Index].Transform, Bone.Transform, Alpha);
+		}
+	}
+	for (FNamedBoneData& Bone : OutSkeleton.TrackedAdvancedBones)
+	{
+		const int32 Index = Bone.Name < EBodyStateBasicBoneType::BONES_COUNT ? AdvancedIndexInA[(int32) Bone.Name] : INDEX_NONE;
+		if (Index != INDEX_NONE)
+		{
+			const FBodyStateBoneData& DataA = A.TrackedAdvancedBones[Index].Data;
+			Bone.Data.Transform = LerpTransform(DataA.Transform, Bone.Data.Transform, Alpha);
+			Bone.Data.Alpha = FMath::Clamp(FMath::Lerp(DataA.Alpha, Bone.Data.Alpha, Alpha), 0.f, 1.f);
+			Bone.Data.Length = FMath::Lerp(DataA.Length, Bone.Data.Length, Alpha);
+		}
+	}
+}
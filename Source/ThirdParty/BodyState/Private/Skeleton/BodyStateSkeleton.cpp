@@ -20,11 +20,18 @@
 
 #include "Skeleton/BodyStateSkeleton.h"
 
+#include "BodyStateSkeletonJitterBuffer.h"
 #include "BodyStateUtility.h"
+#include "Engine/NetSerialization.h"
+#include "Math/Float16.h"
 
 UBodyStateSkeleton::UBodyStateSkeleton(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
 	// Todo: build
+	bUseJitterBuffer = true;
+	JitterBufferDelay = 0.1f;
+	MaxExtrapolationTime = 0.1f;
+	LastJitterBufferSampleTime = 0;
 
 	// add a bone for each possible bone in the skeleton
 	for (int i = 0; i < (int32) EBodyStateBasicBoneType::BONES_COUNT; i++)
@@ -407,6 +414,7 @@ FNamedSkeletonData UBodyStateSkeleton::GetMinimalNamedSkeletonData()
 	NamedSkeleton.TrackedBasicBones = TrackedBasicBones();
 	NamedSkeleton.TrackedAdvancedBones = TrackedAdvancedBones();
 	NamedSkeleton.UniqueMetas = UniqueBoneMetas();
+	NamedSkeleton.TimeStamp = FPlatformTime::Seconds();
 
 	return NamedSkeleton;
 }
@@ -580,9 +588,60 @@ void UBodyStateSkeleton::ServerUpdateBodyState_Implementation(const FNamedSkelet
 
 void UBodyStateSkeleton::Multi_UpdateBodyState_Implementation(const FNamedSkeletonData InBodyStateSkeleton)
 {
-	SetFromNamedSkeletonData(InBodyStateSkeleton);
+	ApplyReceivedBodyState(InBodyStateSkeleton);
+}
+
+void UBodyStateSkeleton::ApplyReceivedBodyState(const FNamedSkeletonData& InBodyStateSkeleton)
+{
+	// seconds without UpdateFromJitterBuffer() before falling back to applying updates on arrival
+	static const double JitterBufferIdleTimeout = 1.0;
+
+	const double Now = FPlatformTime::Seconds();
+	if (!bUseJitterBuffer || (Now - LastJitterBufferSampleTime) > JitterBufferIdleTimeout)
+	{
+		SetFromNamedSkeletonData(InBodyStateSkeleton);
+	}
+	if (bUseJitterBuffer)
+	{
+		if (!JitterBuffer.IsValid())
+		{
+			JitterBuffer = MakeShared<FBodyStateSkeletonJitterBuffer>();
+		}
+		JitterBuffer->AddSnapshot(InBodyStateSkeleton, Now);
+	}
 	Name = TEXT("Network");
 }
+
+bool UBodyStateSkeleton::UpdateFromJitterBuffer()
+{
+	if (!bUseJitterBuffer || !JitterBuffer.IsValid())
+	{
+		return false;
+	}
+	const double Now = FPlatformTime::Seconds();
+	LastJitterBufferSampleTime = Now;
+
+	JitterBuffer->Delay = JitterBufferDelay;
+	JitterBuffer->MaxExtrapolation = MaxExtrapolationTime;
+
+	FNamedSkeletonData Sampled;
+	if (!JitterBuffer->Sample(Now, Sampled))
+	{
+		return false;
+	}
+	SetFromNamedSkeletonData(Sampled);
+	return true;
+}
+
+FBodyStateJitterBufferStats UBodyStateSkeleton::GetJitterBufferStats()
+{
+	if (!JitterBuffer.IsValid())
+	{
+		return FBodyStateJitterBufferStats();
+	}
+	return JitterBuffer->GetStats();
+}
+
 void UBodyStateSkeleton::ReleaseRefs()
 {
 	if (PrivateLeftArm && PrivateLeftArm->IsValidLowLevel())
@@ -595,4 +654,563 @@ void UBodyStateSkeleton::ReleaseRefs()
 		PrivateRightArm->RemoveFromRoot();
 		PrivateRightArm = nullptr;
 	}
-}
\ No newline at end of file
+}
+// Quantized replication of FNamedSkeletonData
+//
+// Rotations use smallest three encoding, 2 bits for the dropped component and 11 bits for each remaining one,
+// max error per component is 0.00035, under 0.13 degrees of rotation once the dropped component is rebuilt.
+// Hand bones are sent relative to the wrist of the same hand as 16 bit fixed point in 0.01cm steps (+-327cm),
+// everything else uses the engine's packed vector quantization at 0.01cm, so max position error is 0.005cm per axis.
+// Non unit scales are sent as full floats. Bone alpha and confidence are 8 bit (max error 0.002),
+// length and accuracy are half floats.
+// Metas only differ by confidence/accuracy/time in practice, so their strings are sent once per packet in a
+// table and each meta refers to its table entry by handle.
+//
+// Deltas (DeltaKeyframeId set) skip bone names and send each transform relative to the keyframe: rotations within
+// 14 degrees of it as the 3 vector components of the delta quaternion in 10 bits each (max error 0.00012 per component),
+// positions within 20cm of it as 12 bit signed 0.01cm steps. Anything further from the keyframe costs one bit more than
+// the absolute encoding, so the error bounds above hold for deltas too. The skeleton RPCs are unreliable, so deltas
+// are made against a keyframe rather than the last update and a receiver that lost the keyframe waits for the next one.
+
+static const int32 QuatComponentBits = 11;
+static const float QuatComponentRange = 0.70710678f;	// 1/sqrt(2), the largest value a non largest component can have
+static const float RelativePositionScale = 100.0f;		// 0.01cm per step
+static const int32 DeltaQuatComponentBits = 10;
+static const float DeltaQuatComponentRange = 0.125f;	// sin of half the largest rotation from the keyframe
+static const int32 DeltaPositionBits = 12;
+
+static uint64 QuantizeUnitFloat(const float Value, const float Range, const int32 NumBits)
+{
+	const uint32 MaxValue = (1u << NumBits) - 1;
+	const float Normalized = FMath::Clamp((Value + Range) / (2.0f * Range), 0.0f, 1.0f);
+	return (uint64) FMath::RoundToInt(Normalized * MaxValue);
+}
+static float DequantizeUnitFloat(const uint64 Value, const float Range, const int32 NumBits)
+{
+	const uint32 MaxValue = (1u << NumBits) - 1;
+	return ((float) Value / MaxValue) * 2.0f * Range - Range;
+}
+
+static void SerializeQuatSmallestThree(FArchive& Ar, FQuat& Quat)
+{
+	// 35 bits, serialized from the low bytes
+	uint64 Packed = 0;
+	if (Ar.IsSaving())
+	{
+		FQuat Normalized = Quat.GetNormalized();
+		float Components[4] = {(float) Normalized.X, (float) Normalized.Y, (float) Normalized.Z, (float) Normalized.W};
+
+		uint32 LargestIndex = 0;
+		for (uint32 i = 1; i < 4; i++)
+		{
+			if (FMath::Abs(Components[i]) > FMath::Abs(Components[LargestIndex]))
+			{
+				LargestIndex = i;
+			}
+		}
+		// q and -q are the same rotation, make the dropped component positive so it can be rebuilt from the others
+		const float Sign = Components[LargestIndex] < 0 ? -1.0f : 1.0f;
+
+		Packed = LargestIndex;
+		int32 Shift = 2;
+		for (uint32 i = 0; i < 4; i++)
+		{
+			if (i != LargestIndex)
+			{
+				Packed |= QuantizeUnitFloat(Components[i] * Sign, QuatComponentRange, QuatComponentBits) << Shift;
+				Shift += QuatComponentBits;
+			}
+		}
+	}
+
+	Ar.SerializeBits(&Packed, 2 + 3 * QuatComponentBits);
+
+	if (Ar.IsLoading())
+	{
+		const uint32 LargestIndex = (uint32)(Packed & 3);
+		const uint64 Mask = (1ull << QuatComponentBits) - 1;
+
+		float Components[4];
+		float SumSquares = 0;
+		int32 Shift = 2;
+		for (uint32 i = 0; i < 4; i++)
+		{
+			if (i != LargestIndex)
+			{
+				Components[i] = DequantizeUnitFloat((Packed >> Shift) & Mask, QuatComponentRange, QuatComponentBits);
+				SumSquares += Components[i] * Components[i];
+				Shift += QuatComponentBits;
+			}
+		}
+		Components[LargestIndex] = FMath::Sqrt(FMath::Max(0.0f, 1.0f - SumSquares));
+
+		Quat = FQuat(Components[0], Components[1], Components[2], Components[3]);
+		Quat.Normalize();
+	}
+}
+
+// rotations close to the keyframe only, with the fallback flag the caller has written
+static void SerializeQuatDelta(FArchive& Ar, FQuat& Quat)
+{
+	uint8 bSmall = 0;
+	FQuat Normalized = Quat.GetNormalized();
+	if (Ar.IsSaving())
+	{
+		// q and -q are the same rotation, W is rebuilt as the positive one
+		if (Normalized.W < 0)
+		{
+			Normalized = FQuat(-Normalized.X, -Normalized.Y, -Normalized.Z, -Normalized.W);
+		}
+		bSmall = FMath::Abs(Normalized.X) <= DeltaQuatComponentRange && FMath::Abs(Normalized.Y) <= DeltaQuatComponentRange &&
+				 FMath::Abs(Normalized.Z) <= DeltaQuatComponentRange;
+	}
+	Ar.SerializeBits(&bSmall, 1);
+	if (!bSmall)
+	{
+		SerializeQuatSmallestThree(Ar, Quat);
+		return;
+	}
+
+	// 30 bits, serialized from the low bytes
+	uint64 Packed = 0;
+	if (Ar.IsSaving())
+	{
+		Packed = QuantizeUnitFloat(Normalized.X, DeltaQuatComponentRange, DeltaQuatComponentBits) |
+				 QuantizeUnitFloat(Normalized.Y, DeltaQuatComponentRange, DeltaQuatComponentBits) << DeltaQuatComponentBits |
+				 QuantizeUnitFloat(Normalized.Z, DeltaQuatComponentRange, DeltaQuatComponentBits) << (2 * DeltaQuatComponentBits);
+	}
+	Ar.SerializeBits(&Packed, 3 * DeltaQuatComponentBits);
+	if (Ar.IsLoading())
+	{
+		const uint64 Mask = (1ull << DeltaQuatComponentBits) - 1;
+		const float X = DequantizeUnitFloat(Packed & Mask, DeltaQuatComponentRange, DeltaQuatComponentBits);
+		const float Y = DequantizeUnitFloat((Packed >> DeltaQuatComponentBits) & Mask, DeltaQuatComponentRange, DeltaQuatComponentBits);
+		const float Z =
+			DequantizeUnitFloat((Packed >> (2 * DeltaQuatComponentBits)) & Mask, DeltaQuatComponentRange, DeltaQuatComponentBits);
+		Quat = FQuat(X, Y, Z, FMath::Sqrt(FMath::Max(0.0f, 1.0f - X * X - Y * Y - Z * Z)));
+		Quat.Normalize();
+	}
+}
+
+static void SerializePositionDelta(FArchive& Ar, FVector& Offset)
+{
+	static const int32 MaxSteps = (1 << (DeltaPositionBits - 1)) - 1;
+
+	int32 Steps[3] = {0, 0, 0};
+	uint8 bSmall = 0;
+	if (Ar.IsSaving())
+	{
+		bSmall = 1;
+		for (int32 Axis = 0; Axis < 3; Axis++)
+		{
+			const double Scaled = Offset[Axis] * RelativePositionScale;
+			bSmall &= FMath::Abs(Scaled) < MaxSteps ? 1 : 0;
+			Steps[Axis] = bSmall ? FMath::RoundToInt(Scaled) : 0;
+		}
+	}
+	Ar.SerializeBits(&bSmall, 1);
+	if (!bSmall)
+	{
+		SerializePackedVector<100, 30>(Offset, Ar);
+		return;
+	}
+
+	// 36 bits, each axis offset to be positive, serialized from the low bytes
+	uint64 Packed = 0;
+	if (Ar.IsSaving())
+	{
+		for (int32 Axis = 0; Axis < 3; Axis++)
+		{
+			Packed |= (uint64)(Steps[Axis] + MaxSteps) << (Axis * DeltaPositionBits);
+		}
+	}
+	Ar.SerializeBits(&Packed, 3 * DeltaPositionBits);
+	if (Ar.IsLoading())
+	{
+		const uint64 Mask = (1ull << DeltaPositionBits) - 1;
+		for (int32 Axis = 0; Axis < 3; Axis++)
+		{
+			Steps[Axis] = (int32)((Packed >> (Axis * DeltaPositionBits)) & Mask) - MaxSteps;
+		}
+		Offset = FVector(Steps[0], Steps[1], Steps[2]) / RelativePositionScale;
+	}
+}
+
+static void SerializeHalf(FArchive& Ar, float& Value)
+{
+	FFloat16 Half(Value);
+	Ar << Half.Encoded;
+	if (Ar.IsLoading())
+	{
+		Value = Half;
+	}
+}
+
+static void SerializeByteFloat(FArchive& Ar, float& Value)
+{
+	uint8 Quantized = (uint8) FMath::RoundToInt(FMath::Clamp(Value, 0.0f, 1.0f) * 255.0f);
+	Ar << Quantized;
+	if (Ar.IsLoading())
+	{
+		Value = Quantized / 255.0f;
+	}
+}
+
+// fingers relative to the wrist of the same hand
+static EBodyStateBasicBoneType GetWristForBone(const EBodyStateBasicBoneType Bone)
+{
+	if (Bone >= EBodyStateBasicBoneType::BONE_INDEX_0_METACARPAL_L && Bone <= EBodyStateBasicBoneType::BONE_THUMB_2_DISTAL_L)
+	{
+		return EBodyStateBasicBoneType::BONE_HAND_WRIST_L;
+	}
+	if (Bone >= EBodyStateBasicBoneType::BONE_INDEX_0_METACARPAL_R && Bone <= EBodyStateBasicBoneType::BONE_THUMB_2_DISTAL_R)
+	{
+		return EBodyStateBasicBoneType::BONE_HAND_WRIST_R;
+	}
+	return EBodyStateBasicBoneType::BONES_COUNT;
+}
+
+// shared between the basic and advanced bone lists so either can supply the wrist
+struct FSkeletonSerializeContext
+{
+	bool HasWrist[2] = {false, false};
+	FVector Wrist[2];
+
+	int32 WristSlot(const EBodyStateBasicBoneType Wrist) const
+	{
+		return Wrist == EBodyStateBasicBoneType::BONE_HAND_WRIST_L ? 0 : 1;
+	}
+};
+
+static void SerializeBoneName(FArchive& Ar, EBodyStateBasicBoneType& Name)
+{
+	uint8 Value = (uint8) Name;
+	Ar << Value;
+	if (Ar.IsLoading())
+	{
+		if (Value >= (uint8) EBodyStateBasicBoneType::BONES_COUNT)
+		{
+			Ar.SetError();
+			Value = 0;
+		}
+		Name = (EBodyStateBasicBoneType) Value;
+	}
+}
+
+static void SerializeBoneScale(FArchive& Ar, FVector& Scale)
+{
+	uint8 bUnitScale = Scale.Equals(FVector::OneVector, 1e-3f) ? 1 : 0;
+	Ar.SerializeBits(&bUnitScale, 1);
+	if (!bUnitScale)
+	{
+		Ar << Scale;
+	}
+	else
+	{
+		Scale = FVector::OneVector;
+	}
+}
+
+static void SerializeBoneTransform(FArchive& Ar, FTransform& Transform, const EBodyStateBasicBoneType Name, FSkeletonSerializeContext& Context)
+{
+	FQuat Rotation = Transform.GetRotation();
+	SerializeQuatSmallestThree(Ar, Rotation);
+
+	FVector Position = Transform.GetLocation();
+	const EBodyStateBasicBoneType Wrist = GetWristForBone(Name);
+	const int32 WristSlot = Context.WristSlot(Wrist);
+
+	uint8 bRelative = 0;
+	int16 Relative[3] = {0, 0, 0};
+	if (Ar.IsSaving() && Wrist != EBodyStateBasicBoneType::BONES_COUNT && Context.HasWrist[WristSlot])
+	{
+		const FVector Offset = (Position - Context.Wrist[WristSlot]) * RelativePositionScale;
+		if (FMath::Abs(Offset.X) < MAX_int16 && FMath::Abs(Offset.Y) < MAX_int16 && FMath::Abs(Offset.Z) < MAX_int16)
+		{
+			bRelative = 1;
+			Relative[0] = (int16) FMath::RoundToInt(Offset.X);
+			Relative[1] = (int16) FMath::RoundToInt(Offset.Y);
+			Relative[2] = (int16) FMath::RoundToInt(Offset.Z);
+		}
+	}
+	Ar.SerializeBits(&bRelative, 1);
+
+	if (bRelative)
+	{
+		Ar << Relative[0] << Relative[1] << Relative[2];
+		if (Ar.IsLoading())
+		{
+			if (Wrist == EBodyStateBasicBoneType::BONES_COUNT || !Context.HasWrist[WristSlot])
+			{
+				Ar.SetError();
+				return;
+			}
+			Position = Context.Wrist[WristSlot] + FVector(Relative[0], Relative[1], Relative[2]) / RelativePositionScale;
+		}
+	}
+	else
+	{
+		SerializePackedVector<100, 30>(Position, Ar);
+		if (Ar.IsSaving())
+		{
+			// match the receiver's quantization so a wrist gives both sides the same reference
+			Position = FVector(FMath::RoundToInt(Position.X * 100), FMath::RoundToInt(Position.Y * 100),
+						   FMath::RoundToInt(Position.Z * 100)) / 100.0f;
+		}
+	}
+
+	if (Name == EBodyStateBasicBoneType::BONE_HAND_WRIST_L || Name == EBodyStateBasicBoneType::BONE_HAND_WRIST_R)
+	{
+		const int32 Slot = Context.WristSlot(Name);
+		Context.HasWrist[Slot] = true;
+		Context.Wrist[Slot] = Position;
+	}
+
+	FVector Scale = Transform.GetScale3D();
+	SerializeBoneScale(Ar, Scale);
+
+	if (Ar.IsLoading())
+	{
+		Transform = FTransform(Rotation, Position, Scale);
+	}
+}
+
+// Delta is the transform relative to the keyframe's, as made by FNamedSkeletonData::MakeDelta
+static void SerializeBoneDelta(FArchive& Ar, FTransform& Delta)
+{
+	FQuat Rotation = Delta.GetRotation();
+	SerializeQuatDelta(Ar, Rotation);
+	FVector Offset = Delta.GetLocation();
+	SerializePositionDelta(Ar, Offset);
+	FVector Scale = Delta.GetScale3D();
+	SerializeBoneScale(Ar, Scale);
+
+	if (Ar.IsLoading())
+	{
+		Delta = FTransform(Rotation, Offset, Scale);
+	}
+}
+
+bool FNamedSkeletonData::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	FSkeletonSerializeContext Context;
+	static const int32 MaxBones = (int32) EBodyStateBasicBoneType::BONES_COUNT;
+
+	Ar << TimeStamp;
+	Ar << KeyframeId;
+	Ar << DeltaKeyframeId;
+	// a delta has the keyframe's bones, their names come from it in ApplyDelta
+	const bool bDelta = DeltaKeyframeId != 0;
+
+	// Basic bones
+	uint32 NumBasic = TrackedBasicBones.Num();
+	Ar.SerializeInt(NumBasic, MaxBones + 1);
+	if (Ar.IsLoading())
+	{
+		TrackedBasicBones.SetNum(NumBasic);
+	}
+	for (FKeyedTransform& Bone : TrackedBasicBones)
+	{
+		FTransform Transform = Bone.Transform;
+		if (bDelta)
+		{
+			SerializeBoneDelta(Ar, Transform);
+		}
+		else
+		{
+			SerializeBoneName(Ar, Bone.Name);
+			SerializeBoneTransform(Ar, Transform, Bone.Name, Context);
+		}
+		if (Ar.IsLoading())
+		{
+			Bone.Transform = Transform;
+		}
+	}
+
+	// Advanced bones
+	uint32 NumAdvanced = TrackedAdvancedBones.Num();
+	Ar.SerializeInt(NumAdvanced, MaxBones + 1);
+	if (Ar.IsLoading())
+	{
+		TrackedAdvancedBones.SetNum(NumAdvanced);
+	}
+	for (FNamedBoneData& Bone : TrackedAdvancedBones)
+	{
+		FTransform Transform = Bone.Data.Transform;
+		if (bDelta)
+		{
+			SerializeBoneDelta(Ar, Transform);
+		}
+		else
+		{
+			SerializeBoneName(Ar, Bone.Name);
+			SerializeBoneTransform(Ar, Transform, Bone.Name, Context);
+		}
+		SerializeByteFloat(Ar, Bone.Data.Alpha);
+		SerializeHalf(Ar, Bone.Data.Length);
+		if (Ar.IsLoading())
+		{
+			Bone.Data.Transform = Transform;
+			Bone.Data.AdvancedBoneType = true;
+		}
+	}
+
+	// Meta string table, each distinct TrackingType + TrackingTags combination is sent once
+	TArray<const FBodyStateBoneMeta*> MetaTable;
+	TArray<uint32> MetaHandles;
+	if (Ar.IsSaving())
+	{
+		for (const FNamedBoneMeta& NamedMeta : UniqueMetas)
+		{
+			int32 Handle = MetaTable.IndexOfByPredicate([&NamedMeta](const FBodyStateBoneMeta* Other) {
+				return Other->TrackingType == NamedMeta.Meta.TrackingType && Other->TrackingTags == NamedMeta.Meta.TrackingTags;
+			});
+			if (Handle == INDEX_NONE)
+			{
+				Handle = MetaTable.Add(&NamedMeta.Meta);
+			}
+			MetaHandles.Add(Handle);
+		}
+	}
+	uint32 NumTableEntries = MetaTable.Num();
+	Ar.SerializeIntPacked(NumTableEntries);
+
+	TArray<FBodyStateBoneMeta> LoadedTable;
+	if (Ar.IsLoading())
+	{
+		if (NumTableEntries > (uint32) MaxBones)
+		{
+			Ar.SetError();
+			bOutSuccess = false;
+			return false;
+		}
+		LoadedTable.SetNum(NumTableEntries);
+	}
+	for (uint32 Handle = 0; Handle < NumTableEntries; Handle++)
+	{
+		FString TrackingType = Ar.IsSaving() ? MetaTable[Handle]->TrackingType : FString();
+		TArray<FString> TrackingTags = Ar.IsSaving() ? MetaTable[Handle]->TrackingTags : TArray<FString>();
+		Ar << TrackingType;
+		Ar << TrackingTags;
+		if (Ar.IsLoading())
+		{
+			LoadedTable[Handle].TrackingType = TrackingType;
+			LoadedTable[Handle].TrackingTags = TrackingTags;
+		}
+	}
+
+	uint32 NumMetas = UniqueMetas.Num();
+	Ar.SerializeInt(NumMetas, MaxBones + 1);
+	if (Ar.IsLoading())
+	{
+		UniqueMetas.SetNum(NumMetas);
+	}
+	for (int32 i = 0; i < UniqueMetas.Num(); i++)
+	{
+		FNamedBoneMeta& NamedMeta = UniqueMetas[i];
+		SerializeBoneName(Ar, NamedMeta.Name);
+
+		uint32 Handle = Ar.IsSaving() ? MetaHandles[i] : 0;
+		Ar.SerializeIntPacked(Handle);
+
+		uint8 bParentDistinct = NamedMeta.Meta.ParentDistinctMeta ? 1 : 0;
+		Ar.SerializeBits(&bParentDistinct, 1);
+		SerializeByteFloat(Ar, NamedMeta.Meta.Confidence);
+		SerializeHalf(Ar, NamedMeta.Meta.Accuracy);
+		Ar << NamedMeta.Meta.TimeStamp;
+
+		if (Ar.IsLoading())
+		{
+			if (Handle >= NumTableEntries)
+			{
+				Ar.SetError();
+				break;
+			}
+			NamedMeta.Meta.TrackingType = LoadedTable[Handle].TrackingType;
+			NamedMeta.Meta.TrackingTags = LoadedTable[Handle].TrackingTags;
+			NamedMeta.Meta.ParentDistinctMeta = bParentDistinct != 0;
+		}
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+bool FNamedSkeletonData::HasSameBones(const FNamedSkeletonData& Other) const
+{
+	if (TrackedBasicBones.Num() != Other.TrackedBasicBones.Num() || TrackedAdvancedBones.Num() != Other.TrackedAdvancedBones.Num())
+	{
+		return false;
+	}
+	for (int32 i = 0; i < TrackedBasicBones.Num(); i++)
+	{
+		if (TrackedBasicBones[i].Name != Other.TrackedBasicBones[i].Name)
+		{
+			return false;
+		}
+	}
+	for (int32 i = 0; i < TrackedAdvancedBones.Num(); i++)
+	{
+		if (TrackedAdvancedBones[i].Name != Other.TrackedAdvancedBones[i].Name)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static FTransform MakeDeltaTransform(const FTransform& Keyframe, const FTransform& Transform)
+{
+	return FTransform(Keyframe.GetRotation().Inverse() * Transform.GetRotation(), Transform.GetLocation() - Keyframe.GetLocation(),
+		Transform.GetScale3D());
+}
+
+static FTransform ApplyDeltaTransform(const FTransform& Keyframe, const FTransform& Delta)
+{
+	return FTransform(
+		(Keyframe.GetRotation() * Delta.GetRotation()).GetNormalized(), Keyframe.GetLocation() + Delta.GetLocation(), Delta.GetScale3D());
+}
+
+bool FNamedSkeletonData::MakeDelta(const FNamedSkeletonData& Keyframe)
+{
+	if (Keyframe.KeyframeId == 0 || !HasSameBones(Keyframe))
+	{
+		return false;
+	}
+	for (int32 i = 0; i < TrackedBasicBones.Num(); i++)
+	{
+		TrackedBasicBones[i].Transform = MakeDeltaTransform(Keyframe.TrackedBasicBones[i].Transform, TrackedBasicBones[i].Transform);
+	}
+	for (int32 i = 0; i < TrackedAdvancedBones.Num(); i++)
+	{
+		FTransform& Transform = TrackedAdvancedBones[i].Data.Transform;
+		Transform = MakeDeltaTransform(Keyframe.TrackedAdvancedBones[i].Data.Transform, Transform);
+	}
+	KeyframeId = 0;
+	DeltaKeyframeId = Keyframe.KeyframeId;
+	return true;
+}
+
+bool FNamedSkeletonData::ApplyDelta(const FNamedSkeletonData& Keyframe)
+{
+	if (DeltaKeyframeId == 0 || Keyframe.KeyframeId != DeltaKeyframeId ||
+		TrackedBasicBones.Num() != Keyframe.TrackedBasicBones.Num() ||
+		TrackedAdvancedBones.Num() != Keyframe.TrackedAdvancedBones.Num())
+	{
+		return false;
+	}
+	for (int32 i = 0; i < TrackedBasicBones.Num(); i++)
+	{
+		const FKeyedTransform& KeyBone = Keyframe.TrackedBasicBones[i];
+		TrackedBasicBones[i].Name = KeyBone.Name;
+		TrackedBasicBones[i].Transform = ApplyDeltaTransform(KeyBone.Transform, TrackedBasicBones[i].Transform);
+	}
+	for (int32 i = 0; i < TrackedAdvancedBones.Num(); i++)
+	{
+		const FNamedBoneData& KeyBone = Keyframe.TrackedAdvancedBones[i];
+		TrackedAdvancedBones[i].Name = KeyBone.Name;
+		TrackedAdvancedBones[i].Data.Transform = ApplyDeltaTransform(KeyBone.Data.Transform, TrackedAdvancedBones[i].Data.Transform);
+	}
+	DeltaKeyframeId = 0;
+	return true;
+}
@@ -37,7 +37,9 @@ enum EBSDeviceCombinerClass
 {
 	BS_DEVICE_COMBINER_UNKNOWN,
 	BS_DEVICE_COMBINER_CONFIDENCE,
-	BS_DEVICE_COMBINER_ANGULAR
+	BS_DEVICE_COMBINER_ANGULAR,
+	BS_DEVICE_COMBINER_SPATIAL,
+	BS_DEVICE_COMBINER_KALMAN
 	// add your custom classes here and add them to the class factory
 };
 class BODYSTATE_API IBodyStateDeviceManagerRawInterface
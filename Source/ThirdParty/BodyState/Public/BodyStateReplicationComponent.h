@@ -0,0 +1,205 @@
+/*************************************************************************************************************************************
+ *The MIT License(MIT)
+ *
+ *Copyright(c) 2016 Jan Kaniewski(Getnamo)
+ *Modified work Copyright(C) 2019 - 2021 Ultraleap, Inc.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ *files(the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify,
+ *merge, publish, distribute, sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is
+ *furnished to do so, subject to the following conditions :
+ *
+ *The above copyright notice and this permission notice shall be included in all copies or
+ *substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ *FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *************************************************************************************************************************************/
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "Skeleton/BodyStateSkeleton.h"
+
+#include "BodyStateReplicationComponent.generated.h"
+
+/** Replication bandwidth and scheduling counters, valid on the server */
+USTRUCT(BlueprintType)
+struct BODYSTATE_API FBodyStateReplicationStats
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Skeleton bytes per second sent to this player */
+	UPROPERTY(BlueprintReadOnly, Category = "BodyState Replication")
+	float SentBytesPerSecond = 0;
+
+	/** Skeleton bytes per second received from this player */
+	UPROPERTY(BlueprintReadOnly, Category = "BodyState Replication")
+	float ReceivedBytesPerSecond = 0;
+
+	/** Updates to this player that were due but held back by the bandwidth budget */
+	UPROPERTY(BlueprintReadOnly, Category = "BodyState Replication")
+	int32 BudgetDeferredUpdates = 0;
+
+	/** Updates to this player sent without finger bones because the source was far away */
+	UPROPERTY(BlueprintReadOnly, Category = "BodyState Replication")
+	int32 ReducedDetailUpdates = 0;
+
+	/** Local updates not sent because the hands were static (owning client only) */
+	UPROPERTY(BlueprintReadOnly, Category = "BodyState Replication")
+	int32 SkippedStaticUpdates = 0;
+
+	/** Updates sent as a delta against a keyframe rather than in full */
+	UPROPERTY(BlueprintReadOnly, Category = "BodyState Replication")
+	int32 DeltaUpdates = 0;
+
+	/** Deltas received for this player's skeleton and dropped because their keyframe was lost */
+	UPROPERTY(BlueprintReadOnly, Category = "BodyState Replication")
+	int32 DroppedDeltaUpdates = 0;
+};
+
+/**
+ * Replicates the local BodyState skeleton of the owning player and receives the skeletons of other players.
+ * Add to the player pawn. The server forwards each player's hands to every other player at a rate driven by
+ * viewer distance, visibility and hand motion, sends finger bones only to nearby viewers and keeps each
+ * connection within a bandwidth budget.
+ */
+UCLASS(ClassGroup = "BodyState", meta = (BlueprintSpawnableComponent))
+class BODYSTATE_API UBodyStateReplicationComponent : public UActorComponent
+{
+	GENERATED_UCLASS_BODY()
+public:
+	/** Device id of the local skeleton to send, 0 is the merged skeleton */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BodyState Replication")
+	int32 SkeletonDeviceId;
+
+	/** Highest rate updates are sent at, for close, visible and moving hands */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BodyState Replication")
+	float MaxSendRate;
+
+	/** Lowest rate updates are sent at, for distant, out of view or slow hands */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BodyState Replication")
+	float MinSendRate;
+
+	/** Within this distance (cm) viewers get full rate and finger detail */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BodyState Replication")
+	float NearDistance;
+
+	/** Beyond this distance (cm) viewers get the minimum rate */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BodyState Replication")
+	float FarDistance;
+
+	/** Beyond this distance (cm) viewers only get wrist and arm bones */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BodyState Replication")
+	float FingerDetailDistance;
+
+	/** Hand speed (cm/s) considered fully active, slower hands are sent less often */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BodyState Replication")
+	float ActiveHandSpeed;
+
+	/** Bones moving less than this (cm) since the last send are considered static and not sent */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BodyState Replication")
+	float StaticThreshold;
+
+	/** Static hands are still sent this often (s) so late joiners get a pose */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BodyState Replication")
+	float StaticKeepAliveInterval;
+
+	/** Skeleton bytes per second the server may send to this player */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BodyState Replication")
+	int32 BandwidthBudget;
+
+	/** Updates between full keyframes, the rest are sent as deltas against the last keyframe. Lower recovers sooner
+	 * when a keyframe is lost, 0 sends every update in full */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BodyState Replication")
+	int32 KeyframeInterval;
+
+	/** Skeleton received for this (remote) player, assign it to the anim instance of their hands */
+	UFUNCTION(BlueprintPure, Category = "BodyState Replication")
+	UBodyStateSkeleton* GetRemoteSkeleton();
+
+	UFUNCTION(BlueprintPure, Category = "BodyState Replication")
+	FBodyStateReplicationStats GetReplicationStats();
+
+	// Owning client -> server
+	UFUNCTION(Unreliable, Server, WithValidation)
+	void ServerReceiveSkeleton(const FNamedSkeletonData& InSkeleton);
+
+	// Server -> this player, Source is the component of the player the skeleton belongs to
+	UFUNCTION(Unreliable, Client)
+	void ClientReceiveSkeleton(UBodyStateReplicationComponent* Source, const FNamedSkeletonData& InSkeleton);
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Serialized size of a skeleton with the RPC serializer, INDEX_NONE if it is too large to send */
+	static int32 GetSerializedSize(FNamedSkeletonData& Skeleton);
+
+	/** Remove finger bones and metas, leaving wrists and arms */
+	static void StripFingerBones(FNamedSkeletonData& Skeleton);
+
+	/** Largest bone translation between two skeletons in cm */
+	static float GetMaxBoneDelta(const FNamedSkeletonData& A, const FNamedSkeletonData& B);
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Keyframes of a skeleton stream to one receiver
+	struct FKeyframeState
+	{
+		// the last keyframe as the receiver decodes it, so quantization errors don't add up across deltas
+		FNamedSkeletonData Keyframe;
+		uint8 LastKeyframeId = 0;
+		int32 UpdatesSinceKeyframe = 0;
+	};
+	/** Turns Data into a delta against State's keyframe, or into the next keyframe when it's due or the bones changed */
+	void EncodeForSend(const FKeyframeState& State, FNamedSkeletonData& Data);
+	/** Updates State once Data from EncodeForSend has been sent */
+	void CommitSent(FKeyframeState& State, const FNamedSkeletonData& Data);
+	/** Resolves received data for this player's skeleton to absolute transforms, false if its keyframe was lost */
+	bool DecodeReceived(FNamedSkeletonData& Data);
+
+	bool IsLocallyOwned() const;
+	bool GetViewPoint(FVector& OutLocation, FVector& OutDirection) const;
+	void SendLocalSkeleton(const double Now);
+	void ScheduleForwarding(const float DeltaTime, const double Now);
+	void UpdateByteRates(const double Now);
+
+	UPROPERTY()
+	UBodyStateSkeleton* RemoteSkeleton;
+
+	// Owning client
+	FNamedSkeletonData LastSentSkeleton;
+	double LastLocalSendTime;
+	FKeyframeState LocalKeyframes;
+
+	// The last keyframes received for this player's skeleton, on the server from the owner and on clients from the
+	// server. More than one so a delta overtaken by the next keyframe can still be read
+	TArray<FNamedSkeletonData> ReceivedKeyframes;
+
+	// Server, latest data from this player
+	FNamedSkeletonData LatestSkeleton;
+	int32 LatestSequence;
+	// smoothed hand speed in cm/s
+	float MotionEnergy;
+	// server clock when LatestSkeleton arrived, the owning client stops sending while the hands are static
+	double LatestReceiveTime;
+
+	// Server, what this player has been sent of each other player
+	struct FForwardState
+	{
+		double LastSendTime = 0;
+		int32 LastSentSequence = 0;
+		FKeyframeState Keyframes;
+	};
+	TMap<TWeakObjectPtr<UBodyStateReplicationComponent>, FForwardState> ForwardStates;
+	float BudgetTokens;
+
+	int32 SentBytesThisWindow;
+	int32 ReceivedBytesThisWindow;
+	double ByteWindowStart;
+	FBodyStateReplicationStats Stats;
+};
@@ -0,0 +1,78 @@
+/*************************************************************************************************************************************
+ *The MIT License(MIT)
+ *
+ *Copyright(c) 2016 Jan Kaniewski(Getnamo)
+ *Modified work Copyright(C) 2019 - 2021 Ultraleap, Inc.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ *files(the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify,
+ *merge, publish, distribute, sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is
+ *furnished to do so, subject to the following conditions :
+ *
+ *The above copyright notice and this permission notice shall be included in all copies or
+ *substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ *FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *************************************************************************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Skeleton/BodyStateSkeleton.h"
+
+/**
+ * Buffers replicated skeleton snapshots and renders them a fixed delay behind the sender so that network
+ * jitter, reordering and loss don't show up as hitches. Bones are interpolated between the two snapshots
+ * bracketing the render time. If the buffer runs dry they are briefly extrapolated, then settle back onto
+ * the newest snapshot and hold it.
+ *
+ * Times are passed in explicitly so the buffer can be driven by a simulated transport.
+ */
+class BODYSTATE_API FBodyStateSkeletonJitterBuffer
+{
+public:
+	/** Add a received snapshot, ArrivalTime is the local clock in seconds */
+	void AddSnapshot(const FNamedSkeletonData& Snapshot, double ArrivalTime);
+
+	/** Sample the skeleton to render at local time Now, returns false if nothing has been received */
+	bool Sample(double Now, FNamedSkeletonData& OutSkeleton);
+
+	void Reset();
+
+	const FBodyStateJitterBufferStats& GetStats() const
+	{
+		return Stats;
+	}
+
+	/** Lerp/slerp all bones present in B with their counterparts in A, Alpha > 1 extrapolates */
+	static void InterpolateSkeleton(
+		const FNamedSkeletonData& A, const FNamedSkeletonData& B, float Alpha, FNamedSkeletonData& OutSkeleton);
+
+	// seconds to render behind the sender
+	float Delay = 0.1f;
+	// seconds to extrapolate past the newest snapshot, it takes as long again to settle back and hold it
+	float MaxExtrapolation = 0.1f;
+
+	static const int32 MaxSnapshots = 32;
+
+private:
+	struct FSnapshot
+	{
+		double SenderTime;
+		FNamedSkeletonData Data;
+	};
+
+	// sorted oldest first
+	TArray<FSnapshot> Snapshots;
+
+	// estimated local arrival time minus sender time
+	double ClockOffset = 0;
+	bool bHasClockOffset = false;
+	// in sender time, never goes backwards
+	double LastRenderTime = -1;
+
+	FBodyStateJitterBufferStats Stats;
+};
@@ -80,6 +80,71 @@ struct BODYSTATE_API FNamedSkeletonData
 
 	UPROPERTY()
 	TArray<FNamedBoneMeta> UniqueMetas;
+
+	/** Sender clock in seconds when this data was captured, used to order and pace received updates */
+	UPROPERTY()
+	double TimeStamp = 0;
+
+	/** Non zero when this data is a keyframe that later deltas can refer to */
+	UPROPERTY()
+	uint8 KeyframeId = 0;
+
+	/** Non zero when the bone transforms are relative to the keyframe with this ID, see MakeDelta */
+	UPROPERTY()
+	uint8 DeltaKeyframeId = 0;
+
+	/** Quantized serialization used by the skeleton RPCs, error bounds are documented in BodyStateSkeleton.cpp */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	/** Makes the bone transforms relative to Keyframe, which then has to be applied to read them. Leaves the data as is
+	 * and returns false if the tracked bones are not the keyframe's */
+	bool MakeDelta(const FNamedSkeletonData& Keyframe);
+
+	/** Turns a received delta back into absolute transforms, false if it wasn't made against Keyframe */
+	bool ApplyDelta(const FNamedSkeletonData& Keyframe);
+
+	/** Whether both track the same bones in the same order */
+	bool HasSameBones(const FNamedSkeletonData& Other) const;
+};
+
+template <>
+struct TStructOpsTypeTraits<FNamedSkeletonData> : public TStructOpsTypeTraitsBase2<FNamedSkeletonData>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/** Health of the jitter buffer used for received skeleton updates */
+USTRUCT(BlueprintType)
+struct BODYSTATE_API FBodyStateJitterBufferStats
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Snapshots currently buffered */
+	UPROPERTY(BlueprintReadOnly, Category = "BodyState Jitter Buffer")
+	int32 BufferDepth = 0;
+
+	/** Time in ms between the rendered skeleton and the newest received snapshot */
+	UPROPERTY(BlueprintReadOnly, Category = "BodyState Jitter Buffer")
+	float BufferedTime = 0;
+
+	/** Snapshots that arrived after their time had already been rendered */
+	UPROPERTY(BlueprintReadOnly, Category = "BodyState Jitter Buffer")
+	int32 LateSnapshots = 0;
+
+	/** Snapshots discarded because the buffer was full */
+	UPROPERTY(BlueprintReadOnly, Category = "BodyState Jitter Buffer")
+	int32 DroppedSnapshots = 0;
+
+	/** Frames rendered past the newest snapshot by extrapolation */
+	UPROPERTY(BlueprintReadOnly, Category = "BodyState Jitter Buffer")
+	int32 ExtrapolatedFrames = 0;
+
+	/** Frames where extrapolation ran out and the last pose was held */
+	UPROPERTY(BlueprintReadOnly, Category = "BodyState Jitter Buffer")
+	int32 HeldFrames = 0;
 };
 
 /** Body Skeleton data, all bones are expected in component space*/
@@ -190,6 +255,29 @@ class BODYSTATE_API UBodyStateSkeleton : public UObject
 	UFUNCTION(NetMulticast, Unreliable)
 	void Multi_UpdateBodyState(const FNamedSkeletonData InBodyStateSkeleton);
 
+	/** Apply a skeleton received over the network locally, through the jitter buffer if it is in use */
+	void ApplyReceivedBodyState(const FNamedSkeletonData& InBodyStateSkeleton);
+
+	/** Buffer received updates and render them JitterBufferDelay behind the sender rather than applying on arrival */
+	UPROPERTY(BlueprintReadWrite, Category = "BodyState Skeleton Replication")
+	bool bUseJitterBuffer;
+
+	/** Seconds received skeletons are rendered behind the sender, higher values hide more jitter and loss */
+	UPROPERTY(BlueprintReadWrite, Category = "BodyState Skeleton Replication")
+	float JitterBufferDelay;
+
+	/** Seconds to extrapolate when updates stop arriving, the skeleton then settles back onto the last received pose and holds it */
+	UPROPERTY(BlueprintReadWrite, Category = "BodyState Skeleton Replication")
+	float MaxExtrapolationTime;
+
+	/** Apply the buffered network pose for this frame, called by the BodyState anim instance. Returns false if nothing is
+	 * buffered */
+	UFUNCTION(BlueprintCallable, Category = "BodyState Skeleton Replication")
+	bool UpdateFromJitterBuffer();
+
+	UFUNCTION(BlueprintPure, Category = "BodyState Skeleton Replication")
+	FBodyStateJitterBufferStats GetJitterBufferStats();
+
 	FCriticalSection BoneDataLock;
 
 	void ReleaseRefs();
@@ -201,6 +289,10 @@ protected:
 	TArray<FNamedBoneMeta> UniqueBoneMetas();
 
 private:
+	TSharedPtr<class FBodyStateSkeletonJitterBuffer> JitterBuffer;
+	// Updates are applied on arrival if nothing has sampled the buffer recently
+	double LastJitterBufferSampleTime;
+
 	UPROPERTY()
 	UBodyStateArm* PrivateLeftArm;
 
@@ -17,10 +17,10 @@
 #include "LeapUtility.h"
 #include "Skeleton/BodyStateSkeleton.h"
 #include "UltraleapTrackingData.h"
+#include "LeapFrameStreamer.h"
 #include "LeapTrackingSettings.h"
+#include "UltraleapTrackingStats.h"
 
-
-DECLARE_STATS_GROUP(TEXT("UltraleapMultiTracking"), STATGROUP_UltraleapMultiTracking, STATCAT_Advanced);
 DECLARE_CYCLE_STAT(TEXT("Multi Leap Game Input and Events"), STAT_MultiLeapInputTick, STATGROUP_UltraleapMultiTracking);
 DECLARE_CYCLE_STAT(TEXT("Multi Leap BodyState Tick"), STAT_MultiLeapBodyStateTick, STATGROUP_UltraleapMultiTracking);
 
@@ -148,6 +148,10 @@ void FUltraleapDevice::InitOptions()
 
 void FUltraleapDevice::OnFrame(const LEAP_TRACKING_EVENT* Frame)
 {
+	if (LeapImageHandler.IsValid())
+	{
+		LeapImageHandler->OnFrame(Frame);
+	}
 	if (TrackingDeviceWrapper)
 	{
 		TrackingDeviceWrapper->HandleTrackingEvent(Frame);
@@ -335,16 +339,20 @@ void FUltraleapDevice::Init()
 	}
 	BodyStateDeviceId = UBodyStateBPLibrary::AttachDeviceNative(Config, this);
 
-#if WITH_EDITOR
-	// LiveLink startup
-	LiveLink = MakeShareable(new FLeapLiveLinkProducer());
-	LiveLink->Startup(Leap->GetDeviceSerial());
-	LiveLink->SyncSubjectToSkeleton(IBodyState::Get().SkeletonForDevice(BodyStateDeviceId));
-#endif
+	// LiveLink startup, always available in editor, opt in for packaged builds
+	const ULeapTrackingSettings* TrackingSettings = GetDefault<ULeapTrackingSettings>();
+	if (GIsEditor || TrackingSettings->bEnableLiveLinkInPackagedBuilds)
+	{
+		LiveLink = MakeShareable(new FLeapLiveLinkProducer());
+		LiveLink->Startup(Leap->GetDeviceSerial());
+		LiveLink->SetMaxPublishRate(TrackingSettings->LiveLinkMaxPublishRate);
+		LiveLink->SyncSubjectToSkeleton(IBodyState::Get().SkeletonForDevice(BodyStateDeviceId));
+	}
 
 	// Image support
-	LeapImageHandler = MakeShareable(new FLeapImage);
+	LeapImageHandler = MakeShared<FLeapImage, ESPMode::ThreadSafe>();
 	LeapImageHandler->OnImageCallback.AddRaw(this, &FUltraleapDevice::OnImageCallback);
+	LeapImageHandler->SetDevice(Leap);
 
 	InitOptions();
 
@@ -360,14 +368,15 @@ void FUltraleapDevice::Init()
 }
 FUltraleapDevice::~FUltraleapDevice()
 {
-#if WITH_EDITOR
 	if (LiveLink != nullptr)
 	{
 		// LiveLink cleanup
 		LiveLink->ShutDown();
 		LiveLink = nullptr;
 	}
-#endif
+	FrameStreamer = nullptr;
+	FrameProcessors.Empty();
+	CustomFrameProcessors.Empty();
 
 	ShutdownLeap();
 }
@@ -377,6 +386,11 @@ void FUltraleapDevice::Tick(float DeltaTime)
 	GameTimeInSec += DeltaTime;
 	FrameTimeInMicros = DeltaTime * 1000000;
 	DeltaTimeFromTick = DeltaTime;
+	// adaptive fidelity interpolates by the estimate, the predict stage predicts by it at any fidelity
+	if (Options.TrackingFidelity == ELeapTrackingFidelity::LEAP_ADAPTIVE || PredictProcessor.IsValid())
+	{
+		FramePacer.Update(DeltaTime);
+	}
 	
 }
 
@@ -426,15 +440,20 @@ void FUltraleapDevice::CaptureAndEvaluateInput()
 	{
 		return;
 	}
+	// streamed as tracked, receivers interpolate and transform it for themselves
+	if (FrameStreamer.IsValid())
+	{
+		FrameStreamer->PushFrame(*Frame, Leap->GetNow());
+	}
 	if (!Options.bUseOpenXRAsSource)
 	{
 		TimeWarpTimeStamp = Frame->info.timestamp;
+		const int64 DeviceFrameId = Frame->info.frame_id;
 		int64 LeapTimeNow = 0;
 		LeapTimeNow = Leap->GetNow();
 		SnapshotHandler.AddCurrentHMDSample(LeapTimeNow);
 
-		HandInterpolationTimeOffset = Options.HandInterpFactor * FrameTimeInMicros;
-		FingerInterpolationTimeOffset = Options.FingerInterpFactor * FrameTimeInMicros;
+		UpdateInterpolationTimeOffsets();
 
 		// interpolation not supported in OpenXR
 		if (Options.bUseInterpolation)
@@ -458,6 +477,8 @@ void FUltraleapDevice::CaptureAndEvaluateInput()
 				return;
 			}
 			CurrentFrame.SetInterpolationPartialFromLeapFrame(Frame,Options.HMDPositionOffset, Options.HMDRotationOffset.Quaternion());
+			CurrentFrame.TrackingTimeStamp = TimeWarpTimeStamp;
+			CurrentFrame.DeviceFrameId = DeviceFrameId;
 
 			// Track our extrapolation time in stats
 			Stats.FrameExtrapolationInMS = (CurrentFrame.TimeStamp - TimeWarpTimeStamp) / 1000.f;
@@ -535,6 +556,18 @@ void FUltraleapDevice::ParseEvents()
 	// e.g. Pinch and Grasp simulation for OpenXR
 	Leap->PostLeapHandUpdate(CurrentFrame);
 
+	// once per device, before gestures are detected and the frame is sent anywhere
+	if (FrameProcessors.Num())
+	{
+		if (PredictProcessor.IsValid())
+		{
+			// the frame's age now plus the time until it is on screen
+			PredictProcessor->SetLatency(
+				FMath::Clamp((Leap->GetNow() - CurrentFrame.TimeStamp) * 1.0e-6f, 0.0f, 0.1f), FramePacer.GetDisplayLatency());
+		}
+		FrameProcessors.Process(CurrentFrame, CurrentFrame.FrameRate > 0 ? 1.0f / CurrentFrame.FrameRate : 1.0f / 90.0f);
+	}
+
 	CheckHandVisibility();
 	CheckGrabGesture();
 	CheckPinchGesture();
@@ -1162,9 +1195,8 @@ void FUltraleapDevice::UpdateInput(int32 DeviceID, class UBodyStateSkeleton* Ske
 	}
 
 // Livelink is an editor only thing
-#if WITH_EDITOR
 	// LiveLink logic
-	if (LiveLink->HasConnection())
+	if (LiveLink.IsValid() && LiveLink->HasConnection())
 	{
 		if (bTrackedBonesChanged)
 		{
@@ -1172,7 +1204,6 @@ void FUltraleapDevice::UpdateInput(int32 DeviceID, class UBodyStateSkeleton* Ske
 		}
 		LiveLink->UpdateFromBodyState(Skeleton);
 	}
-#endif
 }
 void FUltraleapDevice::SetBSFingerFromLeapDigit(UBodyStateFinger* Finger, const FLeapDigitData& LeapDigit)
 {
@@ -1221,6 +1252,8 @@ void FUltraleapDevice::SetBSHandFromLeapHand(UBodyStateHand* Hand, const FLeapHa
 void FUltraleapDevice::SwitchTrackingSource(const bool UseOpenXRAsSource)
 {
 	Leap->OpenConnection(this);
+	// history from the previous source doesn't apply
+	FrameProcessors.Reset();
 }
 void FUltraleapDevice::SetOptions(const FLeapOptions& InOptions)
 {
@@ -1273,6 +1306,16 @@ void FUltraleapDevice::SetOptions(const FLeapOptions& InOptions)
 	// Set main options
 	Options = InOptions;
 
+	if (LeapImageHandler.IsValid())
+	{
+		LeapImageHandler->SetRectify(Options.bRectifyImages);
+		LeapImageHandler->History.SetCapacity(Options.ImageHistorySize);
+		LeapImageHandler->SetImageProcessing(
+			Options.ImageDownsampleFactor, Options.bImageHandRegionOfInterest, Options.ImageRegionOfInterestSize);
+	}
+	UpdateFrameStreamer();
+	UpdateFrameProcessors();
+
 	// Make sure the hints are unique, hints can also be set using SetLeapOptions
 	if (UniqueHints.Num())
 	{
@@ -1310,6 +1353,12 @@ void FUltraleapDevice::SetOptions(const FLeapOptions& InOptions)
 					Options.HandInterpFactor = -1.f;
 					Options.FingerInterpFactor = -1.f;
 					break;
+				case ELeapTrackingFidelity::LEAP_ADAPTIVE:
+					// timewarp as normal, the pacer picks the interpolation time
+					Options.bUseTimeWarp = true;
+					Options.TimewarpOffset = 500;
+					Options.TimewarpFactor = -1.f;
+					break;
 				case ELeapTrackingFidelity::LEAP_SMOOTH:
 					Options.bUseTimeWarp = false;
 					Options.bUseInterpolation = true;
@@ -1387,6 +1436,19 @@ void FUltraleapDevice::SetOptions(const FLeapOptions& InOptions)
 					Options.HandInterpFactor = 0.f;
 					Options.FingerInterpFactor = 0.f;
 					break;
+				case ELeapTrackingFidelity::LEAP_ADAPTIVE:
+					// timewarp as normal, the pacer picks the interpolation time
+					if (DeviceType == ELeapDeviceType::LEAP_DEVICE_TYPE_PERIPHERAL)
+					{
+						Options.TimewarpOffset = 20000;
+					}
+					else
+					{
+						Options.TimewarpOffset = 25000;
+					}
+					Options.bUseTimeWarp = true;
+					Options.TimewarpFactor = -1.f;
+					break;
 
 				case ELeapTrackingFidelity::LEAP_SMOOTH:
 					Options.bUseTimeWarp = true;
@@ -1418,9 +1480,25 @@ void FUltraleapDevice::SetOptions(const FLeapOptions& InOptions)
 		Options.HMDPositionOffset = FVector(0, 0, 0);
 		Options.HMDRotationOffset = FRotator(0, 0, 0);
 	}
+	if (Options.TrackingFidelity == ELeapTrackingFidelity::LEAP_ADAPTIVE)
+	{
+		// the pacer picks the time to interpolate at, the factors aren't used
+		Options.bUseInterpolation = true;
+		FramePacer.SetLimits(Options.AdaptiveLatencyScale, Options.AdaptiveMaxLeadInMS);
+	}
+	else
+	{
+		FramePacer.Reset();
+	}
+	if (PredictProcessor.IsValid())
+	{
+		// the predict stage already extrapolates by the measured latency, a preset's lead (0.5 frames for
+		// LEAP_LOW_LATENCY) would be added on top of it
+		Options.HandInterpFactor = 0.0f;
+		Options.FingerInterpFactor = 0.0f;
+	}
 	// Ensure other factors are synced
-	HandInterpolationTimeOffset = Options.HandInterpFactor * FrameTimeInMicros;
-	FingerInterpolationTimeOffset = Options.FingerInterpFactor * FrameTimeInMicros;
+	UpdateInterpolationTimeOffsets();
 
 	// Disable time warp in desktop mode
 	if (Options.Mode == ELeapMode::LEAP_MODE_DESKTOP)
@@ -1447,8 +1525,174 @@ FLeapOptions FUltraleapDevice::GetOptions()
 
 FLeapStats FUltraleapDevice::GetStats()
 {
+	if (LeapImageHandler.IsValid())
+	{
+		LeapImageHandler->GetStats(Stats);
+	}
+	if (FrameStreamer.IsValid())
+	{
+		FrameStreamer->GetStats(Stats);
+	}
+	if (PredictProcessor.IsValid())
+	{
+		PredictProcessor->GetStats(Stats);
+	}
+	else
+	{
+		Stats.PredictionHorizonInMS = 0;
+		Stats.PredictionErrorInMM = 0;
+	}
+	// the pacer is only updated while adaptive fidelity or the predict stage uses it, don't report a stale estimate
+	if (Options.TrackingFidelity == ELeapTrackingFidelity::LEAP_ADAPTIVE || PredictProcessor.IsValid())
+	{
+		FramePacer.GetStats(Stats);
+	}
+	else
+	{
+		Stats.DisplayLatencyInMS = 0;
+	}
+	if (Options.TrackingFidelity != ELeapTrackingFidelity::LEAP_ADAPTIVE || PredictProcessor.IsValid())
+	{
+		// only adaptive fidelity interpolates by the pacer's offset, and not while predicting (see UpdateInterpolationTimeOffsets)
+		Stats.InterpolationOffsetInMS = 0;
+	}
 	return Stats;
 }
+
+void FUltraleapDevice::UpdateInterpolationTimeOffsets()
+{
+	if (Options.TrackingFidelity == ELeapTrackingFidelity::LEAP_ADAPTIVE)
+	{
+		// the predict stage covers the display latency itself, don't extrapolate twice
+		HandInterpolationTimeOffset = PredictProcessor.IsValid() ? 0 : FramePacer.GetInterpolationOffset();
+		FingerInterpolationTimeOffset = HandInterpolationTimeOffset;
+		return;
+	}
+	HandInterpolationTimeOffset = Options.HandInterpFactor * FrameTimeInMicros;
+	FingerInterpolationTimeOffset = Options.FingerInterpFactor * FrameTimeInMicros;
+}
+
+void FUltraleapDevice::UpdateFrameStreamer()
+{
+	if (!Options.bStreamFrames)
+	{
+		FrameStreamer = nullptr;
+		return;
+	}
+	// Socket settings need a restart, rate and back pressure apply live
+	if (!FrameStreamer.IsValid() ||
+		!FrameStreamer->IsStartedWith(Options.StreamPort, Options.bStreamOverTCP, Options.StreamMulticastGroup))
+	{
+		FrameStreamer = MakeShareable(new FLeapFrameStreamer());
+		if (!FrameStreamer->Start(Options.StreamPort, Options.bStreamOverTCP, Options.StreamMulticastGroup))
+		{
+			FrameStreamer = nullptr;
+			return;
+		}
+	}
+	FrameStreamer->SetMaxRate(Options.StreamMaxRate);
+	FrameStreamer->SetBackPressure(Options.StreamBackPressure);
+}
+
+TSharedPtr<ILeapFrameProcessor> FUltraleapDevice::GetBuiltInFrameProcessor(const ELeapFrameProcessor Type)
+{
+	switch (Type)
+	{
+		case ELeapFrameProcessor::LEAP_PROCESSOR_FILTER:
+		{
+			if (!FilterProcessor.IsValid())
+			{
+				FilterProcessor = MakeShareable(new FLeapFilterFrameProcessor());
+			}
+			FLeapOneEuroParams PositionParams;
+			PositionParams.MinCutoff = Options.HandSmoothingMinCutoff;
+			PositionParams.CutoffSlope = Options.HandSmoothingCutoffSlope;
+			FLeapOneEuroParams RotationParams = PositionParams;
+			RotationParams.CutoffSlope = Options.HandSmoothingRotationCutoffSlope;
+			FilterProcessor->GetFilterBank().SetAllParams(PositionParams, RotationParams);
+			return FilterProcessor;
+		}
+		case ELeapFrameProcessor::LEAP_PROCESSOR_CLAMP:
+			if (!ClampProcessor.IsValid())
+			{
+				ClampProcessor = MakeShareable(new FLeapClampFrameProcessor());
+			}
+			ClampProcessor->SetBounds(Options.ProcessorClampBounds);
+			return ClampProcessor;
+		case ELeapFrameProcessor::LEAP_PROCESSOR_MIRROR:
+			if (!MirrorProcessor.IsValid())
+			{
+				MirrorProcessor = MakeShareable(new FLeapMirrorFrameProcessor());
+			}
+			return MirrorProcessor;
+		case ELeapFrameProcessor::LEAP_PROCESSOR_SCALE:
+			if (!ScaleProcessor.IsValid())
+			{
+				ScaleProcessor = MakeShareable(new FLeapScaleFrameProcessor());
+			}
+			ScaleProcessor->SetScale(Options.ProcessorScale);
+			return ScaleProcessor;
+		case ELeapFrameProcessor::LEAP_PROCESSOR_PREDICT:
+			if (!PredictProcessor.IsValid())
+			{
+				PredictProcessor = MakeShareable(new FLeapPredictFrameProcessor());
+			}
+			PredictProcessor->SetHorizonLimits(Options.PredictionLatencyScale, Options.MaxPredictionInMS / 1000.0f);
+			PredictProcessor->SetJointLimit(Options.PredictionJointLimit);
+			return PredictProcessor;
+	}
+	return nullptr;
+}
+
+void FUltraleapDevice::UpdateFrameProcessors()
+{
+	TArray<ELeapFrameProcessor> BuiltIn = Options.FrameProcessors;
+	if (Options.bSmoothHands && !BuiltIn.Contains(ELeapFrameProcessor::LEAP_PROCESSOR_FILTER))
+	{
+		BuiltIn.Insert(ELeapFrameProcessor::LEAP_PROCESSOR_FILTER, 0);
+	}
+
+	if (!BuiltIn.Contains(ELeapFrameProcessor::LEAP_PROCESSOR_PREDICT))
+	{
+		PredictProcessor = nullptr;
+	}
+
+	FrameProcessors.Empty();
+	for (const ELeapFrameProcessor Type : BuiltIn)
+	{
+		FrameProcessors.Add(GetBuiltInFrameProcessor(Type));
+	}
+	for (const TSharedPtr<ILeapFrameProcessor>& Processor : CustomFrameProcessors)
+	{
+		FrameProcessors.Add(Processor);
+	}
+}
+
+void FUltraleapDevice::AddFrameProcessor(const TSharedPtr<ILeapFrameProcessor>& Processor)
+{
+	if (Processor.IsValid() && !CustomFrameProcessors.Contains(Processor))
+	{
+		CustomFrameProcessors.Add(Processor);
+		FrameProcessors.Add(Processor);
+	}
+}
+
+void FUltraleapDevice::RemoveFrameProcessor(const TSharedPtr<ILeapFrameProcessor>& Processor)
+{
+	if (CustomFrameProcessors.Remove(Processor) > 0)
+	{
+		FrameProcessors.Remove(Processor);
+	}
+}
+
+bool FUltraleapDevice::GetImagesForFrame(const int64 FrameId, FLeapImagePair& OutImages)
+{
+	if (!LeapImageHandler.IsValid())
+	{
+		return false;
+	}
+	return LeapImageHandler->History.FindByFrameId(FrameId, OutImages);
+}
 void FUltraleapDevice::OnDeviceDetach()
 {
 	ShutdownLeap();
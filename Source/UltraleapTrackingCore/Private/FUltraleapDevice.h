@@ -15,6 +15,8 @@
 #include "IXRTrackingSystem.h"
 #include "LeapC.h"
 #include "LeapComponent.h"
+#include "LeapFramePacer.h"
+#include "LeapFrameProcessor.h"
 #include "LeapImage.h"
 #include "LeapLiveLink.h"
 #include "LeapUtility.h"
@@ -73,6 +75,9 @@ public:
 	{
 		NumCombinedLeft = NumCombinedRight = 0;
 	}
+	virtual bool GetImagesForFrame(const int64 FrameId, FLeapImagePair& OutImages) override;
+	virtual void AddFrameProcessor(const TSharedPtr<ILeapFrameProcessor>& Processor) override;
+	virtual void RemoveFrameProcessor(const TSharedPtr<ILeapFrameProcessor>& Processor) override;
 	virtual int32 GetBodyStateDeviceID() override
 	{
 		return BodyStateDeviceId;
@@ -102,6 +107,11 @@ public:
 protected:
 	FLeapFrameData CurrentFrame;
 	float DeltaTimeFromTick;
+	FLeapStats Stats;
+
+	void UpdateInterpolationTimeOffsets();
+	// the Leap time hands are interpolated to, i.e. when they are expected to be on screen
+	int64 GetInterpolatedNow();
 
 private:
 	bool UseTimeBasedVisibilityCheck = false;
@@ -148,11 +158,8 @@ private:
 	void CheckPinchGesture();
 	void CheckGrabGesture();
 
-	int64 GetInterpolatedNow();
-
 	// Internal states
 	FLeapOptions Options;
-	FLeapStats Stats;
 
 	// Interpolation time offsets
 	int64 HandInterpolationTimeOffset;		// in microseconds
@@ -170,6 +177,8 @@ private:
 	LeapUtilityTimer FrameTimer;
 	double GameTimeInSec;
 	int64 FrameTimeInMicros;
+	// Interpolation offset for LEAP_ADAPTIVE fidelity
+	FLeapFramePacer FramePacer;
 
 	// Game thread Data
 	
@@ -181,7 +190,7 @@ private:
 	BSHMDSnapshotHandler SnapshotHandler;
 
 	// Image handling
-	TSharedPtr<FLeapImage> LeapImageHandler;
+	TSharedPtr<FLeapImage, ESPMode::ThreadSafe> LeapImageHandler;
 	void OnImageCallback(UTexture2D* LeftCapturedTexture, UTexture2D* RightCapturedTexture);
 
 	// v5 Tracking mode API
@@ -203,10 +212,25 @@ private:
 	int32 BodyStateDeviceId;
 	FBodyStateDeviceConfig Config;
 	ELeapDeviceType DeviceType = ELeapDeviceType::LEAP_DEVICE_TYPE_UNKNOWN;
-#if WITH_EDITOR
 	// LiveLink
 	TSharedPtr<FLeapLiveLinkProducer> LiveLink;
-#endif
+
+	// Streaming to external consumers, only created while Options.bStreamFrames is set
+	TSharedPtr<class FLeapFrameStreamer> FrameStreamer;
+	void UpdateFrameStreamer();
+
+	// Run on CurrentFrame before it is published, the stages from Options.FrameProcessors then the custom ones.
+	// Built in stages are kept while unused so their state survives option changes, except predict which is dropped: its
+	// history would extrapolate from stale frames when it came back, and its validity marks the stage active for stats
+	FLeapFrameProcessorChain FrameProcessors;
+	TSharedPtr<FLeapFilterFrameProcessor> FilterProcessor;
+	TSharedPtr<FLeapClampFrameProcessor> ClampProcessor;
+	TSharedPtr<FLeapMirrorFrameProcessor> MirrorProcessor;
+	TSharedPtr<FLeapScaleFrameProcessor> ScaleProcessor;
+	TSharedPtr<FLeapPredictFrameProcessor> PredictProcessor;
+	TArray<TSharedPtr<ILeapFrameProcessor>> CustomFrameProcessors;
+	void UpdateFrameProcessors();
+	TSharedPtr<ILeapFrameProcessor> GetBuiltInFrameProcessor(const ELeapFrameProcessor Type);
 
 	// Convenience Converters - Todo: wrap into separate class?
 	void SetBSFingerFromLeapDigit(class UBodyStateFinger* Finger, const FLeapDigitData& LeapDigit);
@@ -18,8 +18,8 @@
 #include "LeapUtility.h"
 #include "Skeleton/BodyStateSkeleton.h"
 #include "UltraleapTrackingData.h"
+#include "UltraleapTrackingStats.h"
 
-DECLARE_STATS_GROUP(TEXT("UltraleapTracking"), STATGROUP_UltraleapTracking, STATCAT_Advanced);
 DECLARE_CYCLE_STAT(TEXT("Leap Game Input and Events"), STAT_LeapInputTick, STATGROUP_UltraleapTracking);
 DECLARE_CYCLE_STAT(TEXT("Leap BodyState Tick"), STAT_LeapBodyStateTick, STATGROUP_UltraleapTracking);
 
@@ -477,6 +477,12 @@ int32 FUltraleapTrackingInputDevice::RequestCombinedDevice(
 		case EBSDeviceCombinerClass::BS_DEVICE_COMBINER_ANGULAR:
 			LeapCombinerClass = ELeapDeviceCombinerClass::LEAP_DEVICE_COMBINER_ANGULAR;
 			break;
+		case EBSDeviceCombinerClass::BS_DEVICE_COMBINER_SPATIAL:
+			LeapCombinerClass = ELeapDeviceCombinerClass::LEAP_DEVICE_COMBINER_SPATIAL;
+			break;
+		case EBSDeviceCombinerClass::BS_DEVICE_COMBINER_KALMAN:
+			LeapCombinerClass = ELeapDeviceCombinerClass::LEAP_DEVICE_COMBINER_KALMAN;
+			break;
 	}
 	auto DeviceWrapper = Connector->GetDevice(DeviceSerials, LeapCombinerClass, IsInOpenXRMode);
 	if (DeviceWrapper)
@@ -588,4 +594,36 @@ FLeapStats FUltraleapTrackingInputDevice::GetStats(const FString& DeviceSerial)
 	return Stats;
 }
 
+bool FUltraleapTrackingInputDevice::GetImagesForFrame(const FString& DeviceSerial, const int64 FrameId, FLeapImagePair& OutImages)
+{
+	IHandTrackingDevice* Device = GetDeviceBySerial(DeviceSerial);
+	if (Device)
+	{
+		return Device->GetImagesForFrame(FrameId, OutImages);
+	}
+	return false;
+}
+
+bool FUltraleapTrackingInputDevice::AddFrameProcessor(const FString& DeviceSerial, const TSharedPtr<ILeapFrameProcessor>& Processor)
+{
+	IHandTrackingDevice* Device = GetDeviceBySerial(DeviceSerial);
+	if (Device && Processor.IsValid())
+	{
+		Device->AddFrameProcessor(Processor);
+		return true;
+	}
+	return false;
+}
+
+bool FUltraleapTrackingInputDevice::RemoveFrameProcessor(const FString& DeviceSerial, const TSharedPtr<ILeapFrameProcessor>& Processor)
+{
+	IHandTrackingDevice* Device = GetDeviceBySerial(DeviceSerial);
+	if (Device)
+	{
+		Device->RemoveFrameProcessor(Processor);
+		return true;
+	}
+	return false;
+}
+
 #pragma endregion Leap Input Device
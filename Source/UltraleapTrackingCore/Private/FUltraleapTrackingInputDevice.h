@@ -79,6 +79,9 @@ public:
 	void SetOptions(const FLeapOptions& Options, const TArray<FString>& DeviceSerials);
 	FLeapOptions GetOptions(const FString& DeviceSerial);
 	FLeapStats GetStats(const FString& DeviceSerial);
+	bool GetImagesForFrame(const FString& DeviceSerial, const int64 FrameId, FLeapImagePair& OutImages);
+	bool AddFrameProcessor(const FString& DeviceSerial, const TSharedPtr<ILeapFrameProcessor>& Processor);
+	bool RemoveFrameProcessor(const FString& DeviceSerial, const TSharedPtr<ILeapFrameProcessor>& Processor);
 	const TArray<FString>& GetAttachedDevices()
 	{
 		return AttachedDevices;
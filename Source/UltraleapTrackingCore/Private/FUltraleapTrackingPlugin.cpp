@@ -128,6 +128,33 @@ FLeapStats FUltraleapTrackingPlugin::GetLeapStats(const FString& DeviceSerial)
 	}
 }
 
+bool FUltraleapTrackingPlugin::GetImagesForFrame(const FString& DeviceSerial, const int64 FrameId, FLeapImagePair& OutImages)
+{
+	if (bActive)
+	{
+		return LeapInputDevice->GetImagesForFrame(DeviceSerial, FrameId, OutImages);
+	}
+	return false;
+}
+
+bool FUltraleapTrackingPlugin::AddFrameProcessor(const FString& DeviceSerial, const TSharedPtr<ILeapFrameProcessor>& Processor)
+{
+	if (bActive)
+	{
+		return LeapInputDevice->AddFrameProcessor(DeviceSerial, Processor);
+	}
+	return false;
+}
+
+bool FUltraleapTrackingPlugin::RemoveFrameProcessor(const FString& DeviceSerial, const TSharedPtr<ILeapFrameProcessor>& Processor)
+{
+	if (bActive)
+	{
+		return LeapInputDevice->RemoveFrameProcessor(DeviceSerial, Processor);
+	}
+	return false;
+}
+
 void FUltraleapTrackingPlugin::SetOptions(const FLeapOptions& Options, const TArray<FString>& DeviceSerials)
 {
 	if (bActive)
@@ -25,6 +25,9 @@ public:
 	virtual void AddEventDelegate(const ULeapComponent* EventDelegate) override;
 	virtual void RemoveEventDelegate(const ULeapComponent* EventDelegate) override;
 	virtual FLeapStats GetLeapStats(const FString& DeviceSerial) override;
+	virtual bool GetImagesForFrame(const FString& DeviceSerial, const int64 FrameId, FLeapImagePair& OutImages) override;
+	virtual bool AddFrameProcessor(const FString& DeviceSerial, const TSharedPtr<ILeapFrameProcessor>& Processor) override;
+	virtual bool RemoveFrameProcessor(const FString& DeviceSerial, const TSharedPtr<ILeapFrameProcessor>& Processor) override;
 	virtual void SetOptions(const FLeapOptions& Options, const TArray<FString>& DeviceSerials) override;
 	virtual FLeapOptions GetOptions(const FString& DeviceSerial) override;
 	virtual void AreHandsVisible(bool& LeftHandIsVisible, bool& RightHandIsVisible, const FString& DeviceSerial) override;
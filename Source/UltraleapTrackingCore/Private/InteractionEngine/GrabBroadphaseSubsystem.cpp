@@ -0,0 +1,558 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "InteractionEngine/GrabBroadphaseSubsystem.h"
+
+#include "Components/PrimitiveComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "LeapUtility.h"
+#include "Math/RandomStream.h"
+#include "UltraleapTrackingStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("IE Broadphase Refresh"), STAT_IEBroadphaseRefresh, STATGROUP_UltraleapTracking);
+DECLARE_CYCLE_STAT(TEXT("IE Broadphase Query"), STAT_IEBroadphaseQuery, STATGROUP_UltraleapTracking);
+DECLARE_DWORD_COUNTER_STAT(TEXT("IE Broadphase Candidates"), STAT_IEBroadphaseCandidates, STATGROUP_UltraleapTracking);
+
+FIEGrabBroadphaseGrid::FIEGrabBroadphaseGrid(const float InCellSize)
+{
+	CellSize = FMath::Max(InCellSize, 1.0f);
+	InvCellSize = 1.0f / CellSize;
+}
+
+void FIEGrabBroadphaseGrid::SetCellSize(const float InCellSize)
+{
+	const float NewCellSize = FMath::Max(InCellSize, 1.0f);
+	if (NewCellSize == CellSize)
+	{
+		return;
+	}
+	CellSize = NewCellSize;
+	InvCellSize = 1.0f / CellSize;
+
+	Cells.Reset();
+	Oversized.Reset();
+	for (int32 Id = 0; Id < Items.Num(); ++Id)
+	{
+		if (Items[Id].bUsed)
+		{
+			Link(Id);
+		}
+	}
+}
+
+FIntVector FIEGrabBroadphaseGrid::ToCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt(Location.X * InvCellSize), FMath::FloorToInt(Location.Y * InvCellSize),
+		FMath::FloorToInt(Location.Z * InvCellSize));
+}
+
+int32 FIEGrabBroadphaseGrid::Add(const FBox& Box)
+{
+	const int32 Id = FreeIds.Num() ? FreeIds.Pop() : Items.AddDefaulted();
+	FItem& Item = Items[Id];
+	Item.Box = Box;
+	Item.QueryStamp = 0;
+	Item.bUsed = true;
+	Link(Id);
+	NumItems++;
+	return Id;
+}
+
+void FIEGrabBroadphaseGrid::Update(const int32 Id, const FBox& Box)
+{
+	FItem& Item = Items[Id];
+	if (!Item.bOversized && ToCell(Box.Min) == Item.MinCell && ToCell(Box.Max) == Item.MaxCell)
+	{
+		// still in the same cells, the common case for props being nudged around
+		Item.Box = Box;
+		return;
+	}
+	Unlink(Id);
+	Item.Box = Box;
+	Link(Id);
+}
+
+void FIEGrabBroadphaseGrid::Remove(const int32 Id)
+{
+	if (!Items.IsValidIndex(Id) || !Items[Id].bUsed)
+	{
+		return;
+	}
+	Unlink(Id);
+	Items[Id].bUsed = false;
+	FreeIds.Add(Id);
+	NumItems--;
+}
+
+void FIEGrabBroadphaseGrid::Reset()
+{
+	Items.Reset();
+	FreeIds.Reset();
+	Cells.Reset();
+	Oversized.Reset();
+	NumItems = 0;
+}
+
+void FIEGrabBroadphaseGrid::Link(const int32 Id)
+{
+	FItem& Item = Items[Id];
+	Item.MinCell = ToCell(Item.Box.Min);
+	Item.MaxCell = ToCell(Item.Box.Max);
+
+	const FIntVector Span = Item.MaxCell - Item.MinCell + FIntVector(1);
+	Item.bOversized = (int64) Span.X * Span.Y * Span.Z > MaxCellsPerItem;
+	if (Item.bOversized)
+	{
+		Oversized.Add(Id);
+		return;
+	}
+	for (int32 X = Item.MinCell.X; X <= Item.MaxCell.X; ++X)
+	{
+		for (int32 Y = Item.MinCell.Y; Y <= Item.MaxCell.Y; ++Y)
+		{
+			for (int32 Z = Item.MinCell.Z; Z <= Item.MaxCell.Z; ++Z)
+			{
+				Cells.FindOrAdd(FIntVector(X, Y, Z)).Add(Id);
+			}
+		}
+	}
+}
+
+void FIEGrabBroadphaseGrid::Unlink(const int32 Id)
+{
+	const FItem& Item = Items[Id];
+	if (Item.bOversized)
+	{
+		Oversized.RemoveSingleSwap(Id);
+		return;
+	}
+	for (int32 X = Item.MinCell.X; X <= Item.MaxCell.X; ++X)
+	{
+		for (int32 Y = Item.MinCell.Y; Y <= Item.MaxCell.Y; ++Y)
+		{
+			for (int32 Z = Item.MinCell.Z; Z <= Item.MaxCell.Z; ++Z)
+			{
+				const FIntVector Cell(X, Y, Z);
+				TArray<int32>* CellIds = Cells.Find(Cell);
+				if (!CellIds)
+				{
+					continue;
+				}
+				CellIds->RemoveSingleSwap(Id);
+				if (!CellIds->Num())
+				{
+					Cells.Remove(Cell);
+				}
+			}
+		}
+	}
+}
+
+void FIEGrabBroadphaseGrid::Visit(const int32 Id, const FBox& QueryBox, TArray<int32>& OutIds)
+{
+	FItem& Item = Items[Id];
+	if (Item.QueryStamp == QueryStamp)
+	{
+		return;
+	}
+	Item.QueryStamp = QueryStamp;
+	if (Item.Box.Intersect(QueryBox))
+	{
+		OutIds.Add(Id);
+	}
+}
+
+void FIEGrabBroadphaseGrid::Query(const FBox& QueryBox, TArray<int32>& OutIds)
+{
+	OutIds.Reset();
+	if (!NumItems || !QueryBox.IsValid)
+	{
+		return;
+	}
+
+	// stamps dedupe items spanning several cells without a set
+	if (++QueryStamp == 0)
+	{
+		for (FItem& Item : Items)
+		{
+			Item.QueryStamp = 0;
+		}
+		QueryStamp = 1;
+	}
+
+	for (const int32 Id : Oversized)
+	{
+		Visit(Id, QueryBox, OutIds);
+	}
+
+	const FIntVector MinCell = ToCell(QueryBox.Min);
+	const FIntVector MaxCell = ToCell(QueryBox.Max);
+	const FIntVector Span = MaxCell - MinCell + FIntVector(1);
+	if ((int64) Span.X * Span.Y * Span.Z > Cells.Num())
+	{
+		// huge query, cheaper to walk the occupied cells
+		for (const TPair<FIntVector, TArray<int32>>& Cell : Cells)
+		{
+			for (const int32 Id : Cell.Value)
+			{
+				Visit(Id, QueryBox, OutIds);
+			}
+		}
+		return;
+	}
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+			{
+				if (const TArray<int32>* CellIds = Cells.Find(FIntVector(X, Y, Z)))
+				{
+					for (const int32 Id : *CellIds)
+					{
+						Visit(Id, QueryBox, OutIds);
+					}
+				}
+			}
+		}
+	}
+}
+
+UIEGrabBroadphaseSubsystem* UIEGrabBroadphaseSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull) : nullptr;
+	return World ? World->GetSubsystem<UIEGrabBroadphaseSubsystem>() : nullptr;
+}
+
+void UIEGrabBroadphaseSubsystem::Deinitialize()
+{
+	Grid.Reset();
+	GridPrimitives.Reset();
+	GridIds.Reset();
+	MovableIds.Reset();
+	StaleIds.Reset();
+	Super::Deinitialize();
+}
+
+void UIEGrabBroadphaseSubsystem::RegisterGraspable(UPrimitiveComponent* Primitive)
+{
+	if (!Primitive || GridIds.Contains(Primitive))
+	{
+		return;
+	}
+	const int32 Id = Grid.Add(Primitive->Bounds.GetBox());
+	if (GridPrimitives.Num() <= Id)
+	{
+		GridPrimitives.SetNum(Id + 1);
+	}
+	GridPrimitives[Id].Primitive = Primitive;
+	GridPrimitives[Id].Key = Primitive;
+	GridIds.Add(Primitive, Id);
+	if (Primitive->Mobility == EComponentMobility::Movable)
+	{
+		MovableIds.Add(Id);
+	}
+}
+
+void UIEGrabBroadphaseSubsystem::UnregisterGraspable(UPrimitiveComponent* Primitive)
+{
+	const int32* Id = GridIds.Find(Primitive);
+	if (Id)
+	{
+		RemoveById(*Id);
+	}
+}
+
+void UIEGrabBroadphaseSubsystem::RemoveById(const int32 Id)
+{
+	GridIds.Remove(GridPrimitives[Id].Key);
+	GridPrimitives[Id] = FGraspable();
+	MovableIds.RemoveSingleSwap(Id);
+	Grid.Remove(Id);
+}
+
+bool UIEGrabBroadphaseSubsystem::IsGraspableRegistered(UPrimitiveComponent* Primitive) const
+{
+	return GridIds.Contains(Primitive);
+}
+
+int32 UIEGrabBroadphaseSubsystem::GetNumGraspables() const
+{
+	return Grid.Num();
+}
+
+void UIEGrabBroadphaseSubsystem::SetCellSize(const float CellSize)
+{
+	Grid.SetCellSize(CellSize);
+}
+
+void UIEGrabBroadphaseSubsystem::RefreshBounds()
+{
+	// both hands and any blueprint queries share one refresh per frame
+	if (LastRefreshFrame == GFrameCounter)
+	{
+		return;
+	}
+	LastRefreshFrame = GFrameCounter;
+
+	SCOPE_CYCLE_COUNTER(STAT_IEBroadphaseRefresh);
+
+	// static graspables destroyed without unregistering, found by the last queries
+	for (const int32 Id : StaleIds)
+	{
+		if (GridPrimitives.IsValidIndex(Id) && GridIds.Contains(GridPrimitives[Id].Key) && !GridPrimitives[Id].Primitive.IsValid())
+		{
+			RemoveById(Id);
+		}
+	}
+	StaleIds.Reset();
+
+	for (int32 Index = MovableIds.Num() - 1; Index >= 0; --Index)
+	{
+		const int32 Id = MovableIds[Index];
+		UPrimitiveComponent* Primitive = GridPrimitives[Id].Primitive.Get();
+		if (!Primitive)
+		{
+			// destroyed without unregistering
+			RemoveById(Id);
+			continue;
+		}
+		// sleeping bodies haven't moved
+		if (Primitive->IsSimulatingPhysics() && !Primitive->RigidBodyIsAwake())
+		{
+			continue;
+		}
+		// bounds are only recomputed when the component moves, most movable props sit still
+		const FBox Box = Primitive->Bounds.GetBox();
+		const FBox& GridBox = Grid.GetBox(Id);
+		if (Box.Min == GridBox.Min && Box.Max == GridBox.Max)
+		{
+			continue;
+		}
+		Grid.Update(Id, Box);
+	}
+}
+
+void UIEGrabBroadphaseSubsystem::QuerySphere(const FVector& Center, const float Radius, TArray<UPrimitiveComponent*>& OutPrimitives)
+{
+	SCOPE_CYCLE_COUNTER(STAT_IEBroadphaseQuery);
+	OutPrimitives.Reset();
+	RefreshBounds();
+
+	Grid.Query(FBox(Center - FVector(Radius), Center + FVector(Radius)), ScratchIds);
+	const float RadiusSquared = FMath::Square(Radius);
+	for (const int32 Id : ScratchIds)
+	{
+		UPrimitiveComponent* Primitive = GridPrimitives[Id].Primitive.Get();
+		if (!Primitive)
+		{
+			StaleIds.AddUnique(Id);
+			continue;
+		}
+		if (FMath::SphereAABBIntersection(Center, RadiusSquared, Grid.GetBox(Id)))
+		{
+			OutPrimitives.Add(Primitive);
+		}
+	}
+}
+
+bool UIEGrabBroadphaseSubsystem::GatherProbeCandidates(const TArray<FVector>& Locations, const TArray<float>& Radii)
+{
+	ScratchIds.Reset();
+	if (Radii.Num() != Locations.Num())
+	{
+		UE_LOG(UltraleapTrackingLog, Warning, TEXT("UIEGrabBroadphaseSubsystem expects one radius per probe (%d vs %d)"),
+			Radii.Num(), Locations.Num());
+		return false;
+	}
+	if (!Locations.Num())
+	{
+		return false;
+	}
+	RefreshBounds();
+
+	// one grid walk for the region covering every probe of the hand
+	FBox Region(ForceInit);
+	for (int32 Index = 0; Index < Locations.Num(); ++Index)
+	{
+		Region += FBox(Locations[Index] - FVector(Radii[Index]), Locations[Index] + FVector(Radii[Index]));
+	}
+	Grid.Query(Region, ScratchIds);
+	INC_DWORD_STAT_BY(STAT_IEBroadphaseCandidates, ScratchIds.Num());
+	return ScratchIds.Num() > 0;
+}
+
+bool UIEGrabBroadphaseSubsystem::ProbeOverlaps(
+	UPrimitiveComponent* Primitive, const FBox& Box, const FVector& Location, const float Radius) const
+{
+	if (!FMath::SphereAABBIntersection(Location, FMath::Square(Radius), Box))
+	{
+		return false;
+	}
+	return !bPreciseOverlap || Primitive->OverlapComponent(Location, FQuat::Identity, FCollisionShape::MakeSphere(Radius));
+}
+
+void UIEGrabBroadphaseSubsystem::QueryProbes(
+	const TArray<FVector>& Locations, const TArray<float>& Radii, TArray<UPrimitiveComponent*>& OutHits)
+{
+	SCOPE_CYCLE_COUNTER(STAT_IEBroadphaseQuery);
+	OutHits.Reset();
+	OutHits.SetNumZeroed(Locations.Num());
+	if (!GatherProbeCandidates(Locations, Radii))
+	{
+		return;
+	}
+
+	for (const int32 Id : ScratchIds)
+	{
+		UPrimitiveComponent* Primitive = GridPrimitives[Id].Primitive.Get();
+		if (!Primitive)
+		{
+			StaleIds.AddUnique(Id);
+			continue;
+		}
+		if (Primitive->GetCollisionEnabled() == ECollisionEnabled::NoCollision)
+		{
+			continue;
+		}
+		const FBox& Box = Grid.GetBox(Id);
+		for (int32 Index = 0; Index < Locations.Num(); ++Index)
+		{
+			if (!OutHits[Index] && ProbeOverlaps(Primitive, Box, Locations[Index], Radii[Index]))
+			{
+				OutHits[Index] = Primitive;
+			}
+		}
+	}
+}
+
+void UIEGrabBroadphaseSubsystem::QueryProbeContacts(
+	const TArray<FVector>& Locations, const TArray<float>& Radii, TArray<FIEProbeContact>& OutContacts)
+{
+	SCOPE_CYCLE_COUNTER(STAT_IEBroadphaseQuery);
+	OutContacts.Reset();
+	if (!GatherProbeCandidates(Locations, Radii))
+	{
+		return;
+	}
+
+	for (const int32 Id : ScratchIds)
+	{
+		UPrimitiveComponent* Primitive = GridPrimitives[Id].Primitive.Get();
+		if (!Primitive)
+		{
+			StaleIds.AddUnique(Id);
+			continue;
+		}
+		if (Primitive->GetCollisionEnabled() == ECollisionEnabled::NoCollision)
+		{
+			continue;
+		}
+		const FBox& Box = Grid.GetBox(Id);
+		for (int32 Index = 0; Index < Locations.Num(); ++Index)
+		{
+			if (ProbeOverlaps(Primitive, Box, Locations[Index], Radii[Index]))
+			{
+				OutContacts.Add({Index, Primitive});
+			}
+		}
+	}
+}
+
+// Synthetic benchmark of the grid against testing every prop per probe, which is what the
+// overlap list approach costs the physics scene. Usage: IE.BroadphaseBenchmark [NumProps]
+static void RunGrabBroadphaseBenchmark(const int32 NumProps)
+{
+	const int32 NumTicks = 1000;
+	const int32 NumProbes = 10;
+	const float WorldExtent = 1000.0f;
+
+	FRandomStream Random(NumProps);
+	FIEGrabBroadphaseGrid Grid;
+	TArray<FBox> Boxes;
+	Boxes.Reserve(NumProps);
+	for (int32 Index = 0; Index < NumProps; ++Index)
+	{
+		const FVector Center = FVector(Random.FRandRange(-WorldExtent, WorldExtent), Random.FRandRange(-WorldExtent, WorldExtent),
+			Random.FRandRange(0.0f, 200.0f));
+		const FVector Extent = FVector(Random.FRandRange(2.5f, 15.0f));
+		Boxes.Add(FBox(Center - Extent, Center + Extent));
+		Grid.Add(Boxes.Last());
+	}
+
+	// two hands worth of fingertips wandering around
+	TArray<FVector> Probes;
+	Probes.SetNum(NumTicks * NumProbes);
+	for (int32 Tick = 0; Tick < NumTicks; ++Tick)
+	{
+		const FVector Hand = FVector(Random.FRandRange(-WorldExtent, WorldExtent), Random.FRandRange(-WorldExtent, WorldExtent),
+			Random.FRandRange(0.0f, 200.0f));
+		for (int32 Probe = 0; Probe < NumProbes; ++Probe)
+		{
+			Probes[Tick * NumProbes + Probe] = Hand + Random.GetUnitVector() * 10.0f;
+		}
+	}
+	const float RadiusSquared = FMath::Square(1.2f);
+
+	int32 BruteHits = 0;
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 Tick = 0; Tick < NumTicks; ++Tick)
+	{
+		for (int32 Probe = 0; Probe < NumProbes; ++Probe)
+		{
+			for (const FBox& Box : Boxes)
+			{
+				BruteHits += FMath::SphereAABBIntersection(Probes[Tick * NumProbes + Probe], RadiusSquared, Box);
+			}
+		}
+	}
+	const double BruteTime = FPlatformTime::Seconds() - StartTime;
+
+	int32 GridHits = 0;
+	int64 Candidates = 0;
+	TArray<int32> Ids;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Tick = 0; Tick < NumTicks; ++Tick)
+	{
+		FBox Region(ForceInit);
+		for (int32 Probe = 0; Probe < NumProbes; ++Probe)
+		{
+			const FVector& Location = Probes[Tick * NumProbes + Probe];
+			Region += FBox(Location - FVector(1.2f), Location + FVector(1.2f));
+		}
+		Grid.Query(Region, Ids);
+		Candidates += Ids.Num();
+		for (const int32 Id : Ids)
+		{
+			for (int32 Probe = 0; Probe < NumProbes; ++Probe)
+			{
+				GridHits += FMath::SphereAABBIntersection(Probes[Tick * NumProbes + Probe], RadiusSquared, Grid.GetBox(Id));
+			}
+		}
+	}
+	const double GridTime = FPlatformTime::Seconds() - StartTime;
+
+	UE_LOG(UltraleapTrackingLog, Log,
+		TEXT("IE.BroadphaseBenchmark %d props: brute force %.4fms/tick, grid %.4fms/tick (%.1f candidates/query), hits %d/%d"),
+		NumProps, BruteTime * 1000.0 / NumTicks, GridTime * 1000.0 / NumTicks, (double) Candidates / NumTicks, GridHits,
+		BruteHits);
+}
+
+static FAutoConsoleCommand GrabBroadphaseBenchmarkCommand(TEXT("IE.BroadphaseBenchmark"),
+	TEXT("Time the grab broadphase grid against brute force probe tests, defaults to 1000 and 10000 props"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args) {
+		if (Args.Num())
+		{
+			RunGrabBroadphaseBenchmark(FMath::Max(FCString::Atoi(*Args[0]), 1));
+			return;
+		}
+		RunGrabBroadphaseBenchmark(1000);
+		RunGrabBroadphaseBenchmark(10000);
+	}));
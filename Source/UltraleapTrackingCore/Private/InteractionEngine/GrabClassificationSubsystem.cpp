@@ -0,0 +1,359 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "InteractionEngine/GrabClassificationSubsystem.h"
+
+#include "Components/PrimitiveComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "LeapUtility.h"
+#include "UltraleapTrackingStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("IE Grab Classification"), STAT_IEGrabClassification, STATGROUP_UltraleapTracking);
+DECLARE_DWORD_COUNTER_STAT(TEXT("IE Grab Classifiers"), STAT_IEGrabClassifiers, STATGROUP_UltraleapTracking);
+
+// thumb plus any finger inside is a grab
+static const uint8 ThumbProbeMask = 0x1;
+static const uint8 FingerProbesMask = 0x1E;
+
+UIEGrabClassificationSubsystem* UIEGrabClassificationSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull) : nullptr;
+	return World ? World->GetSubsystem<UIEGrabClassificationSubsystem>() : nullptr;
+}
+
+void UIEGrabClassificationSubsystem::Deinitialize()
+{
+	while (PairHand.Num())
+	{
+		RemovePair(PairHand.Num() - 1);
+	}
+	HandUsed.Reset();
+	FreeHandIds.Reset();
+	Super::Deinitialize();
+}
+
+TStatId UIEGrabClassificationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UIEGrabClassificationSubsystem, STATGROUP_Tickables);
+}
+
+bool UIEGrabClassificationSubsystem::IsTickable() const
+{
+	return !IsTemplate() && HandUsed.Num() > FreeHandIds.Num();
+}
+
+UWorld* UIEGrabClassificationSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+bool UIEGrabClassificationSubsystem::IsValidHand(const int32 HandId) const
+{
+	return HandUsed.IsValidIndex(HandId) && HandUsed[HandId];
+}
+
+int32 UIEGrabClassificationSubsystem::RegisterHand(const FGrabClassifierParams& Params)
+{
+	int32 HandId;
+	if (FreeHandIds.Num())
+	{
+		HandId = FreeHandIds.Pop();
+	}
+	else
+	{
+		HandId = HandUsed.AddDefaulted();
+		HandParams.AddDefaulted();
+		HandForward.AddDefaulted();
+		HandRight.AddDefaulted();
+		HandIgnoreTemporal.AddDefaulted();
+		HandUpdatedFrame.AddDefaulted();
+		HandContacts.AddDefaulted();
+		ProbeLocations.AddDefaulted(NumProbes);
+		ProbeDirections.AddDefaulted(NumProbes);
+		ProbeCurls.AddDefaulted(NumProbes);
+		ProbePrevCurls.AddDefaulted(NumProbes);
+		ProbeCurlVelocities.AddDefaulted(NumProbes);
+	}
+	HandUsed[HandId] = true;
+	HandParams[HandId] = Params;
+	HandIgnoreTemporal[HandId] = false;
+	HandUpdatedFrame[HandId] = MAX_uint64;
+	HandContacts[HandId] = 0;
+	for (int32 Probe = 0; Probe < NumProbes; ++Probe)
+	{
+		ProbePrevCurls[HandId * NumProbes + Probe] = 0;
+	}
+	return HandId;
+}
+
+void UIEGrabClassificationSubsystem::UnregisterHand(const int32 HandId)
+{
+	if (!IsValidHand(HandId))
+	{
+		return;
+	}
+	ForceResetHand(HandId);
+	HandUsed[HandId] = false;
+	FreeHandIds.Add(HandId);
+}
+
+void UIEGrabClassificationSubsystem::SetHandParams(const int32 HandId, const FGrabClassifierParams& Params)
+{
+	if (IsValidHand(HandId))
+	{
+		HandParams[HandId] = Params;
+	}
+}
+
+void UIEGrabClassificationSubsystem::UpdateHand(const int32 HandId, const USceneComponent* Hand,
+	const TArray<FVector>& InProbeLocations, const TArray<FVector>& InProbeDirections, const bool IgnoreTemporal)
+{
+	if (!IsValidHand(HandId) || !Hand)
+	{
+		return;
+	}
+	if (InProbeLocations.Num() != NumProbes || InProbeDirections.Num() != NumProbes)
+	{
+		UE_LOG(UltraleapTrackingLog, Warning, TEXT("UIEGrabClassificationSubsystem::UpdateHand expects %d probes"), NumProbes);
+		return;
+	}
+	HandForward[HandId] = Hand->GetForwardVector();
+	HandRight[HandId] = Hand->GetRightVector();
+	HandIgnoreTemporal[HandId] = IgnoreTemporal;
+	HandUpdatedFrame[HandId] = GFrameCounter;
+	FMemory::Memcpy(&ProbeLocations[HandId * NumProbes], InProbeLocations.GetData(), sizeof(FVector) * NumProbes);
+	FMemory::Memcpy(&ProbeDirections[HandId * NumProbes], InProbeDirections.GetData(), sizeof(FVector) * NumProbes);
+}
+
+void UIEGrabClassificationSubsystem::ForceResetHand(const int32 HandId)
+{
+	for (int32 PairIndex = PairHand.Num() - 1; PairIndex >= 0; --PairIndex)
+	{
+		if (PairHand[PairIndex] == HandId)
+		{
+			RemovePair(PairIndex);
+		}
+	}
+}
+
+bool UIEGrabClassificationSubsystem::IsHandGrabbing(const int32 HandId, UPrimitiveComponent* Object) const
+{
+	const int32* PairIndex = PairLookup.Find(TPair<int32, TObjectKey<UPrimitiveComponent>>(HandId, Object));
+	return PairIndex && PairGrabbing[*PairIndex];
+}
+
+int32 UIEGrabClassificationSubsystem::FindOrAddPair(const int32 HandId, UPrimitiveComponent* Object)
+{
+	const TPair<int32, TObjectKey<UPrimitiveComponent>> Key(HandId, Object);
+	if (const int32* Found = PairLookup.Find(Key))
+	{
+		return *Found;
+	}
+	const int32 PairIndex = PairHand.Add(HandId);
+	PairObject.Add(Object);
+	PairObjectKey.Add(Object);
+	PairContacts.Add(0);
+	PairInside.Add(0);
+	PairGrabbing.Add(false);
+	// nothing to cool down from
+	PairCoolDown.Add(MAX_flt);
+	PairStickyCurls.AddZeroed(NumProbes);
+	PairLookup.Add(Key, PairIndex);
+	return PairIndex;
+}
+
+void UIEGrabClassificationSubsystem::RemovePair(const int32 PairIndex)
+{
+	PairLookup.Remove(TPair<int32, TObjectKey<UPrimitiveComponent>>(PairHand[PairIndex], PairObjectKey[PairIndex]));
+
+	const int32 LastIndex = PairHand.Num() - 1;
+	if (PairIndex != LastIndex)
+	{
+		// swap the last pair into the hole to keep the arrays dense
+		PairHand[PairIndex] = PairHand[LastIndex];
+		PairObject[PairIndex] = PairObject[LastIndex];
+		PairObjectKey[PairIndex] = PairObjectKey[LastIndex];
+		PairContacts[PairIndex] = PairContacts[LastIndex];
+		PairInside[PairIndex] = PairInside[LastIndex];
+		PairGrabbing[PairIndex] = PairGrabbing[LastIndex];
+		PairCoolDown[PairIndex] = PairCoolDown[LastIndex];
+		FMemory::Memcpy(&PairStickyCurls[PairIndex * NumProbes], &PairStickyCurls[LastIndex * NumProbes], sizeof(float) * NumProbes);
+		PairLookup.Add(TPair<int32, TObjectKey<UPrimitiveComponent>>(PairHand[PairIndex], PairObjectKey[PairIndex]), PairIndex);
+	}
+	PairHand.Pop();
+	PairObject.Pop();
+	PairObjectKey.Pop();
+	PairContacts.Pop();
+	PairInside.Pop();
+	PairGrabbing.Pop();
+	PairCoolDown.Pop();
+	PairStickyCurls.SetNum(LastIndex * NumProbes);
+}
+
+void UIEGrabClassificationSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_IEGrabClassification);
+	GrabEvents.Reset();
+
+	UpdateCurls();
+	UpdateContacts();
+	ClassifyPairs(DeltaTime);
+	CullPairs();
+
+	SET_DWORD_STAT(STAT_IEGrabClassifiers, PairHand.Num());
+	if (GrabEvents.Num())
+	{
+		OnGrabEventsNative.Broadcast(GrabEvents);
+		OnGrabEvents.Broadcast(GrabEvents);
+	}
+}
+
+void UIEGrabClassificationSubsystem::UpdateCurls()
+{
+	// curl only depends on the hand, so it's computed once per probe and shared by every object the hand touches
+	for (int32 HandId = 0; HandId < HandUsed.Num(); ++HandId)
+	{
+		if (!HandUsed[HandId] || HandUpdatedFrame[HandId] != GFrameCounter)
+		{
+			continue;
+		}
+		const FVector ThumbAxis = -HandRight[HandId];
+		const FVector FingerAxis = HandForward[HandId];
+		for (int32 Index = HandId * NumProbes; Index < (HandId + 1) * NumProbes; ++Index)
+		{
+			const float Curl =
+				FVector::DotProduct(ProbeDirections[Index], (Index == HandId * NumProbes) ? ThumbAxis : FingerAxis);
+			ProbeCurlVelocities[Index] = Curl - ProbePrevCurls[Index];
+			ProbePrevCurls[Index] = Curl;
+			ProbeCurls[Index] = Curl;
+		}
+	}
+}
+
+void UIEGrabClassificationSubsystem::UpdateContacts()
+{
+	FMemory::Memzero(PairContacts.GetData(), PairContacts.Num());
+	FMemory::Memzero(HandContacts.GetData(), HandContacts.Num());
+
+	UIEGrabBroadphaseSubsystem* Broadphase = GetWorld() ? GetWorld()->GetSubsystem<UIEGrabBroadphaseSubsystem>() : nullptr;
+	if (!Broadphase)
+	{
+		return;
+	}
+	for (int32 HandId = 0; HandId < HandUsed.Num(); ++HandId)
+	{
+		if (!HandUsed[HandId] || HandUpdatedFrame[HandId] != GFrameCounter)
+		{
+			continue;
+		}
+		QueryLocations.Reset();
+		QueryRadii.Reset();
+		for (int32 Probe = 0; Probe < NumProbes; ++Probe)
+		{
+			QueryLocations.Add(ProbeLocations[HandId * NumProbes + Probe]);
+			QueryRadii.Add(Probe == 0 ? HandParams[HandId].ThumbTipRadius : HandParams[HandId].FingerTipRadius);
+		}
+		Broadphase->QueryProbeContacts(QueryLocations, QueryRadii, QueryContacts);
+		for (const FIEProbeContact& Contact : QueryContacts)
+		{
+			const int32 PairIndex = FindOrAddPair(HandId, Contact.Primitive);
+			PairContacts[PairIndex] |= 1 << Contact.ProbeIndex;
+			HandContacts[HandId] |= 1 << Contact.ProbeIndex;
+		}
+	}
+}
+
+void UIEGrabClassificationSubsystem::ClassifyPairs(const float DeltaTime)
+{
+	for (int32 PairIndex = 0; PairIndex < PairHand.Num(); ++PairIndex)
+	{
+		const int32 HandId = PairHand[PairIndex];
+		if (HandUpdatedFrame[HandId] != GFrameCounter)
+		{
+			continue;
+		}
+		const FGrabClassifierParams& Params = HandParams[HandId];
+		const bool IgnoreTemporal = HandIgnoreTemporal[HandId];
+		const float MinimumCurl = IgnoreTemporal ? -1.0f : Params.MinimumCurl;
+		const float MaximumCurlVelocity = PairGrabbing[PairIndex] ? Params.GrabbedMaximumCurlVelocity : Params.MaximumCurlVelocity;
+		const uint8 Contacts = PairContacts[PairIndex];
+		// if grabbed in multigrasp a probe may touch nothing at all, it keeps holding until uncurl occurs. A probe touching
+		// another object doesn't hold this one
+		const uint8 HeldWithoutContacts = PairGrabbing[PairIndex] ? (uint8) ~HandContacts[HandId] : 0;
+
+		uint8 Inside = PairInside[PairIndex];
+		for (int32 Probe = 0; Probe < NumProbes; ++Probe)
+		{
+			const int32 ProbeIndex = HandId * NumProbes + Probe;
+			const float Curl = ProbeCurls[ProbeIndex];
+			const uint8 ProbeBit = 1 << Probe;
+
+			const bool CollidingWithObject = ((Contacts | HeldWithoutContacts) & ProbeBit) && Curl < Params.MaximumCurl &&
+											 Curl > MinimumCurl &&
+											 (IgnoreTemporal || ProbeCurlVelocities[ProbeIndex] < MaximumCurlVelocity);
+
+			// Probes go inside when they intersect, probes come out when they uncurl
+			float& StickyCurl = PairStickyCurls[PairIndex * NumProbes + Probe];
+			if (!(Inside & ProbeBit))
+			{
+				const float Stickiness = Probe == 0 ? Params.ThumbStickiness : Params.FingerStickiness;
+				Inside |= CollidingWithObject ? ProbeBit : 0;
+				StickyCurl = IgnoreTemporal ? Stickiness : Curl + Stickiness;
+			}
+			else if (Curl > StickyCurl && !CollidingWithObject)
+			{
+				Inside &= ~ProbeBit;
+			}
+		}
+		PairInside[PairIndex] = Inside;
+
+		bool IsGrabbing = (Inside & ThumbProbeMask) && (Inside & FingerProbesMask);
+
+		// Suppresses spurious regrabs and makes throws work better
+		if (PairCoolDown[PairIndex] <= Params.GrabCooldown && !IgnoreTemporal && Params.UseGrabCooldown)
+		{
+			IsGrabbing = false;
+			PairCoolDown[PairIndex] += DeltaTime;
+		}
+
+		if (IsGrabbing != PairGrabbing[PairIndex])
+		{
+			if (!IsGrabbing)
+			{
+				PairCoolDown[PairIndex] = 0.0f;
+			}
+			PairGrabbing[PairIndex] = IsGrabbing;
+			GrabEvents.Add({HandId, PairObject[PairIndex].Get(), IsGrabbing});
+		}
+	}
+}
+
+void UIEGrabClassificationSubsystem::CullPairs()
+{
+	for (int32 PairIndex = PairHand.Num() - 1; PairIndex >= 0; --PairIndex)
+	{
+		if (!PairObject[PairIndex].IsValid())
+		{
+			// the hand still has to let go, the object can no longer be named
+			if (PairGrabbing[PairIndex])
+			{
+				GrabEvents.Add({PairHand[PairIndex], nullptr, false});
+			}
+			RemovePair(PairIndex);
+			continue;
+		}
+		// keep pairs that are still touching, held or cooling down so their hysteresis survives
+		const FGrabClassifierParams& Params = HandParams[PairHand[PairIndex]];
+		const bool CoolingDown = Params.UseGrabCooldown && PairCoolDown[PairIndex] <= Params.GrabCooldown;
+		if (!PairContacts[PairIndex] && !PairInside[PairIndex] && !PairGrabbing[PairIndex] && !CoolingDown)
+		{
+			RemovePair(PairIndex);
+		}
+	}
+}
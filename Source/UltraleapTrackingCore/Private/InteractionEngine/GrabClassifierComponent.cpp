@@ -9,12 +9,15 @@
 #include "InteractionEngine/GrabClassifierComponent.h"
 
 #include "Components/PrimitiveComponent.h"
+#include "InteractionEngine/GrabBroadphaseSubsystem.h"
 // Sets default values for this component's properties
 UIEGrabClassifierComponent::UIEGrabClassifierComponent()
 {
 	// no need for tick, this is driven by calls from the IEGrabberComponent tick
 	PrimaryComponentTick.bCanEverTick = false;
 
+	UseBroadphase = false;
+
 	// ...
 }
 
@@ -37,6 +40,20 @@ void UIEGrabClassifierComponent::UpdateClassifier(const USceneComponent* Hand, c
 	}
 	int32 ProbeIndex = 0;
 
+	// One query for all fingertips of this hand, replaces the per probe candidate lists
+	UIEGrabBroadphaseSubsystem* Broadphase = UseBroadphase ? UIEGrabBroadphaseSubsystem::Get(this) : nullptr;
+	if (Broadphase)
+	{
+		BroadphaseLocations.Reset();
+		BroadphaseRadii.Reset();
+		for (auto Probe : Probes)
+		{
+			BroadphaseLocations.Add(Probe->Location);
+			BroadphaseRadii.Add(BroadphaseRadii.Num() == 0 ? Params.ThumbTipRadius : Params.FingerTipRadius);
+		}
+		Broadphase->QueryProbes(BroadphaseLocations, BroadphaseRadii, BroadphaseHits);
+	}
+
 	// For each probe (fingertip)
 	for (auto Probe : Probes)
 	{
@@ -51,7 +68,12 @@ void UIEGrabClassifierComponent::UpdateClassifier(const USceneComponent* Hand, c
 
 		// Determine if this probe is intersecting an object
 		bool CollidingWithObject = false;
-		if (Probe->CandidateColliders.Num())
+		if (Broadphase)
+		{
+			// as below, keep a multigrasp grab alive with no contacts until uncurl occurs
+			CollidingWithObject = BroadphaseHits[ProbeIndex] != nullptr || IsThisControllerGrabbing;
+		}
+		else if (Probe->CandidateColliders.Num())
 		{
 			for (auto Collider : Probe->CandidateColliders)
 			{
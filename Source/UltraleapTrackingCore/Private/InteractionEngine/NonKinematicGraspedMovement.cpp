@@ -9,6 +9,22 @@
 
 #include "InteractionEngine/NonKinematicGraspedMovement.h"
 #include "Components/PrimitiveComponent.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+
+namespace
+{
+// The physics scene clamps the time it simulates each frame, so substeps may cover less than the game frame
+float GetPhysicsStepTime(const float DeltaTime)
+{
+	const UPhysicsSettings* Settings = UPhysicsSettings::Get();
+	float StepTime = FMath::Min(DeltaTime, Settings->MaxPhysicsDeltaTime);
+	if (Settings->bSubstepping)
+	{
+		StepTime = FMath::Min(StepTime, Settings->MaxSubstepDeltaTime * Settings->MaxSubsteps);
+	}
+	return StepTime;
+}
+}	 // namespace
 
 /// <summary>
 /// This implementation of UGraspedMovementHandler moves a grabbable object to its
@@ -29,39 +45,138 @@ UNonKinematicGraspedMovement::UNonKinematicGraspedMovement() : UGraspedMovementH
 void UNonKinematicGraspedMovement::MoveToImpl(
 	const FVector& SolvedPosition, const FQuat& SolvedRotation, UPrimitiveComponent* RigidBody, const bool JustGrasped)
 {
-	// centre of mass is in world coords
-	FVector RelativeCenterOfMass = RigidBody->GetComponentLocation() - RigidBody->GetCenterOfMass();
+	FBodyInstance* BodyInstance = RigidBody->GetBodyInstance();
+	if (!BodyInstance)
+	{
+		return;
+	}
 
-	FVector SolvedCenterOfMass = SolvedRotation * RelativeCenterOfMass + SolvedPosition;
-	FVector CurrCenterOfMass = FQuat(RigidBody->GetComponentRotation()) * RelativeCenterOfMass + RigidBody->GetComponentLocation();
+	// centre of mass is in world coords
+	const FVector RelativeCenterOfMass = RigidBody->GetComponentLocation() - RigidBody->GetCenterOfMass();
+	const FTransform Current = RigidBody->GetComponentTransform();
+	const float DeltaTime = GetWorld()->GetDeltaSeconds();
+	const bool bSubstep = bSolveInPhysicsSubsteps && RigidBody->IsSimulatingPhysics();
+	const uint64 Frame = GFrameCounter;
 
-	FVector TargetVelocity = ToLinearVelocity(CurrCenterOfMass, SolvedCenterOfMass, GetWorld()->GetDeltaSeconds());
-	
-	FVector TargetAngularVelocity =
-		ToAngularVelocity(FQuat(RigidBody->GetComponentRotation()), SolvedRotation, GetWorld()->GetDeltaSeconds());
-	
-	// Clamp TargetVelocity by MaxVelocity.
-	float MaxScaledVelocity = MaxVelocity * SimulationScale;
-	float TargetSpeedSqrd = TargetVelocity.SizeSquared();
-	if (TargetSpeedSqrd > MaxScaledVelocity * MaxScaledVelocity)
+	float Strength;
+	float MaxScaledVelocity;
 	{
-		float TargetPercent = MaxScaledVelocity / FMath::Sqrt(TargetSpeedSqrd);
-		TargetVelocity *= TargetPercent;
-		TargetAngularVelocity *= TargetPercent;
+		FScopeLock Lock(&GraspedBodiesLock);
+
+		// drop bodies that are no longer held
+		for (auto It = GraspedBodies.CreateIterator(); It; ++It)
+		{
+			if (It.Value().LastMoveFrame + 1 < Frame)
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		// a body not moved last frame has been released in between, don't carry over its old target
+		FGraspedBodyState* State = GraspedBodies.Find(BodyInstance);
+		const bool Regrasped = JustGrasped || !State;
+		if (!State)
+		{
+			State = &GraspedBodies.Add(BodyInstance);
+		}
+
+		if (Regrasped)
+		{
+			State->FollowStrength = FollowStrength;
+		}
+		else
+		{
+			const FVector CurrCenterOfMass = Current.GetRotation() * RelativeCenterOfMass + Current.GetLocation();
+			const float RemainingDistanceLastFrame = FVector::Distance(State->TargetCenterOfMass, CurrCenterOfMass);
+			State->FollowStrength = StrengthByDistance->GetFloatValue(RemainingDistanceLastFrame / SimulationScale);
+		}
+		State->PrevTargetPosition = Regrasped ? SolvedPosition : State->TargetPosition;
+		State->PrevTargetRotation = Regrasped ? SolvedRotation : State->TargetRotation;
+		State->TargetPosition = SolvedPosition;
+		State->TargetRotation = SolvedRotation;
+		State->RelativeCenterOfMass = RelativeCenterOfMass;
+		State->TargetCenterOfMass = SolvedRotation * RelativeCenterOfMass + SolvedPosition;
+		State->MaxScaledVelocity = MaxVelocity * SimulationScale;
+		State->StepTime = GetPhysicsStepTime(DeltaTime);
+		State->SubstepTime = 0.0f;
+		State->LastMoveFrame = Frame;
+
+		Strength = State->FollowStrength;
+		MaxScaledVelocity = State->MaxScaledVelocity;
 	}
 
-	
-	if (!JustGrasped)
+	if (bSubstep)
 	{
-		float RemainingDistanceLastFrame = FVector::Distance(LastSolvedCoMPosition, CurrCenterOfMass);
-		FollowStrength = StrengthByDistance->GetFloatValue(RemainingDistanceLastFrame / SimulationScale);
+		// custom physics is cleared after every frame, so it's added each time the target moves
+		if (!OnCalculateCustomPhysics.IsBound())
+		{
+			OnCalculateCustomPhysics.BindUObject(this, &UNonKinematicGraspedMovement::SubstepMoveTo);
+		}
+		BodyInstance->AddCustomPhysics(OnCalculateCustomPhysics);
+		return;
 	}
 
-	FVector LerpedVelocity = FMath::Lerp(RigidBody->GetPhysicsLinearVelocity(), TargetVelocity, FollowStrength);
-	FVector LerpedAngularVelocity = FMath::Lerp(RigidBody->GetPhysicsAngularVelocityInDegrees(), TargetAngularVelocity, FollowStrength);
+	FVector LerpedVelocity;
+	FVector LerpedAngularVelocity;
+	SolveVelocities(Current, RelativeCenterOfMass, SolvedPosition, SolvedRotation, RigidBody->GetPhysicsLinearVelocity(),
+		RigidBody->GetPhysicsAngularVelocityInDegrees(), DeltaTime, Strength, MaxScaledVelocity, LerpedVelocity,
+		LerpedAngularVelocity);
 
 	RigidBody->SetPhysicsLinearVelocity(LerpedVelocity);
 	RigidBody->SetPhysicsAngularVelocityInDegrees(LerpedAngularVelocity);
+}
+
+void UNonKinematicGraspedMovement::SubstepMoveTo(float DeltaTime, FBodyInstance* BodyInstance)
+{
+	if (!BodyInstance || DeltaTime <= 0.0f)
+	{
+		return;
+	}
+	FScopeLock Lock(&GraspedBodiesLock);
+	FGraspedBodyState* State = GraspedBodies.Find(BodyInstance);
+	if (!State)
+	{
+		return;
+	}
+
+	// aim for the target at the end of this substep, the last substep of the step reaches the target solved this tick
+	State->SubstepTime += DeltaTime;
+	const float Alpha = State->SubstepTime < State->StepTime - KINDA_SMALL_NUMBER ? State->SubstepTime / State->StepTime : 1.0f;
+	const FVector TargetPosition = FMath::Lerp(State->PrevTargetPosition, State->TargetPosition, Alpha);
+	const FQuat TargetRotation = FQuat::Slerp(State->PrevTargetRotation, State->TargetRotation, Alpha);
+
+	FVector LerpedVelocity;
+	FVector LerpedAngularVelocity;
+	SolveVelocities(BodyInstance->GetUnrealWorldTransform_AssumesLocked(), State->RelativeCenterOfMass, TargetPosition,
+		TargetRotation, BodyInstance->GetUnrealWorldVelocity_AssumesLocked(),
+		FMath::RadiansToDegrees(BodyInstance->GetUnrealWorldAngularVelocityInRadians_AssumesLocked()), DeltaTime,
+		State->FollowStrength, State->MaxScaledVelocity, LerpedVelocity, LerpedAngularVelocity);
+
+	BodyInstance->SetLinearVelocity(LerpedVelocity, false);
+	BodyInstance->SetAngularVelocityInRadians(FMath::DegreesToRadians(LerpedAngularVelocity), false);
+}
+
+void UNonKinematicGraspedMovement::SolveVelocities(const FTransform& Current, const FVector& RelativeCenterOfMass,
+	const FVector& TargetPosition, const FQuat& TargetRotation, const FVector& CurrentVelocity,
+	const FVector& CurrentAngularVelocityInDegrees, const float DeltaTime, const float Strength, const float MaxScaledVelocity,
+	FVector& OutVelocity, FVector& OutAngularVelocityInDegrees)
+{
+	FVector SolvedCenterOfMass = TargetRotation * RelativeCenterOfMass + TargetPosition;
+	FVector CurrCenterOfMass = Current.GetRotation() * RelativeCenterOfMass + Current.GetLocation();
+
+	FVector TargetVelocity = ToLinearVelocity(CurrCenterOfMass, SolvedCenterOfMass, DeltaTime);
+
+	FVector TargetAngularVelocity = ToAngularVelocity(Current.GetRotation(), TargetRotation, DeltaTime);
+
+	// Clamp TargetVelocity by MaxVelocity.
+	float TargetSpeedSqrd = TargetVelocity.SizeSquared();
+	if (TargetSpeedSqrd > MaxScaledVelocity * MaxScaledVelocity)
+	{
+		float TargetPercent = MaxScaledVelocity / FMath::Sqrt(TargetSpeedSqrd);
+		TargetVelocity *= TargetPercent;
+		TargetAngularVelocity *= TargetPercent;
+	}
 
-	LastSolvedCoMPosition = SolvedCenterOfMass;
+	OutVelocity = FMath::Lerp(CurrentVelocity, TargetVelocity, Strength);
+	OutAngularVelocityInDegrees = FMath::Lerp(CurrentAngularVelocityInDegrees, TargetAngularVelocity, Strength);
 }
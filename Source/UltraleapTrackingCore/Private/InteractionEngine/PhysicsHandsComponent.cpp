@@ -0,0 +1,339 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "InteractionEngine/PhysicsHandsComponent.h"
+
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "LeapSubsystem.h"
+#include "LeapUtility.h"
+#include "UltraleapTrackingStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("IE Physics Hands"), STAT_IEPhysicsHands, STATGROUP_UltraleapTracking);
+DECLARE_DWORD_COUNTER_STAT(TEXT("IE Physics Hand Bodies Awake"), STAT_IEPhysicsHandBodiesAwake, STATGROUP_UltraleapTracking);
+
+namespace
+{
+// Body slots after the palm in budget order, fingertips do most of the poking so they come first.
+// Digit 0-4 is thumb to pinky, bone 0-3 is metacarpal to distal, the thumb has no metacarpal
+struct FHandBodyBone
+{
+	int8 Digit;
+	int8 Bone;
+};
+const FHandBodyBone HandBodyBones[] = {{0, 3}, {1, 3}, {2, 3}, {3, 3}, {4, 3}, {0, 2}, {1, 2}, {2, 2}, {3, 2}, {4, 2}, {0, 1},
+	{1, 1}, {2, 1}, {3, 1}, {4, 1}, {1, 0}, {2, 0}, {3, 0}, {4, 0}};
+const int32 MaxHandBodies = 1 + UE_ARRAY_COUNT(HandBodyBones);
+
+const FLeapBoneData& GetHandBone(const FLeapHandData& Hand, const FHandBodyBone& Bone)
+{
+	const FLeapDigitData* Digits[] = {&Hand.Thumb, &Hand.Index, &Hand.Middle, &Hand.Ring, &Hand.Pinky};
+	const FLeapDigitData& Digit = *Digits[Bone.Digit];
+	switch (Bone.Bone)
+	{
+		case 0:
+			return Digit.Metacarpal;
+		case 1:
+			return Digit.Proximal;
+		case 2:
+			return Digit.Intermediate;
+		default:
+			return Digit.Distal;
+	}
+}
+}	 // namespace
+
+UIEPhysicsHandsComponent::UIEPhysicsHandsComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	// drive the bodies before physics runs this frame
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+	LeapSubsystem = nullptr;
+}
+
+void UIEPhysicsHandsComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	CreateBodyPool();
+
+	LeapSubsystem = ULeapSubsystem::Get();
+	if (LeapSubsystem)
+	{
+		LeapSubsystem->OnLeapFrameMulti.AddUObject(this, &UIEPhysicsHandsComponent::OnLeapTrackingData);
+	}
+}
+
+void UIEPhysicsHandsComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (LeapSubsystem)
+	{
+		LeapSubsystem->OnLeapFrameMulti.RemoveAll(this);
+		LeapSubsystem = nullptr;
+	}
+	for (UPrimitiveComponent* Body : Bodies)
+	{
+		if (Body)
+		{
+			Body->DestroyComponent();
+		}
+	}
+	Bodies.Reset();
+	HandSlots[0] = HandSlots[1] = FHandSlot();
+	TrackedHands[0].bTracked = TrackedHands[1].bTracked = false;
+	LastFrameTime = -1.0;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UIEPhysicsHandsComponent::CreateBodyPool()
+{
+	AActor* Owner = GetOwner();
+	if (!Owner)
+	{
+		return;
+	}
+	BodiesPerHand = FMath::Clamp(MaxBodiesPerHand, 1, MaxHandBodies);
+	Bodies.Reset();
+	for (int32 HandIndex = 0; HandIndex < 2; ++HandIndex)
+	{
+		for (int32 BodySlot = 0; BodySlot < BodiesPerHand; ++BodySlot)
+		{
+			UPrimitiveComponent* Body;
+			if (BodySlot == 0)
+			{
+				Body = NewObject<UBoxComponent>(Owner);
+			}
+			else
+			{
+				Body = NewObject<UCapsuleComponent>(Owner);
+			}
+			// simulated bodies live in world space, they aren't attached to anything
+			Body->SetUsingAbsoluteLocation(true);
+			Body->SetUsingAbsoluteRotation(true);
+			Body->SetUsingAbsoluteScale(true);
+			Body->SetGenerateOverlapEvents(false);
+			Body->SetCollisionObjectType(HandCollisionChannel);
+			Body->SetCollisionResponseToAllChannels(ECR_Block);
+			Body->SetCollisionResponseToChannel(HandCollisionChannel, ECR_Ignore);
+			Body->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+			Body->BodyInstance.bUseCCD = true;
+			Body->RegisterComponent();
+
+			Body->SetEnableGravity(false);
+			Body->SetMassOverrideInKg(NAME_None, BoneMass, true);
+			Body->SetSimulatePhysics(true);
+			Body->PutRigidBodyToSleep();
+			Bodies.Add(Body);
+		}
+	}
+}
+
+void UIEPhysicsHandsComponent::OnLeapTrackingData(const FLeapFrameData& Frame)
+{
+	UpdateHands(Frame);
+}
+
+void UIEPhysicsHandsComponent::UpdateHands(const FLeapFrameData& Frame)
+{
+	// copied into fixed storage per hand, frames arrive every tick and shouldn't reallocate
+	TrackedHands[0].bTracked = TrackedHands[1].bTracked = false;
+	for (const FLeapHandData& Hand : Frame.Hands)
+	{
+		FTrackedHand& Tracked = TrackedHands[Hand.HandType == EHandType::LEAP_HAND_LEFT ? 0 : 1];
+		Tracked.Hand = Hand;
+		Tracked.bTracked = true;
+	}
+	LastFrameTime = GetWorld() ? GetWorld()->GetRealTimeSeconds() : 0.0;
+}
+
+bool UIEPhysicsHandsComponent::GetBodyTarget(
+	const FLeapHandData& Hand, const int32 BodySlot, FTransform& OutTarget, FVector& OutShape) const
+{
+	if (BodySlot == 0)
+	{
+		// palm box, fingers along X
+		const float Width = Hand.Palm.Width;
+		OutTarget = FTransform(Hand.Palm.Orientation, Hand.Palm.Position);
+		OutShape = FVector(Width * 0.45f, Width * 0.5f, Width * 0.15f);
+	}
+	else
+	{
+		const FLeapBoneData& Bone = GetHandBone(Hand, HandBodyBones[BodySlot - 1]);
+		const FVector Axis = Bone.NextJoint - Bone.PrevJoint;
+		const float Length = Axis.Size();
+		if (Length < KINDA_SMALL_NUMBER)
+		{
+			return false;
+		}
+		const float Radius = Bone.Width * 0.5f;
+		// capsules run along Z
+		OutTarget = FTransform(FRotationMatrix::MakeFromZ(Axis).ToQuat(), (Bone.PrevJoint + Bone.NextJoint) * 0.5f);
+		OutShape = FVector(Radius, Length * 0.5f + Radius, 0);
+	}
+	if (!bFramesInWorldSpace)
+	{
+		OutTarget = OutTarget * GetComponentTransform();
+	}
+	return true;
+}
+
+void UIEPhysicsHandsComponent::WakeHand(const int32 HandIndex, const FLeapHandData& Hand)
+{
+	for (int32 BodySlot = 0; BodySlot < BodiesPerHand; ++BodySlot)
+	{
+		UPrimitiveComponent* Body = Bodies[HandIndex * BodiesPerHand + BodySlot];
+		FTransform Target;
+		FVector Shape;
+		if (!GetBodyTarget(Hand, BodySlot, Target, Shape))
+		{
+			continue;
+		}
+		// sizes only change with the tracked hand, resizing every tick would rebuild the physics shapes
+		if (UBoxComponent* Box = Cast<UBoxComponent>(Body))
+		{
+			Box->SetBoxExtent(Shape, false);
+		}
+		else if (UCapsuleComponent* Capsule = Cast<UCapsuleComponent>(Body))
+		{
+			Capsule->SetCapsuleSize(Shape.X, Shape.Y, false);
+		}
+		Body->SetWorldTransform(Target, false, nullptr, ETeleportType::TeleportPhysics);
+		Body->SetPhysicsLinearVelocity(FVector::ZeroVector);
+		Body->SetPhysicsAngularVelocityInRadians(FVector::ZeroVector);
+		Body->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+		Body->WakeRigidBody();
+	}
+	HandSlots[HandIndex].bAwake = true;
+	HandSlots[HandIndex].HandId = Hand.Id;
+}
+
+void UIEPhysicsHandsComponent::SleepHand(const int32 HandIndex)
+{
+	if (!HandSlots[HandIndex].bAwake)
+	{
+		return;
+	}
+	for (int32 BodySlot = 0; BodySlot < BodiesPerHand; ++BodySlot)
+	{
+		UPrimitiveComponent* Body = Bodies[HandIndex * BodiesPerHand + BodySlot];
+		Body->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Body->SetPhysicsLinearVelocity(FVector::ZeroVector);
+		Body->SetPhysicsAngularVelocityInRadians(FVector::ZeroVector);
+		Body->PutRigidBodyToSleep();
+	}
+	HandSlots[HandIndex] = FHandSlot();
+}
+
+void UIEPhysicsHandsComponent::DriveHand(const int32 HandIndex, const FLeapHandData& Hand, const float DeltaTime)
+{
+	const float MaxVelocitySquared = FMath::Square(MaxVelocity);
+	const float TeleportDistanceSquared = FMath::Square(TeleportDistance);
+	for (int32 BodySlot = 0; BodySlot < BodiesPerHand; ++BodySlot)
+	{
+		UPrimitiveComponent* Body = Bodies[HandIndex * BodiesPerHand + BodySlot];
+		FTransform Target;
+		FVector Shape;
+		if (!GetBodyTarget(Hand, BodySlot, Target, Shape))
+		{
+			continue;
+		}
+		const FTransform Current = Body->GetComponentTransform();
+		const FVector Delta = Target.GetLocation() - Current.GetLocation();
+		if (Delta.SizeSquared() > TeleportDistanceSquared)
+		{
+			// stuck behind something, snapping back beats dragging objects through the scene
+			Body->SetWorldTransform(Target, false, nullptr, ETeleportType::TeleportPhysics);
+			Body->SetPhysicsLinearVelocity(FVector::ZeroVector);
+			Body->SetPhysicsAngularVelocityInRadians(FVector::ZeroVector);
+			continue;
+		}
+
+		// velocities that reach the tracked pose by the end of this physics step
+		FVector LinearVelocity = Delta / DeltaTime;
+		if (LinearVelocity.SizeSquared() > MaxVelocitySquared)
+		{
+			LinearVelocity = LinearVelocity.GetSafeNormal() * MaxVelocity;
+		}
+		FQuat DeltaRotation = Target.GetRotation() * Current.GetRotation().Inverse();
+		DeltaRotation.EnforceShortestArcWith(FQuat::Identity);
+		FVector Axis;
+		float Angle;
+		DeltaRotation.ToAxisAndAngle(Axis, Angle);
+
+		Body->SetPhysicsLinearVelocity(LinearVelocity);
+		Body->SetPhysicsAngularVelocityInRadians(Axis * Angle / DeltaTime);
+	}
+}
+
+void UIEPhysicsHandsComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	SCOPE_CYCLE_COUNTER(STAT_IEPhysicsHands);
+
+	if (!Bodies.Num() || DeltaTime <= 0.0f)
+	{
+		return;
+	}
+
+	// the last frame is held when frames stop arriving (device unplugged, subsystem gone), don't keep driving it
+	const bool bFrameTimedOut = LastFrameTime < 0.0 || GetWorld()->GetRealTimeSeconds() - LastFrameTime > TrackingTimeout;
+
+	const float MaxHandDistanceSquared = FMath::Square(MaxHandDistance);
+	int32 BodiesAwake = 0;
+	for (int32 HandIndex = 0; HandIndex < 2; ++HandIndex)
+	{
+		const FLeapHandData* Hand =
+			!bFrameTimedOut && TrackedHands[HandIndex].bTracked ? &TrackedHands[HandIndex].Hand : nullptr;
+		if (Hand)
+		{
+			const FVector PalmPosition =
+				bFramesInWorldSpace ? Hand->Palm.Position : GetComponentTransform().TransformPosition(Hand->Palm.Position);
+			if (FVector::DistSquared(PalmPosition, GetComponentLocation()) > MaxHandDistanceSquared)
+			{
+				Hand = nullptr;
+			}
+		}
+		if (!Hand)
+		{
+			SleepHand(HandIndex);
+			continue;
+		}
+
+		// a new hand id is a different (possibly differently sized) hand, start it from its tracked pose
+		if (!HandSlots[HandIndex].bAwake || HandSlots[HandIndex].HandId != Hand->Id)
+		{
+			WakeHand(HandIndex, *Hand);
+		}
+		else
+		{
+			DriveHand(HandIndex, *Hand, DeltaTime);
+		}
+		BodiesAwake += BodiesPerHand;
+	}
+	SET_DWORD_STAT(STAT_IEPhysicsHandBodiesAwake, BodiesAwake);
+}
+
+bool UIEPhysicsHandsComponent::IsHandAwake(TEnumAsByte<EHandType> HandType) const
+{
+	return HandSlots[HandType == EHandType::LEAP_HAND_LEFT ? 0 : 1].bAwake;
+}
+
+void UIEPhysicsHandsComponent::GetHandBodies(TEnumAsByte<EHandType> HandType, TArray<UPrimitiveComponent*>& OutBodies) const
+{
+	OutBodies.Reset();
+	if (!Bodies.Num())
+	{
+		return;
+	}
+	const int32 HandIndex = HandType == EHandType::LEAP_HAND_LEFT ? 0 : 1;
+	for (int32 BodySlot = 0; BodySlot < BodiesPerHand; ++BodySlot)
+	{
+		OutBodies.Add(Bodies[HandIndex * BodiesPerHand + BodySlot]);
+	}
+}
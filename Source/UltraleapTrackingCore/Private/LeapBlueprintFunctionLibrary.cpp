@@ -73,6 +73,12 @@ void ULeapBlueprintFunctionLibrary::GetLeapStats(FLeapStats& OutStats, const FSt
 	OutStats = IUltraleapTrackingPlugin::Get().GetLeapStats(DeviceSerial);
 }
 
+bool ULeapBlueprintFunctionLibrary::GetImagesForFrame(
+	const FLeapFrameData& Frame, FLeapImagePair& OutImages, const FString& DeviceSerial)
+{
+	return IUltraleapTrackingPlugin::Get().GetImagesForFrame(DeviceSerial, Frame.DeviceFrameId, OutImages);
+}
+
 void ULeapBlueprintFunctionLibrary::SetLeapPolicy(ELeapPolicyFlag Flag, bool Enable, const TArray<FString>& DeviceSerials)
 {
 	IUltraleapTrackingPlugin::Get().SetLeapPolicy(Flag, Enable, DeviceSerials);
@@ -0,0 +1,137 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "LeapClickPredictor.h"
+
+void FLeapClickPredictor::Configure(
+	const float InPressThreshold, const float InReleaseThreshold, const float InLeadTime, const float InOnsetVelocity)
+{
+	PressThreshold = InPressThreshold;
+	ReleaseThreshold = FMath::Min(InReleaseThreshold, InPressThreshold);
+	LeadTime = FMath::Max(InLeadTime, 0.0f);
+	OnsetVelocity = FMath::Max(InOnsetVelocity, KINDA_SMALL_NUMBER);
+}
+
+void FLeapClickPredictor::Reset()
+{
+	NumSamples = 0;
+	NextSample = 0;
+	Velocity = 0;
+	bPressed = false;
+	bReachedPressThreshold = false;
+	bHasOnset = false;
+}
+
+const FLeapClickPredictor::FSample& FLeapClickPredictor::GetSample(const int32 Age) const
+{
+	return History[(NextSample - 1 - Age + HistoryLength) % HistoryLength];
+}
+
+float FLeapClickPredictor::FitVelocity() const
+{
+	if (NumSamples < 2)
+	{
+		return 0;
+	}
+	// least squares slope, less sensitive to jitter than the last two samples
+	const double T0 = GetSample(0).Time;
+	double SumT = 0, SumV = 0, SumTT = 0, SumTV = 0;
+	for (int32 Age = 0; Age < NumSamples; ++Age)
+	{
+		const FSample& Sample = GetSample(Age);
+		const double T = Sample.Time - T0;
+		SumT += T;
+		SumV += Sample.Value;
+		SumTT += T * T;
+		SumTV += T * Sample.Value;
+	}
+	const double Denominator = NumSamples * SumTT - SumT * SumT;
+	if (Denominator <= SMALL_NUMBER)
+	{
+		return 0;
+	}
+	return (float) ((NumSamples * SumTV - SumT * SumV) / Denominator);
+}
+
+void FLeapClickPredictor::FindOnset()
+{
+	// walk back to where the signal started rising, the ray there is what the user aimed at
+	int32 Age = 0;
+	while (Age + 1 < NumSamples && GetSample(Age + 1).Value < GetSample(Age).Value)
+	{
+		++Age;
+	}
+	Onset = GetSample(Age);
+	bHasOnset = true;
+}
+
+ELeapClickPrediction FLeapClickPredictor::AddSample(
+	const double Time, const float Value, const FVector& RayStart, const FVector& RayDirection)
+{
+	if (NumSamples > 0 && Time <= GetSample(0).Time)
+	{
+		// same tracking frame delivered again
+		return ELeapClickPrediction::None;
+	}
+	FSample& Sample = History[NextSample];
+	Sample.Time = Time;
+	Sample.Value = Value;
+	Sample.RayStart = RayStart;
+	Sample.RayDirection = RayDirection;
+	NextSample = (NextSample + 1) % HistoryLength;
+	NumSamples = FMath::Min(NumSamples + 1, HistoryLength);
+
+	Velocity = FitVelocity();
+
+	if (!bPressed)
+	{
+		if (Velocity >= OnsetVelocity)
+		{
+			if (!bHasOnset)
+			{
+				FindOnset();
+			}
+		}
+		else if (Velocity <= 0)
+		{
+			bHasOnset = false;
+		}
+
+		const float Predicted = Value + FMath::Max(Velocity, 0.0f) * LeadTime;
+		if (Value >= PressThreshold || (bHasOnset && Predicted >= PressThreshold))
+		{
+			bPressed = true;
+			bReachedPressThreshold = Value >= PressThreshold;
+			return ELeapClickPrediction::Press;
+		}
+		return ELeapClickPrediction::None;
+	}
+
+	bReachedPressThreshold |= Value >= PressThreshold;
+	// cancel straight away if a predicted press never reached the threshold and the signal has turned back,
+	// otherwise release on the hysteresis threshold
+	const bool bMispredicted = Value < PressThreshold && Velocity < 0 && !bReachedPressThreshold;
+	if (bMispredicted || Value < ReleaseThreshold)
+	{
+		bPressed = false;
+		bHasOnset = false;
+		return bMispredicted ? ELeapClickPrediction::Cancel : ELeapClickPrediction::Release;
+	}
+	return ELeapClickPrediction::None;
+}
+
+bool FLeapClickPredictor::GetOnsetRay(FVector& OutStart, FVector& OutDirection) const
+{
+	if (!bHasOnset)
+	{
+		return false;
+	}
+	OutStart = Onset.RayStart;
+	OutDirection = Onset.RayDirection;
+	return true;
+}
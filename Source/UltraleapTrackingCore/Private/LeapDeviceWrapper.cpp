@@ -239,6 +239,47 @@ void FLeapDeviceWrapper::SetDeviceHints(TArray<FString>& Hints, const uint32_t L
 	Connector->SetDeviceHints(Hints, DeviceID);
 }
 
+bool FLeapDeviceWrapper::RectilinearToPixel(const int32 CameraIndex, const LEAP_VECTOR& Ray, FVector2D& OutPixel)
+{
+	if (DeviceHandle == nullptr || ConnectionHandle == nullptr)
+	{
+		return false;
+	}
+	const eLeapPerspectiveType Camera = CameraIndex == 0 ? eLeapPerspectiveType_stereo_left : eLeapPerspectiveType_stereo_right;
+	const LEAP_VECTOR Pixel = LeapRectilinearToPixelEx(ConnectionHandle, DeviceHandle, Camera, Ray);
+	// NaN until LeapC has seen an image from this device
+	if (FMath::IsNaN(Pixel.x) || FMath::IsNaN(Pixel.y))
+	{
+		return false;
+	}
+	OutPixel = FVector2D(Pixel.x, Pixel.y);
+	return true;
+}
+
+bool FLeapDeviceWrapper::GetCameraToTrackingTransform(const int32 CameraIndex, FMatrix& OutCameraToTracking)
+{
+	if (DeviceHandle == nullptr || ConnectionHandle == nullptr)
+	{
+		return false;
+	}
+	const eLeapPerspectiveType Camera = CameraIndex == 0 ? eLeapPerspectiveType_stereo_left : eLeapPerspectiveType_stereo_right;
+	float Matrix[16] = {0};
+	LeapExtrinsicCameraMatrixEx(ConnectionHandle, DeviceHandle, Camera, Matrix);
+	if (Matrix[15] == 0.f)
+	{
+		return false;
+	}
+	// LeapC is column major for column vectors, the same memory read row major is the row vector matrix UE uses
+	for (int32 Row = 0; Row < 4; Row++)
+	{
+		for (int32 Column = 0; Column < 4; Column++)
+		{
+			OutCameraToTracking.M[Row][Column] = Matrix[Row * 4 + Column];
+		}
+	}
+	return true;
+}
+
 void FLeapDeviceWrapper::Millisleep(int milliseconds)
 {
 	FPlatformProcess::Sleep(((float) milliseconds) / 1000.f);
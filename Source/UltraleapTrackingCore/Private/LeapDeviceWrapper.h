@@ -86,6 +86,9 @@ public:
 	 */
 	virtual void SetDeviceHints(TArray<FString>& Hints, const uint32_t LeapDeviceID = 0) override;
 
+	virtual bool RectilinearToPixel(const int32 CameraIndex, const LEAP_VECTOR& Ray, FVector2D& OutPixel) override;
+	virtual bool GetCameraToTrackingTransform(const int32 CameraIndex, FMatrix& OutCameraToTracking) override;
+
 private:
 	void Millisleep(int Milliseconds);
 
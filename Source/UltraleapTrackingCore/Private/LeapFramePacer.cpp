@@ -0,0 +1,76 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "LeapFramePacer.h"
+
+#include "Engine/Engine.h"
+#include "IXRTrackingSystem.h"
+#include "RHI.h"
+#include "RHICommandList.h"
+#include "RenderCore.h"
+
+float FLeapFramePacer::MeasureLatency(const float DeltaTime) const
+{
+	// stage times are from the last completed frame of each thread, the best guess for the frame being built
+	const float GameThread = FPlatformTime::ToSeconds(GGameThreadTime);
+	const float RenderThread = GIsThreadedRendering ? FPlatformTime::ToSeconds(GRenderThreadTime) : 0.0f;
+	const float RHIThread = IsRunningRHIInSeparateThread() ? FPlatformTime::ToSeconds(GRHIThreadTime) : 0.0f;
+	const float GPU = FPlatformTime::ToSeconds(RHIGetGPUFrameCycles());
+
+	// the display refreshes at the frame rate when vsynced, half a refresh to the middle of scanout
+	float Latency = GameThread + RenderThread + FMath::Max(RHIThread, GPU) + DeltaTime * 0.5f;
+
+	// HMD compositors hold the frame for their own reprojection pass
+	if (GEngine && GEngine->XRSystem.IsValid() && GEngine->IsStereoscopic3D())
+	{
+		Latency += DeltaTime;
+	}
+	return Latency;
+}
+
+void FLeapFramePacer::Update(const float DeltaTime)
+{
+	if (DeltaTime > 0)
+	{
+		Update(DeltaTime, MeasureLatency(DeltaTime));
+	}
+}
+
+void FLeapFramePacer::Update(const float DeltaTime, const float MeasuredLatency)
+{
+	if (DeltaTime <= 0)
+	{
+		return;
+	}
+	const float Measured = FMath::Clamp(MeasuredLatency, 0.0f, MaxMeasuredLatency);
+	DisplayLatency = bHasEstimate ? FMath::Lerp(DisplayLatency, Measured, LatencySmoothing) : Measured;
+
+	const float Target = FMath::Clamp(DisplayLatency * LatencyScale, 0.0f, MaxLead);
+	InterpolationOffset =
+		bHasEstimate ? InterpolationOffset + FMath::Clamp(Target - InterpolationOffset, -MaxOffsetStep, MaxOffsetStep) : Target;
+	bHasEstimate = true;
+}
+
+void FLeapFramePacer::Reset()
+{
+	DisplayLatency = 0;
+	InterpolationOffset = 0;
+	bHasEstimate = false;
+}
+
+void FLeapFramePacer::SetLimits(const float InLatencyScale, const float InMaxLeadInMS)
+{
+	LatencyScale = FMath::Max(InLatencyScale, 0.0f);
+	MaxLead = FMath::Max(InMaxLeadInMS, 0.0f) / 1000.0f;
+}
+
+void FLeapFramePacer::GetStats(FLeapStats& OutStats) const
+{
+	OutStats.DisplayLatencyInMS = DisplayLatency * 1000.0f;
+	OutStats.InterpolationOffsetInMS = InterpolationOffset * 1000.0f;
+}
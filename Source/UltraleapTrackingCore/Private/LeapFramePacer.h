@@ -0,0 +1,67 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UltraleapTrackingData.h"
+
+/**
+ * Estimates the time from the game thread sampling tracking to the frame reaching the display, from the engine's
+ * measured game, render, RHI and GPU frame times plus half a refresh for scanout and a compositor frame when an HMD
+ * is rendering. The estimate and the interpolation offset chosen from it are smoothed so the tracking time asked for
+ * moves steadily instead of following every frame time spike. Used by the LEAP_ADAPTIVE tracking fidelity in place
+ * of the fixed interpolation factors, and by the predict frame processor at any fidelity.
+ */
+class FLeapFramePacer
+{
+public:
+	/** Weight of each new latency measurement, about a third of a second to settle at 90Hz */
+	static constexpr float LatencySmoothing = 0.05f;
+	/** Most the interpolation offset moves per frame in seconds, so tracking time never jumps back or forth */
+	static constexpr float MaxOffsetStep = 0.001f;
+	/** Measurements are capped here to ignore hitches, a frame that long isn't representative of the next one */
+	static constexpr float MaxMeasuredLatency = 0.1f;
+
+	/** Call once per game frame on the game thread */
+	void Update(const float DeltaTime);
+
+	/** Update from a latency measured elsewhere, in seconds */
+	void Update(const float DeltaTime, const float MeasuredLatency);
+
+	void Reset();
+
+	/**
+	 * @param InLatencyScale - fraction of the estimated latency to interpolate ahead by
+	 * @param InMaxLeadInMS - furthest ahead of now to interpolate
+	 */
+	void SetLimits(const float InLatencyScale, const float InMaxLeadInMS);
+
+	/** Smoothed time until the current frame is displayed in seconds */
+	float GetDisplayLatency() const
+	{
+		return DisplayLatency;
+	}
+
+	/** Offset from now to interpolate tracking at in microseconds */
+	int64 GetInterpolationOffset() const
+	{
+		return FMath::RoundToInt(InterpolationOffset * 1.0e6f);
+	}
+
+	void GetStats(FLeapStats& OutStats) const;
+
+private:
+	float MeasureLatency(const float DeltaTime) const;
+
+	float DisplayLatency = 0;
+	float InterpolationOffset = 0;
+	float LatencyScale = 1.0f;
+	float MaxLead = 0.03f;
+	bool bHasEstimate = false;
+};
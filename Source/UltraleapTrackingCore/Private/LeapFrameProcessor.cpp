@@ -0,0 +1,476 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "LeapFrameProcessor.h"
+
+#include "LeapHandDataUtils.h"
+#include "UltraleapTrackingStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Leap Frame Processors"), STAT_LeapFrameProcessors, STATGROUP_UltraleapTracking);
+DECLARE_CYCLE_STAT(TEXT("Leap Filter Processor"), STAT_LeapFilterProcessor, STATGROUP_UltraleapTracking);
+DECLARE_CYCLE_STAT(TEXT("Leap Clamp Processor"), STAT_LeapClampProcessor, STATGROUP_UltraleapTracking);
+DECLARE_CYCLE_STAT(TEXT("Leap Mirror Processor"), STAT_LeapMirrorProcessor, STATGROUP_UltraleapTracking);
+DECLARE_CYCLE_STAT(TEXT("Leap Scale Processor"), STAT_LeapScaleProcessor, STATGROUP_UltraleapTracking);
+DECLARE_CYCLE_STAT(TEXT("Leap Predict Processor"), STAT_LeapPredictProcessor, STATGROUP_UltraleapTracking);
+
+// how much of each new velocity/acceleration sample is taken, lower values are steadier but respond later
+static const float PredictionVelocitySmoothing = 0.5f;
+static const float PredictionAccelerationSmoothing = 0.3f;
+// predicted bones can't rotate further than this in one prediction
+static const float PredictionMaxAngle = PI / 4.0f;
+
+namespace
+{
+template <typename FuncType>
+void ForEachDigitBone(FLeapDigitData& Digit, FuncType& Func)
+{
+	Func(Digit.Metacarpal);
+	Func(Digit.Proximal);
+	Func(Digit.Intermediate);
+	Func(Digit.Distal);
+	for (FLeapBoneData& Bone : Digit.Bones)
+	{
+		Func(Bone);
+	}
+}
+
+// hand data keeps copies of each bone in the digit arrays and the named members, visit all of them
+template <typename FuncType>
+void ForEachBone(FLeapHandData& Hand, FuncType Func)
+{
+	Func(Hand.Arm);
+	ForEachDigitBone(Hand.Thumb, Func);
+	ForEachDigitBone(Hand.Index, Func);
+	ForEachDigitBone(Hand.Middle, Func);
+	ForEachDigitBone(Hand.Ring, Func);
+	ForEachDigitBone(Hand.Pinky, Func);
+	for (FLeapDigitData& Digit : Hand.Digits)
+	{
+		ForEachDigitBone(Digit, Func);
+	}
+}
+
+int32 DigitBasePoint(const int32 Digit)
+{
+	return 3 + Digit * 5;
+}
+
+int32 BoneEndPoint(const int32 Digit, const int32 Bone)
+{
+	return 3 + Digit * 5 + 1 + Bone;
+}
+
+int32 BoneRotation(const int32 Digit, const int32 Bone)
+{
+	return 2 + Digit * 4 + Bone;
+}
+
+FVector MirrorVector(const FVector& Vector)
+{
+	return FVector(Vector.X, -Vector.Y, Vector.Z);
+}
+
+FRotator MirrorRotator(const FRotator& Rotator)
+{
+	const FQuat Quat = Rotator.Quaternion();
+	return FQuat(-Quat.X, Quat.Y, -Quat.Z, Quat.W).Rotator();
+}
+}	 // namespace
+
+void FLeapFilterFrameProcessor::Process(FLeapFrameData& Frame, const float DeltaTime)
+{
+	FilterBank.Filter(Frame, DeltaTime);
+}
+
+void FLeapFilterFrameProcessor::Reset()
+{
+	FilterBank.Reset();
+}
+
+TStatId FLeapFilterFrameProcessor::GetStatId() const
+{
+	return GET_STATID(STAT_LeapFilterProcessor);
+}
+
+void FLeapClampFrameProcessor::Process(FLeapFrameData& Frame, const float DeltaTime)
+{
+	if (!Bounds.IsValid)
+	{
+		return;
+	}
+	for (FLeapHandData& Hand : Frame.Hands)
+	{
+		const FVector Offset = Bounds.GetClosestPointTo(Hand.Palm.Position) - Hand.Palm.Position;
+		if (!Offset.IsNearlyZero())
+		{
+			Hand.TranslateHand(Offset);
+		}
+	}
+}
+
+TStatId FLeapClampFrameProcessor::GetStatId() const
+{
+	return GET_STATID(STAT_LeapClampProcessor);
+}
+
+void FLeapMirrorFrameProcessor::Process(FLeapFrameData& Frame, const float DeltaTime)
+{
+	for (FLeapHandData& Hand : Frame.Hands)
+	{
+		ForEachBone(Hand,
+			[](FLeapBoneData& Bone)
+			{
+				Bone.PrevJoint = MirrorVector(Bone.PrevJoint);
+				Bone.NextJoint = MirrorVector(Bone.NextJoint);
+				Bone.Rotation = MirrorRotator(Bone.Rotation);
+			});
+		Hand.Palm.Position = MirrorVector(Hand.Palm.Position);
+		Hand.Palm.StabilizedPosition = MirrorVector(Hand.Palm.StabilizedPosition);
+		Hand.Palm.Velocity = MirrorVector(Hand.Palm.Velocity);
+		Hand.Palm.Direction = MirrorVector(Hand.Palm.Direction);
+		Hand.Palm.Normal = MirrorVector(Hand.Palm.Normal);
+		Hand.Palm.Orientation = MirrorRotator(Hand.Palm.Orientation);
+		Hand.HandType = Hand.HandType == EHandType::LEAP_HAND_LEFT ? EHandType::LEAP_HAND_RIGHT : EHandType::LEAP_HAND_LEFT;
+	}
+	Swap(Frame.LeftHandVisible, Frame.RightHandVisible);
+}
+
+TStatId FLeapMirrorFrameProcessor::GetStatId() const
+{
+	return GET_STATID(STAT_LeapMirrorProcessor);
+}
+
+void FLeapScaleFrameProcessor::Process(FLeapFrameData& Frame, const float DeltaTime)
+{
+	if (Scale != 1.0f)
+	{
+		Frame.ScaleFrame(Scale);
+	}
+}
+
+TStatId FLeapScaleFrameProcessor::GetStatId() const
+{
+	return GET_STATID(STAT_LeapScaleProcessor);
+}
+
+void FLeapPredictFrameProcessor::SetLatency(const float TrackingLatency, const float DisplayLatency)
+{
+	const float Target =
+		FMath::Clamp((FMath::Max(TrackingLatency, 0.0f) + FMath::Max(DisplayLatency, 0.0f)) * LatencyScale, 0.0f, MaxHorizon);
+	// latency is measured per frame, smooth it so the prediction doesn't jump about with frame timing
+	Horizon = FMath::Lerp(Horizon, Target, 0.1f);
+}
+
+void FLeapPredictFrameProcessor::SetHorizonLimits(const float InLatencyScale, const float InMaxHorizon)
+{
+	LatencyScale = FMath::Max(InLatencyScale, 0.0f);
+	MaxHorizon = FMath::Max(InMaxHorizon, 0.0f);
+}
+
+void FLeapPredictFrameProcessor::Reset()
+{
+	for (FHandState& Hand : Hands)
+	{
+		Hand.HandId = INDEX_NONE;
+		Hand.bTracked = false;
+		Hand.bPredictionPending = false;
+	}
+	LastTimeStamp = 0;
+}
+
+TStatId FLeapPredictFrameProcessor::GetStatId() const
+{
+	return GET_STATID(STAT_LeapPredictProcessor);
+}
+
+void FLeapPredictFrameProcessor::GetStats(FLeapStats& OutStats) const
+{
+	OutStats.PredictionHorizonInMS = Horizon * 1000.0f;
+	OutStats.PredictionErrorInMM = ErrorInMM;
+}
+
+void FLeapPredictFrameProcessor::Gather(
+	const FLeapHandData& Hand, FVector* OutPoints, FQuat* OutRotations, const FHandState& State) const
+{
+	OutPoints[0] = Hand.Palm.Position;
+	OutPoints[1] = Hand.Arm.PrevJoint;
+	OutPoints[2] = Hand.Arm.NextJoint;
+	OutRotations[0] = Hand.Palm.Orientation.Quaternion();
+	OutRotations[1] = Hand.Arm.Rotation.Quaternion();
+	for (int32 Digit = 0; Digit < 5; ++Digit)
+	{
+		const TArray<FLeapBoneData>& Bones = Hand.Digits[Digit].Bones;
+		OutPoints[DigitBasePoint(Digit)] = Bones[0].PrevJoint;
+		for (int32 Bone = 0; Bone < 4; ++Bone)
+		{
+			OutPoints[BoneEndPoint(Digit, Bone)] = Bones[Bone].NextJoint;
+			OutRotations[BoneRotation(Digit, Bone)] = Bones[Bone].Rotation.Quaternion();
+		}
+	}
+	if (State.bTracked)
+	{
+		// q and -q are the same rotation, stay in the previous hemisphere so the angular velocity is the short way round
+		for (int32 Index = 0; Index < NumRotations; ++Index)
+		{
+			if ((OutRotations[Index] | State.Rotation[Index]) < 0)
+			{
+				OutRotations[Index] = OutRotations[Index] * -1.0f;
+			}
+		}
+	}
+}
+
+void FLeapPredictFrameProcessor::Estimate(
+	FHandState& State, const FVector* Points, const FQuat* Rotations, const float DeltaTime) const
+{
+	const float InvDeltaTime = 1.0f / DeltaTime;
+	for (int32 Index = 0; Index < NumPoints; ++Index)
+	{
+		const FVector Velocity = FMath::Lerp(
+			State.Velocity[Index], (Points[Index] - State.Position[Index]) * InvDeltaTime, PredictionVelocitySmoothing);
+		State.Acceleration[Index] = FMath::Lerp(
+			State.Acceleration[Index], (Velocity - State.Velocity[Index]) * InvDeltaTime, PredictionAccelerationSmoothing);
+		State.Velocity[Index] = Velocity;
+		State.Position[Index] = Points[Index];
+	}
+	State.PositionTime = FrameTime;
+	for (int32 Index = 0; Index < NumRotations; ++Index)
+	{
+		FVector Axis;
+		float Angle;
+		(Rotations[Index] * State.Rotation[Index].Inverse()).ToAxisAndAngle(Axis, Angle);
+		if (Angle > PI)
+		{
+			Angle -= 2.0f * PI;
+		}
+		State.AngularVelocity[Index] =
+			FMath::Lerp(State.AngularVelocity[Index], Axis * (Angle * InvDeltaTime), PredictionVelocitySmoothing);
+		State.Rotation[Index] = Rotations[Index];
+	}
+}
+
+void FLeapPredictFrameProcessor::MeasureError(FHandState& State, const FVector* Points)
+{
+	if (!State.bPredictionPending || FrameTime < State.PredictionTime)
+	{
+		return;
+	}
+	State.bPredictionPending = false;
+
+	// the hand at the predicted time, between the last frame (still in State) and this one
+	const double FrameInterval = FrameTime - State.PositionTime;
+	const float Alpha =
+		FrameInterval > 0 ? (float) FMath::Clamp((State.PredictionTime - State.PositionTime) / FrameInterval, 0.0, 1.0) : 1.0f;
+	float Error = FVector::Dist(State.PredictedErrorPoints[0], FMath::Lerp(State.Position[0], Points[0], Alpha));
+	for (int32 Digit = 0; Digit < 5; ++Digit)
+	{
+		const int32 TipPoint = BoneEndPoint(Digit, 3);
+		Error +=
+			FVector::Dist(State.PredictedErrorPoints[1 + Digit], FMath::Lerp(State.Position[TipPoint], Points[TipPoint], Alpha));
+	}
+	// cm to mm
+	Error = Error * 10.0f / NumErrorPoints;
+	ErrorInMM = bHasError ? FMath::Lerp(ErrorInMM, Error, 0.05f) : Error;
+	bHasError = true;
+}
+
+void FLeapPredictFrameProcessor::Predict(FLeapHandData& Hand, FHandState& State, const FVector* Points, const FQuat* Rotations)
+{
+	for (int32 Index = 0; Index < NumPoints; ++Index)
+	{
+		const FVector& Velocity = State.Velocity[Index];
+		const FVector& Acceleration = State.Acceleration[Index];
+		float Time = Horizon;
+		const float Decelerating = Velocity | Acceleration;
+		if (Decelerating < 0)
+		{
+			// a joint that is slowing down is predicted to stop, not to turn around
+			Time = FMath::Min(Time, -Decelerating / Acceleration.SizeSquared());
+		}
+		PredictedPoints[Index] = Points[Index] + Velocity * Time + Acceleration * (0.5f * Time * Time);
+	}
+	for (int32 Index = 0; Index < NumRotations; ++Index)
+	{
+		const FVector& AngularVelocity = State.AngularVelocity[Index];
+		const float Angle = FMath::Min(AngularVelocity.Size() * Horizon, PredictionMaxAngle);
+		PredictedRotations[Index] =
+			Angle > KINDA_SMALL_NUMBER ? FQuat(AngularVelocity.GetSafeNormal(), Angle) * Rotations[Index] : Rotations[Index];
+	}
+
+	// palm vectors follow the predicted position and orientation
+	const FQuat PalmCorrection = PredictedRotations[0] * Rotations[0].Inverse();
+	Hand.Palm.StabilizedPosition += PredictedPoints[0] - Points[0];
+	Hand.Palm.Position = PredictedPoints[0];
+	Hand.Palm.Direction = PalmCorrection.RotateVector(Hand.Palm.Direction);
+	Hand.Palm.Normal = PalmCorrection.RotateVector(Hand.Palm.Normal);
+	Hand.Palm.Orientation = PredictedRotations[0].Rotator();
+
+	// the arm keeps its length, hanging back from the predicted wrist
+	const float ArmLength = FVector::Dist(Points[1], Points[2]);
+	const FVector ArmDirection = (PredictedPoints[2] - PredictedPoints[1]).GetSafeNormal();
+	Hand.Arm.NextJoint = PredictedPoints[2];
+	Hand.Arm.PrevJoint =
+		ArmDirection.IsZero() ? Points[1] + (PredictedPoints[2] - Points[2]) : PredictedPoints[2] - ArmDirection * ArmLength;
+	Hand.Arm.Rotation = PredictedRotations[1].Rotator();
+
+	const float CosJointLimit = FMath::Cos(JointLimit);
+	for (int32 Digit = 0; Digit < 5; ++Digit)
+	{
+		FVector PrevJoint = PredictedPoints[DigitBasePoint(Digit)];
+		FVector ParentDirection = FVector::ZeroVector;
+		for (int32 Bone = 0; Bone < 4; ++Bone)
+		{
+			const int32 EndPoint = BoneEndPoint(Digit, Bone);
+			const int32 RotationIndex = BoneRotation(Digit, Bone);
+			const FVector Tracked = Points[EndPoint] - Points[EndPoint - 1];
+			const float Length = Tracked.Size();
+			if (Length < KINDA_SMALL_NUMBER)
+			{
+				// e.g. the thumb metacarpal
+				FLeapHandDataUtils::SetDigitBone(
+					Hand, Digit, Bone, PrevJoint, PrevJoint, PredictedRotations[RotationIndex].Rotator());
+				continue;
+			}
+			// bone direction in its own frame, whatever the axis convention
+			const FVector LocalDirection = Rotations[RotationIndex].UnrotateVector(Tracked / Length);
+			const FVector AngularDirection = PredictedRotations[RotationIndex].RotateVector(LocalDirection);
+			const FVector LinearDirection = (PredictedPoints[EndPoint] - PredictedPoints[EndPoint - 1]).GetSafeNormal();
+			FVector Direction = (AngularDirection + LinearDirection).GetSafeNormal();
+			if (Direction.IsZero())
+			{
+				Direction = AngularDirection;
+			}
+			// joint limit, keep the bend from the parent bone within a cone
+			if (!ParentDirection.IsZero() && (ParentDirection | Direction) < CosJointLimit)
+			{
+				const FVector BendAxis = (ParentDirection ^ Direction).GetSafeNormal();
+				if (!BendAxis.IsZero())
+				{
+					Direction = FQuat(BendAxis, JointLimit).RotateVector(ParentDirection);
+				}
+			}
+			const FQuat Rotation = FQuat::FindBetweenNormals(AngularDirection, Direction) * PredictedRotations[RotationIndex];
+			const FVector NextJoint = PrevJoint + Direction * Length;
+			FLeapHandDataUtils::SetDigitBone(Hand, Digit, Bone, PrevJoint, NextJoint, Rotation.Rotator());
+			PrevJoint = NextJoint;
+			ParentDirection = Direction;
+		}
+	}
+
+	if (!State.bPredictionPending)
+	{
+		State.bPredictionPending = true;
+		State.PredictionTime = FrameTime + Horizon;
+		State.PredictedErrorPoints[0] = Hand.Palm.Position;
+		for (int32 Digit = 0; Digit < 5; ++Digit)
+		{
+			State.PredictedErrorPoints[1 + Digit] = Hand.Digits[Digit].Bones[3].NextJoint;
+		}
+	}
+}
+
+void FLeapPredictFrameProcessor::Process(FLeapFrameData& Frame, const float DeltaTime)
+{
+	float FrameDeltaTime = DeltaTime;
+	if (LastTimeStamp > 0 && Frame.TimeStamp > LastTimeStamp)
+	{
+		FrameDeltaTime = (Frame.TimeStamp - LastTimeStamp) * 1.0e-6f;
+	}
+	if (Frame.TimeStamp > 0)
+	{
+		LastTimeStamp = Frame.TimeStamp;
+		FrameTime = Frame.TimeStamp * 1.0e-6;
+	}
+	else
+	{
+		FrameTime += FrameDeltaTime;
+	}
+	FrameDeltaTime = FMath::Max(FrameDeltaTime, 1.0e-4f);
+
+	bool bSeen[2] = {false, false};
+	for (FLeapHandData& Hand : Frame.Hands)
+	{
+		const int32 Slot = Hand.HandType == EHandType::LEAP_HAND_LEFT ? 0 : 1;
+		if (bSeen[Slot] || !FLeapHandDataUtils::HasAllBones(Hand))
+		{
+			continue;
+		}
+		bSeen[Slot] = true;
+
+		FHandState& State = Hands[Slot];
+		if (State.HandId != Hand.Id)
+		{
+			State.bTracked = false;
+		}
+		Gather(Hand, MeasuredPoints, MeasuredRotations, State);
+		if (!State.bTracked)
+		{
+			// nothing to estimate motion from yet
+			for (int32 Index = 0; Index < NumPoints; ++Index)
+			{
+				State.Position[Index] = MeasuredPoints[Index];
+				State.Velocity[Index] = FVector::ZeroVector;
+				State.Acceleration[Index] = FVector::ZeroVector;
+			}
+			for (int32 Index = 0; Index < NumRotations; ++Index)
+			{
+				State.Rotation[Index] = MeasuredRotations[Index];
+				State.AngularVelocity[Index] = FVector::ZeroVector;
+			}
+			State.PositionTime = FrameTime;
+			State.HandId = Hand.Id;
+			State.bPredictionPending = false;
+			continue;
+		}
+		MeasureError(State, MeasuredPoints);
+		Estimate(State, MeasuredPoints, MeasuredRotations, FrameDeltaTime);
+		if (Horizon > KINDA_SMALL_NUMBER)
+		{
+			Predict(Hand, State, MeasuredPoints, MeasuredRotations);
+		}
+	}
+	// hands that weren't tracked this frame start over when they return
+	Hands[0].bTracked = bSeen[0];
+	Hands[1].bTracked = bSeen[1];
+}
+
+void FLeapFrameProcessorChain::Add(const TSharedPtr<ILeapFrameProcessor>& Processor)
+{
+	if (Processor.IsValid())
+	{
+		Processors.Add(Processor);
+	}
+}
+
+bool FLeapFrameProcessorChain::Remove(const TSharedPtr<ILeapFrameProcessor>& Processor)
+{
+	return Processors.Remove(Processor) > 0;
+}
+
+void FLeapFrameProcessorChain::Empty()
+{
+	Processors.Reset();
+}
+
+void FLeapFrameProcessorChain::Process(FLeapFrameData& Frame, const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LeapFrameProcessors);
+	for (const TSharedPtr<ILeapFrameProcessor>& Processor : Processors)
+	{
+		FScopeCycleCounter ProcessorCounter(Processor->GetStatId());
+		Processor->Process(Frame, DeltaTime);
+	}
+}
+
+void FLeapFrameProcessorChain::Reset()
+{
+	for (const TSharedPtr<ILeapFrameProcessor>& Processor : Processors)
+	{
+		Processor->Reset();
+	}
+}
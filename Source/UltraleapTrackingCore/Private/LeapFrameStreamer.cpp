@@ -0,0 +1,500 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "LeapFrameStreamer.h"
+
+#include "Common/TcpSocketBuilder.h"
+#include "Common/UdpSocketBuilder.h"
+#include "HAL/RunnableThread.h"
+#include "LeapUtility.h"
+#include "Serialization/MemoryWriter.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+#include "UltraleapTrackingStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Leap Stream Encode"), STAT_LeapStreamEncode, STATGROUP_UltraleapTracking);
+DECLARE_CYCLE_STAT(TEXT("Leap Stream Send"), STAT_LeapStreamSend, STATGROUP_UltraleapTracking);
+
+namespace
+{
+void WriteVector(FArchive& Ar, const LEAP_VECTOR& Vector)
+{
+	float X = Vector.x;
+	float Y = Vector.y;
+	float Z = Vector.z;
+	Ar << X << Y << Z;
+}
+
+void WriteQuat(FArchive& Ar, const LEAP_QUATERNION& Quat)
+{
+	float X = Quat.x;
+	float Y = Quat.y;
+	float Z = Quat.z;
+	float W = Quat.w;
+	Ar << X << Y << Z << W;
+}
+
+// Components of a unit quaternion in [-1, 1] quantised to 16 bits, about 3e-5 error
+void WritePackedQuat(FArchive& Ar, const LEAP_QUATERNION& Quat)
+{
+	const FQuat Normalized = FQuat(Quat.x, Quat.y, Quat.z, Quat.w).GetNormalized();
+	int16 X = (int16) FMath::RoundToInt(Normalized.X * 32767.0);
+	int16 Y = (int16) FMath::RoundToInt(Normalized.Y * 32767.0);
+	int16 Z = (int16) FMath::RoundToInt(Normalized.Z * 32767.0);
+	int16 W = (int16) FMath::RoundToInt(Normalized.W * 32767.0);
+	Ar << X << Y << Z << W;
+}
+
+void WriteDigitJoints(FArchive& Ar, const LEAP_DIGIT& Digit)
+{
+	WriteVector(Ar, Digit.metacarpal.prev_joint);
+	for (const LEAP_BONE& Bone : Digit.bones)
+	{
+		WriteVector(Ar, Bone.next_joint);
+	}
+}
+
+void WriteDigitRotations(FArchive& Ar, const LEAP_DIGIT& Digit)
+{
+	for (const LEAP_BONE& Bone : Digit.bones)
+	{
+		WritePackedQuat(Ar, Bone.rotation);
+	}
+}
+}	 // namespace
+
+FLeapFrameStreamer::FLeapFrameStreamer()
+	: Port(0)
+	, bUseTCP(false)
+	, MaxRate(0)
+	, LastPushTime(0)
+	, LastPushedTimeStamp(0)
+	, BackPressure(ELeapStreamBackPressure::LEAP_STREAM_LATEST_ONLY)
+	, UdpSocket(nullptr)
+	, TcpListener(nullptr)
+	, Thread(nullptr)
+	, WakeEvent(nullptr)
+	, bStopping(false)
+{
+}
+
+FLeapFrameStreamer::~FLeapFrameStreamer()
+{
+	Shutdown();
+}
+
+bool FLeapFrameStreamer::Start(const int32 InPort, const bool bInUseTCP, const FString& InMulticastGroup)
+{
+	Shutdown();
+
+	Port = InPort;
+	bUseTCP = bInUseTCP;
+	MulticastGroup = InMulticastGroup;
+	LastPushedTimeStamp = 0;
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	if (!SocketSubsystem)
+	{
+		UE_LOG(UltraleapTrackingLog, Warning, TEXT("FLeapFrameStreamer::Start no socket subsystem"));
+		return false;
+	}
+
+	UdpSocket = FUdpSocketBuilder(TEXT("UltraleapFrameStreamUdp"))
+					.AsNonBlocking()
+					.AsReusable()
+					.BoundToPort(Port)
+					.WithMulticastTtl(1)
+					.WithSendBufferSize(256 * 1024)
+					.Build();
+	if (!UdpSocket)
+	{
+		UE_LOG(UltraleapTrackingLog, Warning, TEXT("FLeapFrameStreamer::Start failed to bind UDP port %d"), Port);
+		return false;
+	}
+
+	if (!MulticastGroup.IsEmpty())
+	{
+		bool bIsValid = false;
+		MulticastAddress = SocketSubsystem->CreateInternetAddr();
+		MulticastAddress->SetIp(*MulticastGroup, bIsValid);
+		MulticastAddress->SetPort(Port);
+		if (!bIsValid)
+		{
+			UE_LOG(UltraleapTrackingLog, Warning, TEXT("FLeapFrameStreamer::Start invalid multicast group %s"), *MulticastGroup);
+			MulticastAddress = nullptr;
+		}
+	}
+
+	if (bUseTCP)
+	{
+		TcpListener = FTcpSocketBuilder(TEXT("UltraleapFrameStreamListener"))
+						  .AsNonBlocking()
+						  .AsReusable()
+						  .BoundToPort(Port)
+						  .Listening(MaxSubscribers)
+						  .Build();
+		if (!TcpListener)
+		{
+			UE_LOG(UltraleapTrackingLog, Warning, TEXT("FLeapFrameStreamer::Start failed to listen on TCP port %d"), Port);
+			CloseSockets();
+			return false;
+		}
+	}
+
+	ReceiveBuffer.SetNumUninitialized(64);
+	bStopping = false;
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, TEXT("UltraleapFrameStreamer"), 0, TPri_AboveNormal);
+
+	UE_LOG(UltraleapTrackingLog, Log, TEXT("FLeapFrameStreamer streaming on port %d%s%s"), Port, bUseTCP ? TEXT(" (UDP and TCP)") : TEXT(""),
+		MulticastAddress.IsValid() ? *FString::Printf(TEXT(" multicast %s"), *MulticastGroup) : TEXT(""));
+	return true;
+}
+
+void FLeapFrameStreamer::Shutdown()
+{
+	if (Thread)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+	if (WakeEvent)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+		WakeEvent = nullptr;
+	}
+	CloseSockets();
+
+	FScopeLock ScopeLock(&QueueLock);
+	QueuedPackets.Reset();
+}
+
+bool FLeapFrameStreamer::IsStartedWith(const int32 InPort, const bool bInUseTCP, const FString& InMulticastGroup) const
+{
+	return Thread != nullptr && Port == InPort && bUseTCP == bInUseTCP && MulticastGroup == InMulticastGroup;
+}
+
+void FLeapFrameStreamer::SetMaxRate(const float InMaxRate)
+{
+	MaxRate = InMaxRate;
+}
+
+void FLeapFrameStreamer::SetBackPressure(const ELeapStreamBackPressure InBackPressure)
+{
+	BackPressure = InBackPressure;
+}
+
+void FLeapFrameStreamer::PushFrame(const LEAP_TRACKING_EVENT& Frame, const int64 DeviceNow)
+{
+	// the device is polled every game frame, which may be faster than it tracks
+	if (!Thread || NumSubscribers.GetValue() == 0 || Frame.info.timestamp == LastPushedTimeStamp)
+	{
+		return;
+	}
+	const double Now = FPlatformTime::Seconds();
+	if (MaxRate > 0 && (Now - LastPushTime) < 1.0 / MaxRate)
+	{
+		return;
+	}
+	LastPushTime = Now;
+	LastPushedTimeStamp = Frame.info.timestamp;
+
+	EncodeFrame(Frame, DeviceNow, ScratchPacket);
+	{
+		FScopeLock ScopeLock(&QueueLock);
+
+		// The worker hasn't caught up, either replace what it has not sent yet or queue behind it
+		const int32 MaxQueued = BackPressure == ELeapStreamBackPressure::LEAP_STREAM_LATEST_ONLY ? 1 : MaxQueuedPackets;
+		while (QueuedPackets.Num() >= MaxQueued)
+		{
+			FreePackets.Add(MoveTemp(QueuedPackets[0]));
+			QueuedPackets.RemoveAt(0);
+			FramesDropped.Increment();
+		}
+
+		FQueuedPacket Packet = FreePackets.Num() ? FreePackets.Pop() : FQueuedPacket();
+		Packet.Data.Reset();
+		Packet.Data.Append(ScratchPacket);
+		Packet.QueuedTime = Now;
+		QueuedPackets.Add(MoveTemp(Packet));
+	}
+	WakeEvent->Trigger();
+}
+
+void FLeapFrameStreamer::EncodeFrame(const LEAP_TRACKING_EVENT& Frame, const int64 DeviceNow, TArray<uint8>& OutPacket)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LeapStreamEncode);
+
+	OutPacket.Reset();
+	FMemoryWriter Writer(OutPacket);
+
+	// Patched once the size is known, skipped for UDP
+	uint16 Length = 0;
+	uint32 Magic = StreamMagic;
+	uint16 Version = StreamVersion;
+	uint8 NumHands = (uint8) FMath::Min<uint32>(Frame.nHands, 255);
+	uint8 Reserved = 0;
+	int32 FrameId = (int32) Frame.tracking_frame_id;
+	int64 TimeStamp = Frame.info.timestamp;
+	int64 SendTime = DeviceNow;
+	Writer << Length << Magic << Version << NumHands << Reserved << FrameId << TimeStamp << SendTime;
+
+	for (int32 i = 0; i < NumHands; i++)
+	{
+		const LEAP_HAND& Hand = Frame.pHands[i];
+		int32 Id = (int32) Hand.id;
+		uint8 HandType = Hand.type == eLeapHandType_Left ? 0 : 1;
+		uint8 Extended = 0;
+		for (int32 Digit = 0; Digit < 5; Digit++)
+		{
+			Extended |= Hand.digits[Digit].is_extended ? (1 << Digit) : 0;
+		}
+		float Confidence = Hand.confidence;
+		float GrabStrength = Hand.grab_strength;
+		float GrabAngle = Hand.grab_angle;
+		float PinchStrength = Hand.pinch_strength;
+		float PinchDistance = Hand.pinch_distance;
+		float VisibleTime = Hand.visible_time / 1000000.f;
+		float PalmWidth = Hand.palm.width;
+		Writer << Id << HandType << Extended << Reserved << Reserved;
+		Writer << Confidence << GrabStrength << GrabAngle << PinchStrength << PinchDistance << VisibleTime << PalmWidth;
+
+		WriteVector(Writer, Hand.palm.position);
+		WriteVector(Writer, Hand.palm.velocity);
+		WriteVector(Writer, Hand.palm.normal);
+		WriteVector(Writer, Hand.palm.direction);
+		WriteQuat(Writer, Hand.palm.orientation);
+
+		for (const LEAP_DIGIT& Digit : Hand.digits)
+		{
+			WriteDigitJoints(Writer, Digit);
+		}
+		for (const LEAP_DIGIT& Digit : Hand.digits)
+		{
+			WriteDigitRotations(Writer, Digit);
+		}
+		for (const LEAP_DIGIT& Digit : Hand.digits)
+		{
+			float Width = Digit.proximal.width;
+			Writer << Width;
+		}
+
+		WriteVector(Writer, Hand.arm.prev_joint);
+		WriteVector(Writer, Hand.arm.next_joint);
+		WritePackedQuat(Writer, Hand.arm.rotation);
+		float ArmWidth = Hand.arm.width;
+		Writer << ArmWidth;
+	}
+
+	Length = OutPacket.Num() - sizeof(uint16);
+	FMemory::Memcpy(OutPacket.GetData(), &Length, sizeof(uint16));
+}
+
+uint32 FLeapFrameStreamer::Run()
+{
+	while (!bStopping)
+	{
+		WakeEvent->Wait(PollIntervalInMS);
+		if (bStopping)
+		{
+			break;
+		}
+
+		const double Now = FPlatformTime::Seconds();
+		AcceptTcpClients();
+		ReceiveUdpSubscriptions(Now);
+
+		{
+			FScopeLock ScopeLock(&QueueLock);
+			Swap(SendingPackets, QueuedPackets);
+		}
+		for (const FQueuedPacket& Packet : SendingPackets)
+		{
+			SendPacket(Packet);
+		}
+		{
+			FScopeLock ScopeLock(&QueueLock);
+			for (FQueuedPacket& Packet : SendingPackets)
+			{
+				FreePackets.Add(MoveTemp(Packet));
+			}
+		}
+		SendingPackets.Reset();
+
+		NumSubscribers.Set(UdpSubscribers.Num() + TcpClients.Num() + (MulticastAddress.IsValid() ? 1 : 0));
+	}
+	return 0;
+}
+
+void FLeapFrameStreamer::Stop()
+{
+	bStopping = true;
+	if (WakeEvent)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+void FLeapFrameStreamer::AcceptTcpClients()
+{
+	if (!TcpListener)
+	{
+		return;
+	}
+	bool bHasPendingConnection = false;
+	while (TcpListener->HasPendingConnection(bHasPendingConnection) && bHasPendingConnection &&
+		   TcpClients.Num() < MaxSubscribers)
+	{
+		FSocket* Socket = TcpListener->Accept(TEXT("UltraleapFrameStreamClient"));
+		if (!Socket)
+		{
+			break;
+		}
+		Socket->SetNonBlocking(true);
+		Socket->SetNoDelay(true);
+		TcpClients.Add({Socket, TArray<uint8>()});
+	}
+}
+
+void FLeapFrameStreamer::ReceiveUdpSubscriptions(const double Now)
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	TSharedRef<FInternetAddr> Sender = SocketSubsystem->CreateInternetAddr();
+
+	uint32 PendingSize = 0;
+	while (UdpSocket->HasPendingData(PendingSize))
+	{
+		int32 BytesRead = 0;
+		if (!UdpSocket->RecvFrom(ReceiveBuffer.GetData(), ReceiveBuffer.Num(), BytesRead, *Sender))
+		{
+			break;
+		}
+		FUdpSubscriber* Existing =
+			UdpSubscribers.FindByPredicate([&Sender](const FUdpSubscriber& Subscriber) { return *Subscriber.Address == *Sender; });
+		if (Existing)
+		{
+			Existing->LastSeen = Now;
+		}
+		else if (UdpSubscribers.Num() < MaxSubscribers)
+		{
+			UdpSubscribers.Add({Sender->Clone(), Now});
+		}
+	}
+
+	UdpSubscribers.RemoveAll([Now](const FUdpSubscriber& Subscriber) { return Now - Subscriber.LastSeen > SubscriberTimeout; });
+}
+
+void FLeapFrameStreamer::SendPacket(const FQueuedPacket& Packet)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LeapStreamSend);
+
+	// UDP datagrams are self delimiting so skip the length prefix
+	const uint8* Datagram = Packet.Data.GetData() + sizeof(uint16);
+	const int32 DatagramSize = Packet.Data.Num() - sizeof(uint16);
+	int32 BytesSent = 0;
+	for (const FUdpSubscriber& Subscriber : UdpSubscribers)
+	{
+		UdpSocket->SendTo(Datagram, DatagramSize, BytesSent, *Subscriber.Address);
+	}
+	if (MulticastAddress.IsValid())
+	{
+		UdpSocket->SendTo(Datagram, DatagramSize, BytesSent, *MulticastAddress);
+	}
+
+	for (int32 i = TcpClients.Num() - 1; i >= 0; i--)
+	{
+		if (!SendToTcpClient(TcpClients[i], Packet.Data.GetData(), Packet.Data.Num()))
+		{
+			ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(TcpClients[i].Socket);
+			TcpClients.RemoveAtSwap(i);
+		}
+	}
+
+	const int32 Latency = (int32) ((FPlatformTime::Seconds() - Packet.QueuedTime) * 1000000.0);
+	SendLatencyInMicros.Set((SendLatencyInMicros.GetValue() * 7 + Latency) / 8);
+	FramesSent.Increment();
+}
+
+bool FLeapFrameStreamer::SendToTcpClient(FTcpClient& Client, const uint8* Data, const int32 Num)
+{
+	int32 BytesSent = 0;
+	if (Client.Backlog.Num())
+	{
+		if (!Client.Socket->Send(Client.Backlog.GetData(), Client.Backlog.Num(), BytesSent))
+		{
+			if (Client.Socket->GetConnectionState() != SCS_Connected)
+			{
+				return false;
+			}
+			BytesSent = 0;
+		}
+		Client.Backlog.RemoveAt(0, BytesSent);
+		if (Client.Backlog.Num())
+		{
+			// Keep packet boundaries intact, this frame goes behind the remainder unless the client is too far behind
+			if (Client.Backlog.Num() + Num > MaxTcpBacklog)
+			{
+				FramesDropped.Increment();
+				return true;
+			}
+			Client.Backlog.Append(Data, Num);
+			return true;
+		}
+	}
+
+	if (!Client.Socket->Send(Data, Num, BytesSent))
+	{
+		if (Client.Socket->GetConnectionState() != SCS_Connected)
+		{
+			return false;
+		}
+		BytesSent = 0;
+	}
+	if (BytesSent < Num)
+	{
+		Client.Backlog.Append(Data + BytesSent, Num - BytesSent);
+	}
+	return true;
+}
+
+void FLeapFrameStreamer::CloseSockets()
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	for (FTcpClient& Client : TcpClients)
+	{
+		Client.Socket->Close();
+		SocketSubsystem->DestroySocket(Client.Socket);
+	}
+	TcpClients.Reset();
+	UdpSubscribers.Reset();
+	NumSubscribers.Set(0);
+
+	if (TcpListener)
+	{
+		TcpListener->Close();
+		SocketSubsystem->DestroySocket(TcpListener);
+		TcpListener = nullptr;
+	}
+	if (UdpSocket)
+	{
+		UdpSocket->Close();
+		SocketSubsystem->DestroySocket(UdpSocket);
+		UdpSocket = nullptr;
+	}
+	MulticastAddress = nullptr;
+}
+
+void FLeapFrameStreamer::GetStats(FLeapStats& OutStats) const
+{
+	OutStats.StreamSubscribers = NumSubscribers.GetValue();
+	OutStats.StreamFramesSent = FramesSent.GetValue();
+	OutStats.StreamFramesDropped = FramesDropped.GetValue();
+	OutStats.StreamLatencyInMS = SendLatencyInMicros.GetValue() / 1000.f;
+}
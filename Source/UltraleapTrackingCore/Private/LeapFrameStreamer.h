@@ -0,0 +1,140 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "LeapC.h"
+#include "UltraleapTrackingData.h"
+
+class FSocket;
+class FInternetAddr;
+class FRunnableThread;
+
+/** Streams tracking frames to external (non Unreal) consumers over UDP and optionally TCP.
+ *
+ * One packet per frame, little endian. Over TCP each packet is preceded by its uint16 byte length.
+ *   Header: uint32 magic 'ULHF', uint16 version, uint8 hand count, uint8 reserved,
+ *           int32 frame id, int64 device timestamp (us), int64 device clock when queued (us)
+ *   Hand:   int32 id, uint8 hand type (0 left, 1 right), uint8 extended finger bits (thumb = bit 0), uint8 reserved[2],
+ *           float confidence, grab strength, grab angle, pinch strength, pinch distance, visible time (s), palm width,
+ *           float[3] palm position, velocity, normal, direction, float[4] palm orientation quaternion,
+ *           float[3] x 25 joints, thumb to pinky: metacarpal prev joint then the next joint of each bone,
+ *           int16[4] x 20 bone rotations, thumb to pinky and metacarpal to distal, quaternion components * 32767,
+ *           float[5] digit widths, float[3] elbow, float[3] wrist, int16[4] arm rotation, float arm width
+ * The header is 28 bytes and each hand 616, so two hands take 1260 bytes and fit in a single unfragmented datagram.
+ * Frames are the device's own LeapC frames in tracking space, in mm with LeapC axes and quaternions.
+ * None of the sender's mode, offset or HMD transforms are applied, receivers apply their own as for a local device.
+ * The device clock is the one frame timestamps use, which lets receivers estimate the clock offset (see FNetworkToLeapWrapper).
+ *
+ * UDP consumers subscribe by sending any datagram to the port, and resend at least every SubscriberTimeout seconds.
+ * Frames are also sent to the multicast group if one is set. TCP consumers just connect.
+ * Sockets are serviced on a dedicated thread, woken as soon as a frame is queued. */
+class FLeapFrameStreamer : public FRunnable
+{
+public:
+	FLeapFrameStreamer();
+	virtual ~FLeapFrameStreamer();
+
+	bool Start(const int32 InPort, const bool bInUseTCP, const FString& InMulticastGroup);
+	void Shutdown();
+	bool IsStartedWith(const int32 InPort, const bool bInUseTCP, const FString& InMulticastGroup) const;
+
+	/** Frames per second sent at most, 0 sends every frame */
+	void SetMaxRate(const float InMaxRate);
+	void SetBackPressure(const ELeapStreamBackPressure InBackPressure);
+
+	/** Encode and queue a LeapC frame, call from the thread capturing them. Repeats of the last frame are skipped.
+	 * DeviceNow is the tracking clock in us */
+	void PushFrame(const LEAP_TRACKING_EVENT& Frame, const int64 DeviceNow);
+
+	void GetStats(FLeapStats& OutStats) const;
+
+	static const uint32 StreamMagic = 0x46484C55;	 // 'ULHF'
+	static const uint16 StreamVersion = 3;
+	static const int32 NumJointsPerHand = 25;
+	static const int32 NumBonesPerHand = 20;
+
+	// FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	struct FUdpSubscriber
+	{
+		TSharedPtr<FInternetAddr> Address;
+		double LastSeen;
+	};
+	struct FQueuedPacket
+	{
+		TArray<uint8> Data;
+		double QueuedTime;
+	};
+	struct FTcpClient
+	{
+		FSocket* Socket;
+		// Bytes the socket would not take yet, sent before any newer frame
+		TArray<uint8> Backlog;
+	};
+
+	void EncodeFrame(const LEAP_TRACKING_EVENT& Frame, const int64 DeviceNow, TArray<uint8>& OutPacket);
+
+	void AcceptTcpClients();
+	void ReceiveUdpSubscriptions(const double Now);
+	void SendPacket(const FQueuedPacket& Packet);
+	bool SendToTcpClient(FTcpClient& Client, const uint8* Data, const int32 Num);
+	void CloseSockets();
+
+	int32 Port;
+	bool bUseTCP;
+	FString MulticastGroup;
+
+	float MaxRate;
+	double LastPushTime;
+	int64 LastPushedTimeStamp;
+	ELeapStreamBackPressure BackPressure;
+
+	// Producer side, reused so encoding doesn't allocate
+	TArray<uint8> ScratchPacket;
+
+	// Queued packets waiting for the worker, and spent buffers handed back for reuse
+	FCriticalSection QueueLock;
+	TArray<FQueuedPacket> QueuedPackets;
+	TArray<FQueuedPacket> FreePackets;
+
+	// Worker only
+	TArray<FQueuedPacket> SendingPackets;
+	FSocket* UdpSocket;
+	FSocket* TcpListener;
+	TSharedPtr<FInternetAddr> MulticastAddress;
+	TArray<FUdpSubscriber> UdpSubscribers;
+	TArray<FTcpClient> TcpClients;
+	TArray<uint8> ReceiveBuffer;
+
+	FRunnableThread* Thread;
+	FEvent* WakeEvent;
+	FThreadSafeBool bStopping;
+
+	FThreadSafeCounter NumSubscribers;
+	FThreadSafeCounter FramesSent;
+	FThreadSafeCounter FramesDropped;
+	// Time from PushFrame to the last socket send, in microseconds, smoothed
+	FThreadSafeCounter SendLatencyInMicros;
+
+	// Seconds without a keep alive before a UDP subscriber is dropped
+	static constexpr double SubscriberTimeout = 5.0;
+	static const int32 MaxSubscribers = 16;
+	static const int32 MaxQueuedPackets = 64;
+	// TCP clients buffering more than this are behind, and skip frames until they catch up
+	static const int32 MaxTcpBacklog = 64 * 1024;
+	// The worker wakes at least this often to accept connections and subscriptions
+	static const uint32 PollIntervalInMS = 10;
+};
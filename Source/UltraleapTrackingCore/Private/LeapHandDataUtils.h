@@ -0,0 +1,90 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UltraleapTrackingData.h"
+
+/**
+ * Access to the bones of FLeapHandData by index. The hand keeps each digit bone four times, in the Digits/Bones
+ * arrays and in the named Thumb..Pinky/Metacarpal..Distal members, and code writing bones has to keep them all in step
+ */
+class FLeapHandDataUtils
+{
+public:
+	/** Digit 0 is the thumb, 4 the pinky */
+	static FLeapDigitData& GetNamedDigit(FLeapHandData& Hand, const int32 Digit)
+	{
+		switch (Digit)
+		{
+			case 0:
+				return Hand.Thumb;
+			case 1:
+				return Hand.Index;
+			case 2:
+				return Hand.Middle;
+			case 3:
+				return Hand.Ring;
+			default:
+				return Hand.Pinky;
+		}
+	}
+
+	/** Bone 0 is the metacarpal, 3 the distal */
+	static FLeapBoneData& GetNamedBone(FLeapDigitData& Digit, const int32 Bone)
+	{
+		switch (Bone)
+		{
+			case 0:
+				return Digit.Metacarpal;
+			case 1:
+				return Digit.Proximal;
+			case 2:
+				return Digit.Intermediate;
+			default:
+				return Digit.Distal;
+		}
+	}
+
+	/** Whether the Digits/Bones arrays are fully populated, as they are for tracked hands */
+	static bool HasAllBones(const FLeapHandData& Hand)
+	{
+		if (Hand.Digits.Num() != 5)
+		{
+			return false;
+		}
+		for (const FLeapDigitData& Digit : Hand.Digits)
+		{
+			if (Digit.Bones.Num() != 4)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/** Writes a digit bone to every copy of it in the hand, which must have all bones */
+	static void SetDigitBone(FLeapHandData& Hand, const int32 Digit, const int32 Bone, const FVector& PrevJoint,
+		const FVector& NextJoint, const FRotator& Rotation)
+	{
+		FLeapDigitData& DigitData = Hand.Digits[Digit];
+		FLeapDigitData& NamedDigit = GetNamedDigit(Hand, Digit);
+		FLeapBoneData* Copies[] = {&DigitData.Bones[Bone], &GetNamedBone(DigitData, Bone), &GetNamedBone(NamedDigit, Bone),
+			NamedDigit.Bones.IsValidIndex(Bone) ? &NamedDigit.Bones[Bone] : nullptr};
+		for (FLeapBoneData* Copy : Copies)
+		{
+			if (Copy)
+			{
+				Copy->PrevJoint = PrevJoint;
+				Copy->NextJoint = NextJoint;
+				Copy->Rotation = Rotation;
+			}
+		}
+	}
+};
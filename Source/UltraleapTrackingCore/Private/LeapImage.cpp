@@ -9,19 +9,30 @@
 #include "LeapImage.h"
 
 #include "LeapAsync.h"
+#include "LeapImageProcessing.h"
+#include "UltraleapTrackingStats.h"
 
 #if (ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 4)
 #include "RenderingThread.h"
 #endif
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("Leap Image CPU Copies"), STAT_LeapImageCopies, STATGROUP_UltraleapTracking);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Leap Image GPU Uploads"), STAT_LeapImageUploads, STATGROUP_UltraleapTracking);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Leap Images Dropped"), STAT_LeapImagesDropped, STATGROUP_UltraleapTracking);
+DECLARE_CYCLE_STAT(TEXT("Leap Image Rectify"), STAT_LeapImageRectify, STATGROUP_UltraleapTracking);
+DECLARE_CYCLE_STAT(TEXT("Leap Image Downsample"), STAT_LeapImageProcess, STATGROUP_UltraleapTracking);
+
 FLeapImage::FLeapImage()
 {
+	Settings = MakeShared<FImageSettings, ESPMode::ThreadSafe>();
 	LeftImageTexture = nullptr;
 	RightImageTexture = nullptr;
+	Device = nullptr;
+	bHasCameraTransforms = false;
 	Reset();
 }
 
-bool FLeapImage::HasSameTextureFormat(UTexture2D* TexturePointer, const LEAP_IMAGE& Image)
+bool FLeapImage::HasSameTextureFormat(UTexture2D* TexturePointer, const uint32 Width, const uint32 Height)
 {
 	if (TexturePointer == nullptr)
 	{
@@ -29,205 +40,368 @@ bool FLeapImage::HasSameTextureFormat(UTexture2D* TexturePointer, const LEAP_IMA
 	}
 #if ENGINE_MAJOR_VERSION >= 5 
 	return (TexturePointer->IsValidLowLevelFast() && TexturePointer->GetPlatformData() &&
-			TexturePointer->GetPlatformData()->SizeX == Image.properties.width &&
-			TexturePointer->GetPlatformData()->SizeY == Image.properties.height);
+			TexturePointer->GetPlatformData()->SizeX == Width && TexturePointer->GetPlatformData()->SizeY == Height);
 #else
 	return (TexturePointer->IsValidLowLevelFast() && TexturePointer->PlatformData &&
-			TexturePointer->PlatformData->SizeX == Image.properties.width &&
-			TexturePointer->PlatformData->SizeY == Image.properties.height);
+			TexturePointer->PlatformData->SizeX == Width && TexturePointer->PlatformData->SizeY == Height);
 #endif
 }
 
-UTexture2D* FLeapImage::CreateTextureIfNeeded(UTexture2D* TexturePointer, const LEAP_IMAGE& Image)
+UTexture2D* FLeapImage::CreateTextureIfNeeded(UTexture2D* TexturePointer, const uint32 Width, const uint32 Height)
 {
 	if (bIsQuitting)
 	{
 		return nullptr;
 	}
 
-	if (!HasSameTextureFormat(TexturePointer, Image))
+	if (!HasSameTextureFormat(TexturePointer, Width, Height))
 	{
 		EPixelFormat PixelFormat = PF_G8;
-		if (TexturePointer->IsValidLowLevelFast())
+		if (TexturePointer && TexturePointer->IsValidLowLevelFast())
 		{
 			TexturePointer->RemoveFromRoot();
 		}
-		TexturePointer = UTexture2D::CreateTransient(Image.properties.width, Image.properties.height, PixelFormat);
+		// The only UpdateResource, after this the RHI texture is written to directly
+		TexturePointer = UTexture2D::CreateTransient(Width, Height, PixelFormat);
 		TexturePointer->CompressionSettings = TextureCompressionSettings::TC_Grayscale;
 		TexturePointer->UpdateResource();
 		TexturePointer->AddToRoot();
-		UpdateTextureRegion = FUpdateTextureRegion2D(0, 0, 0, 0, Image.properties.width, Image.properties.height);
 		return TexturePointer;
 	}
 	return TexturePointer;
 }
 
-void FLeapImage::UpdateTextureRegions(UTexture2D* Texture, int32 MipIndex, uint32 NumRegions, FUpdateTextureRegion2D* Regions,
-	uint32 SrcPitch, uint32 SrcBpp, uint8* SrcData, bool bFreeData)
+FLeapImage::FUploadBufferPtr FLeapImage::AcquireUploadBuffer()
 {
-#if ENGINE_MAJOR_VERSION >= 5 
-	if (Texture->GetResource())
-#else
-	if (Texture->Resource)
-#endif
+	FScopeLock Lock(&UploadLock);
+	if (UploadBuffers.Num() == 0)
 	{
-		struct FUpdateTextureRegionsData
-		{
-			FTexture2DResource* Texture2DResource;
-			int32 MipIndex;
-			uint32 NumRegions;
-			FUpdateTextureRegion2D* Regions;
-			uint32 SrcPitch;
-			uint32 SrcBpp;
-			uint8* SrcData;
-			bool bFreeData;
-			FLeapImage* LeapImagePtr;
-		};
-
-		FUpdateTextureRegionsData* RegionData = new FUpdateTextureRegionsData;
-#if ENGINE_MAJOR_VERSION >= 5 
-		RegionData->Texture2DResource = (FTexture2DResource*) Texture->GetResource();
-#else
-		RegionData->Texture2DResource = (FTexture2DResource*) Texture->Resource;
-#endif
-		RegionData->MipIndex = MipIndex;
-		RegionData->NumRegions = NumRegions;
-		RegionData->Regions = Regions;
-		RegionData->SrcPitch = SrcPitch;
-		RegionData->SrcBpp = SrcBpp;
-		RegionData->SrcData = SrcData;
-		RegionData->bFreeData = bFreeData;
-		RegionData->LeapImagePtr = this;
-
-		ENQUEUE_RENDER_COMMAND(UpdateTextureRegionsData)
-		([RegionData](FRHICommandListImmediate& RHICmdList) {
-			for (uint32 RegionIndex = 0; RegionIndex < RegionData->NumRegions; ++RegionIndex)
-			{
-				int32 CurrentFirstMip = RegionData->Texture2DResource->GetCurrentFirstMip();
-				if (RegionData->MipIndex >= CurrentFirstMip)
-				{
-					RHIUpdateTexture2D(RegionData->Texture2DResource->GetTexture2DRHI(), RegionData->MipIndex - CurrentFirstMip,
-						RegionData->Regions[RegionIndex], RegionData->SrcPitch,
-						RegionData->SrcData + RegionData->Regions[RegionIndex].SrcY * RegionData->SrcPitch +
-							RegionData->Regions[RegionIndex].SrcX * RegionData->SrcBpp);
-				}
-			}
-			if (RegionData->bFreeData)
-			{
-				FMemory::Free(RegionData->SrcData);
-			}
-			RegionData->LeapImagePtr->bRenderDidUpdate = true;
-			delete RegionData;
-		});	   // End Enqueue
+		return nullptr;
 	}
+	FUploadBufferPtr& Buffer = UploadBuffers[NextUploadBuffer];
+	if (Buffer->bInUse)
+	{
+		// Render thread hasn't caught up, dropping is better than queueing latency
+		return nullptr;
+	}
+	NextUploadBuffer = (NextUploadBuffer + 1) % UploadBuffers.Num();
+	Buffer->bInUse = true;
+	return Buffer;
 }
 
-void FLeapImage::UpdateTextureRegions(UTexture2D* Texture, const LEAP_IMAGE& Image, uint8* SrcData)
-{
-	UpdateTextureRegions(Texture, 0, 1, &UpdateTextureRegion, Image.properties.width, Image.properties.bpp, SrcData, true);
-}
-
-void FLeapImage::UpdateTextureOnGameThread(UTexture2D* Texture, uint8* SrcData, const int32 BufferLength)
+void FLeapImage::EnqueueUpload(const FUploadBufferPtr& Buffer)
 {
 #if ENGINE_MAJOR_VERSION >= 5 
-	uint8* MipData = static_cast<uint8*>(Texture->GetPlatformData()->Mips[0].BulkData.Lock(LOCK_READ_WRITE));
+	FTexture2DResource* LeftResource = (FTexture2DResource*) LeftImageTexture->GetResource();
+	FTexture2DResource* RightResource = (FTexture2DResource*) RightImageTexture->GetResource();
 #else
-	uint8* MipData = static_cast<uint8*>(Texture->PlatformData->Mips[0].BulkData.Lock(LOCK_READ_WRITE));
+	FTexture2DResource* LeftResource = (FTexture2DResource*) LeftImageTexture->Resource;
+	FTexture2DResource* RightResource = (FTexture2DResource*) RightImageTexture->Resource;
 #endif
-	memcpy(MipData, SrcData, BufferLength);
+	if (!LeftResource || !RightResource)
+	{
+		Buffer->bInUse = false;
+		return;
+	}
 
-#if ENGINE_MAJOR_VERSION >= 5 
-	Texture->GetPlatformData()->Mips[0].BulkData.Unlock();
-#else
-	Texture->PlatformData->Mips[0].BulkData.Unlock();
-#endif
-	Texture->UpdateResource();
+	ENQUEUE_RENDER_COMMAND(UpdateLeapImageTextures)
+	([LeftResource, RightResource, Buffer](FRHICommandListImmediate& RHICmdList) {
+		const FUpdateTextureRegion2D Region(0, 0, 0, 0, Buffer->Width, Buffer->Height);
+		const uint32 Pitch = Buffer->Width * Buffer->Bpp;
+		FTexture2DResource* Resources[2] = {LeftResource, RightResource};
+		for (int32 ImageIndex = 0; ImageIndex < 2; ImageIndex++)
+		{
+			if (Resources[ImageIndex]->GetTexture2DRHI())
+			{
+				RHIUpdateTexture2D(Resources[ImageIndex]->GetTexture2DRHI(), 0, Region, Pitch, Buffer->Images[ImageIndex].GetData());
+				INC_DWORD_STAT(STAT_LeapImageUploads);
+			}
+		}
+		Buffer->bInUse = false;
+	});	   // End Enqueue
 }
 
 void FLeapImage::OnImage(const LEAP_IMAGE_EVENT* ImageEvent)
 {
-	// Don't schedule more events if we've received quitting signal or we haven't updated the last render
-	if (bIsQuitting || !bRenderDidUpdate)
+	if (bIsQuitting)
 	{
 		return;
 	}
 
-	const LEAP_IMAGE& LeftLeapImage = ImageEvent->image[0];
-	const LEAP_IMAGE& RightLeapImage = ImageEvent->image[1];
-	const int32 BufferSize =
-		LeftLeapImage.properties.height * LeftLeapImage.properties.width * LeftLeapImage.properties.bpp;	// same size for both
-	if (LeftImageBuffer.Num() != BufferSize)
+	ImagesReceived.Increment();
+	const int64 FrameId = ImageEvent->info.frame_id;
+	if (LastImageFrameId > 0 && FrameId > LastImageFrameId + 1)
 	{
-		LeftImageBuffer.SetNumUninitialized(BufferSize);
+		ImageFramesMissed.Add(FrameId - LastImageFrameId - 1);
 	}
-	if (RightImageBuffer.Num() != BufferSize)
+	LastImageFrameId = FrameId;
+
+	// Kept regardless of whether anything is rendering the images
+	History.Add(ImageEvent);
+
+	// Don't schedule more events if nothing is listening
+	if (!OnImageCallback.IsBound())
 	{
-		RightImageBuffer.SetNumUninitialized(BufferSize);
+		return;
 	}
 
-	// Texture allocation
-	LeftImageTexture = CreateTextureIfNeeded(LeftImageTexture, LeftLeapImage);
-	if (LeftImageTexture)
+	FUploadBufferPtr Buffer = AcquireUploadBuffer();
+	if (!Buffer.IsValid())
 	{
-		// memcopy to a safe resource area
-		uint8* SrcPtr = (uint8*) LeftLeapImage.data + LeftLeapImage.offset;
-		FMemory::Memcpy(LeftImageBuffer.GetData(), SrcPtr, BufferSize);
+		ImagesDropped.Increment();
+		INC_DWORD_STAT(STAT_LeapImagesDropped);
+		return;
 	}
 
-	RightImageTexture = CreateTextureIfNeeded(RightImageTexture, RightLeapImage);
-	if (RightImageTexture)
+	// one snapshot for the whole image
+	const FImageSettingsPtr ImageSettings = GetSettings();
+	const bool bRectify = ImageSettings->bRectify;
+
+	const LEAP_IMAGE_PROPERTIES& Properties = ImageEvent->image[0].properties;	 // same size for both
+	const int32 BufferSize = Properties.height * Properties.width * Properties.bpp;
+	Buffer->Width = Properties.width;
+	Buffer->Height = Properties.height;
+	Buffer->Bpp = Properties.bpp;
+
+	// Reduced images are processed straight out of LeapC's buffer, the full resolution image is never copied
+	if (!bRectify && Properties.bpp == 1 && (ImageSettings->DownsampleFactor > 1 || ImageSettings->bHandRegionOfInterest))
 	{
-		// memcopy to a safe resource area
-		uint8* SrcPtr = (uint8*) RightLeapImage.data + RightLeapImage.offset;
-		FMemory::Memcpy(RightImageBuffer.GetData(), SrcPtr, BufferSize);
+		ProcessImages(ImageEvent, *ImageSettings, *Buffer);
+		PublishOnGameThread(Buffer);
+		return;
 	}
 
-	bRenderDidUpdate = false;
+	// The only CPU copy, LeapC's buffer is only valid for the duration of this callback
+	for (int32 ImageIndex = 0; ImageIndex < 2; ImageIndex++)
+	{
+		const LEAP_IMAGE& LeapImage = ImageEvent->image[ImageIndex];
+		TArray<uint8>& Dest = Buffer->Images[ImageIndex];
+		if (Dest.Num() != BufferSize)
+		{
+			Dest.SetNumUninitialized(BufferSize);
+		}
+		FMemory::Memcpy(Dest.GetData(), (uint8*) LeapImage.data + LeapImage.offset, BufferSize);
+		INC_DWORD_STAT(STAT_LeapImageCopies);
+	}
 
-	if (OnImageCallback.IsBound())
+	// Only 8 bit images are supported, the textures are PF_G8
+	if (bRectify && Properties.bpp == 1)
 	{
-		if (LeftImageTexture && RightImageTexture)
+		// Tables are (re)built here as the distortion matrix is only valid during this callback
+		// Rectified images are scaled down by the same factor
+		Rectifier.Width = RectifiedImageSize / ImageSettings->DownsampleFactor;
+		Rectifier.Height = RectifiedImageSize / ImageSettings->DownsampleFactor;
+		const FLeapImageRectifier::FLookupTablePtr Tables[2] = {
+			Rectifier.GetLookupTable(0, ImageEvent->image[0]), Rectifier.GetLookupTable(1, ImageEvent->image[1])};
+		if (Tables[0].IsValid() && Tables[1].IsValid())
 		{
-			FLeapAsync::RunShortLambdaOnGameThread([&, BufferSize] {
-				if (bIsQuitting)
+			TWeakPtr<FLeapImage, ESPMode::ThreadSafe> WeakThis = AsShared();
+			FLeapAsync::RunLambdaOnBackGroundThreadPool([WeakThis, Buffer, Tables] {
+				RectifyBuffer(Buffer, Tables);
+				TSharedPtr<FLeapImage, ESPMode::ThreadSafe> This = WeakThis.Pin();
+				if (!This.IsValid())
 				{
+					Buffer->bInUse = false;
 					return;
 				}
-				// This is sufficient for now since leap images are small
-				UpdateTextureOnGameThread(LeftImageTexture, LeftImageBuffer.GetData(), BufferSize);
-				UpdateTextureOnGameThread(RightImageTexture, RightImageBuffer.GetData(), BufferSize);
-				bRenderDidUpdate = true;
+				This->PublishOnGameThread(Buffer);
+			});
+			return;
+		}
+	}
+	PublishOnGameThread(Buffer);
+}
 
-				// Todo: swap to optimized when ready
-				// UpdateTextureRegions(LeftImageTexture, LeftLeapImage, LeftImageBuffer.GetData());
-				// UpdateTextureRegions(RightImageTexture, RightLeapImage, RightImageBuffer.GetData());
+void FLeapImage::OnFrame(const LEAP_TRACKING_EVENT* TrackingEvent)
+{
+	if (!GetSettings()->bHandRegionOfInterest)
+	{
+		return;
+	}
+	TrackedPalms.Reset();
+	for (uint32 HandIndex = 0; HandIndex < TrackingEvent->nHands && HandIndex < 2; HandIndex++)
+	{
+		TrackedPalms.Add(TrackingEvent->pHands[HandIndex].palm.position);
+	}
+}
 
-				OnImageCallback.Broadcast(LeftImageTexture, RightImageTexture);
-			});
+void FLeapImage::ProcessImages(const LEAP_IMAGE_EVENT* ImageEvent, const FImageSettings& ImageSettings, FUploadBuffer& Buffer)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LeapImageProcess);
+	const LEAP_IMAGE_PROPERTIES& Properties = ImageEvent->image[0].properties;
+	const int32 Factor = ImageSettings.DownsampleFactor;
+
+	if (ImageSettings.bHandRegionOfInterest && Device && !bHasCameraTransforms)
+	{
+		FMatrix CameraToTracking[2];
+		if (Device->GetCameraToTrackingTransform(0, CameraToTracking[0]) &&
+			Device->GetCameraToTrackingTransform(1, CameraToTracking[1]))
+		{
+			TrackingToCamera[0] = CameraToTracking[0].Inverse();
+			TrackingToCamera[1] = CameraToTracking[1].Inverse();
+			bHasCameraTransforms = true;
+		}
+	}
+
+	for (int32 ImageIndex = 0; ImageIndex < 2; ImageIndex++)
+	{
+		const LEAP_IMAGE& LeapImage = ImageEvent->image[ImageIndex];
+
+		FIntRect Region(0, 0, Properties.width, Properties.height);
+		if (ImageSettings.bHandRegionOfInterest)
+		{
+			// Centre on the palms, stay where we were when there are no hands so the view doesn't jump
+			FVector2D Centre = FVector2D::ZeroVector;
+			int32 NumProjected = 0;
+			for (const LEAP_VECTOR& Palm : TrackedPalms)
+			{
+				FVector2D Pixel;
+				if (bHasCameraTransforms && FLeapImageProcessing::ProjectToImage(
+												*Device, ImageIndex, TrackingToCamera[ImageIndex], LeapImage, Palm, Pixel))
+				{
+					Centre += Pixel;
+					NumProjected++;
+				}
+			}
+			if (NumProjected > 0)
+			{
+				RegionCentres[ImageIndex] = Centre / NumProjected;
+			}
+			else if (RegionCentres[ImageIndex].IsZero())
+			{
+				RegionCentres[ImageIndex] = FVector2D(Properties.width / 2, Properties.height / 2);
+			}
+			Region = FLeapImageProcessing::GetRegionAround(
+				RegionCentres[ImageIndex], ImageSettings.RegionOfInterestSize, Properties.width, Properties.height);
 		}
+		// whole output pixels only
+		Region.Max.X -= Region.Width() % Factor;
+		Region.Max.Y -= Region.Height() % Factor;
+
+		Buffer.Width = Region.Width() / Factor;
+		Buffer.Height = Region.Height() / Factor;
+		TArray<uint8>& Dest = Buffer.Images[ImageIndex];
+		Dest.SetNumUninitialized(Buffer.Width * Buffer.Height, false);
+		FLeapImageProcessing::DownsampleRegion(
+			(const uint8*) LeapImage.data + LeapImage.offset, Properties.width, Region, Factor, Dest.GetData());
+		INC_DWORD_STAT(STAT_LeapImageCopies);
+	}
+}
+
+void FLeapImage::RectifyBuffer(const FUploadBufferPtr& Buffer, const FLeapImageRectifier::FLookupTablePtr Tables[2])
+{
+	SCOPE_CYCLE_COUNTER(STAT_LeapImageRectify);
+	for (int32 ImageIndex = 0; ImageIndex < 2; ImageIndex++)
+	{
+		const FLeapImageRectifier::FLookupTable& Table = *Tables[ImageIndex];
+		TArray<uint8>& Dest = Buffer->Rectified[ImageIndex];
+		Dest.SetNumUninitialized(Table.Width * Table.Height, false);
+		FLeapImageRectifier::Rectify(Buffer->Images[ImageIndex].GetData(), Table, Dest.GetData());
+		Swap(Buffer->Images[ImageIndex], Dest);
 	}
+	Buffer->Width = Tables[0]->Width;
+	Buffer->Height = Tables[0]->Height;
+}
+
+void FLeapImage::PublishOnGameThread(const FUploadBufferPtr& Buffer)
+{
+	TWeakPtr<FLeapImage, ESPMode::ThreadSafe> WeakThis = AsShared();
+	FLeapAsync::RunShortLambdaOnGameThread([WeakThis, Buffer] {
+		// the handler may have gone with its device by the time this runs
+		TSharedPtr<FLeapImage, ESPMode::ThreadSafe> This = WeakThis.Pin();
+		if (!This.IsValid() || This->bIsQuitting)
+		{
+			Buffer->bInUse = false;
+			return;
+		}
+		// Textures are UObjects so only ever created here
+		This->LeftImageTexture = This->CreateTextureIfNeeded(This->LeftImageTexture, Buffer->Width, Buffer->Height);
+		This->RightImageTexture = This->CreateTextureIfNeeded(This->RightImageTexture, Buffer->Width, Buffer->Height);
+		if (!This->LeftImageTexture || !This->RightImageTexture)
+		{
+			Buffer->bInUse = false;
+			return;
+		}
+		This->EnqueueUpload(Buffer);
+
+		This->OnImageCallback.Broadcast(This->LeftImageTexture, This->RightImageTexture);
+	});
+}
+
+FLeapImage::FImageSettingsPtr FLeapImage::GetSettings() const
+{
+	FScopeLock Lock(&SettingsLock);
+	return Settings;
+}
+
+void FLeapImage::SetSettings(const FImageSettings& InSettings)
+{
+	FImageSettingsPtr NewSettings = MakeShared<FImageSettings, ESPMode::ThreadSafe>(InSettings);
+	FScopeLock Lock(&SettingsLock);
+	Settings = NewSettings;
+}
+
+void FLeapImage::SetRectify(const bool bInRectify)
+{
+	FImageSettings NewSettings = *GetSettings();
+	NewSettings.bRectify = bInRectify;
+	SetSettings(NewSettings);
+}
+
+void FLeapImage::SetImageProcessing(
+	const int32 InDownsampleFactor, const bool bInHandRegionOfInterest, const int32 InRegionOfInterestSize)
+{
+	FImageSettings NewSettings = *GetSettings();
+	NewSettings.DownsampleFactor = InDownsampleFactor >= 4 ? 4 : (InDownsampleFactor >= 2 ? 2 : 1);
+	NewSettings.bHandRegionOfInterest = bInHandRegionOfInterest;
+	NewSettings.RegionOfInterestSize = FMath::Max(InRegionOfInterestSize, 16);
+	SetSettings(NewSettings);
+}
+
+void FLeapImage::GetStats(FLeapStats& OutStats) const
+{
+	OutStats.ImagesReceived = ImagesReceived.GetValue();
+	OutStats.ImagesDropped = ImagesDropped.GetValue();
+	OutStats.ImageFramesMissed = ImageFramesMissed.GetValue();
+	OutStats.ImagesOverwritten = History.GetNumOverwritten();
+}
+
+void FLeapImage::SetDevice(IHandTrackingWrapper* InDevice)
+{
+	Device = InDevice;
+	bHasCameraTransforms = false;
 }
 
 void FLeapImage::CleanupImageData()
 {
+	bIsQuitting = true;
 	if (LeftImageTexture != nullptr && LeftImageTexture->IsValidLowLevelFast())
 	{
 		LeftImageTexture->RemoveFromRoot();
-		RightImageTexture = nullptr;
+		LeftImageTexture = nullptr;
 	}
 	if (RightImageTexture != nullptr && RightImageTexture->IsValidLowLevelFast())
 	{
 		RightImageTexture->RemoveFromRoot();
 		RightImageTexture = nullptr;
 	}
-	LeftImageBuffer.Empty();
-	RightImageBuffer.Empty();
-	bIsQuitting = true;
+	// in flight uploads keep their buffer alive until the render thread is done with it
+	FScopeLock Lock(&UploadLock);
+	UploadBuffers.Empty();
 }
 
 void FLeapImage::Reset()
 {
 	CleanupImageData();
+	{
+		FScopeLock Lock(&UploadLock);
+		for (int32 Index = 0; Index < NumUploadBuffers; Index++)
+		{
+			UploadBuffers.Add(MakeShared<FUploadBuffer, ESPMode::ThreadSafe>());
+		}
+		NextUploadBuffer = 0;
+	}
+	LastImageFrameId = 0;
+	RegionCentres[0] = RegionCentres[1] = FVector2D::ZeroVector;
 	bIsQuitting = false;
-	bRenderDidUpdate = true;
 }
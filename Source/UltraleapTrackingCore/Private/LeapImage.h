@@ -17,15 +17,24 @@
 #if (ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 3) 
 #include "Rendering/Texture2DResource.h"
 #endif
+#include "HAL/CriticalSection.h"
 #include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "IUltraleapTrackingPlugin.h"
+#include "LeapImageHistory.h"
+#include "LeapImageRectifier.h"
 #include "RHI.h"
 #include "UltraleapTrackingData.h"
 
 /** Signature with Left/Right Image pair */
 DECLARE_MULTICAST_DELEGATE_TwoParams(FLeapImageRawSignature, UTexture2D*, UTexture2D*);
 
-/** Handles checking, conversion, scheduling, and forwarding of image texture data from leap type events */
-class FLeapImage
+/** Handles checking, conversion, scheduling, and forwarding of image texture data from leap type events
+ *
+ * Images are copied once from LeapC into a ring of persistent upload buffers and streamed into the textures on the
+ * render thread with RHIUpdateTexture2D, textures are only (re)created when the image format changes.
+ * Owned through a thread safe shared pointer, work queued to other threads only holds it weakly */
+class FLeapImage : public TSharedFromThis<FLeapImage, ESPMode::ThreadSafe>
 {
 public:
 	FLeapImage();
@@ -33,28 +42,97 @@ public:
 	// Callback when an image has been processed and is ready to consume
 	FLeapImageRawSignature OnImageCallback;
 
-	bool HasSameTextureFormat(UTexture2D* TexturePointer, const LEAP_IMAGE& Image);
-	UTexture2D* CreateTextureIfNeeded(UTexture2D* TexturePointer, const LEAP_IMAGE& Image);
-	void UpdateTextureRegions(UTexture2D* Texture, int32 MipIndex, uint32 NumRegions, FUpdateTextureRegion2D* Regions,
-		uint32 SrcPitch, uint32 SrcBpp, uint8* SrcData, bool bFreeData);
-	void UpdateTextureRegions(UTexture2D* Texture, const LEAP_IMAGE& ImageProps, uint8* SrcData);
+	bool HasSameTextureFormat(UTexture2D* TexturePointer, const uint32 Width, const uint32 Height);
+	UTexture2D* CreateTextureIfNeeded(UTexture2D* TexturePointer, const uint32 Width, const uint32 Height);
 
-	// Backup function, images are fairly small
-	void UpdateTextureOnGameThread(UTexture2D* Texture, uint8* SrcData, const int32 BufferLength);
 	void OnImage(const LEAP_IMAGE_EVENT* ImageEvent);
+	// Tracks the palms for the hand region of interest, called on the same LeapC thread as OnImage
+	void OnFrame(const LEAP_TRACKING_EVENT* TrackingEvent);
 
 	void CleanupImageData();
 	void Reset();
 
+	/** Publish undistorted images instead of the raw sensor images, rectification runs on a worker thread */
+	void SetRectify(const bool bInRectify);
+
+	/** Raw image pairs kept for matching with tracking frames */
+	FLeapImageHistory History;
+
+	/** Downsample factor (1, 2 or 4) and optional hand centred region applied before upload */
+	void SetImageProcessing(const int32 InDownsampleFactor, const bool bInHandRegionOfInterest, const int32 InRegionOfInterestSize);
+
+	/** Fill in the image counters */
+	void GetStats(FLeapStats& OutStats) const;
+
+	/** Device whose camera model places the hand region of interest, set before images are enabled */
+	void SetDevice(IHandTrackingWrapper* InDevice);
+
+	// Images in flight between the LeapC thread and the render thread, further images are dropped
+	static const int32 NumUploadBuffers = 3;
+	// Rectified output size before downsampling
+	static const int32 RectifiedImageSize = 400;
+
 private:
+	struct FUploadBuffer
+	{
+		// Left, Right, what gets uploaded
+		TArray<uint8> Images[2];
+		// Rectification output, swapped into Images when done
+		TArray<uint8> Rectified[2];
+		uint32 Width = 0;
+		uint32 Height = 0;
+		uint32 Bpp = 0;
+		// Set while filled or queued for upload, cleared by the render thread
+		FThreadSafeBool bInUse;
+	};
+	typedef TSharedPtr<FUploadBuffer, ESPMode::ThreadSafe> FUploadBufferPtr;
+
+	// Set on the game thread, read on the LeapC thread, replaced whole so an image never sees half an update
+	struct FImageSettings
+	{
+		bool bRectify = false;
+		int32 DownsampleFactor = 1;
+		bool bHandRegionOfInterest = false;
+		int32 RegionOfInterestSize = 128;
+	};
+	typedef TSharedPtr<const FImageSettings, ESPMode::ThreadSafe> FImageSettingsPtr;
+
+	FImageSettingsPtr GetSettings() const;
+	void SetSettings(const FImageSettings& InSettings);
+
+	FUploadBufferPtr AcquireUploadBuffer();
+	// Game thread, enqueues the upload of both images
+	void EnqueueUpload(const FUploadBufferPtr& Buffer);
+	// Any thread, creates textures if needed, uploads and broadcasts on the game thread
+	void PublishOnGameThread(const FUploadBufferPtr& Buffer);
+	// Worker thread
+	static void RectifyBuffer(const FUploadBufferPtr& Buffer, const FLeapImageRectifier::FLookupTablePtr Tables[2]);
+
 	UTexture2D* LeftImageTexture;
 	UTexture2D* RightImageTexture;
-	FUpdateTextureRegion2D UpdateTextureRegion;
-	TArray<uint8> LeftImageBuffer;
-	TArray<uint8> RightImageBuffer;
-	bool bIsQuitting;
-	FThreadSafeBool bRenderDidUpdate;
-
-	// FThreadSafeBool bRenderDidUpdateLeft;
-	// FThreadSafeBool bRenderDidUpdateRight;
-};
\ No newline at end of file
+	// Acquired on the LeapC thread, recreated on the game thread
+	FCriticalSection UploadLock;
+	TArray<FUploadBufferPtr> UploadBuffers;
+	int32 NextUploadBuffer;
+	FThreadSafeBool bIsQuitting;
+
+	mutable FCriticalSection SettingsLock;
+	FImageSettingsPtr Settings;
+
+	// LeapC thread only
+	FLeapImageRectifier Rectifier;
+
+	// Crop/downsample straight from the LeapC buffer into the upload buffer
+	void ProcessImages(const LEAP_IMAGE_EVENT* ImageEvent, const FImageSettings& ImageSettings, FUploadBuffer& Buffer);
+	TArray<LEAP_VECTOR, TInlineAllocator<2>> TrackedPalms;
+	FVector2D RegionCentres[2];
+	IHandTrackingWrapper* Device;
+	// fetched from LeapC with the first image, the extrinsics don't change while the device is connected
+	FMatrix TrackingToCamera[2];
+	bool bHasCameraTransforms;
+
+	FThreadSafeCounter ImagesReceived;
+	FThreadSafeCounter ImagesDropped;
+	FThreadSafeCounter ImageFramesMissed;
+	int64 LastImageFrameId;
+};
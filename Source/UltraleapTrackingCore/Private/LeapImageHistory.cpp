@@ -0,0 +1,109 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+
+#include "LeapImageHistory.h"
+
+FLeapImageHistory::FLeapImageHistory() : NextSlot(0), NumOverwritten(0)
+{
+}
+
+void FLeapImageHistory::SetCapacity(const int32 InCapacity)
+{
+	FScopeLock ScopeLock(&HistoryLock);
+	const int32 Capacity = FMath::Max(InCapacity, 0);
+	if (Slots.Num() == Capacity)
+	{
+		return;
+	}
+	Slots.Empty(Capacity);
+	Slots.SetNum(Capacity);
+	NextSlot = 0;
+}
+
+int32 FLeapImageHistory::GetCapacity() const
+{
+	FScopeLock ScopeLock(&HistoryLock);
+	return Slots.Num();
+}
+
+void FLeapImageHistory::Add(const LEAP_IMAGE_EVENT* ImageEvent)
+{
+	FScopeLock ScopeLock(&HistoryLock);
+	if (Slots.Num() == 0)
+	{
+		return;
+	}
+	FSlot& Slot = Slots[NextSlot];
+	NextSlot = (NextSlot + 1) % Slots.Num();
+	if (Slot.bValid && !Slot.bRead)
+	{
+		NumOverwritten++;
+	}
+
+	const LEAP_IMAGE_PROPERTIES& Properties = ImageEvent->image[0].properties;
+	const int32 BufferSize = Properties.width * Properties.height * Properties.bpp;
+
+	FLeapImagePair& Pair = Slot.Pair;
+	Pair.FrameId = ImageEvent->info.frame_id;
+	Pair.TimeStamp = ImageEvent->info.timestamp;
+	Pair.Width = Properties.width;
+	Pair.Height = Properties.height;
+	// same size every frame, so after the first pass through the ring these don't reallocate
+	TArray<uint8>* Images[2] = {&Pair.Left, &Pair.Right};
+	for (int32 ImageIndex = 0; ImageIndex < 2; ImageIndex++)
+	{
+		const LEAP_IMAGE& LeapImage = ImageEvent->image[ImageIndex];
+		Images[ImageIndex]->SetNumUninitialized(BufferSize, false);
+		FMemory::Memcpy(Images[ImageIndex]->GetData(), (uint8*) LeapImage.data + LeapImage.offset, BufferSize);
+	}
+	Slot.bValid = true;
+	Slot.bRead = false;
+}
+
+bool FLeapImageHistory::FindByFrameId(const int64 FrameId, FLeapImagePair& OutPair) const
+{
+	FScopeLock ScopeLock(&HistoryLock);
+	for (const FSlot& Slot : Slots)
+	{
+		if (Slot.bValid && Slot.Pair.FrameId == FrameId)
+		{
+			OutPair = Slot.Pair;
+			Slot.bRead = true;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FLeapImageHistory::FindNearestTimeStamp(const int64 TimeStamp, FLeapImagePair& OutPair) const
+{
+	FScopeLock ScopeLock(&HistoryLock);
+	const FSlot* Nearest = nullptr;
+	for (const FSlot& Slot : Slots)
+	{
+		if (Slot.bValid &&
+			(!Nearest || FMath::Abs(Slot.Pair.TimeStamp - TimeStamp) < FMath::Abs(Nearest->Pair.TimeStamp - TimeStamp)))
+		{
+			Nearest = &Slot;
+		}
+	}
+	if (!Nearest)
+	{
+		return false;
+	}
+	OutPair = Nearest->Pair;
+	Nearest->bRead = true;
+	return true;
+}
+
+int32 FLeapImageHistory::GetNumOverwritten() const
+{
+	FScopeLock ScopeLock(&HistoryLock);
+	return NumOverwritten;
+}
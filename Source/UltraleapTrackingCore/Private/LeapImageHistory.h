@@ -0,0 +1,48 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LeapC.h"
+#include "UltraleapTrackingData.h"
+
+/** Bounded history of the last N raw stereo image pairs keyed by device frame id (FLeapFrameData::DeviceFrameId), so
+ * images can be matched with the hands they were tracked from. Slots are reused so memory stays fixed once the ring has filled */
+class FLeapImageHistory
+{
+public:
+	FLeapImageHistory();
+
+	/** Number of pairs kept, 0 or less disables the history */
+	void SetCapacity(const int32 InCapacity);
+	int32 GetCapacity() const;
+
+	/** Copy the images out of the event, call from the LeapC thread */
+	void Add(const LEAP_IMAGE_EVENT* ImageEvent);
+
+	bool FindByFrameId(const int64 FrameId, FLeapImagePair& OutPair) const;
+	bool FindNearestTimeStamp(const int64 TimeStamp, FLeapImagePair& OutPair) const;
+
+	/** Pairs evicted before anyone looked them up */
+	int32 GetNumOverwritten() const;
+
+private:
+	struct FSlot
+	{
+		FLeapImagePair Pair;
+		bool bValid = false;
+		// set by lookups
+		mutable bool bRead = false;
+	};
+	TArray<FSlot> Slots;
+	int32 NextSlot;
+	int32 NumOverwritten;
+	mutable FCriticalSection HistoryLock;
+};
@@ -0,0 +1,112 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+
+#include "LeapImageProcessing.h"
+
+namespace
+{
+template <int32 Factor>
+void BoxFilter(const uint8* Src, const int32 SrcPitch, const FIntRect& SrcRect, uint8* Dst)
+{
+	const int32 Width = SrcRect.Width();
+	const int32 OutWidth = Width / Factor;
+	const int32 OutHeight = SrcRect.Height() / Factor;
+	static const uint32 Round = (Factor * Factor) / 2;
+	static const uint32 Shift = Factor == 2 ? 2 : 4;
+
+	// Vertical sums go into a row of accumulators first so the inner loops are contiguous and vectorise
+	TArray<uint16, TInlineAllocator<1024>> RowSums;
+	RowSums.SetNumUninitialized(Width);
+	uint16* Sums = RowSums.GetData();
+
+	for (int32 OutY = 0; OutY < OutHeight; OutY++)
+	{
+		const uint8* Row = Src + (SrcRect.Min.Y + OutY * Factor) * SrcPitch + SrcRect.Min.X;
+		for (int32 X = 0; X < Width; X++)
+		{
+			Sums[X] = Row[X];
+		}
+		for (int32 RowIndex = 1; RowIndex < Factor; RowIndex++)
+		{
+			Row += SrcPitch;
+			for (int32 X = 0; X < Width; X++)
+			{
+				Sums[X] += Row[X];
+			}
+		}
+		uint8* OutRow = Dst + OutY * OutWidth;
+		for (int32 OutX = 0; OutX < OutWidth; OutX++)
+		{
+			uint32 Sum = Round;
+			for (int32 Column = 0; Column < Factor; Column++)
+			{
+				Sum += Sums[OutX * Factor + Column];
+			}
+			OutRow[OutX] = (uint8) (Sum >> Shift);
+		}
+	}
+}
+}	 // namespace
+
+void FLeapImageProcessing::DownsampleRegion(
+	const uint8* Src, const int32 SrcPitch, const FIntRect& SrcRect, const int32 Factor, uint8* Dst)
+{
+	switch (Factor)
+	{
+		case 2:
+			BoxFilter<2>(Src, SrcPitch, SrcRect, Dst);
+			break;
+		case 4:
+			BoxFilter<4>(Src, SrcPitch, SrcRect, Dst);
+			break;
+		default:
+		{
+			const int32 Width = SrcRect.Width();
+			for (int32 Y = 0; Y < SrcRect.Height(); Y++)
+			{
+				FMemory::Memcpy(Dst + Y * Width, Src + (SrcRect.Min.Y + Y) * SrcPitch + SrcRect.Min.X, Width);
+			}
+		}
+		break;
+	}
+}
+
+bool FLeapImageProcessing::ProjectToImage(IHandTrackingWrapper& Device, const int32 CameraIndex, const FMatrix& TrackingToCamera,
+	const LEAP_IMAGE& Image, const LEAP_VECTOR& Position, FVector2D& OutPixel)
+{
+	// Cameras look along +z in their own space
+	const FVector InCamera = TrackingToCamera.TransformPosition(FVector(Position.x, Position.y, Position.z));
+	if (InCamera.Z <= 0.f)
+	{
+		return false;
+	}
+	LEAP_VECTOR Ray;
+	Ray.x = InCamera.X / InCamera.Z;
+	Ray.y = InCamera.Y / InCamera.Z;
+	Ray.z = 1.f;
+
+	FVector2D Pixel;
+	if (!Device.RectilinearToPixel(CameraIndex, Ray, Pixel) || Pixel.X < 0.f || Pixel.X > Image.properties.width ||
+		Pixel.Y < 0.f || Pixel.Y > Image.properties.height)
+	{
+		return false;
+	}
+	OutPixel = Pixel;
+	return true;
+}
+
+FIntRect FLeapImageProcessing::GetRegionAround(
+	const FVector2D& Centre, const int32 Size, const int32 ImageWidth, const int32 ImageHeight)
+{
+	const int32 Width = FMath::Min(Size, ImageWidth);
+	const int32 Height = FMath::Min(Size, ImageHeight);
+	const int32 MinX = FMath::Clamp(FMath::RoundToInt(Centre.X) - Width / 2, 0, ImageWidth - Width);
+	const int32 MinY = FMath::Clamp(FMath::RoundToInt(Centre.Y) - Height / 2, 0, ImageHeight - Height);
+	return FIntRect(MinX, MinY, MinX + Width, MinY + Height);
+}
@@ -0,0 +1,32 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IUltraleapTrackingPlugin.h"
+#include "LeapC.h"
+
+/** Reduces IR images before upload so texture size and copy cost follow what is displayed */
+class FLeapImageProcessing
+{
+public:
+	/** Crop SrcRect out of an 8 bit image and box filter it down by Factor (1, 2 or 4). SrcRect must be a multiple of
+	 * Factor in size, Dst must hold (SrcRect.Width() / Factor) * (SrcRect.Height() / Factor) bytes */
+	static void DownsampleRegion(const uint8* Src, const int32 SrcPitch, const FIntRect& SrcRect, const int32 Factor, uint8* Dst);
+
+	/** Project a LeapC space position (mm) into the image of CameraIndex through the device's own camera model,
+	 * TrackingToCamera is the inverse of IHandTrackingWrapper::GetCameraToTrackingTransform.
+	 * Returns false if it is behind the camera or off the sensor */
+	static bool ProjectToImage(IHandTrackingWrapper& Device, const int32 CameraIndex, const FMatrix& TrackingToCamera,
+		const LEAP_IMAGE& Image, const LEAP_VECTOR& Position, FVector2D& OutPixel);
+
+	/** A Size x Size region clamped to the image, centred on Centre */
+	static FIntRect GetRegionAround(const FVector2D& Centre, const int32 Size, const int32 ImageWidth, const int32 ImageHeight);
+};
@@ -0,0 +1,119 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+
+#include "LeapImageRectifier.h"
+
+#include "LeapUtility.h"
+
+namespace
+{
+// The distortion grid covers ray slopes from -GridSlopeRange to GridSlopeRange
+const float GridSlopeRange = 4.f;
+const int32 GridN = LEAP_DISTORTION_MATRIX_N;
+}	 // namespace
+
+FVector2D FLeapImageRectifier::SlopeToImage(const LEAP_DISTORTION_MATRIX& Matrix, const float SlopeX, const float SlopeY)
+{
+	const float GridX = FMath::Clamp((SlopeX / (2.f * GridSlopeRange) + 0.5f) * (GridN - 1), 0.f, GridN - 1.001f);
+	const float GridY = FMath::Clamp((SlopeY / (2.f * GridSlopeRange) + 0.5f) * (GridN - 1), 0.f, GridN - 1.001f);
+	const int32 X0 = FMath::FloorToInt(GridX);
+	const int32 Y0 = FMath::FloorToInt(GridY);
+	const float Fx = GridX - X0;
+	const float Fy = GridY - Y0;
+
+	// matrix is indexed [row][column]
+	const auto& P00 = Matrix.matrix[Y0][X0];
+	const auto& P01 = Matrix.matrix[Y0][X0 + 1];
+	const auto& P10 = Matrix.matrix[Y0 + 1][X0];
+	const auto& P11 = Matrix.matrix[Y0 + 1][X0 + 1];
+
+	const float X = FMath::Lerp(FMath::Lerp(P00.x, P01.x, Fx), FMath::Lerp(P10.x, P11.x, Fx), Fy);
+	const float Y = FMath::Lerp(FMath::Lerp(P00.y, P01.y, Fx), FMath::Lerp(P10.y, P11.y, Fx), Fy);
+	return FVector2D(X, Y);
+}
+
+FLeapImageRectifier::FLookupTablePtr FLeapImageRectifier::BuildLookupTable(const LEAP_DISTORTION_MATRIX& Matrix,
+	const uint64 MatrixVersion, const int32 SrcWidth, const int32 SrcHeight, const int32 Width, const int32 Height,
+	const float MaxSlope)
+{
+	TSharedPtr<FLookupTable, ESPMode::ThreadSafe> Table = MakeShared<FLookupTable, ESPMode::ThreadSafe>();
+	Table->SrcWidth = SrcWidth;
+	Table->SrcHeight = SrcHeight;
+	Table->Width = Width;
+	Table->Height = Height;
+	Table->MaxSlope = MaxSlope;
+	Table->MatrixVersion = MatrixVersion;
+	Table->Entries.SetNumUninitialized(Width * Height);
+
+	FLookupEntry* Entry = Table->Entries.GetData();
+	for (int32 Y = 0; Y < Height; Y++)
+	{
+		const float SlopeY = ((Y + 0.5f) / Height * 2.f - 1.f) * MaxSlope;
+		for (int32 X = 0; X < Width; X++, Entry++)
+		{
+			const float SlopeX = ((X + 0.5f) / Width * 2.f - 1.f) * MaxSlope;
+			const FVector2D Normalized = SlopeToImage(Matrix, SlopeX, SlopeY);
+
+			// Grid values outside [0..1] are rays that don't land on the sensor
+			const bool bValid = Normalized.X >= 0.f && Normalized.X <= 1.f && Normalized.Y >= 0.f && Normalized.Y <= 1.f;
+
+			// pixel centres, clamped so the 2x2 footprint stays inside the image
+			const float SrcX = FMath::Clamp(Normalized.X * SrcWidth - 0.5f, 0.f, SrcWidth - 1.001f);
+			const float SrcY = FMath::Clamp(Normalized.Y * SrcHeight - 0.5f, 0.f, SrcHeight - 1.001f);
+			const int32 X0 = FMath::Min(FMath::FloorToInt(SrcX), SrcWidth - 2);
+			const int32 Y0 = FMath::Min(FMath::FloorToInt(SrcY), SrcHeight - 2);
+
+			Entry->SrcIndex = bValid ? Y0 * SrcWidth + X0 : 0;
+			Entry->FracX = (uint8) FMath::Clamp(FMath::RoundToInt((SrcX - X0) * 256.f), 0, 255);
+			Entry->FracY = (uint8) FMath::Clamp(FMath::RoundToInt((SrcY - Y0) * 256.f), 0, 255);
+			Entry->Mask = bValid ? 0xFF : 0;
+			Entry->Padding = 0;
+		}
+	}
+	return Table;
+}
+
+void FLeapImageRectifier::Rectify(const uint8* Src, const FLookupTable& Table, uint8* Dst)
+{
+	// Scalar fixed point, the four taps of each pixel are a gather from wherever the table points so the time goes on loads
+	// rather than the weighting. Branch free, invalid entries sample pixel 0 and are masked out
+	const int32 Pitch = Table.SrcWidth;
+	const int32 Num = Table.Entries.Num();
+	const FLookupEntry* Entries = Table.Entries.GetData();
+	for (int32 Index = 0; Index < Num; Index++)
+	{
+		const FLookupEntry& Entry = Entries[Index];
+		const uint8* P = Src + Entry.SrcIndex;
+		const uint32 Fx = Entry.FracX;
+		const uint32 Fy = Entry.FracY;
+		const uint32 Top = P[0] * (256 - Fx) + P[1] * Fx;
+		const uint32 Bottom = P[Pitch] * (256 - Fx) + P[Pitch + 1] * Fx;
+		Dst[Index] = (uint8) (((Top * (256 - Fy) + Bottom * Fy + 32768) >> 16) & Entry.Mask);
+	}
+}
+
+FLeapImageRectifier::FLookupTablePtr FLeapImageRectifier::GetLookupTable(const int32 CameraIndex, const LEAP_IMAGE& Image)
+{
+	if (CameraIndex < 0 || CameraIndex > 1 || !Image.distortion_matrix || Image.properties.width < 2 ||
+		Image.properties.height < 2)
+	{
+		return nullptr;
+	}
+	const FLookupTablePtr& Current = Tables[CameraIndex];
+	if (!Current.IsValid() || Current->MatrixVersion != Image.matrix_version || Current->SrcWidth != Image.properties.width ||
+		Current->SrcHeight != Image.properties.height || Current->Width != Width || Current->Height != Height ||
+		Current->MaxSlope != MaxSlope)
+	{
+		UE_LOG(UltraleapTrackingLog, Log, TEXT("FLeapImageRectifier building %dx%d lookup table for camera %d"), Width, Height,
+			CameraIndex);
+		Tables[CameraIndex] = BuildLookupTable(*Image.distortion_matrix, Image.matrix_version, Image.properties.width,
+			Image.properties.height, Width, Height, MaxSlope);
+	}
+	return Tables[CameraIndex];
+}
@@ -0,0 +1,66 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LeapC.h"
+
+/** Undistorts IR images with remap tables built once per calibration from the LeapC distortion grid.
+ *
+ * Both cameras are resampled onto the same rectilinear ray slope grid so the output pair is row aligned */
+class FLeapImageRectifier
+{
+public:
+	struct FLookupEntry
+	{
+		// top left source pixel
+		int32 SrcIndex;
+		// bilinear weights in 1/256ths
+		uint8 FracX;
+		uint8 FracY;
+		// 0 for rays that miss the sensor
+		uint8 Mask;
+		uint8 Padding;
+	};
+
+	struct FLookupTable
+	{
+		int32 SrcWidth = 0;
+		int32 SrcHeight = 0;
+		int32 Width = 0;
+		int32 Height = 0;
+		float MaxSlope = 0;
+		uint64 MatrixVersion = 0;
+		TArray<FLookupEntry> Entries;
+	};
+	typedef TSharedPtr<const FLookupTable, ESPMode::ThreadSafe> FLookupTablePtr;
+
+	/** Build the remap table, MaxSlope is the ray slope at the output image edges (1 = 90 degree field of view) */
+	static FLookupTablePtr BuildLookupTable(const LEAP_DISTORTION_MATRIX& Matrix, const uint64 MatrixVersion, const int32 SrcWidth,
+		const int32 SrcHeight, const int32 Width, const int32 Height, const float MaxSlope);
+
+	/** Bilinear lookup into the distortion grid, returns normalized image coordinates, outside [0..1] misses the sensor */
+	static FVector2D SlopeToImage(const LEAP_DISTORTION_MATRIX& Matrix, const float SlopeX, const float SlopeY);
+
+	/** Remap an 8 bit image, Dst must hold Table.Width * Table.Height bytes */
+	static void Rectify(const uint8* Src, const FLookupTable& Table, uint8* Dst);
+
+	/** Returns the table for the camera, rebuilding it if the calibration or image size changed. Call from the LeapC thread,
+	 * the distortion matrix is only valid for the duration of the image event */
+	FLookupTablePtr GetLookupTable(const int32 CameraIndex, const LEAP_IMAGE& Image);
+
+	// Output size and field of view
+	int32 Width = 400;
+	int32 Height = 400;
+	float MaxSlope = 1.f;
+
+private:
+	FLookupTablePtr Tables[2];
+};
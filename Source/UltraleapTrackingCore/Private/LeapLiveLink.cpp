@@ -10,6 +10,7 @@
 
 #include "Animation/AnimInstance.h"
 #include "CoreMinimal.h"
+#include "LeapAsync.h"
 #include "LeapBlueprintFunctionLibrary.h"
 #include "LiveLinkProvider.h"
 #include "Misc/App.h"
@@ -17,9 +18,18 @@
 #include "Roles/LiveLinkAnimationTypes.h"
 
 FLeapLiveLinkProducer::FLeapLiveLinkProducer()
+	: SnapshotTime(0), bHasPublished(false), bPublishInFlight(false), MaxPublishRate(0), LastPublishTime(0)
 {
 }
 
+FLeapLiveLinkProducer::~FLeapLiveLinkProducer()
+{
+	if (PublishTask.IsValid())
+	{
+		PublishTask.Wait();
+	}
+}
+
 void FLeapLiveLinkProducer::Startup(const FString& DeviceSerial)
 {
 	LiveLinkProvider = ILiveLinkProvider::CreateLiveLinkProvider(TEXT("Ultraleap Tracking Live Link: ") + DeviceSerial);
@@ -42,9 +52,18 @@ void FLeapLiveLinkProducer::Startup(const FString& DeviceSerial)
 
 void FLeapLiveLinkProducer::ShutDown()
 {
+	if (PublishTask.IsValid())
+	{
+		PublishTask.Wait();
+	}
 	LiveLinkProvider->UnregisterConnStatusChangedHandle(ConnectionStatusChangedHandle);
 }
 
+void FLeapLiveLinkProducer::SetMaxPublishRate(const float InMaxPublishRate)
+{
+	MaxPublishRate = InMaxPublishRate;
+}
+
 void FLeapLiveLinkProducer::SyncSubjectToSkeleton(const UBodyStateSkeleton* Skeleton)
 {
 	const TArray<UBodyStateBone*>& Bones = Skeleton->Bones;
@@ -53,7 +72,14 @@ void FLeapLiveLinkProducer::SyncSubjectToSkeleton(const UBodyStateSkeleton* Skel
 	FLiveLinkStaticDataStruct StaticData(FLiveLinkSkeletonStaticData::StaticStruct());
 	FLiveLinkSkeletonStaticData& AnimationData = *StaticData.Cast<FLiveLinkSkeletonStaticData>();
 
-	TrackedBones.Reset();
+	// The worker owns the snapshot arrays while publishing
+	if (PublishTask.IsValid())
+	{
+		PublishTask.Wait();
+	}
+
+	TrackedBoneIndices.Reset();
+	ParentBoneIndices.Reset();
 
 	TArray<FName> ParentsNames;
 	for (int i = 0; i < Bones.Num(); i++)
@@ -62,7 +88,8 @@ void FLeapLiveLinkProducer::SyncSubjectToSkeleton(const UBodyStateSkeleton* Skel
 		{
 			AnimationData.BoneNames.Add(FName(*Bones[i]->Name));
 			ParentsNames.Add(FName(*Bones[i]->Parent->Name));
-			TrackedBones.Add(Bones[i]);
+			TrackedBoneIndices.Add(i);
+			ParentBoneIndices.Add(Bones.IndexOfByKey(Bones[i]->Parent));
 		}
 	}
 
@@ -72,29 +99,88 @@ void FLeapLiveLinkProducer::SyncSubjectToSkeleton(const UBodyStateSkeleton* Skel
 		AnimationData.BoneParents.Add(AnimationData.BoneNames.IndexOfByKey(ParentsNames[j]));
 	}
 
-	LiveLinkProvider->UpdateSubjectStaticData(SubjectName, ULiveLinkAnimationRole::StaticClass(), MoveTemp(StaticData));
+	// Sized once per skeleton layout, reused every frame after this
+	const int32 NumTracked = TrackedBoneIndices.Num();
+	BoneSnapshot.SetNum(NumTracked);
+	ParentSnapshot.SetNum(NumTracked);
+	LastBoneTransforms.SetNum(NumTracked);
+	LastParentTransforms.SetNum(NumTracked);
+	LocalTransforms.SetNum(NumTracked);
+	bHasPublished = false;
+
+	// Sent ahead of the next frame by the worker so static and frame data stay in order
+	PendingStaticData.Emplace(MoveTemp(StaticData));
 }
 
 void FLeapLiveLinkProducer::UpdateFromBodyState(const UBodyStateSkeleton* Skeleton)
 {
-	FLiveLinkFrameDataStruct FrameData(FLiveLinkAnimationFrameData::StaticStruct());
-	FLiveLinkAnimationFrameData* AnimationFrameData = FrameData.Cast<FLiveLinkAnimationFrameData>();
+	const double Now = FPlatformTime::Seconds();
+	if (MaxPublishRate > 0 && (Now - LastPublishTime) < 1.0 / MaxPublishRate)
+	{
+		return;
+	}
+	// Previous frame still being published, drop this one rather than queue
+	if (bPublishInFlight)
+	{
+		return;
+	}
 
 	const TArray<UBodyStateBone*>& Bones = Skeleton->Bones;
+	for (int32 i = 0; i < TrackedBoneIndices.Num(); i++)
+	{
+		// Parents outside the skeleton (root) are treated as identity
+		BoneSnapshot[i] = Bones[TrackedBoneIndices[i]]->BoneData.Transform;
+		ParentSnapshot[i] =
+			ParentBoneIndices[i] != INDEX_NONE ? Bones[ParentBoneIndices[i]]->BoneData.Transform : FTransform::Identity;
+	}
+	SnapshotTime = Now;
+	LastPublishTime = Now;
+
+	// this is safe to capture, ShutDown and the destructor wait for the task
+	bPublishInFlight = true;
+	PublishTask = FLeapAsync::RunLambdaOnBackGroundThreadPool([this] {
+		Publish();
+		bPublishInFlight = false;
+	});
+}
 
-	for (int i = 0; i < Bones.Num(); i++)
+void FLeapLiveLinkProducer::Publish()
+{
+	if (PendingStaticData.IsSet())
 	{
-		if (Bones[i]->IsTracked())
-		{
-			FTransform BoneTransform = Bones[i]->Transform();
-			FTransform ParentTransform;
+		LiveLinkProvider->UpdateSubjectStaticData(
+			SubjectName, ULiveLinkAnimationRole::StaticClass(), MoveTemp(PendingStaticData.GetValue()));
+		PendingStaticData.Reset();
+	}
 
-			// The live link node outputs in local space (this means each bone transform must be relative to its parent)
-			// so convert from component space here
-			ConvertComponentTransformToLocalTransform(BoneTransform, Bones[i]->Parent->Transform());
-			AnimationFrameData->Transforms.Add(BoneTransform);
+	// Only bones whose transform or parent moved need converting
+	bool bAnyChanged = !bHasPublished;
+	for (int32 i = 0; i < BoneSnapshot.Num(); i++)
+	{
+		if (bHasPublished && BoneSnapshot[i].Equals(LastBoneTransforms[i]) && ParentSnapshot[i].Equals(LastParentTransforms[i]))
+		{
+			continue;
 		}
+		LastBoneTransforms[i] = BoneSnapshot[i];
+		LastParentTransforms[i] = ParentSnapshot[i];
+
+		// The live link node outputs in local space (this means each bone transform must be relative to its parent)
+		// so convert from component space here
+		LocalTransforms[i] = BoneSnapshot[i];
+		ConvertComponentTransformToLocalTransform(LocalTransforms[i], ParentSnapshot[i]);
+		bAnyChanged = true;
+	}
+	if (!bAnyChanged)
+	{
+		return;
 	}
+	bHasPublished = true;
+
+	FLiveLinkFrameDataStruct FrameData(FLiveLinkAnimationFrameData::StaticStruct());
+	FLiveLinkAnimationFrameData* AnimationFrameData = FrameData.Cast<FLiveLinkAnimationFrameData>();
+	AnimationFrameData->WorldTime = FLiveLinkWorldTime(SnapshotTime);
+	// Single exactly sized allocation, the frame is then moved into the provider
+	AnimationFrameData->Transforms = LocalTransforms;
 
 	LiveLinkProvider->UpdateSubjectFrameData(SubjectName, MoveTemp(FrameData));
 }
@@ -107,4 +193,4 @@ void FLeapLiveLinkProducer::ConvertComponentTransformToLocalTransform(FTransform
 {
 	BoneTransform.SetToRelativeTransform(ParentTransform);
 	BoneTransform.NormalizeRotation();
-}
\ No newline at end of file
+}
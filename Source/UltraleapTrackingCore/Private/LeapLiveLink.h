@@ -8,32 +8,62 @@
 
 #pragma once
 
+#include "Async/Future.h"
+#include "HAL/ThreadSafeBool.h"
 #include "ILiveLinkClient.h"
 #include "LiveLinkProvider.h"
 #include "LiveLinkTypes.h"
+#include "Roles/LiveLinkAnimationTypes.h"
 #include "Skeleton/BodyStateSkeleton.h"
 
 class FLeapLiveLinkProducer
 {
 public:
 	FLeapLiveLinkProducer();
+	// Waits for a publish in flight, the worker uses this producer's members
+	~FLeapLiveLinkProducer();
 	void Startup(const FString& DeviceSerial);
 	void ShutDown();
 
 	// Linkup initial information of the skeleton
 	void SyncSubjectToSkeleton(const UBodyStateSkeleton* Skeleton);
 
-	// Update transforms from bodystate skeleton data
+	// Snapshot transforms from bodystate skeleton data on the game thread, conversion and publishing happens on a worker
 	void UpdateFromBodyState(const UBodyStateSkeleton* Skeleton);
 
 	// Whether it's connected as a live link source, use this to determine if we should pay the live link data cost
 	bool HasConnection();
 
+	// Frames per second published at most, independent of the game tick. 0 publishes every update
+	void SetMaxPublishRate(const float InMaxPublishRate);
+
 protected:
 	FDelegateHandle ConnectionStatusChangedHandle;
 	TSharedPtr<ILiveLinkProvider> LiveLinkProvider;
 	FName SubjectName;
-	TArray<UBodyStateBone*> TrackedBones;
+
+	// Indices into UBodyStateSkeleton::Bones, set by SyncSubjectToSkeleton
+	TArray<int32> TrackedBoneIndices;
+	TArray<int32> ParentBoneIndices;
+
+	// Preallocated per tracked bone, written on the game thread and read by the worker, never both at once
+	TArray<FTransform> BoneSnapshot;
+	TArray<FTransform> ParentSnapshot;
+	double SnapshotTime;
+	TOptional<FLiveLinkStaticDataStruct> PendingStaticData;
+
+	// Worker only, used to skip unchanged bones and frames
+	TArray<FTransform> LastBoneTransforms;
+	TArray<FTransform> LastParentTransforms;
+	TArray<FTransform> LocalTransforms;
+	bool bHasPublished;
+
+	FThreadSafeBool bPublishInFlight;
+	TFuture<void> PublishTask;
+	float MaxPublishRate;
+	double LastPublishTime;
+
+	void Publish();
 
 	static void ConvertComponentTransformToLocalTransform(FTransform& BoneTransform, const FTransform& ParentTransform);
-};
\ No newline at end of file
+};
@@ -14,6 +14,22 @@
 #include "LeapUtility.h"
 #include "UObject/ConstructorHelpers.h"
 #include "Engine/Engine.h"
+#include "Framework/Application/SlateApplication.h"
+#include "UltraleapTrackingStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Leap Widget Cursor"), STAT_LeapWidgetCursor, STATGROUP_UltraleapTracking);
+DECLARE_CYCLE_STAT(TEXT("Leap Widget Hit Test"), STAT_LeapWidgetHitTest, STATGROUP_UltraleapTracking);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Leap Widget Traces"), STAT_LeapWidgetTraces, STATGROUP_UltraleapTracking);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Leap Widget Traces Skipped"), STAT_LeapWidgetTracesSkipped, STATGROUP_UltraleapTracking);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Leap Widget Traces Rejected"), STAT_LeapWidgetTracesRejected, STATGROUP_UltraleapTracking);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Leap Widget Predicted Clicks"), STAT_LeapWidgetPredictedClicks, STATGROUP_UltraleapTracking);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Leap Widget Cancelled Clicks"), STAT_LeapWidgetCancelledClicks, STATGROUP_UltraleapTracking);
+
+// pinch strength hysteresis, same as the LeapSubsystem pinch events
+static const float PinchPressStrength = 0.8f;
+static const float PinchReleaseStrength = 0.5f;
+// added to the release distance, cause of the jitter can cause accidental release
+static const float PokeReleaseOffset = 2.0f;
 
 ULeapWidgetInteractionComponent::ULeapWidgetInteractionComponent()
 	: LeapHandType(EHandType::LEAP_HAND_LEFT)
@@ -30,6 +46,15 @@ ULeapWidgetInteractionComponent::ULeapWidgetInteractionComponent()
 	, YAxisCalibOffset(4.0f)
 	, ZAxisCalibOffset(4.0f)
 	, ModeChangeThreshold(30.0f)
+	, bCacheHitTests(true)
+	, RayPositionTolerance(0.1f)
+	, RayAngleTolerance(0.1f)
+	, MaxCachedHitTestFrames(8)
+	, bUseWidgetIndex(false)
+	, bPredictClicks(false)
+	, ClickPredictionTime(0.03f)
+	, PinchOnsetVelocity(1.5f)
+	, PokeOnsetVelocity(15.0f)
 	, LeapPawn(nullptr)
 	, PointerActor(nullptr)
 	, World(nullptr)
@@ -45,7 +70,15 @@ ULeapWidgetInteractionComponent::ULeapWidgetInteractionComponent()
 	, PinchOffsetX(6.0f)
 	, PinchOffsetY(2.0f)
 	, bHidden(false)
-
+	, WidgetSubsystem(nullptr)
+	, CachedTraceStart(FVector::ZeroVector)
+	, CachedTraceDirection(FVector::ZeroVector)
+	, CachedWidgetsVersion(0)
+	, CachedTraceFrame(0)
+	, bHasCachedTrace(false)
+	, FrameTime(0)
+	, bPinchConfirmed(false)
+	, bBlankTrace(false)
 {
 	CreatStaticMeshForCursor();
 }
@@ -130,15 +163,17 @@ void ULeapWidgetInteractionComponent::HandleDistanceChange(float Dist, float Min
 	}
 }
 
-void ULeapWidgetInteractionComponent::DrawLeapCursor(FLeapHandData& Hand)
+void ULeapWidgetInteractionComponent::DrawLeapCursor(const FLeapHandData& TmpHand)
 {
-	FLeapHandData TmpHand = Hand;
 	if (TmpHand.HandType != LeapHandType)
 	{
 		return;
 	}
-	if (CursorStaticMesh != nullptr && LeapPawn != nullptr && PlayerCameraManager != nullptr)
+	SCOPE_CYCLE_COUNTER(STAT_LeapWidgetCursor);
+	const double StartTime = FPlatformTime::Seconds();
+	if (CursorStaticMesh != nullptr && LeapPawn != nullptr && PlayerCameraManager != nullptr && WidgetSubsystem != nullptr)
 	{
+		const FLeapHandRayFrame& RayFrame = WidgetSubsystem->GetRayFrame(PlayerCameraManager);
 		// The cursor position is the addition of the Pawn pose and the hand pose
 		FVector Position = FVector::ZeroVector;
 		FVector Direction = FVector();
@@ -146,7 +181,7 @@ void ULeapWidgetInteractionComponent::DrawLeapCursor(FLeapHandData& Hand)
 		FVector IndexIntermNext = TmpHand.Index.Intermediate.NextJoint;
 		FVector IndexMetaNext = TmpHand.Index.Metacarpal.NextJoint;
 
-		FRotator ForwardRot = PlayerCameraManager->GetActorForwardVector().Rotation();
+		FRotator ForwardRot = RayFrame.CameraForward.Rotation();
 		ForwardRot = FRotator(0, ForwardRot.Yaw, 0);
 		FVector ForwardDirection = ForwardRot.Vector();
 
@@ -165,13 +200,45 @@ void ULeapWidgetInteractionComponent::DrawLeapCursor(FLeapHandData& Hand)
 		FTransform NewTransform =
 			UKismetMathLibrary::TInterpTo(GetComponentTransform(), TargetTrans, World->GetDeltaSeconds(), InterpolationSpeed);
 
-		FHitResult SweepHitResult;
-		K2_SetWorldTransform(NewTransform, true, SweepHitResult, true);
+		// nothing to sweep, this component has no collision
+		SetWorldTransform(NewTransform, false, nullptr, ETeleportType::TeleportPhysics);
 
 		CursorStaticMesh->SetWorldLocation(LastHitResult.ImpactPoint);
 		float Dist = FVector::Dist(Position, LastHitResult.ImpactPoint);
 
-		if (WidgetInteraction == EUIInteractionType::NEAR)
+		if (bPredictClicks)
+		{
+			// the ray was just updated, keep it with the sample so a press can go back to the onset ray
+			const FVector RayStart = GetComponentLocation();
+			const FVector RayDirection = GetForwardVector();
+			if (bNear)
+			{
+				EndPredictedPress(PinchPredictor, bIsPinched, bPinchConfirmed);
+				if (!LastHitResult.bBlockingHit)
+				{
+					// the impact point is stale without a hit. Starting over each time means the history only holds
+					// frames with a hit, so there's no velocity to predict with until two in a row have one
+					EndPredictedPress(PokePredictor, bHandTouchWidget, PokePredictor.HasReachedPressThreshold());
+				}
+				else
+				{
+					FingerJointEstimatedLen = FVector::Dist(TmpHand.Index.Intermediate.PrevJoint, IndexDistalNext);
+					// depth past the touch distance, positive once touching
+					const float Depth = (IndexDistanceFromUI + FingerJointEstimatedLen) - Dist;
+					ApplyClickPrediction(
+						PokePredictor.AddSample(FrameTime, Depth, RayStart, RayDirection), PokePredictor, bHandTouchWidget);
+				}
+			}
+			else
+			{
+				EndPredictedPress(PokePredictor, bHandTouchWidget, PokePredictor.HasReachedPressThreshold());
+				// the pinch events stay in charge, the predictor only presses early and takes back a press they never confirm
+				const ELeapClickPrediction Prediction = FLeapClickPredictor::FilterConfirmed(
+					PinchPredictor.AddSample(FrameTime, TmpHand.PinchStrength, RayStart, RayDirection), bPinchConfirmed);
+				ApplyClickPrediction(Prediction, PinchPredictor, bIsPinched);
+			}
+		}
+		else if (WidgetInteraction == EUIInteractionType::NEAR)
 		{
 			FingerJointEstimatedLen = FVector::Dist(TmpHand.Index.Intermediate.PrevJoint, IndexDistalNext);
 			if (Dist < (IndexDistanceFromUI + FingerJointEstimatedLen))
@@ -197,25 +264,31 @@ void ULeapWidgetInteractionComponent::DrawLeapCursor(FLeapHandData& Hand)
 	{
 		UE_LOG(UltraleapTrackingLog, Error, TEXT("nullptr in DrawLeapCircles"));
 	}
+	if (WidgetSubsystem != nullptr)
+	{
+		WidgetSubsystem->RecordCost(FPlatformTime::Seconds() - StartTime);
+	}
 }
 
-FVector ULeapWidgetInteractionComponent::GetHandRayDirection(FLeapHandData& TmpHand, FVector& Position)
+FVector ULeapWidgetInteractionComponent::GetHandRayDirection(const FLeapHandData& TmpHand, FVector& Position)
 {
-	if (World == nullptr && PlayerCameraManager == nullptr)
+	if (World == nullptr || PlayerCameraManager == nullptr || WidgetSubsystem == nullptr)
 	{
 		UE_LOG(UltraleapTrackingLog, Error, TEXT("World or PlayerCameraManager nullptr in GetHandRayDirection"));
 		return FVector::ZeroVector;
 	}
+	// camera state is captured once per frame and shared with the other hand
+	const FLeapHandRayFrame& RayFrame = WidgetSubsystem->GetRayFrame(PlayerCameraManager);
 
 	// Use neck offset to overcome camera roll and pitch rotations
 	FVector NeckOffset = GetNeckOffset();
 	// Get the neck postion
-	FVector CameraLocationWithNeckOffset = PlayerCameraManager->GetCameraLocation();
+	FVector CameraLocationWithNeckOffset = RayFrame.CameraLocation;
 	CameraLocationWithNeckOffset -= NeckOffset;
 	CameraLocationWithNeckOffset -= 15 * FVector::UpVector;
 
 	// Get the estimated right direction of the camera
-	FRotator RightRot = PlayerCameraManager->GetActorRightVector().Rotation();
+	FRotator RightRot = RayFrame.CameraRight.Rotation();
 	RightRot = FRotator(0, RightRot.Yaw, 0);
 	FVector RightDirection = RightRot.Vector();
 
@@ -223,14 +296,14 @@ FVector ULeapWidgetInteractionComponent::GetHandRayDirection(FLeapHandData& TmpH
 	FVector ShoulderPos = FVector::ZeroVector;
 	// Use the camera location with offset to overcome head Roll and Pitch
 	ShoulderPos = CameraLocationWithNeckOffset;
-	ShoulderPos +=  WristRotationFactor * PlayerCameraManager->GetActorForwardVector();
+	ShoulderPos +=  WristRotationFactor * RayFrame.CameraForward;
 	ShoulderPos += RightDirection * (TmpHand.HandType == EHandType::LEAP_HAND_LEFT ? -ShoulderWidth : ShoulderWidth);
 	// Get approximate pintch position
 	if (WidgetInteraction == EUIInteractionType::FAR)
 	{
 		Position += FVector::UpVector;
-		Position += PinchOffsetX * PlayerCameraManager->GetActorForwardVector();
-		Position += PlayerCameraManager->GetActorRightVector() *
+		Position += PinchOffsetX * RayFrame.CameraForward;
+		Position += RayFrame.CameraRight *
 					(TmpHand.HandType == EHandType::LEAP_HAND_LEFT ? PinchOffsetY : -PinchOffsetY);
 	}
 	// Get the direction from the shoulders to the pinch position
@@ -241,13 +314,13 @@ FVector ULeapWidgetInteractionComponent::GetHandRayDirection(FLeapHandData& TmpH
 
 FVector ULeapWidgetInteractionComponent::GetNeckOffset()
 {
-	if (PlayerCameraManager == nullptr)
+	if (PlayerCameraManager == nullptr || WidgetSubsystem == nullptr)
 	{
 		UE_LOG(UltraleapTrackingLog, Error, TEXT("PlayerCameraManager in GetNeckOffset"));
 		return FVector();
 	}
 
-	FRotator HMDRotation = PlayerCameraManager->GetCameraRotation();
+	FRotator HMDRotation = WidgetSubsystem->GetRayFrame(PlayerCameraManager).CameraRotation;
 	float AlphaPitch = 0;
 	float AlphaRoll = 0;
 	FVector PitchOffset, RollOffset;
@@ -307,6 +380,16 @@ void ULeapWidgetInteractionComponent::BeginPlay()
 		UE_LOG(UltraleapTrackingLog, Error, TEXT("PlayerCameraManager is nullptr in BeginPlay"));
 		return;
 	}
+	WidgetSubsystem = ULeapWidgetInteractionSubsystem::Get(World);
+	if (WidgetSubsystem == nullptr)
+	{
+		UE_LOG(UltraleapTrackingLog, Error, TEXT("WidgetSubsystem is nullptr in BeginPlay"));
+		return;
+	}
+	WidgetSubsystem->RegisterTaggedWidgets();
+
+	PinchPredictor.Configure(PinchPressStrength, PinchReleaseStrength, ClickPredictionTime, PinchOnsetVelocity);
+	PokePredictor.Configure(0.0f, -PokeReleaseOffset, ClickPredictionTime, PokeOnsetVelocity);
 
 	// Subscribe events from leap, for pinch, unpinch and get the tracking data
 	if (WidgetInteraction != EUIInteractionType::NEAR)
@@ -358,7 +441,13 @@ void ULeapWidgetInteractionComponent::BeginPlay()
 
 void ULeapWidgetInteractionComponent::OnLeapPinch(const FLeapHandData& HandData)
 {
-	if (HandData.HandType == LeapHandType && !bIsPinched && WidgetInteraction == EUIInteractionType::FAR)
+	if (HandData.HandType != LeapHandType || WidgetInteraction != EUIInteractionType::FAR)
+	{
+		return;
+	}
+	// a predicted press may already be down, the pinch makes it real
+	bPinchConfirmed = true;
+	if (!bIsPinched)
 	{
 		ScaleUpCursorAndClickButton();
 		bIsPinched = true;
@@ -367,7 +456,14 @@ void ULeapWidgetInteractionComponent::OnLeapPinch(const FLeapHandData& HandData)
 
 void ULeapWidgetInteractionComponent::OnLeapUnPinch(const FLeapHandData& HandData)
 {
-	if (HandData.HandType == LeapHandType && bIsPinched && WidgetInteraction == EUIInteractionType::FAR)
+	if (HandData.HandType != LeapHandType || WidgetInteraction != EUIInteractionType::FAR)
+	{
+		return;
+	}
+	bPinchConfirmed = false;
+	// start the next prediction from scratch rather than waiting for the strength to drop below its release threshold
+	PinchPredictor.Reset();
+	if (bIsPinched)
 	{
 		ScaleDownCursorAndUnclickButton();
 		bIsPinched = false;
@@ -392,6 +488,79 @@ void ULeapWidgetInteractionComponent::NearReleaseLeftMouse(TEnumAsByte<EHandType
 	}
 }
 
+void ULeapWidgetInteractionComponent::ApplyClickPrediction(
+	ELeapClickPrediction Prediction, const FLeapClickPredictor& Predictor, bool& bPressedState)
+{
+	if (Prediction == ELeapClickPrediction::Press && !bPressedState)
+	{
+		FVector OnsetStart, OnsetDirection;
+		if (Predictor.GetOnsetRay(OnsetStart, OnsetDirection))
+		{
+			// move the pointer back to where the user aimed before pinching/poking pulled the hand off target
+			SetWorldTransform(FTransform(OnsetDirection.Rotation(), OnsetStart, GetComponentScale()), false, nullptr,
+				ETeleportType::TeleportPhysics);
+			SimulatePointerMovement();
+		}
+		ScaleUpCursorAndClickButton();
+		bPressedState = true;
+		INC_DWORD_STAT(STAT_LeapWidgetPredictedClicks);
+	}
+	else if (Prediction == ELeapClickPrediction::Release && bPressedState)
+	{
+		ScaleDownCursorAndUnclickButton();
+		bPressedState = false;
+	}
+	else if (Prediction == ELeapClickPrediction::Cancel && bPressedState)
+	{
+		CancelPredictedPress();
+		bPressedState = false;
+	}
+}
+
+void ULeapWidgetInteractionComponent::CancelPredictedPress()
+{
+	if (bHidden)
+	{
+		return;
+	}
+	ResetCursorScale();
+	// the pressed widget holds the pointer capture and would get the release. Losing capture un-presses it without
+	// a click, then the release goes out with the trace blanked so it lands on nothing
+	if (VirtualUser.IsValid() && FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().ReleaseAllPointerCapture(VirtualUser->GetUserIndex());
+	}
+	bBlankTrace = true;
+	SimulatePointerMovement();
+	ReleasePointerKey(EKeys::LeftMouseButton);
+	bBlankTrace = false;
+	INC_DWORD_STAT(STAT_LeapWidgetCancelledClicks);
+}
+
+void ULeapWidgetInteractionComponent::EndPredictedPress(FLeapClickPredictor& Predictor, bool& bPressedState, const bool bConfirmed)
+{
+	if (bPressedState)
+	{
+		if (bConfirmed)
+		{
+			ScaleDownCursorAndUnclickButton();
+		}
+		else
+		{
+			CancelPredictedPress();
+		}
+		bPressedState = false;
+	}
+	Predictor.Reset();
+}
+
+void ULeapWidgetInteractionComponent::ReleasePredictedClicks()
+{
+	EndPredictedPress(PinchPredictor, bIsPinched, bPinchConfirmed);
+	EndPredictedPress(PokePredictor, bHandTouchWidget, PokePredictor.HasReachedPressThreshold());
+	bPinchConfirmed = false;
+}
+
 void ULeapWidgetInteractionComponent::ScaleUpCursorAndClickButton(const FKey Button)
 {
 
@@ -541,11 +710,11 @@ void ULeapWidgetInteractionComponent::OnLeapTrackingData(const FLeapFrameData& F
 
 	HandleWidgetChange();
 
-	TArray<FLeapHandData> Hands = Frame.Hands;
+	FrameTime = Frame.TimeStamp > 0 ? Frame.TimeStamp * 1.0e-6 : World->GetTimeSeconds();
 	HandleVisibilityChange(Frame);
-	for (int32 i = 0; i < Hands.Num(); ++i)
+	for (const FLeapHandData& Hand : Frame.Hands)
 	{
-		DrawLeapCursor(Hands[i]);	
+		DrawLeapCursor(Hand);
 	}
 }
 
@@ -558,5 +727,73 @@ void ULeapWidgetInteractionComponent::HandleVisibilityChange(const FLeapFrameDat
 		HandVisibility = LatestHandVis;
 		CursorStaticMesh->SetHiddenInGame(!HandVisibility);
 		SetHiddenInGame(!HandVisibility);
+		if (!HandVisibility && bPredictClicks)
+		{
+			// no more samples will come to release with
+			ReleasePredictedClicks();
+		}
 	}
 }
+
+FWidgetTraceResult ULeapWidgetInteractionComponent::PerformTrace() const
+{
+	SCOPE_CYCLE_COUNTER(STAT_LeapWidgetHitTest);
+	// the cursor ray is this component's transform, other sources use the engine trace as is
+	if (InteractionSource != EWidgetInteractionSource::World || WidgetSubsystem == nullptr)
+	{
+		return Super::PerformTrace();
+	}
+	if (bBlankTrace)
+	{
+		// lifting a cancelled press off the widget, see CancelPredictedPress
+		FWidgetTraceResult Blank;
+		Blank.LineStartLocation = GetComponentLocation();
+		Blank.LineEndLocation = Blank.LineStartLocation + GetForwardVector() * InteractionDistance;
+		return Blank;
+	}
+	const double StartTime = FPlatformTime::Seconds();
+
+	WidgetSubsystem->RefreshWidgets();
+	const FVector Start = GetComponentLocation();
+	const FVector Direction = GetForwardVector();
+	const uint32 WidgetsVersion = WidgetSubsystem->GetWidgetsVersion();
+
+	// the ray hasn't moved and neither have the widgets, the last result still holds
+	if (bCacheHitTests && bHasCachedTrace && CachedWidgetsVersion == WidgetsVersion &&
+		GFrameCounter - CachedTraceFrame < (uint64) FMath::Max(MaxCachedHitTestFrames, 1) &&
+		FVector::DistSquared(Start, CachedTraceStart) <= FMath::Square(RayPositionTolerance) &&
+		FVector::DotProduct(Direction, CachedTraceDirection) >= FMath::Cos(FMath::DegreesToRadians(RayAngleTolerance)) &&
+		(!CachedTraceResult.bWasHit || IsValid(CachedTraceResult.HitWidgetComponent)))
+	{
+		INC_DWORD_STAT(STAT_LeapWidgetTracesSkipped);
+		WidgetSubsystem->RecordHitTest(true, false);
+		WidgetSubsystem->RecordCost(FPlatformTime::Seconds() - StartTime);
+		return CachedTraceResult;
+	}
+
+	const FVector End = Start + Direction * InteractionDistance;
+	bool bRejected = false;
+	if (bUseWidgetIndex && !WidgetSubsystem->MayHitWidget(Start, End))
+	{
+		// can't reach any widget, no need for a world trace
+		CachedTraceResult = FWidgetTraceResult();
+		CachedTraceResult.LineStartLocation = Start;
+		CachedTraceResult.LineEndLocation = End;
+		bRejected = true;
+		INC_DWORD_STAT(STAT_LeapWidgetTracesRejected);
+	}
+	else
+	{
+		CachedTraceResult = Super::PerformTrace();
+		INC_DWORD_STAT(STAT_LeapWidgetTraces);
+	}
+	CachedTraceStart = Start;
+	CachedTraceDirection = Direction;
+	CachedWidgetsVersion = WidgetsVersion;
+	CachedTraceFrame = GFrameCounter;
+	bHasCachedTrace = true;
+
+	WidgetSubsystem->RecordHitTest(false, bRejected);
+	WidgetSubsystem->RecordCost(FPlatformTime::Seconds() - StartTime);
+	return CachedTraceResult;
+}
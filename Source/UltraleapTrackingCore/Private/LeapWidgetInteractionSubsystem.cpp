@@ -0,0 +1,210 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "LeapWidgetInteractionSubsystem.h"
+
+#include "Camera/PlayerCameraManager.h"
+#include "Components/WidgetComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+// widget quads have no thickness, pad them so rays grazing the plane still count
+static const float WidgetBoundsPadding = 1.0f;
+
+ULeapWidgetInteractionSubsystem* ULeapWidgetInteractionSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull) : nullptr;
+	return World ? World->GetSubsystem<ULeapWidgetInteractionSubsystem>() : nullptr;
+}
+
+void ULeapWidgetInteractionSubsystem::Deinitialize()
+{
+	if (ActorSpawnedHandle.IsValid() && GetWorld())
+	{
+		GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+	ActorSpawnedHandle.Reset();
+	Grid.Reset();
+	GridWidgets.Reset();
+	GridIds.Reset();
+	Super::Deinitialize();
+}
+
+void ULeapWidgetInteractionSubsystem::RegisterWidget(UWidgetComponent* Widget)
+{
+	if (!Widget || GridIds.Contains(Widget))
+	{
+		return;
+	}
+	const int32 Id = Grid.Add(Widget->Bounds.GetBox().ExpandBy(WidgetBoundsPadding));
+	if (GridWidgets.Num() <= Id)
+	{
+		GridWidgets.SetNum(Id + 1);
+	}
+	GridWidgets[Id].Widget = Widget;
+	GridWidgets[Id].Key = Widget;
+	GridWidgets[Id].bUsed = true;
+	GridIds.Add(Widget, Id);
+	WidgetsVersion++;
+}
+
+void ULeapWidgetInteractionSubsystem::UnregisterWidget(UWidgetComponent* Widget)
+{
+	const int32* Id = GridIds.Find(Widget);
+	if (Id)
+	{
+		RemoveById(*Id);
+	}
+}
+
+void ULeapWidgetInteractionSubsystem::RemoveById(const int32 Id)
+{
+	GridIds.Remove(GridWidgets[Id].Key);
+	GridWidgets[Id] = FIndexedWidget();
+	Grid.Remove(Id);
+	WidgetsVersion++;
+}
+
+void ULeapWidgetInteractionSubsystem::RegisterTaggedWidgets()
+{
+	UWorld* World = GetWorld();
+	if (!World || ActorSpawnedHandle.IsValid())
+	{
+		return;
+	}
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		RegisterActorWidgets(*It);
+	}
+	ActorSpawnedHandle =
+		World->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &ULeapWidgetInteractionSubsystem::OnActorSpawned));
+}
+
+void ULeapWidgetInteractionSubsystem::OnActorSpawned(AActor* Actor)
+{
+	RegisterActorWidgets(Actor);
+}
+
+void ULeapWidgetInteractionSubsystem::RegisterActorWidgets(AActor* Actor)
+{
+	// same tag the widget interaction component requires before it will interact
+	if (!Actor || !Actor->Tags.Contains(FName("UltraleapUMG")))
+	{
+		return;
+	}
+	TArray<UWidgetComponent*> Widgets;
+	Actor->GetComponents<UWidgetComponent>(Widgets);
+	for (UWidgetComponent* Widget : Widgets)
+	{
+		RegisterWidget(Widget);
+	}
+}
+
+void ULeapWidgetInteractionSubsystem::RefreshWidgets()
+{
+	if (LastRefreshFrame == GFrameCounter)
+	{
+		return;
+	}
+	LastRefreshFrame = GFrameCounter;
+
+	for (int32 Id = 0; Id < GridWidgets.Num(); ++Id)
+	{
+		if (!GridWidgets[Id].bUsed)
+		{
+			continue;
+		}
+		UWidgetComponent* Widget = GridWidgets[Id].Widget.Get();
+		if (!Widget)
+		{
+			// destroyed without unregistering
+			RemoveById(Id);
+			continue;
+		}
+		if (Widget->Mobility != EComponentMobility::Movable)
+		{
+			continue;
+		}
+		const FBox Box = Widget->Bounds.GetBox().ExpandBy(WidgetBoundsPadding);
+		if (!Box.Equals(Grid.GetBox(Id)))
+		{
+			Grid.Update(Id, Box);
+			WidgetsVersion++;
+		}
+	}
+}
+
+bool ULeapWidgetInteractionSubsystem::MayHitWidget(const FVector& Start, const FVector& End)
+{
+	RefreshWidgets();
+
+	FBox SegmentBox(ForceInit);
+	SegmentBox += Start;
+	SegmentBox += End;
+	Grid.Query(SegmentBox, ScratchIds);
+
+	const FVector StartToEnd = End - Start;
+	for (const int32 Id : ScratchIds)
+	{
+		if (FMath::LineBoxIntersection(Grid.GetBox(Id), Start, End, StartToEnd))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+const FLeapHandRayFrame& ULeapWidgetInteractionSubsystem::GetRayFrame(APlayerCameraManager* PlayerCameraManager)
+{
+	if (RayFrameNumber != GFrameCounter && PlayerCameraManager)
+	{
+		RayFrameNumber = GFrameCounter;
+		RayFrame.CameraLocation = PlayerCameraManager->GetCameraLocation();
+		RayFrame.CameraRotation = PlayerCameraManager->GetCameraRotation();
+		RayFrame.CameraForward = PlayerCameraManager->GetActorForwardVector();
+		RayFrame.CameraRight = PlayerCameraManager->GetActorRightVector();
+	}
+	return RayFrame;
+}
+
+void ULeapWidgetInteractionSubsystem::BeginStatsFrame()
+{
+	if (StatsFrame != GFrameCounter)
+	{
+		if (StatsFrame != MAX_uint64)
+		{
+			LastFrameStats = CurrentFrameStats;
+		}
+		CurrentFrameStats = FLeapWidgetInteractionStats();
+		StatsFrame = GFrameCounter;
+	}
+}
+
+void ULeapWidgetInteractionSubsystem::RecordHitTest(const bool bSkipped, const bool bRejected)
+{
+	BeginStatsFrame();
+	if (bSkipped)
+	{
+		CurrentFrameStats.TracesSkipped++;
+	}
+	else if (bRejected)
+	{
+		CurrentFrameStats.TracesRejected++;
+	}
+	else
+	{
+		CurrentFrameStats.TracesPerformed++;
+	}
+}
+
+void ULeapWidgetInteractionSubsystem::RecordCost(const double Seconds)
+{
+	BeginStatsFrame();
+	CurrentFrameStats.CostInMS += Seconds * 1000.0;
+}
@@ -13,6 +13,8 @@
 #include "Multileap/DeviceCombiner.h"
 #include "Runtime/Core/Public/Misc/Timespan.h"
 #include "LeapBlueprintFunctionLibrary.h"
+#include "LeapTrackingSettings.h"
+#include "NetworkToLeapWrapper.h"
 
 #pragma region LeapC Wrapper
 
@@ -970,6 +972,13 @@ void FLeapWrapper::PostEarlyInit()
 	{
 		AddOpenXRDevice(nullptr);
 	}
+	if (const ULeapTrackingSettings* TrackingSettings = GetDefault<ULeapTrackingSettings>())
+	{
+		for (const FString& Address : TrackingSettings->RemoteTrackingDevices)
+		{
+			AddNetworkDevice(Address);
+		}
+	}
 }
 	// Must be called from the game thread
 void FLeapWrapper::NotifyDeviceAdded(IHandTrackingWrapper* Device)
@@ -1032,6 +1041,32 @@ void FLeapWrapper::AddOpenXRDevice(LeapWrapperCallbackInterface* InCallbackDeleg
 		UltraleapTrackingLog, Log, TEXT("Add OpenXR Device %s %d."), *(Device->GetDeviceSerial()), Device->GetDeviceID());
 }
 
+void FLeapWrapper::AddNetworkDevice(const FString& Address)
+{
+	FString Host = Address;
+	const bool bUseTCP = Host.RemoveFromStart(TEXT("tcp://"));
+	FString PortString;
+	int32 Port = 0;
+	if (!Host.Split(TEXT(":"), &Host, &PortString, ESearchCase::IgnoreCase, ESearchDir::FromEnd) ||
+		!LexTryParseString(Port, *PortString))
+	{
+		UE_LOG(UltraleapTrackingLog, Warning, TEXT("AddNetworkDevice expected host:port or tcp://host:port, got %s"), *Address);
+		return;
+	}
+	IHandTrackingWrapper* Device = new FNetworkToLeapWrapper(Host, Port, bUseTCP);
+
+	// host didn't resolve
+	if (!Device->IsConnected())
+	{
+		delete Device;
+		return;
+	}
+	Devices.Add(Device);
+
+	NotifyDeviceAdded(Device);
+	UE_LOG(UltraleapTrackingLog, Log, TEXT("Add Network Device %s %d."), *(Device->GetDeviceSerial()), Device->GetDeviceID());
+}
+
 void FLeapWrapper::SetDeviceHints(TArray<FString>& Hints, const uint32_t DeviceID)
 {
 	LEAP_DEVICE DeviceHandle = GetDeviceHandleFromDeviceID(DeviceID);
@@ -12,6 +12,8 @@
 #include "FUltraleapCombinedDevice.h"
 #include "FUltraleapCombinedDeviceAngular.h"
 #include "FUltraleapCombinedDeviceConfidence.h"
+#include "FUltraleapCombinedDeviceSpatial.h"
+#include "FUltraleapCombinedDeviceKalman.h"
 #include "Runtime/Core/Public/Misc/Timespan.h"
 
 #pragma region Combiner
@@ -50,6 +52,18 @@ FDeviceCombiner::FDeviceCombiner(const LEAP_CONNECTION ConnectionHandleIn, IHand
 				(IHandTrackingWrapper*) this, (ITrackingDeviceWrapper*) this, DevicesToCombineIn);
 			break;
 		}
+		case ELeapDeviceCombinerClass::LEAP_DEVICE_COMBINER_SPATIAL:
+		{
+			Device = MakeShared<FUltraleapCombinedDeviceSpatial>(
+				(IHandTrackingWrapper*) this, (ITrackingDeviceWrapper*) this, DevicesToCombineIn);
+			break;
+		}
+		case ELeapDeviceCombinerClass::LEAP_DEVICE_COMBINER_KALMAN:
+		{
+			Device = MakeShared<FUltraleapCombinedDeviceKalman>(
+				(IHandTrackingWrapper*) this, (ITrackingDeviceWrapper*) this, DevicesToCombineIn);
+			break;
+		}
 		default:
 			Device = MakeShared<FUltraleapCombinedDeviceConfidence>(
 				(IHandTrackingWrapper*) this, (ITrackingDeviceWrapper*) this, DevicesToCombineIn);
@@ -0,0 +1,124 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "DeviceExtrinsicsCache.h"
+#include "LeapUtility.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Runtime/Launch/Resources/Version.h"
+#if (ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 3)
+	#include "JsonObjectConverter.h"
+#else
+	#include "JsonUtilities/Public/JsonObjectConverter.h"
+#endif
+
+FDeviceExtrinsicsCache& FDeviceExtrinsicsCache::Get()
+{
+	static FDeviceExtrinsicsCache Instance;
+	return Instance;
+}
+
+FDeviceExtrinsicsCache::FDeviceExtrinsicsCache() : bLoaded(false)
+{
+}
+
+FString FDeviceExtrinsicsCache::GetCacheFilePath()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Ultraleap"), TEXT("DeviceExtrinsics.json"));
+}
+
+bool FDeviceExtrinsicsCache::Find(const FString& DeviceSerial, FLeapDeviceExtrinsics& OutExtrinsics)
+{
+	FScopeLock ScopeLock(&CacheLock);
+	LoadIfNeeded();
+
+	const FLeapDeviceExtrinsics* Found = Entries.Find(DeviceSerial);
+	if (!Found)
+	{
+		return false;
+	}
+	OutExtrinsics = *Found;
+	return true;
+}
+
+void FDeviceExtrinsicsCache::Store(const FLeapDeviceExtrinsics& Extrinsics)
+{
+	if (Extrinsics.DeviceSerial.IsEmpty())
+	{
+		return;
+	}
+	FScopeLock ScopeLock(&CacheLock);
+	LoadIfNeeded();
+
+	Entries.Add(Extrinsics.DeviceSerial, Extrinsics);
+	Save();
+}
+
+void FDeviceExtrinsicsCache::Remove(const FString& DeviceSerial)
+{
+	FScopeLock ScopeLock(&CacheLock);
+	LoadIfNeeded();
+
+	if (Entries.Remove(DeviceSerial))
+	{
+		Save();
+	}
+}
+
+void FDeviceExtrinsicsCache::LoadIfNeeded()
+{
+	if (bLoaded)
+	{
+		return;
+	}
+	bLoaded = true;
+
+	FString JsonString;
+	if (!FFileHelper::LoadFileToString(JsonString, *GetCacheFilePath()))
+	{
+		// no cache yet, not an error
+		return;
+	}
+	FLeapDeviceExtrinsicsFile File;
+	if (!FJsonObjectConverter::JsonObjectStringToUStruct(JsonString, &File, 0, 0))
+	{
+		UE_LOG(UltraleapTrackingLog, Warning, TEXT("FDeviceExtrinsicsCache failed to parse %s"), *GetCacheFilePath());
+		return;
+	}
+	if (File.Version != CacheVersion)
+	{
+		UE_LOG(UltraleapTrackingLog, Log, TEXT("FDeviceExtrinsicsCache ignoring cache version %d (expected %d)"), File.Version,
+			CacheVersion);
+		return;
+	}
+	for (const FLeapDeviceExtrinsics& Extrinsics : File.Devices)
+	{
+		Entries.Add(Extrinsics.DeviceSerial, Extrinsics);
+	}
+	UE_LOG(UltraleapTrackingLog, Log, TEXT("FDeviceExtrinsicsCache loaded %d device(s)"), Entries.Num());
+}
+
+bool FDeviceExtrinsicsCache::Save()
+{
+	FLeapDeviceExtrinsicsFile File;
+	File.Version = CacheVersion;
+	Entries.GenerateValueArray(File.Devices);
+
+	FString JsonString;
+	if (!FJsonObjectConverter::UStructToJsonObjectString(File, JsonString))
+	{
+		UE_LOG(UltraleapTrackingLog, Error, TEXT("FDeviceExtrinsicsCache::Save Failed Json conversion"));
+		return false;
+	}
+	if (!FFileHelper::SaveStringToFile(JsonString, *GetCacheFilePath()))
+	{
+		UE_LOG(UltraleapTrackingLog, Warning, TEXT("FDeviceExtrinsicsCache failed to write %s"), *GetCacheFilePath());
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,44 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#pragma once
+#include "CoreMinimal.h"
+#include "UltraleapTrackingData.h"
+
+/** Persists solved device origins (and their alignment quality) by device serial
+* so multi device setups start aligned instead of re-converging every session.
+* Stored as versioned json in Saved/Ultraleap/DeviceExtrinsics.json */
+class FDeviceExtrinsicsCache
+{
+public:
+	static FDeviceExtrinsicsCache& Get();
+
+	/** Find cached extrinsics for a device, loads the cache file on first use */
+	bool Find(const FString& DeviceSerial, FLeapDeviceExtrinsics& OutExtrinsics);
+
+	/** Add or replace the entry for Extrinsics.DeviceSerial and write the cache file */
+	void Store(const FLeapDeviceExtrinsics& Extrinsics);
+
+	/** Forget a device, e.g. when it has been physically moved */
+	void Remove(const FString& DeviceSerial);
+
+	static FString GetCacheFilePath();
+
+	// bump when FLeapDeviceExtrinsics changes meaning, older files are ignored
+	static const int32 CacheVersion = 1;
+
+private:
+	FDeviceExtrinsicsCache();
+
+	void LoadIfNeeded();
+	bool Save();
+
+	TMap<FString, FLeapDeviceExtrinsics> Entries;
+	FCriticalSection CacheLock;
+	bool bLoaded;
+};
@@ -7,6 +7,7 @@
  ******************************************************************************/
 
 #include "FUltraleapCombinedDevice.h"
+#include "DeviceExtrinsicsCache.h"
 
 int FUltraleapCombinedDevice::HandID = 0;
 
@@ -19,6 +20,11 @@ FUltraleapCombinedDevice::FUltraleapCombinedDevice(IHandTrackingWrapper* LeapDev
 {
 	// static
 	++HandID;
+
+	SourceFrameHistory.AddDefaulted(DevicesToCombine.Num());
+	SourceHealth.AddDefaulted(DevicesToCombine.Num());
+
+	ApplyCachedDeviceOrigins();
 }
 
 FUltraleapCombinedDevice::~FUltraleapCombinedDevice()
@@ -56,9 +62,11 @@ void FUltraleapCombinedDevice::SendControllerEvents()
 		}
 	}
 	// add combiner logic based on DevicesToCombine List. All devices will have ticked before this is called
-	for (auto SourceDevice : DevicesToCombine)
+	const double Now = FPlatformTime::Seconds();
+	int64 NewestTimeStamp = 0;
+	for (int ProviderIndex = 0; ProviderIndex < DevicesToCombine.Num(); ProviderIndex++)
 	{
-		auto InternalSourceDevice = SourceDevice->GetDevice();
+		auto InternalSourceDevice = DevicesToCombine[ProviderIndex]->GetDevice();
 		if (InternalSourceDevice)
 		{
 			FLeapFrameData SourceFrame;
@@ -81,9 +89,74 @@ void FUltraleapCombinedDevice::SendControllerEvents()
 			// comment in for debugging desktop devices only in the combined hand -> 
 			//if (IsScreenTop)
 			{
-				SourceFrames.Add(SourceFrame);
+				UpdateSourceHealth(ProviderIndex, SourceFrame, Now);
+				AddToSourceFrameHistory(ProviderIndex, SourceFrame);
+				if (SourceHealth[ProviderIndex].Freshness > 0)
+				{
+					NewestTimeStamp = FMath::Max(NewestTimeStamp, SourceFrame.TimeStamp);
+				}
+			}
+		}
+	}
+
+	// The common timestamp is the oldest 'latest frame' of the live sources,
+	// so every source can be interpolated rather than extrapolated
+	int64 TargetTimeStamp = NewestTimeStamp;
+	for (int ProviderIndex = 0; ProviderIndex < SourceFrameHistory.Num(); ProviderIndex++)
+	{
+		const auto& History = SourceFrameHistory[ProviderIndex];
+		if (History.Num() && SourceHealth[ProviderIndex].Freshness > 0 &&
+			(NewestTimeStamp - History.Last().TimeStamp) <= MaxSourceSkewInMicros)
+		{
+			TargetTimeStamp = FMath::Min(TargetTimeStamp, History.Last().TimeStamp);
+		}
+	}
+
+	TimeAlignmentOffsetInMicros = NewestTimeStamp - TargetTimeStamp;
+	CombinedTimeStamp = TargetTimeStamp;
+	UpdateInterpolationTimeOffsets();
+	DisplayTimeStamp = GetInterpolatedNow();
+
+	Stats.CombinedSources.SetNum(DevicesToCombine.Num());
+	for (int ProviderIndex = 0; ProviderIndex < DevicesToCombine.Num(); ProviderIndex++)
+	{
+		const auto& History = SourceFrameHistory[ProviderIndex];
+		const FSourceHealth& Health = SourceHealth[ProviderIndex];
+		FLeapCombinedSourceStats& SourceStats = Stats.CombinedSources[ProviderIndex];
+		SourceStats.DeviceSerial = DevicesToCombine[ProviderIndex]->GetDeviceSerial();
+		SourceStats.FrameRate = Health.FrameRate;
+		SourceStats.DroppedFrames = Health.DroppedFrames;
+		SourceStats.LastFrameAgeInMS = Health.LastNewFrameTime > 0 ? (Now - Health.LastNewFrameTime) * 1000.0 : 0;
+		SourceStats.Freshness = Health.Freshness;
+
+		// stale sources and sources with no frames yet still get an (empty) frame so combiners can index frames by provider
+		FLeapFrameData SourceFrame;
+		if (History.Num())
+		{
+			SourceStats.TimeSkewInMS = (History.Last().TimeStamp - TargetTimeStamp) / 1000.f;
+			GetSourceFrameAtTime(ProviderIndex, TargetTimeStamp, SourceFrame);
+		}
+		else
+		{
+			SourceStats.TimeSkewInMS = 0;
+			SourceFrame.TimeStamp = TargetTimeStamp;
+		}
+
+		if (!History.Num() || Health.Freshness <= 0)
+		{
+			SourceFrame.Hands.Reset();
+			SourceFrame.NumberOfHandsVisible = 0;
+			SourceFrame.LeftHandVisible = false;
+			SourceFrame.RightHandVisible = false;
+		}
+		else
+		{
+			for (auto& Hand : SourceFrame.Hands)
+			{
+				Hand.Confidence *= Health.Freshness;
 			}
 		}
+		SourceFrames.Add(SourceFrame);
 	}
 	
 	CombineFrame(SourceFrames);
@@ -250,6 +323,173 @@ void FUltraleapCombinedDevice::CreateLinearJointListInterp(
 	}
 	return;
 }
+void FUltraleapCombinedDevice::UpdateSourceHealth(const int ProviderIndex, const FLeapFrameData& Frame, const double Now)
+{
+	FSourceHealth& Health = SourceHealth[ProviderIndex];
+
+	// with interpolation the frame's TimeStamp moves on every tick even from a stalled device, so new frames are
+	// told apart by their tracking frame ID and timed by the tracking frame's own timestamp
+	if (Frame.FrameId != Health.LastFrameId)
+	{
+		if (Health.LastTrackingTimeStamp != 0 && Frame.TrackingTimeStamp > Health.LastTrackingTimeStamp)
+		{
+			const float Interval = (Frame.TrackingTimeStamp - Health.LastTrackingTimeStamp) / 1000000.0f;
+			if (Frame.FrameRate > 0)
+			{
+				Health.FrameRate = Frame.FrameRate;
+			}
+			else if (Interval > 0)
+			{
+				Health.FrameRate = FMath::Lerp(Health.FrameRate, 1.0f / Interval, 0.1f);
+			}
+			// more time passed than frame IDs explain, the device skipped frames
+			const int32 FrameIdDelta = Frame.FrameId - Health.LastFrameId;
+			const int32 ExpectedFrames = FMath::RoundToInt(Interval * Health.FrameRate);
+			if (FrameIdDelta > 0 && ExpectedFrames > FrameIdDelta)
+			{
+				Health.DroppedFrames += ExpectedFrames - FrameIdDelta;
+			}
+		}
+		Health.LastTrackingTimeStamp = Frame.TrackingTimeStamp;
+		Health.LastFrameId = Frame.FrameId;
+		Health.LastNewFrameTime = Now;
+	}
+
+	// fully weighted for a couple of frame periods, then fade out until the stale timeout
+	const float Age = Now - Health.LastNewFrameTime;
+	const float FreshAge = FMath::Min(Health.FrameRate > 0 ? 2.0f / Health.FrameRate : 0.025f, StaleSourceTimeout * 0.5f);
+	Health.Freshness = 1.0f - FMath::Clamp((Age - FreshAge) / (StaleSourceTimeout - FreshAge), 0.0f, 1.0f);
+}
+float FUltraleapCombinedDevice::GetSourceFreshness(const int ProviderIndex) const
+{
+	return SourceHealth.IsValidIndex(ProviderIndex) ? SourceHealth[ProviderIndex].Freshness : 1.0f;
+}
+void FUltraleapCombinedDevice::AddToSourceFrameHistory(const int ProviderIndex, const FLeapFrameData& Frame)
+{
+	auto& History = SourceFrameHistory[ProviderIndex];
+
+	// the source may not have had a new frame since the last tick
+	if (History.Num() && History.Last().TimeStamp == Frame.TimeStamp)
+	{
+		History.Last() = Frame;
+		return;
+	}
+	// timestamps going backwards means the source restarted, the old history is meaningless
+	if (History.Num() && History.Last().TimeStamp > Frame.TimeStamp)
+	{
+		History.Reset();
+	}
+	if (History.Num() >= MaxSourceFrameHistory)
+	{
+		History.RemoveAt(0, 1, false);
+	}
+	History.Add(Frame);
+}
+void FUltraleapCombinedDevice::GetSourceFrameAtTime(const int ProviderIndex, const int64 TimeStamp, FLeapFrameData& OutFrame)
+{
+	const auto& History = SourceFrameHistory[ProviderIndex];
+
+	// stale or ahead of the history, use the nearest frame we have
+	if (TimeStamp >= History.Last().TimeStamp)
+	{
+		OutFrame = History.Last();
+		return;
+	}
+	if (TimeStamp <= History[0].TimeStamp)
+	{
+		OutFrame = History[0];
+		return;
+	}
+	for (int i = History.Num() - 1; i > 0; i--)
+	{
+		const FLeapFrameData& FrameA = History[i - 1];
+		const FLeapFrameData& FrameB = History[i];
+		if (FrameA.TimeStamp <= TimeStamp)
+		{
+			const float Alpha = (float) (TimeStamp - FrameA.TimeStamp) / (float) (FrameB.TimeStamp - FrameA.TimeStamp);
+			InterpolateFrame(FrameA, FrameB, Alpha, OutFrame);
+			OutFrame.TimeStamp = TimeStamp;
+			return;
+		}
+	}
+}
+void LerpBone(FLeapBoneData& OutBone, const FLeapBoneData& BoneA, const FLeapBoneData& BoneB, const float Alpha)
+{
+	OutBone.PrevJoint = FMath::Lerp(BoneA.PrevJoint, BoneB.PrevJoint, Alpha);
+	OutBone.NextJoint = FMath::Lerp(BoneA.NextJoint, BoneB.NextJoint, Alpha);
+	OutBone.Rotation = FQuat::Slerp(BoneA.Rotation.Quaternion(), BoneB.Rotation.Quaternion(), Alpha).Rotator();
+}
+void LerpDigit(FLeapDigitData& OutDigit, const FLeapDigitData& DigitA, const FLeapDigitData& DigitB, const float Alpha)
+{
+	for (int i = 0; i < OutDigit.Bones.Num() && i < DigitA.Bones.Num(); i++)
+	{
+		LerpBone(OutDigit.Bones[i], DigitA.Bones[i], DigitB.Bones[i], Alpha);
+	}
+	LerpBone(OutDigit.Metacarpal, DigitA.Metacarpal, DigitB.Metacarpal, Alpha);
+	LerpBone(OutDigit.Proximal, DigitA.Proximal, DigitB.Proximal, Alpha);
+	LerpBone(OutDigit.Intermediate, DigitA.Intermediate, DigitB.Intermediate, Alpha);
+	LerpBone(OutDigit.Distal, DigitA.Distal, DigitB.Distal, Alpha);
+}
+// FrameB is the newer frame, hands that only exist in one of the frames are taken from FrameB as is
+void FUltraleapCombinedDevice::InterpolateFrame(
+	const FLeapFrameData& FrameA, const FLeapFrameData& FrameB, const float Alpha, FLeapFrameData& OutFrame)
+{
+	OutFrame = FrameB;
+
+	for (auto& Hand : OutFrame.Hands)
+	{
+		const FLeapHandData* HandA = FrameA.Hands.FindByPredicate(
+			[&Hand](const FLeapHandData& Other) { return Other.Id == Hand.Id && Other.HandType == Hand.HandType; });
+		if (!HandA)
+		{
+			continue;
+		}
+		const FLeapHandData HandB = Hand;
+
+		for (int i = 0; i < Hand.Digits.Num() && i < HandA->Digits.Num(); i++)
+		{
+			LerpDigit(Hand.Digits[i], HandA->Digits[i], HandB.Digits[i], Alpha);
+		}
+		LerpDigit(Hand.Thumb, HandA->Thumb, HandB.Thumb, Alpha);
+		LerpDigit(Hand.Index, HandA->Index, HandB.Index, Alpha);
+		LerpDigit(Hand.Middle, HandA->Middle, HandB.Middle, Alpha);
+		LerpDigit(Hand.Ring, HandA->Ring, HandB.Ring, Alpha);
+		LerpDigit(Hand.Pinky, HandA->Pinky, HandB.Pinky, Alpha);
+		LerpBone(Hand.Arm, HandA->Arm, HandB.Arm, Alpha);
+
+		Hand.Palm.Position = FMath::Lerp(HandA->Palm.Position, HandB.Palm.Position, Alpha);
+		Hand.Palm.StabilizedPosition = FMath::Lerp(HandA->Palm.StabilizedPosition, HandB.Palm.StabilizedPosition, Alpha);
+		Hand.Palm.Orientation =
+			FQuat::Slerp(HandA->Palm.Orientation.Quaternion(), HandB.Palm.Orientation.Quaternion(), Alpha).Rotator();
+		Hand.Palm.Direction = FMath::Lerp(HandA->Palm.Direction, HandB.Palm.Direction, Alpha).GetSafeNormal();
+		Hand.Palm.Normal = FMath::Lerp(HandA->Palm.Normal, HandB.Palm.Normal, Alpha).GetSafeNormal();
+
+		Hand.GrabStrength = FMath::Lerp(HandA->GrabStrength, HandB.GrabStrength, Alpha);
+		Hand.PinchStrength = FMath::Lerp(HandA->PinchStrength, HandB.PinchStrength, Alpha);
+		Hand.PinchDistance = FMath::Lerp(HandA->PinchDistance, HandB.PinchDistance, Alpha);
+		Hand.Confidence = FMath::Lerp(HandA->Confidence, HandB.Confidence, Alpha);
+	}
+}
+// seed the source device origins from the last session's alignment so that
+// GetSourceDeviceOrigin is valid before the first combined frame
+void FUltraleapCombinedDevice::ApplyCachedDeviceOrigins()
+{
+	for (auto SourceDevice : DevicesToCombine)
+	{
+		auto InternalSourceDevice = SourceDevice->GetDevice();
+		if (!InternalSourceDevice)
+		{
+			continue;
+		}
+		FLeapDeviceExtrinsics Extrinsics;
+		if (FDeviceExtrinsicsCache::Get().Find(SourceDevice->GetDeviceSerial(), Extrinsics))
+		{
+			InternalSourceDevice->SetDeviceOrigin(Extrinsics.DeviceOrigin);
+			UE_LOG(UltraleapTrackingLog, Log, TEXT("Applied cached device origin for %s (residual %f cm)"),
+				*Extrinsics.DeviceSerial, Extrinsics.Residual);
+		}
+	}
+}
 FTransform FUltraleapCombinedDevice::GetSourceDeviceOrigin(const int ProviderIndex)
 {
 	return DevicesToCombine[ProviderIndex]->GetDevice()->GetDeviceOrigin();
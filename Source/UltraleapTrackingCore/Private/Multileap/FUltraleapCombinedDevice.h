@@ -26,6 +26,13 @@ public:
 	static void TransformFrame(
 		FLeapFrameData& OutData, const FVector& TranslationOffset, const FRotator& RotationOffset);
 
+	// Helpers ported from VectorHand.cs, used from multiple Combiners
+	// Equivalent of VectorHand.Encode
+	static void CreateLocalLinearJointList(const FLeapHandData& Hand, TArray<FVector>& JointsPositions);
+	// Equivalent of VectorHand.Decode
+	static void ConvertToWorldSpaceHand(FLeapHandData& Hand,
+		const bool IsLeft, const FVector& PalmPos, const FQuat& PalmRot, const TArray<FVector>& JointPositions);
+
 protected:
 	// override this in any custom combiners
 	virtual void CombineFrame(const TArray<FLeapFrameData>& SourceFrames) = 0;
@@ -34,13 +41,6 @@ protected:
 	// the combined devices
 	TArray<IHandTrackingWrapper*> DevicesToCombine;
 
-	// Helpers ported from VectorHand.cs, used from multiple Combiners
-	// Equivalent of VectorHand.Encode
-	void CreateLocalLinearJointList(const FLeapHandData& Hand, TArray<FVector>& JointsPositions);
-	// Equivalent of VectorHand.Decode
-	void ConvertToWorldSpaceHand(FLeapHandData& Hand,
-		const bool IsLeft, const FVector& PalmPos, const FQuat& PalmRot, const TArray<FVector>& JointPositions);
-
 	// Equivalent of VectorHand.FillLerped
 	void CreateLinearJointListInterp(const FLeapHandData& HandA, const FLeapHandData& HandB, TArray<FVector>& Joints,
 		const float Alpha, FVector& PalmPos, FQuat& PalmRot);
@@ -50,6 +50,44 @@ protected:
 	
 	FTransform GetSourceDeviceOrigin(const int ProviderIndex);
 	
+	void ApplyCachedDeviceOrigins();
+
+	// Source devices are unsynchronised, so keep a short history per source
+	// and resample them all at a common timestamp before combining
+	TArray<TArray<FLeapFrameData>> SourceFrameHistory;
+	static const int MaxSourceFrameHistory = 8;
+	// sources lagging further behind than this are stale and don't hold the others back
+	static const int64 MaxSourceSkewInMicros = 50000;
+	// how far the common timestamp is behind the newest source
+	int64 TimeAlignmentOffsetInMicros = 0;
+	// the common timestamp this tick's source frames were resampled at
+	int64 CombinedTimeStamp = 0;
+	// the Leap time the combined hands are expected on screen, combiners predicting forward should aim here
+	int64 DisplayTimeStamp = 0;
+
+	// Per source heartbeat, sources that stop producing frames (e.g. USB hiccups) are
+	// down weighted and then excluded rather than having their last hands merged at full weight
+	struct FSourceHealth
+	{
+		double LastNewFrameTime = 0;
+		int64 LastTrackingTimeStamp = 0;
+		int32 LastFrameId = 0;
+		int32 DroppedFrames = 0;
+		float FrameRate = 0;
+		// 1 = fresh, 0 = stale and excluded
+		float Freshness = 0;
+	};
+	TArray<FSourceHealth> SourceHealth;
+	// seconds without a new frame before a source is excluded
+	float StaleSourceTimeout = 0.1f;
+
+	void UpdateSourceHealth(const int ProviderIndex, const FLeapFrameData& Frame, const double Now);
+	float GetSourceFreshness(const int ProviderIndex) const;
+
+	void AddToSourceFrameHistory(const int ProviderIndex, const FLeapFrameData& Frame);
+	void GetSourceFrameAtTime(const int ProviderIndex, const int64 TimeStamp, FLeapFrameData& OutFrame);
+	static void InterpolateFrame(
+		const FLeapFrameData& FrameA, const FLeapFrameData& FrameB, const float Alpha, FLeapFrameData& OutFrame);
 
 private:
 };
@@ -417,6 +417,9 @@ float FUltraleapCombinedDeviceConfidence::CalculateHandConfidence(int FrameIdx,c
 									  DevicesToCombine[FrameIdx]->GetDevice(), Hand.HandType == EHandType::LEAP_HAND_LEFT);
 	}
 
+	// sources that have stopped producing frames fade out
+	Confidence *= GetSourceFreshness(FrameIdx);
+
 	// average out new hand confidence with that of the last few frames
 	if (Hand.HandType == EHandType::LEAP_HAND_LEFT)
 	{
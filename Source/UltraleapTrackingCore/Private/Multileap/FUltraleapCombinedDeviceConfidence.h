@@ -274,6 +274,8 @@ private:
 		const EHandType HandType, IHandTrackingWrapper* Provider);
 
 
-	void MergeHands(const TArray<const FLeapHandData*>& Hands, const TArray<float>& HandConfidences,
+protected:
+	// override to change how the confidence weighted hands are combined
+	virtual void MergeHands(const TArray<const FLeapHandData*>& Hands, const TArray<float>& HandConfidences,
 		const TArray<TArray<float>>& JointConfidences, FLeapHandData& HandRet);
 };
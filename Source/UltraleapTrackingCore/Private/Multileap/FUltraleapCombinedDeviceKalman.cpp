@@ -0,0 +1,208 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "FUltraleapCombinedDeviceKalman.h"
+
+namespace
+{
+// hand and joint confidences are normalised over the source hands, 1/N is an average observation
+float GetObservationNoise(const float MeasurementNoise, const float Confidence, const int NumHands)
+{
+	return MeasurementNoise / FMath::Max(Confidence * NumHands, 0.01f);
+}
+}	 // namespace
+
+FUltraleapCombinedDeviceKalman::FUltraleapCombinedDeviceKalman(IHandTrackingWrapper* LeapDeviceWrapperIn,
+	ITrackingDeviceWrapper* TrackingDeviceWrapperIn, TArray<IHandTrackingWrapper*> DevicesToCombineIn)
+	: FUltraleapCombinedDeviceConfidence(LeapDeviceWrapperIn, TrackingDeviceWrapperIn, DevicesToCombineIn)
+{
+	Measurement.AddZeroed(NumFilteredPoints);
+	ObservationNoise.AddZeroed(NumFilteredPoints);
+	FilteredJointPositions.AddZeroed(NumJointPositions);
+}
+
+void FUltraleapCombinedDeviceKalman::CombineFrame(const TArray<FLeapFrameData>& SourceFrames)
+{
+	for (auto& State : HandStates)
+	{
+		State.bUpdatedThisFrame = false;
+	}
+
+	FUltraleapCombinedDeviceConfidence::CombineFrame(SourceFrames);
+
+	// hand lost, start again from the next measurement rather than predicting from stale state
+	for (auto& State : HandStates)
+	{
+		if (!State.bUpdatedThisFrame)
+		{
+			State.bInitialised = false;
+		}
+	}
+}
+
+void FUltraleapCombinedDeviceKalman::MergeHands(const TArray<const FLeapHandData*>& Hands, const TArray<float>& HandConfidences,
+	const TArray<TArray<float>>& JointConfidencesIn, FLeapHandData& HandRet)
+{
+	const bool IsLeft = Hands[0]->HandType == EHandType::LEAP_HAND_LEFT;
+	FKalmanHandState& State = HandStates[IsLeft ? 0 : 1];
+	State.bUpdatedThisFrame = true;
+
+	// palm orientation is measured as the confidence combiner merges it
+	FQuat MeasuredPalmRot = Hands[0]->Palm.Orientation.Quaternion();
+	float ConfidenceSoFar = HandConfidences[0];
+	for (int HandsIdx = 1; HandsIdx < Hands.Num(); HandsIdx++)
+	{
+		const float Total = ConfidenceSoFar + HandConfidences[HandsIdx];
+		const float LerpValue = Total > 0 ? ConfidenceSoFar / Total : 0.5f;
+		MeasuredPalmRot = FQuat::FastLerp(Hands[HandsIdx]->Palm.Orientation.Quaternion(), MeasuredPalmRot, LerpValue);
+		ConfidenceSoFar = Total;
+	}
+
+	bool bObserve = true;
+	if (!State.bInitialised)
+	{
+		// the initial variance is large, so the observations below replace this
+		CreateLocalLinearJointList(*Hands[0], Measurement);
+		Measurement[PalmPointIndex] = Hands[0]->Palm.Position;
+		State.Reset(Measurement);
+		State.PalmOrientation = MeasuredPalmRot;
+	}
+	else
+	{
+		// step by source time, the sources were resampled at CombinedTimeStamp whatever the game frame time
+		const float DeltaTime = (CombinedTimeStamp - State.TimeStamp) / 1000000.0f;
+		// no newer source frames, these observations have already been fused
+		bObserve = DeltaTime > 0;
+		if (bObserve)
+		{
+			State.Predict(DeltaTime, ProcessNoise);
+			State.PalmOrientation = FQuat::Slerp(State.PalmOrientation, MeasuredPalmRot, OrientationBlend);
+		}
+	}
+
+	if (bObserve)
+	{
+		State.TimeStamp = CombinedTimeStamp;
+
+		// one observation per device, each weighted by that device's confidence in the hand and its joints
+		for (int HandsIdx = 0; HandsIdx < Hands.Num(); HandsIdx++)
+		{
+			CreateLocalLinearJointList(*Hands[HandsIdx], Measurement);
+			Measurement[PalmPointIndex] = Hands[HandsIdx]->Palm.Position;
+			for (int i = 0; i < NumJointPositions; i++)
+			{
+				ObservationNoise[i] = GetObservationNoise(MeasurementNoise, JointConfidencesIn[HandsIdx][i], Hands.Num());
+			}
+			ObservationNoise[PalmPointIndex] = GetObservationNoise(MeasurementNoise, HandConfidences[HandsIdx], Hands.Num());
+			State.Update(Measurement, ObservationNoise);
+		}
+	}
+
+	// the filter is at the resampled source time, predict to when the hand is shown. Sources that already
+	// interpolate ahead of now are close to display time, so this only makes up the difference
+	const float ToDisplayTime = FMath::Clamp((DisplayTimeStamp - State.TimeStamp) / 1000000.0f, 0.0f, MaxPredictAhead);
+	const float PredictAhead = PredictionTime + ToDisplayTime;
+
+	for (int i = 0; i < NumJointPositions; i++)
+	{
+		FilteredJointPositions[i] = State.GetPosition(i, PredictAhead);
+	}
+	const FVector PalmPos = State.GetPosition(PalmPointIndex, PredictAhead);
+
+	ConvertToWorldSpaceHand(HandRet, IsLeft, PalmPos, State.PalmOrientation, FilteredJointPositions);
+	HandRet.Palm.Velocity = State.GetVelocity(PalmPointIndex);
+}
+
+FUltraleapCombinedDeviceKalman::FKalmanHandState::FKalmanHandState()
+	: PalmOrientation(FQuat::Identity), TimeStamp(0), bInitialised(false), bUpdatedThisFrame(false)
+{
+}
+
+void FUltraleapCombinedDeviceKalman::FKalmanHandState::Reset(const TArray<FVector>& MeasurementIn)
+{
+	// large initial uncertainty so the first few measurements dominate
+	static const float InitialVariance = 10.0f;
+	static const float InitialVelocityVariance = 10000.0f;
+
+	for (int i = 0; i < NumFilteredPoints; i++)
+	{
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			Position[Axis][i] = MeasurementIn[i][Axis];
+			Velocity[Axis][i] = 0;
+		}
+		P00[i] = InitialVariance;
+		P01[i] = 0;
+		P11[i] = InitialVelocityVariance;
+	}
+	bInitialised = true;
+}
+
+void FUltraleapCombinedDeviceKalman::FKalmanHandState::Predict(const float DeltaTime, const float ProcessNoise)
+{
+	const float Q00 = ProcessNoise * DeltaTime * DeltaTime * DeltaTime / 3.0f;
+	const float Q01 = ProcessNoise * DeltaTime * DeltaTime / 2.0f;
+	const float Q11 = ProcessNoise * DeltaTime;
+
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		float* RESTRICT Pos = Position[Axis];
+		const float* RESTRICT Vel = Velocity[Axis];
+		for (int i = 0; i < NumFilteredPoints; i++)
+		{
+			Pos[i] += Vel[i] * DeltaTime;
+		}
+	}
+	for (int i = 0; i < NumFilteredPoints; i++)
+	{
+		P00[i] += DeltaTime * (2.0f * P01[i] + DeltaTime * P11[i]) + Q00;
+		P01[i] += DeltaTime * P11[i] + Q01;
+		P11[i] += Q11;
+	}
+}
+
+void FUltraleapCombinedDeviceKalman::FKalmanHandState::Update(
+	const TArray<FVector>& MeasurementIn, const TArray<float>& MeasurementNoise)
+{
+	float K0[NumFilteredPoints];
+	float K1[NumFilteredPoints];
+
+	for (int i = 0; i < NumFilteredPoints; i++)
+	{
+		const float S = P00[i] + MeasurementNoise[i];
+		K0[i] = P00[i] / S;
+		K1[i] = P01[i] / S;
+
+		// (I - KH)P with P symmetric
+		P11[i] -= K1[i] * P01[i];
+		P01[i] -= K0[i] * P01[i];
+		P00[i] -= K0[i] * P00[i];
+	}
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		float* RESTRICT Pos = Position[Axis];
+		float* RESTRICT Vel = Velocity[Axis];
+		for (int i = 0; i < NumFilteredPoints; i++)
+		{
+			const float Innovation = MeasurementIn[i][Axis] - Pos[i];
+			Pos[i] += K0[i] * Innovation;
+			Vel[i] += K1[i] * Innovation;
+		}
+	}
+}
+
+FVector FUltraleapCombinedDeviceKalman::FKalmanHandState::GetPosition(const int Index, const float PredictAhead) const
+{
+	return FVector(Position[0][Index] + Velocity[0][Index] * PredictAhead, Position[1][Index] + Velocity[1][Index] * PredictAhead,
+		Position[2][Index] + Velocity[2][Index] * PredictAhead);
+}
+
+FVector FUltraleapCombinedDeviceKalman::FKalmanHandState::GetVelocity(const int Index) const
+{
+	return FVector(Velocity[0][Index], Velocity[1][Index], Velocity[2][Index]);
+}
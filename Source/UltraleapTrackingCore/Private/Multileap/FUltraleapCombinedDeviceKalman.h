@@ -0,0 +1,74 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#pragma once
+#include "FUltraleapCombinedDeviceConfidence.h"
+
+/** Fuses the source hands with a constant velocity Kalman filter per joint. Every source hand is its own observation,
+* its noise scaled by that device's confidence in the hand, so switching the dominant device no longer pops. The filter
+* steps by the resampled source timestamp and the filtered hand is predicted to display time. Palm orientation uses a
+* complementary filter. */
+class FUltraleapCombinedDeviceKalman : public FUltraleapCombinedDeviceConfidence
+{
+public:
+	FUltraleapCombinedDeviceKalman(IHandTrackingWrapper* LeapDeviceWrapperIn, ITrackingDeviceWrapper* TrackingDeviceWrapperIn,
+		TArray<IHandTrackingWrapper*> DevicesToCombineIn);
+
+protected:
+	virtual void CombineFrame(const TArray<FLeapFrameData>& SourceFrames) override;
+	virtual void MergeHands(const TArray<const FLeapHandData*>& Hands, const TArray<float>& HandConfidences,
+		const TArray<TArray<float>>& JointConfidences, FLeapHandData& HandRet) override;
+
+public:
+	// measurement variance of a single device observation of average confidence in cm^2
+	float MeasurementNoise = 0.05f;
+	// white noise acceleration spectral density in cm^2/s^3, higher follows fast motion more closely
+	float ProcessNoise = 2000.0f;
+	// extra prediction on top of display time, in seconds
+	float PredictionTime = 0;
+	// longest prediction from the source timestamp to display time, in seconds
+	float MaxPredictAhead = 0.05f;
+	// 0-1, how much of the measured palm orientation is taken each frame
+	float OrientationBlend = 0.5f;
+
+private:
+	// local space joints plus the palm position
+	static const int NumFilteredPoints = NumJointPositions + 1;
+	static const int PalmPointIndex = NumJointPositions;
+
+	// structure of arrays so the per point update runs over contiguous floats
+	struct FKalmanHandState
+	{
+		FKalmanHandState();
+
+		float Position[3][NumFilteredPoints];
+		float Velocity[3][NumFilteredPoints];
+		// 2x2 covariance is the same for every axis as the noise is isotropic
+		float P00[NumFilteredPoints];
+		float P01[NumFilteredPoints];
+		float P11[NumFilteredPoints];
+
+		FQuat PalmOrientation;
+		// source timestamp of the last observations
+		int64 TimeStamp;
+		bool bInitialised;
+		bool bUpdatedThisFrame;
+
+		void Reset(const TArray<FVector>& Measurement);
+		void Predict(const float DeltaTime, const float ProcessNoise);
+		void Update(const TArray<FVector>& Measurement, const TArray<float>& MeasurementNoise);
+		FVector GetPosition(const int Index, const float PredictAhead) const;
+		FVector GetVelocity(const int Index) const;
+	};
+
+	FKalmanHandState HandStates[2];
+
+	TArray<FVector> Measurement;
+	TArray<float> ObservationNoise;
+	TArray<FVector> FilteredJointPositions;
+};
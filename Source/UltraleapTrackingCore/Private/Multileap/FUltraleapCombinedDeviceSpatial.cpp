@@ -0,0 +1,351 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "FUltraleapCombinedDeviceSpatial.h"
+
+#include "HAL/IConsoleManager.h"
+#include "LeapUtility.h"
+#include "Math/RandomStream.h"
+#include "UltraleapTrackingStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Multi Leap Spatial Combine"), STAT_MultiLeapSpatialCombine, STATGROUP_UltraleapMultiTracking);
+
+void FUltraleapCombinedDeviceSpatial::CombineFrame(const TArray<FLeapFrameData>& SourceFrames)
+{
+	Fusion.Combine(SourceFrames, FPlatformTime::Seconds(), CurrentFrame);
+}
+
+void FUltraleapCombinedDeviceSpatial::GetDebugInfo(int32& NumCombinedLeft, int32& NumCombinedRight)
+{
+	Fusion.GetDebugInfo(NumCombinedLeft, NumCombinedRight);
+}
+
+void FLeapSpatialHandFusion::Combine(const TArray<FLeapFrameData>& SourceFrames, const double Now, FLeapFrameData& OutFrame)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MultiLeapSpatialCombine);
+
+	NumProviders = SourceFrames.Num();
+
+	// gather every hand seen by every device
+	Observations.Reset();
+	for (int32 ProviderIndex = 0; ProviderIndex < NumProviders; ProviderIndex++)
+	{
+		for (const FLeapHandData& Hand : SourceFrames[ProviderIndex].Hands)
+		{
+			FHandObservation Observation;
+			Observation.Hand = &Hand;
+			Observation.ProviderIndex = ProviderIndex;
+			Observation.Weight = FMath::Max(Hand.Confidence, 0.01f);
+			Observation.TrackIndex = INDEX_NONE;
+			Observations.Add(Observation);
+		}
+	}
+
+	TrackUsesProvider.Reset();
+	TrackUsesProvider.AddZeroed(Tracks.Num() * NumProviders);
+
+	// cost of every observation against every existing fused hand of the same chirality.
+	// The number of fused hands is bounded by the number of real hands, so this is linear in devices x hands
+	Candidates.Reset();
+	for (int32 ObservationIndex = 0; ObservationIndex < Observations.Num(); ObservationIndex++)
+	{
+		const FLeapHandData& Hand = *Observations[ObservationIndex].Hand;
+		for (int32 TrackIndex = 0; TrackIndex < Tracks.Num(); TrackIndex++)
+		{
+			if (Tracks[TrackIndex].HandType != Hand.HandType)
+			{
+				continue;
+			}
+			const float Cost = AssociationCost(Tracks[TrackIndex], Hand);
+			if (Cost <= MaxAssociationDistance)
+			{
+				Candidates.Add({Cost, ObservationIndex, TrackIndex});
+			}
+		}
+	}
+	// greedy assignment, cheapest pairs first. Good enough as the gate keeps fused hands well separated
+	Candidates.Sort();
+	for (const FAssociationCandidate& Candidate : Candidates)
+	{
+		FHandObservation& Observation = Observations[Candidate.ObservationIndex];
+		if (Observation.TrackIndex == INDEX_NONE && CanAssign(Observation, Candidate.TrackIndex))
+		{
+			Assign(Observation, Candidate.TrackIndex);
+		}
+	}
+
+	// anything left over is a newly seen hand, cluster with other new hands this frame or start a new fused hand
+	const int32 FirstNewTrack = Tracks.Num();
+	for (FHandObservation& Observation : Observations)
+	{
+		if (Observation.TrackIndex != INDEX_NONE)
+		{
+			continue;
+		}
+		int32 BestTrack = INDEX_NONE;
+		float BestCost = MaxAssociationDistance;
+		for (int32 TrackIndex = FirstNewTrack; TrackIndex < Tracks.Num(); TrackIndex++)
+		{
+			if (Tracks[TrackIndex].HandType != Observation.Hand->HandType || !CanAssign(Observation, TrackIndex))
+			{
+				continue;
+			}
+			const float Cost = AssociationCost(Tracks[TrackIndex], *Observation.Hand);
+			if (Cost <= BestCost)
+			{
+				BestCost = Cost;
+				BestTrack = TrackIndex;
+			}
+		}
+		if (BestTrack == INDEX_NONE)
+		{
+			BestTrack = AddTrack(*Observation.Hand, Now);
+		}
+		Assign(Observation, BestTrack);
+	}
+
+	// fuse each track's observations into a single hand
+	OutFrame.Hands.Reset();
+	OutFrame.LeftHandVisible = false;
+	OutFrame.RightHandVisible = false;
+
+	for (int32 TrackIndex = 0; TrackIndex < Tracks.Num(); TrackIndex++)
+	{
+		FFusedHandTrack& Track = Tracks[TrackIndex];
+
+		TrackHands.Reset();
+		TrackWeights.Reset();
+		for (const FHandObservation& Observation : Observations)
+		{
+			if (Observation.TrackIndex == TrackIndex)
+			{
+				TrackHands.Add(Observation.Hand);
+				TrackWeights.Add(Observation.Weight);
+			}
+		}
+		if (!TrackHands.Num())
+		{
+			continue;
+		}
+		FLeapHandData& FusedHand = OutFrame.Hands.AddDefaulted_GetRef();
+		FuseHands(Track, FusedHand);
+
+		Track.PalmPosition = FusedHand.Palm.Position;
+		Track.PalmOrientation = FusedHand.Palm.Orientation.Quaternion();
+		Track.LastSeenTime = Now;
+
+		if (Track.HandType == EHandType::LEAP_HAND_LEFT)
+		{
+			OutFrame.LeftHandVisible = true;
+		}
+		else
+		{
+			OutFrame.RightHandVisible = true;
+		}
+	}
+	OutFrame.NumberOfHandsVisible = OutFrame.Hands.Num();
+
+	// forget hands that haven't been seen for a while, their IDs are not reused
+	for (int32 TrackIndex = Tracks.Num() - 1; TrackIndex >= 0; TrackIndex--)
+	{
+		if (Now - Tracks[TrackIndex].LastSeenTime > TrackTimeout)
+		{
+			Tracks.RemoveAtSwap(TrackIndex);
+		}
+	}
+}
+
+float FLeapSpatialHandFusion::AssociationCost(const FFusedHandTrack& Track, const FLeapHandData& Hand) const
+{
+	const float Distance = FVector::Distance(Track.PalmPosition, Hand.Palm.Position);
+	const float AngleInDegrees = FMath::RadiansToDegrees(Track.PalmOrientation.AngularDistance(Hand.Palm.Orientation.Quaternion()));
+
+	return Distance + AngleInDegrees * OrientationCostWeight;
+}
+
+bool FLeapSpatialHandFusion::CanAssign(const FHandObservation& Observation, const int32 TrackIndex) const
+{
+	return !TrackUsesProvider[TrackIndex * NumProviders + Observation.ProviderIndex];
+}
+
+void FLeapSpatialHandFusion::Assign(FHandObservation& Observation, const int32 TrackIndex)
+{
+	TrackUsesProvider[TrackIndex * NumProviders + Observation.ProviderIndex] = true;
+	Observation.TrackIndex = TrackIndex;
+}
+
+int32 FLeapSpatialHandFusion::AddTrack(const FLeapHandData& Hand, const double Now)
+{
+	FFusedHandTrack Track;
+	Track.FusedId = NextFusedId++;
+	Track.HandType = Hand.HandType;
+	Track.PalmPosition = Hand.Palm.Position;
+	Track.PalmOrientation = Hand.Palm.Orientation.Quaternion();
+	Track.LastSeenTime = Now;
+
+	TrackUsesProvider.AddZeroed(NumProviders);
+	return Tracks.Add(Track);
+}
+
+// confidence weighted merge of TrackHands, same approach as the confidence combiner but per hand rather than per joint
+void FLeapSpatialHandFusion::FuseHands(const FFusedHandTrack& Track, FLeapHandData& OutHand)
+{
+	if (TrackHands.Num() == 1)
+	{
+		OutHand = *TrackHands[0];
+		OutHand.Id = Track.FusedId;
+		return;
+	}
+
+	float WeightSum = 0;
+	for (const float Weight : TrackWeights)
+	{
+		WeightSum += Weight;
+	}
+
+	FVector MergedPalmPos = FVector::ZeroVector;
+	FQuat MergedPalmRot = FQuat(0, 0, 0, 0);
+	const FQuat ReferenceRot = TrackHands[0]->Palm.Orientation.Quaternion();
+
+	MergedJointPositions.Reset();
+	MergedJointPositions.AddZeroed(FUltraleapCombinedDevice::NumJointPositions);
+	JointPositions.SetNumUninitialized(FUltraleapCombinedDevice::NumJointPositions);
+
+	float GrabStrength = 0;
+	float PinchStrength = 0;
+	float PinchDistance = 0;
+	float Confidence = 0;
+	float VisibleTime = 0;
+
+	for (int32 HandsIdx = 0; HandsIdx < TrackHands.Num(); HandsIdx++)
+	{
+		const FLeapHandData& Hand = *TrackHands[HandsIdx];
+		const float Weight = TrackWeights[HandsIdx] / WeightSum;
+
+		MergedPalmPos += Hand.Palm.Position * Weight;
+
+		// keep all quaternions in the same hemisphere before averaging
+		FQuat PalmRot = Hand.Palm.Orientation.Quaternion();
+		if ((PalmRot | ReferenceRot) < 0)
+		{
+			PalmRot = FQuat(-PalmRot.X, -PalmRot.Y, -PalmRot.Z, -PalmRot.W);
+		}
+		MergedPalmRot += PalmRot * Weight;
+
+		FUltraleapCombinedDevice::CreateLocalLinearJointList(Hand, JointPositions);
+		for (int JointIdx = 0; JointIdx < FUltraleapCombinedDevice::NumJointPositions; JointIdx++)
+		{
+			MergedJointPositions[JointIdx] += JointPositions[JointIdx] * Weight;
+		}
+
+		GrabStrength += Hand.GrabStrength * Weight;
+		PinchStrength += Hand.PinchStrength * Weight;
+		PinchDistance += Hand.PinchDistance * Weight;
+		Confidence = FMath::Max(Confidence, Hand.Confidence);
+		VisibleTime = FMath::Max(VisibleTime, Hand.VisibleTime);
+	}
+	MergedPalmRot.Normalize();
+
+	FUltraleapCombinedDevice::ConvertToWorldSpaceHand(OutHand, Track.HandType == EHandType::LEAP_HAND_LEFT, MergedPalmPos, MergedPalmRot, MergedJointPositions);
+
+	OutHand.Id = Track.FusedId;
+	OutHand.GrabStrength = GrabStrength;
+	OutHand.PinchStrength = PinchStrength;
+	OutHand.PinchDistance = PinchDistance;
+	OutHand.Confidence = Confidence;
+	OutHand.VisibleTime = VisibleTime;
+}
+
+void FLeapSpatialHandFusion::GetDebugInfo(int32& NumCombinedLeft, int32& NumCombinedRight) const
+{
+	NumCombinedLeft = NumCombinedRight = 0;
+	for (const FFusedHandTrack& Track : Tracks)
+	{
+		if (Track.HandType == EHandType::LEAP_HAND_LEFT)
+		{
+			NumCombinedLeft++;
+		}
+		else
+		{
+			NumCombinedRight++;
+		}
+	}
+}
+
+// Synthetic benchmark of spatial fusion with every device seeing two users' hands, with per device noise
+// and the hands moving every tick. Usage: MultiLeap.SpatialCombineBenchmark [NumDevices]
+static void RunSpatialCombineBenchmark(const int32 NumDevices)
+{
+	const int32 NumTicks = 1000;
+	const int32 NumUsers = 2;
+	const float NoiseInCm = 0.5f;
+
+	FRandomStream Random(NumDevices);
+	TArray<FLeapFrameData> SourceFrames;
+	SourceFrames.SetNum(NumDevices);
+
+	const auto FillHand = [&Random, NoiseInCm](FLeapHandData& Hand, const EHandType HandType, const FVector& PalmPosition) {
+		Hand.InitFromEmpty(HandType, 0);
+		Hand.Palm.Position = PalmPosition + Random.GetUnitVector() * NoiseInCm;
+		Hand.Palm.Orientation = FRotator(Random.FRandRange(-2.0f, 2.0f), Random.FRandRange(-2.0f, 2.0f), 0);
+		for (int32 DigitIndex = 0; DigitIndex < Hand.Digits.Num(); DigitIndex++)
+		{
+			FVector Joint = Hand.Palm.Position + FVector(0, (DigitIndex - 2) * 2.0f, 0);
+			for (FLeapBoneData& Bone : Hand.Digits[DigitIndex].Bones)
+			{
+				Bone.PrevJoint = Joint;
+				Joint += FVector(3.0f, 0, 0);
+				Bone.NextJoint = Joint;
+			}
+		}
+		Hand.UpdateFromDigits();
+	};
+
+	FLeapSpatialHandFusion Fusion;
+	FLeapFrameData OutFrame;
+	double CombineTime = 0;
+	int32 MaxFusedHands = 0;
+	for (int32 Tick = 0; Tick < NumTicks; ++Tick)
+	{
+		for (FLeapFrameData& Frame : SourceFrames)
+		{
+			Frame.Hands.SetNum(NumUsers * 2);
+			for (int32 User = 0; User < NumUsers; ++User)
+			{
+				// users stand a metre apart and sway slowly
+				const FVector UserPosition = FVector(30.0f, User * 100.0f, 150.0f + FMath::Sin(Tick * 0.01f) * 10.0f);
+				FillHand(Frame.Hands[User * 2], EHandType::LEAP_HAND_LEFT, UserPosition + FVector(0, -20.0f, 0));
+				FillHand(Frame.Hands[User * 2 + 1], EHandType::LEAP_HAND_RIGHT, UserPosition + FVector(0, 20.0f, 0));
+			}
+		}
+
+		const double StartTime = FPlatformTime::Seconds();
+		Fusion.Combine(SourceFrames, Tick / 120.0, OutFrame);
+		CombineTime += FPlatformTime::Seconds() - StartTime;
+
+		MaxFusedHands = FMath::Max(MaxFusedHands, OutFrame.Hands.Num());
+	}
+
+	UE_LOG(UltraleapTrackingLog, Log,
+		TEXT("MultiLeap.SpatialCombineBenchmark %d devices: %.4fms/frame, fused %d hands at most (%d real hands)"), NumDevices,
+		CombineTime * 1000.0 / NumTicks, MaxFusedHands, NumUsers * 2);
+}
+
+static FAutoConsoleCommand SpatialCombineBenchmarkCommand(TEXT("MultiLeap.SpatialCombineBenchmark"),
+	TEXT("Time spatial hand fusion across devices, defaults to 2, 4, 8 and 16 devices"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args) {
+		if (Args.Num())
+		{
+			RunSpatialCombineBenchmark(FMath::Max(FCString::Atoi(*Args[0]), 1));
+			return;
+		}
+		for (const int32 NumDevices : {2, 4, 8, 16})
+		{
+			RunSpatialCombineBenchmark(NumDevices);
+		}
+	}));
@@ -0,0 +1,102 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#pragma once
+#include "FUltraleapCombinedDevice.h"
+
+/** Associates hands across any number of devices by palm position and orientation
+* rather than bucketing by left/right, so more than one left or right hand (e.g. two users) can be in the shared volume.
+* Fused hands keep a persistent ID for as long as any device keeps seeing them. Independent of any device so it can be
+* driven from recorded or synthetic frames, see MultiLeap.SpatialCombineBenchmark */
+class FLeapSpatialHandFusion
+{
+public:
+	FLeapSpatialHandFusion()
+		: NextFusedId(0)
+		, NumProviders(0)
+	{
+	}
+
+	/** Fuse one frame per source device into OutFrame's hands, Now in seconds */
+	void Combine(const TArray<FLeapFrameData>& SourceFrames, const double Now, FLeapFrameData& OutFrame);
+
+	void GetDebugInfo(int32& NumCombinedLeft, int32& NumCombinedRight) const;
+
+	// observations further than this (cm, including the orientation term) from a fused hand start a new fused hand
+	float MaxAssociationDistance = 10;
+	// cm of association cost per degree of palm orientation difference
+	float OrientationCostWeight = 0.05f;
+	// seconds a fused hand survives without observations, so short dropouts keep the same ID
+	float TrackTimeout = 0.25f;
+
+private:
+	struct FHandObservation
+	{
+		const FLeapHandData* Hand;
+		int32 ProviderIndex;
+		float Weight;
+		int32 TrackIndex;
+	};
+	struct FFusedHandTrack
+	{
+		int32 FusedId;
+		EHandType HandType;
+		FVector PalmPosition;
+		FQuat PalmOrientation;
+		double LastSeenTime;
+	};
+	struct FAssociationCandidate
+	{
+		float Cost;
+		int32 ObservationIndex;
+		int32 TrackIndex;
+
+		bool operator<(const FAssociationCandidate& Other) const
+		{
+			return Cost < Other.Cost;
+		}
+	};
+
+	TArray<FFusedHandTrack> Tracks;
+	int32 NextFusedId;
+
+	// scratch storage reused every frame to avoid per frame allocations
+	TArray<FHandObservation> Observations;
+	TArray<FAssociationCandidate> Candidates;
+	// Tracks.Num() x DevicesToCombine.Num(), a device can contribute at most one hand to a fused hand
+	TArray<bool> TrackUsesProvider;
+	int32 NumProviders;
+	TArray<const FLeapHandData*> TrackHands;
+	TArray<float> TrackWeights;
+	TArray<FVector> JointPositions;
+	TArray<FVector> MergedJointPositions;
+
+	float AssociationCost(const FFusedHandTrack& Track, const FLeapHandData& Hand) const;
+	bool CanAssign(const FHandObservation& Observation, const int32 TrackIndex) const;
+	void Assign(FHandObservation& Observation, const int32 TrackIndex);
+	int32 AddTrack(const FLeapHandData& Hand, const double Now);
+	void FuseHands(const FFusedHandTrack& Track, FLeapHandData& OutHand);
+};
+
+/** Combiner that fuses hands spatially with FLeapSpatialHandFusion */
+class FUltraleapCombinedDeviceSpatial : public FUltraleapCombinedDevice
+{
+public:
+	FUltraleapCombinedDeviceSpatial(IHandTrackingWrapper* LeapDeviceWrapperIn, ITrackingDeviceWrapper* TrackingDeviceWrapperIn,
+		TArray<IHandTrackingWrapper*> DevicesToCombineIn)
+		: FUltraleapCombinedDevice(LeapDeviceWrapperIn, TrackingDeviceWrapperIn, DevicesToCombineIn)
+	{
+	}
+
+	virtual void GetDebugInfo(int32& NumCombinedLeft, int32& NumCombinedRight) override;
+
+	FLeapSpatialHandFusion Fusion;
+
+protected:
+	virtual void CombineFrame(const TArray<FLeapFrameData>& SourceFrames) override;
+};
@@ -10,11 +10,15 @@
 #include "LeapComponent.h"
 #include "FUltraleapDevice.h"
 #include "FUltraleapCombinedDevice.h"
+#include "DeviceExtrinsicsCache.h"
 
 // Sets default values for this component's properties
 UMultiDeviceAlignment::UMultiDeviceAlignment()
 {
 	AlignmentVariance = 2;
+	bUseCachedAlignment = true;
+	RecalibrationThreshold = 4;
+	AlignmentResidual = 0;
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
 	PrimaryComponentTick.bCanEverTick = true;
@@ -29,7 +33,9 @@ void UMultiDeviceAlignment::BeginPlay()
 	Super::BeginPlay();
 
 	UpdateTrackingDevices();
-	
+
+	// the target's serial isn't known until its device attaches, applied from tick once it is
+	bCachedAlignmentPending = bUseCachedAlignment;
 }
 
 
@@ -38,6 +44,15 @@ void UMultiDeviceAlignment::TickComponent(float DeltaTime, ELevelTick TickType,
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
+	if (bCachedAlignmentPending && HasTargetDeviceSerial())
+	{
+		bCachedAlignmentPending = false;
+		// an alignment solved while waiting is newer than the cached one
+		if (!PositioningComplete)
+		{
+			ApplyCachedAlignment();
+		}
+	}
 	Update();
 }
 void UMultiDeviceAlignment::UpdateTrackingDevices()
@@ -95,6 +110,60 @@ FTransform ConvertBSToUETransform(const FTransform& TransformLeap)
 	FTransform Ret = FUltraleapDevice::ConvertUEDeviceOriginToBSTransform(TransformLeap, false);
 	return Ret;
 }
+bool UMultiDeviceAlignment::GetCorrespondingHandPoints(TArray<FVector>& SourceHandPoints, TArray<FVector>& TargetHandPoints)
+{
+	FLeapFrameData SourceFrame;
+	FLeapFrameData TargetFrame;
+
+	const bool SourceIsVR = SourceDevice->LeapComponent->TrackingMode == LEAP_MODE_VR;
+
+	// avoid applying DeviceOrigin twice if VR
+	SourceDevice->LeapComponent->GetLatestFrameData(SourceFrame, !SourceIsVR);
+
+	TargetDevice->LeapComponent->GetLatestFrameData(TargetFrame, true);
+	if (SourceIsVR)
+	{
+		FTransform VRDeviceOrigin;
+		const bool Success = SourceDevice->LeapComponent->GetDeviceOrigin(VRDeviceOrigin);
+		// Transform HMD into Desktop rotation
+		FRotator Rotation(90, 0, 180);
+		FUltraleapCombinedDevice::TransformFrame(SourceFrame, VRDeviceOrigin.GetLocation(), Rotation.GetInverse());
+	}
+
+#ifdef DEBUG_ALIGNMENT
+	if (GEngine)
+	{
+		FString ToPrint = FString::Printf(TEXT("Num Hands %d %d"), SourceFrame.Hands.Num(), TargetFrame.Hands.Num());
+
+		GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, ToPrint);
+	}
+#endif
+	for (auto& SourceHand : SourceFrame.Hands)
+	{
+		auto TargetHand = GetHandFromFrame(TargetFrame, SourceHand.HandType);
+
+		static const int NumFingers = 5;
+		static const int NumJoints = 4;
+
+		if (TargetHand != nullptr)
+		{
+			for (int j = 0; j < NumFingers; j++)
+			{
+				for (int k = 0; k < NumJoints; k++)
+				{
+					SourceHandPoints.Add(
+						CalcCentre(SourceHand.Digits[j].Bones[k].PrevJoint, SourceHand.Digits[j].Bones[k].NextJoint));
+
+					TargetHandPoints.Add(
+						CalcCentre(TargetHand->Digits[j].Bones[k].PrevJoint, TargetHand->Digits[j].Bones[k].NextJoint));
+				}
+			}
+			// first matching hand only
+			return true;
+		}
+	}
+	return false;
+}
 void UMultiDeviceAlignment::Update()
 {
 	if (!TargetDevice || !SourceDevice)
@@ -105,106 +174,131 @@ void UMultiDeviceAlignment::Update()
 	{
 		return;
 	}
-	if (!PositioningComplete)
-	{
-		FLeapFrameData SourceFrame;
-		FLeapFrameData TargetFrame;
+	TArray<FVector> SourceHandPoints;
+	TArray<FVector> TargetHandPoints;
 
-		FLeapFrameData SourceFrameRaw;
-		FLeapFrameData TargetFrameRaw;
+	if (!GetCorrespondingHandPoints(SourceHandPoints, TargetHandPoints))
+	{
+		return;
+	}
 
-		const bool SourceIsVR = SourceDevice->LeapComponent->TrackingMode == LEAP_MODE_VR;
+	float MeanDistance = 0;
+	float MaxDistance = 0;
+	for (int i = 0; i < SourceHandPoints.Num(); i++)
+	{
+		const auto Distance = FVector::Distance(SourceHandPoints[i], TargetHandPoints[i]);
+		MeanDistance += Distance;
+		MaxDistance = FMath::Max(MaxDistance, Distance);
+	}
+	MeanDistance /= SourceHandPoints.Num();
 
-		// avoid applying DeviceOrigin twice if VR
-		SourceDevice->LeapComponent->GetLatestFrameData(SourceFrame, !SourceIsVR);
-		
+	if (PositioningComplete)
+	{
+		// already aligned, only watch for the devices being knocked/moved
+		CheckForDrift(MeanDistance);
+		return;
+	}
 
-		TargetDevice->LeapComponent->GetLatestFrameData(TargetFrame, true);
-		if (SourceIsVR)
-		{
-			FTransform VRDeviceOrigin;
-			const bool Success = SourceDevice->LeapComponent->GetDeviceOrigin(VRDeviceOrigin);
-			// Transform HMD into Desktop rotation
-			FRotator Rotation(90, 0, 180);
-			FUltraleapCombinedDevice::TransformFrame(
-				SourceFrame, VRDeviceOrigin.GetLocation(), Rotation.GetInverse());
-		}
-		
-		TArray<FVector> SourceHandPoints;
-		TArray<FVector> TargetHandPoints;
-		
+	if (MaxDistance <= AlignmentVariance)
+	{
+		// we are already as aligned as we need to be, we can exit the alignment stage
+		PositioningComplete = true;
+		StoreAlignment(MeanDistance, SourceHandPoints.Num());
+		return;
+	}
 #ifdef DEBUG_ALIGNMENT
-		if (GEngine)
-		{
-			FString ToPrint = FString::Printf(TEXT("Num Hands %d %d"), SourceFrame.Hands.Num(), TargetFrame.Hands.Num());
+	if (GEngine)
+	{
+		FString ToPrint = FString::Printf(TEXT("Distance %f %f"), MaxDistance, MeanDistance);
 
-			GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, ToPrint);
-		}	
+		GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, ToPrint);
+	}
 #endif
-		int SourceIndex = 0;
-		for (auto& SourceHand : SourceFrame.Hands )
-		{
-			auto TargetHand = GetHandFromFrame(TargetFrame, SourceHand.HandType);
-			
-			static const int NumFingers = 5;
-			static const int NumJoints = 4;
 
-			if (TargetHand != nullptr)
-			{
-				for (int j = 0; j < NumFingers; j++)
-				{
-					for (int k = 0; k < NumJoints; k++)
-					{
-						SourceHandPoints.Add(CalcCentre(SourceHand.Digits[j].Bones[k].PrevJoint,SourceHand.Digits[j].Bones[k].NextJoint));
-						
-						TargetHandPoints.Add(
-							CalcCentre(TargetHand->Digits[j].Bones[k].PrevJoint, TargetHand->Digits[j].Bones[k].NextJoint));
-
-					}
-				}
+	FMatrix DeviceToOriginDeviceMatrix = Solver.SolveKabsch(TargetHandPoints, SourceHandPoints, 200);
+	FTransform ActorTransformFromSolver = FTransform(DeviceToOriginDeviceMatrix);
 
-				// This is temporary while we check if any of the hands points are not close enough to each other
-				PositioningComplete = true;
+	// to move the target device, we need to be in UE space. This layer is in BSSpace so convert
+	ActorTransformFromSolver = ConvertBSToUETransform(ActorTransformFromSolver);
+	FTransform ActorTransform = TargetDevice->GetActorTransform();
 
-				for (int i = 0; i < SourceHandPoints.Num(); i++)
-				{
-					const auto Distance = FVector::Distance(SourceHandPoints[i], TargetHandPoints[i]);
-					
-					if (Distance > AlignmentVariance)
-					{
-#ifdef DEBUG_ALIGNMENT
-						if (GEngine)
-						{
-							FString ToPrint = FString::Printf(TEXT("Distance %f %f"), Distance, DistanceRaw);
+	ActorTransform *= ActorTransformFromSolver;
 
-							GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, ToPrint);
-						}
-#endif
-						// we are already as aligned as we need to be, we can exit the alignment stage
-						PositioningComplete = false;
-						break;
-					}
-				}
+	TargetDevice->TeleportTo(ActorTransform.GetLocation(), ActorTransform.GetRotation().Rotator(), false, true);
+}
+bool UMultiDeviceAlignment::HasTargetDeviceSerial() const
+{
+	if (!TargetDevice || !TargetDevice->LeapComponent)
+	{
+		return false;
+	}
+	const FString& Serial = TargetDevice->LeapComponent->ActiveDeviceSerial;
+	return !Serial.IsEmpty() && Serial != TEXT("None");
+}
+void UMultiDeviceAlignment::ApplyCachedAlignment()
+{
+	if (!TargetDevice || !TargetDevice->LeapComponent)
+	{
+		return;
+	}
+	FLeapDeviceExtrinsics Extrinsics;
+	if (!FDeviceExtrinsicsCache::Get().Find(TargetDevice->LeapComponent->ActiveDeviceSerial, Extrinsics))
+	{
+		return;
+	}
+	TargetDevice->TeleportTo(
+		Extrinsics.DeviceOrigin.GetLocation(), Extrinsics.DeviceOrigin.GetRotation().Rotator(), false, true);
+	TargetDevice->LeapComponent->UpdateDeviceOrigin(Extrinsics.DeviceOrigin);
 
-				if (PositioningComplete)
-				{
-					return;
-				}
+	// drift checking takes over from here and will restart alignment if the devices moved since
+	PositioningComplete = true;
+	HasResidual = false;
+	AlignmentResidual = Extrinsics.Residual;
+}
+void UMultiDeviceAlignment::StoreAlignment(const float Residual, const int32 NumSamples)
+{
+	AlignmentResidual = Residual;
+	HasResidual = true;
 
-				FMatrix DeviceToOriginDeviceMatrix = Solver.SolveKabsch(TargetHandPoints, SourceHandPoints, 200);
-				FTransform ActorTransformFromSolver = FTransform(DeviceToOriginDeviceMatrix);
-				
-				// to move the target device, we need to be in UE space. This layer is in BSSpace so convert
-				ActorTransformFromSolver = ConvertBSToUETransform(ActorTransformFromSolver);
-				FTransform ActorTransform = TargetDevice->GetActorTransform();
-
-				ActorTransform *= ActorTransformFromSolver;
-				
-				TargetDevice->TeleportTo(ActorTransform.GetLocation(),
-					 ActorTransform.GetRotation().Rotator(), false, true);
-		
-				return;
-			}
-		}
+	// nothing to key it by
+	if (!HasTargetDeviceSerial())
+	{
+		return;
 	}
-}
\ No newline at end of file
+	FLeapDeviceExtrinsics Extrinsics;
+	Extrinsics.DeviceSerial = TargetDevice->LeapComponent->ActiveDeviceSerial;
+	if (SourceDevice && SourceDevice->LeapComponent)
+	{
+		Extrinsics.ReferenceDeviceSerial = SourceDevice->LeapComponent->ActiveDeviceSerial;
+	}
+	Extrinsics.DeviceOrigin = TargetDevice->GetActorTransform();
+	Extrinsics.Residual = Residual;
+	Extrinsics.NumSamples = NumSamples;
+	Extrinsics.CalibrationTime = FDateTime::UtcNow().ToIso8601();
+
+	FDeviceExtrinsicsCache::Get().Store(Extrinsics);
+}
+void UMultiDeviceAlignment::CheckForDrift(const float Residual)
+{
+	// smooth over frames so a single badly tracked hand doesn't trigger a recalibration
+	static const float ResidualSmoothing = 0.05f;
+	AlignmentResidual = HasResidual ? FMath::Lerp(AlignmentResidual, Residual, ResidualSmoothing) : Residual;
+	HasResidual = true;
+
+	if (AlignmentResidual > RecalibrationThreshold)
+	{
+		UE_LOG(UltraleapTrackingLog, Log, TEXT("UMultiDeviceAlignment residual %f cm exceeds %f cm, realigning"), AlignmentResidual,
+			RecalibrationThreshold);
+		PositioningComplete = false;
+		HasResidual = false;
+	}
+}
+void UMultiDeviceAlignment::ClearCachedAlignment()
+{
+	if (TargetDevice && TargetDevice->LeapComponent)
+	{
+		FDeviceExtrinsicsCache::Get().Remove(TargetDevice->LeapComponent->ActiveDeviceSerial);
+	}
+	PositioningComplete = false;
+	HasResidual = false;
+}
@@ -33,7 +33,22 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Leap Devices")
 	float AlignmentVariance;
 
-	
+	/** Start from the alignment saved in a previous session (keyed by the target device serial) instead of re-converging */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Leap Devices")
+	bool bUseCachedAlignment;
+
+	/** Once aligned, the smoothed mean joint distance (cm) above which alignment restarts */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Leap Devices")
+	float RecalibrationThreshold;
+
+	/** Smoothed mean joint distance (cm) between the source and target device hands */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Devices")
+	float AlignmentResidual;
+
+	/** Forget the saved alignment for the target device and align again */
+	UFUNCTION(BlueprintCallable, Category = "Leap Devices")
+	void ClearCachedAlignment();
+
 
 #if WITH_EDITOR
 	// property change handlers
@@ -56,8 +71,17 @@ public:
 private:
 
 	bool PositioningComplete = false;
+	bool HasResidual = false;
+	// BeginPlay asked for the cached alignment but the target device serial wasn't known yet
+	bool bCachedAlignmentPending = false;
 
 	void ReAlignProvider();
 	void Update();
 
+	bool GetCorrespondingHandPoints(TArray<FVector>& SourceHandPoints, TArray<FVector>& TargetHandPoints);
+	bool HasTargetDeviceSerial() const;
+	void ApplyCachedAlignment();
+	void StoreAlignment(const float Residual, const int32 NumSamples);
+	void CheckForDrift(const float Residual);
+
 };
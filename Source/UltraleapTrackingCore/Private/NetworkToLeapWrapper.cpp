@@ -0,0 +1,690 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "NetworkToLeapWrapper.h"
+
+#include "Common/TcpSocketBuilder.h"
+#include "Common/UdpSocketBuilder.h"
+#include "FUltraleapDevice.h"
+#include "HAL/RunnableThread.h"
+#include "Interfaces/IPv4/IPv4Address.h"
+#include "LeapFrameStreamer.h"
+#include "LeapUtility.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+
+namespace
+{
+// Reads the little endian packet written by FLeapFrameStreamer in place, without copying it out first
+struct FPacketReader
+{
+	const uint8* Data;
+	int32 Num;
+	int32 Offset = 0;
+	bool bOverflow = false;
+
+	FPacketReader(const uint8* InData, const int32 InNum) : Data(InData), Num(InNum)
+	{
+	}
+
+	template <typename T>
+	T Read()
+	{
+		T Value = 0;
+		if (Offset + (int32) sizeof(T) > Num)
+		{
+			bOverflow = true;
+			return Value;
+		}
+		FMemory::Memcpy(&Value, Data + Offset, sizeof(T));
+		Offset += sizeof(T);
+		return Value;
+	}
+	LEAP_VECTOR ReadVector()
+	{
+		LEAP_VECTOR Vector;
+		Vector.x = Read<float>();
+		Vector.y = Read<float>();
+		Vector.z = Read<float>();
+		return Vector;
+	}
+	LEAP_QUATERNION ReadQuat()
+	{
+		LEAP_QUATERNION Quat;
+		Quat.x = Read<float>();
+		Quat.y = Read<float>();
+		Quat.z = Read<float>();
+		Quat.w = Read<float>();
+		return Quat;
+	}
+	LEAP_QUATERNION ReadPackedQuat()
+	{
+		const int16 X = Read<int16>();
+		const int16 Y = Read<int16>();
+		const int16 Z = Read<int16>();
+		const int16 W = Read<int16>();
+		const FQuat Normalized = FQuat(X / 32767.f, Y / 32767.f, Z / 32767.f, W / 32767.f).GetNormalized();
+		LEAP_QUATERNION Quat;
+		Quat.x = Normalized.X;
+		Quat.y = Normalized.Y;
+		Quat.z = Normalized.Z;
+		Quat.w = Normalized.W;
+		return Quat;
+	}
+};
+
+LEAP_VECTOR LerpLeapVector(const LEAP_VECTOR& A, const LEAP_VECTOR& B, const float Alpha)
+{
+	LEAP_VECTOR Ret;
+	for (int32 i = 0; i < 3; i++)
+	{
+		Ret.v[i] = A.v[i] + (B.v[i] - A.v[i]) * Alpha;
+	}
+	return Ret;
+}
+
+LEAP_QUATERNION SlerpLeapQuat(const LEAP_QUATERNION& A, const LEAP_QUATERNION& B, const float Alpha)
+{
+	const FQuat Slerped = FQuat::Slerp(FQuat(A.x, A.y, A.z, A.w), FQuat(B.x, B.y, B.z, B.w), Alpha);
+	LEAP_QUATERNION Ret;
+	Ret.x = Slerped.X;
+	Ret.y = Slerped.Y;
+	Ret.z = Slerped.Z;
+	Ret.w = Slerped.W;
+	return Ret;
+}
+
+void InterpolateBone(const LEAP_BONE& A, const LEAP_BONE& B, const float Alpha, LEAP_BONE& Out)
+{
+	Out.prev_joint = LerpLeapVector(A.prev_joint, B.prev_joint, Alpha);
+	Out.next_joint = LerpLeapVector(A.next_joint, B.next_joint, Alpha);
+	Out.rotation = SlerpLeapQuat(A.rotation, B.rotation, Alpha);
+	Out.width = FMath::Lerp(A.width, B.width, Alpha);
+}
+}	 // namespace
+
+FLeapStreamReceiver::FLeapStreamReceiver(const FString& InHost, const int32 InPort, const bool bInUseTCP)
+	: Host(InHost)
+	, Port(InPort)
+	, bUseTCP(bInUseTCP)
+	, bIsMulticast(false)
+	, Head(NumSlots - 1)
+	, NumCommitted(0)
+	, Socket(nullptr)
+	, ReceivedBytes(0)
+	, LastSubscribeTime(0)
+	, LastRemoteTimeStamp(0)
+	, FrameRate(90)
+	, NextOffsetSample(0)
+	, Thread(nullptr)
+	, bStopping(false)
+{
+	FIPv4Address Address;
+	bIsMulticast = !bUseTCP && FIPv4Address::Parse(Host, Address) && Address.IsMulticastAddress();
+	Description = FString::Printf(TEXT("%s%s:%d"), bUseTCP ? TEXT("tcp://") : TEXT(""), *Host, Port);
+
+	for (FFrameSlot& Slot : Slots)
+	{
+		FMemory::Memzero(Slot);
+		Slot.Event.pHands = Slot.Hands;
+	}
+	FMemory::Memzero(OutputSlot);
+	FMemory::Memzero(InterpolatedSlot);
+	OutputSlot.Event.pHands = OutputSlot.Hands;
+	InterpolatedSlot.Event.pHands = InterpolatedSlot.Hands;
+
+	// two hands of the largest packet, plus room for a partial TCP packet behind them
+	ReceiveBuffer.SetNumUninitialized(8 * 1024);
+	OffsetSamples.Reserve(NumOffsetSamples);
+}
+
+FLeapStreamReceiver::~FLeapStreamReceiver()
+{
+	Shutdown();
+}
+
+bool FLeapStreamReceiver::Start()
+{
+	if (Thread)
+	{
+		return true;
+	}
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	RemoteAddress = SocketSubsystem->GetAddressFromString(Host);
+	if (!RemoteAddress.IsValid() || !RemoteAddress->IsValid())
+	{
+		RemoteAddress = nullptr;
+		FAddressInfoResult Result = SocketSubsystem->GetAddressInfo(*Host, nullptr, EAddressInfoFlags::Default, NAME_None);
+		if (Result.Results.Num())
+		{
+			RemoteAddress = Result.Results[0].Address->Clone();
+		}
+	}
+	if (!RemoteAddress.IsValid())
+	{
+		UE_LOG(UltraleapTrackingLog, Warning, TEXT("FLeapStreamReceiver::Start could not resolve %s"), *Host);
+		return false;
+	}
+	RemoteAddress->SetPort(Port);
+
+	bStopping = false;
+	Thread = FRunnableThread::Create(this, TEXT("UltraleapNetworkDevice"), 0, TPri_AboveNormal);
+	return true;
+}
+
+void FLeapStreamReceiver::Shutdown()
+{
+	if (Thread)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+	Disconnect();
+}
+
+bool FLeapStreamReceiver::Connect()
+{
+	if (bUseTCP)
+	{
+		Socket = FTcpSocketBuilder(TEXT("UltraleapNetworkDeviceTcp")).AsBlocking().Build();
+		if (Socket && Socket->Connect(*RemoteAddress))
+		{
+			Socket->SetNonBlocking(true);
+			Socket->SetNoDelay(true);
+			return true;
+		}
+	}
+	else if (bIsMulticast)
+	{
+		FIPv4Address Group;
+		FIPv4Address::Parse(Host, Group);
+		Socket = FUdpSocketBuilder(TEXT("UltraleapNetworkDeviceUdp"))
+					 .AsNonBlocking()
+					 .AsReusable()
+					 .BoundToPort(Port)
+					 .JoinedToGroup(Group)
+					 .Build();
+		if (Socket)
+		{
+			return true;
+		}
+	}
+	else
+	{
+		// any free local port, the streamer replies to wherever subscriptions come from
+		Socket = FUdpSocketBuilder(TEXT("UltraleapNetworkDeviceUdp")).AsNonBlocking().BoundToPort(0).Build();
+		if (Socket)
+		{
+			LastSubscribeTime = 0;
+			return true;
+		}
+	}
+	Disconnect();
+	return false;
+}
+
+void FLeapStreamReceiver::Disconnect()
+{
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+	ReceivedBytes = 0;
+}
+
+void FLeapStreamReceiver::SendSubscribe()
+{
+	const uint32 Magic = FLeapFrameStreamer::StreamMagic;
+	int32 BytesSent = 0;
+	Socket->SendTo((const uint8*) &Magic, sizeof(Magic), BytesSent, *RemoteAddress);
+	LastSubscribeTime = FPlatformTime::Seconds();
+}
+
+uint32 FLeapStreamReceiver::Run()
+{
+	while (!bStopping)
+	{
+		if (!Socket && !Connect())
+		{
+			FPlatformProcess::Sleep(ReconnectInterval);
+			continue;
+		}
+		if (!bUseTCP && !bIsMulticast && FPlatformTime::Seconds() - LastSubscribeTime > SubscribeInterval)
+		{
+			SendSubscribe();
+		}
+		// returns as soon as data arrives
+		if (!Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(PollIntervalInMS)))
+		{
+			continue;
+		}
+		if (bUseTCP)
+		{
+			if (!ReceiveTcp())
+			{
+				UE_LOG(UltraleapTrackingLog, Log, TEXT("FLeapStreamReceiver lost connection to %s, reconnecting"), *Description);
+				Disconnect();
+			}
+		}
+		else
+		{
+			ReceiveUdp();
+		}
+	}
+	return 0;
+}
+
+void FLeapStreamReceiver::Stop()
+{
+	bStopping = true;
+}
+
+void FLeapStreamReceiver::ReceiveUdp()
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	TSharedRef<FInternetAddr> Sender = SocketSubsystem->CreateInternetAddr();
+
+	uint32 PendingSize = 0;
+	while (Socket->HasPendingData(PendingSize))
+	{
+		int32 BytesRead = 0;
+		if (!Socket->RecvFrom(ReceiveBuffer.GetData(), ReceiveBuffer.Num(), BytesRead, *Sender))
+		{
+			break;
+		}
+		const int64 ArrivalTime = GetNow();
+		DecodePacket(ReceiveBuffer.GetData(), BytesRead, ArrivalTime);
+	}
+}
+
+bool FLeapStreamReceiver::ReceiveTcp()
+{
+	int32 BytesRead = 0;
+	if (!Socket->Recv(ReceiveBuffer.GetData() + ReceivedBytes, ReceiveBuffer.Num() - ReceivedBytes, BytesRead))
+	{
+		return Socket->GetConnectionState() == SCS_Connected;
+	}
+	if (BytesRead == 0)
+	{
+		// readable with nothing to read is a closed connection
+		return false;
+	}
+	const int64 ArrivalTime = GetNow();
+	ReceivedBytes += BytesRead;
+
+	// decode every complete length prefixed packet where it landed
+	int32 Offset = 0;
+	while (ReceivedBytes - Offset >= (int32) sizeof(uint16))
+	{
+		uint16 Length = 0;
+		FMemory::Memcpy(&Length, ReceiveBuffer.GetData() + Offset, sizeof(uint16));
+		if (Length + (int32) sizeof(uint16) > ReceiveBuffer.Num())
+		{
+			UE_LOG(UltraleapTrackingLog, Warning, TEXT("FLeapStreamReceiver invalid packet length %d from %s"), Length, *Description);
+			return false;
+		}
+		if (ReceivedBytes - Offset < Length + (int32) sizeof(uint16))
+		{
+			break;
+		}
+		DecodePacket(ReceiveBuffer.GetData() + Offset + sizeof(uint16), Length, ArrivalTime);
+		Offset += Length + sizeof(uint16);
+	}
+	// keep a partial packet for the next read
+	if (Offset > 0)
+	{
+		ReceivedBytes -= Offset;
+		FMemory::Memmove(ReceiveBuffer.GetData(), ReceiveBuffer.GetData() + Offset, ReceivedBytes);
+	}
+	return true;
+}
+
+bool FLeapStreamReceiver::DecodePacket(const uint8* Data, const int32 Num, const int64 ArrivalTime)
+{
+	FPacketReader Reader(Data, Num);
+	const uint32 Magic = Reader.Read<uint32>();
+	const uint16 Version = Reader.Read<uint16>();
+	if (Magic != FLeapFrameStreamer::StreamMagic || Version != FLeapFrameStreamer::StreamVersion)
+	{
+		return false;
+	}
+	const uint8 NumHands = FMath::Min<uint8>(Reader.Read<uint8>(), 2);
+	Reader.Read<uint8>();
+	const int32 FrameId = Reader.Read<int32>();
+	const int64 RemoteTimeStamp = Reader.Read<int64>();
+	const int64 RemoteSendTime = Reader.Read<int64>();
+
+	// drop reordered datagrams, a large step back is the remote restarting and nothing buffered is comparable any more
+	if (RemoteTimeStamp <= LastRemoteTimeStamp)
+	{
+		if (LastRemoteTimeStamp - RemoteTimeStamp < RestartThresholdInMicros)
+		{
+			return false;
+		}
+		UE_LOG(UltraleapTrackingLog, Log, TEXT("FLeapStreamReceiver %s restarted, clearing buffered frames"), *Description);
+		ResetRemoteClock();
+	}
+	UpdateClockOffset(ArrivalTime - RemoteSendTime);
+
+	// nothing reads the slot after Head so it can be written without the lock
+	const int32 WriteIndex = (Head + 1) % NumSlots;
+	FFrameSlot& Slot = Slots[WriteIndex];
+
+	for (int32 i = 0; i < NumHands; i++)
+	{
+		LEAP_HAND& Hand = Slot.Hands[i];
+		Hand.id = Reader.Read<int32>();
+		Hand.type = Reader.Read<uint8>() == 0 ? eLeapHandType_Left : eLeapHandType_Right;
+		const uint8 Extended = Reader.Read<uint8>();
+		Reader.Read<uint16>();
+		Hand.flags = 0;
+		Hand.confidence = Reader.Read<float>();
+		Hand.grab_strength = Reader.Read<float>();
+		Hand.grab_angle = Reader.Read<float>();
+		Hand.pinch_strength = Reader.Read<float>();
+		Hand.pinch_distance = Reader.Read<float>();
+		Hand.visible_time = (uint64) (FMath::Max(Reader.Read<float>(), 0.f) * 1000000.0);
+		Hand.palm.width = Reader.Read<float>();
+
+		Hand.palm.position = Reader.ReadVector();
+		Hand.palm.stabilized_position = Hand.palm.position;
+		Hand.palm.velocity = Reader.ReadVector();
+		Hand.palm.normal = Reader.ReadVector();
+		Hand.palm.direction = Reader.ReadVector();
+		Hand.palm.orientation = Reader.ReadQuat();
+
+		for (int32 DigitIndex = 0; DigitIndex < 5; DigitIndex++)
+		{
+			LEAP_DIGIT& Digit = Hand.digits[DigitIndex];
+			Digit.finger_id = DigitIndex;
+			Digit.is_extended = (Extended >> DigitIndex) & 1;
+
+			// joints are shared between neighbouring bones
+			Digit.bones[0].prev_joint = Reader.ReadVector();
+			for (int32 BoneIndex = 0; BoneIndex < 4; BoneIndex++)
+			{
+				Digit.bones[BoneIndex].next_joint = Reader.ReadVector();
+				if (BoneIndex < 3)
+				{
+					Digit.bones[BoneIndex + 1].prev_joint = Digit.bones[BoneIndex].next_joint;
+				}
+			}
+		}
+		for (int32 DigitIndex = 0; DigitIndex < 5; DigitIndex++)
+		{
+			for (int32 BoneIndex = 0; BoneIndex < 4; BoneIndex++)
+			{
+				Hand.digits[DigitIndex].bones[BoneIndex].rotation = Reader.ReadPackedQuat();
+			}
+		}
+		for (int32 DigitIndex = 0; DigitIndex < 5; DigitIndex++)
+		{
+			const float Width = Reader.Read<float>();
+			for (int32 BoneIndex = 0; BoneIndex < 4; BoneIndex++)
+			{
+				Hand.digits[DigitIndex].bones[BoneIndex].width = Width;
+			}
+		}
+
+		Hand.arm.prev_joint = Reader.ReadVector();
+		Hand.arm.next_joint = Reader.ReadVector();
+		Hand.arm.rotation = Reader.ReadPackedQuat();
+		Hand.arm.width = Reader.Read<float>();
+	}
+	if (Reader.bOverflow)
+	{
+		return false;
+	}
+
+	if (LastRemoteTimeStamp != 0 && RemoteTimeStamp > LastRemoteTimeStamp)
+	{
+		FrameRate = FMath::Lerp(FrameRate, 1000000.f / (RemoteTimeStamp - LastRemoteTimeStamp), 0.1f);
+	}
+	LastRemoteTimeStamp = RemoteTimeStamp;
+
+	Slot.Event.info.frame_id = FrameId;
+	Slot.Event.info.timestamp = RemoteTimeStamp + ClockOffset.GetValue();
+	Slot.Event.tracking_frame_id = FrameId;
+	Slot.Event.nHands = NumHands;
+	Slot.Event.pHands = Slot.Hands;
+	Slot.Event.framerate = FrameRate;
+
+	FScopeLock ScopeLock(&SlotLock);
+	Head = WriteIndex;
+	NumCommitted = FMath::Min(NumCommitted + 1, NumSlots - 1);
+	return true;
+}
+
+void FLeapStreamReceiver::UpdateClockOffset(const int64 Sample)
+{
+	if (OffsetSamples.Num() < NumOffsetSamples)
+	{
+		OffsetSamples.Add(Sample);
+	}
+	else
+	{
+		OffsetSamples[NextOffsetSample] = Sample;
+	}
+	NextOffsetSample = (NextOffsetSample + 1) % NumOffsetSamples;
+
+	// the least delayed packet in the window is closest to the true offset
+	int64 MinSample = OffsetSamples[0];
+	for (const int64 OffsetSample : OffsetSamples)
+	{
+		MinSample = FMath::Min(MinSample, OffsetSample);
+	}
+	ClockOffset.Set(MinSample);
+}
+
+void FLeapStreamReceiver::ResetRemoteClock()
+{
+	OffsetSamples.Reset();
+	NextOffsetSample = 0;
+	LastRemoteTimeStamp = 0;
+
+	FScopeLock ScopeLock(&SlotLock);
+	NumCommitted = 0;
+}
+
+int64 FLeapStreamReceiver::GetClockOffset() const
+{
+	return ClockOffset.GetValue();
+}
+
+int64 FLeapStreamReceiver::GetNow()
+{
+	return (int64) (FPlatformTime::Seconds() * 1000000.0);
+}
+
+void FLeapStreamReceiver::CopySlot(const FFrameSlot& Source, FFrameSlot& Dest)
+{
+	Dest.Event = Source.Event;
+	Dest.Event.pHands = Dest.Hands;
+	for (uint32 i = 0; i < Source.Event.nHands; i++)
+	{
+		Dest.Hands[i] = Source.Hands[i];
+	}
+}
+
+LEAP_TRACKING_EVENT* FLeapStreamReceiver::GetFrame()
+{
+	FScopeLock ScopeLock(&SlotLock);
+	if (NumCommitted == 0)
+	{
+		return nullptr;
+	}
+	CopySlot(Slots[Head], OutputSlot);
+	return &OutputSlot.Event;
+}
+
+LEAP_TRACKING_EVENT* FLeapStreamReceiver::GetInterpolatedFrameAtTime(const int64 TimeStamp)
+{
+	FScopeLock ScopeLock(&SlotLock);
+	if (NumCommitted == 0)
+	{
+		return nullptr;
+	}
+	const FFrameSlot& Newest = Slots[Head];
+	if (NumCommitted == 1)
+	{
+		CopySlot(Newest, InterpolatedSlot);
+		return &InterpolatedSlot.Event;
+	}
+
+	// find the pair either side of the requested time, or the newest two to extrapolate from
+	int32 IndexB = Head;
+	int32 IndexA = (Head + NumSlots - 1) % NumSlots;
+	for (int32 i = 1; i < NumCommitted; i++)
+	{
+		const int32 Older = (Head + NumSlots - i) % NumSlots;
+		IndexB = (Older + 1) % NumSlots;
+		IndexA = Older;
+		if (Slots[Older].Event.info.timestamp <= TimeStamp)
+		{
+			break;
+		}
+	}
+	const FFrameSlot& SlotA = Slots[IndexA];
+	const FFrameSlot& SlotB = Slots[IndexB];
+
+	const int64 Span = SlotB.Event.info.timestamp - SlotA.Event.info.timestamp;
+	const int64 Target = FMath::Min(TimeStamp, Newest.Event.info.timestamp + MaxExtrapolationInMicros);
+	const float Alpha = Span > 0 ? FMath::Max((float) (Target - SlotA.Event.info.timestamp) / Span, 0.f) : 1.f;
+
+	CopySlot(SlotB, InterpolatedSlot);
+	InterpolatedSlot.Event.info.timestamp = SlotA.Event.info.timestamp + (int64) (Span * Alpha);
+	for (uint32 i = 0; i < SlotB.Event.nHands; i++)
+	{
+		for (uint32 j = 0; j < SlotA.Event.nHands; j++)
+		{
+			if (SlotA.Hands[j].id == SlotB.Hands[i].id)
+			{
+				InterpolateHand(SlotA.Hands[j], SlotB.Hands[i], Alpha, InterpolatedSlot.Hands[i]);
+				break;
+			}
+		}
+	}
+	return &InterpolatedSlot.Event;
+}
+
+void FLeapStreamReceiver::InterpolateHand(const LEAP_HAND& HandA, const LEAP_HAND& HandB, const float Alpha, LEAP_HAND& OutHand)
+{
+	// ids, type and flags already come from B
+	OutHand.confidence = FMath::Lerp(HandA.confidence, HandB.confidence, Alpha);
+	OutHand.pinch_distance = FMath::Lerp(HandA.pinch_distance, HandB.pinch_distance, Alpha);
+	OutHand.grab_angle = FMath::Lerp(HandA.grab_angle, HandB.grab_angle, Alpha);
+	OutHand.pinch_strength = FMath::Clamp(FMath::Lerp(HandA.pinch_strength, HandB.pinch_strength, Alpha), 0.f, 1.f);
+	OutHand.grab_strength = FMath::Clamp(FMath::Lerp(HandA.grab_strength, HandB.grab_strength, Alpha), 0.f, 1.f);
+
+	OutHand.palm.position = LerpLeapVector(HandA.palm.position, HandB.palm.position, Alpha);
+	OutHand.palm.stabilized_position = OutHand.palm.position;
+	OutHand.palm.velocity = LerpLeapVector(HandA.palm.velocity, HandB.palm.velocity, Alpha);
+	OutHand.palm.normal = LerpLeapVector(HandA.palm.normal, HandB.palm.normal, Alpha);
+	OutHand.palm.direction = LerpLeapVector(HandA.palm.direction, HandB.palm.direction, Alpha);
+	OutHand.palm.width = FMath::Lerp(HandA.palm.width, HandB.palm.width, Alpha);
+	OutHand.palm.orientation = SlerpLeapQuat(HandA.palm.orientation, HandB.palm.orientation, Alpha);
+
+	for (int32 DigitIndex = 0; DigitIndex < 5; DigitIndex++)
+	{
+		for (int32 BoneIndex = 0; BoneIndex < 4; BoneIndex++)
+		{
+			InterpolateBone(HandA.digits[DigitIndex].bones[BoneIndex], HandB.digits[DigitIndex].bones[BoneIndex], Alpha,
+				OutHand.digits[DigitIndex].bones[BoneIndex]);
+		}
+	}
+	InterpolateBone(HandA.arm, HandB.arm, Alpha, OutHand.arm);
+}
+
+FNetworkToLeapWrapper::FNetworkToLeapWrapper(const FString& InHost, const int32 InPort, const bool bInUseTCP)
+	: Receiver(InHost, InPort, bInUseTCP)
+{
+	static int32 NetworkDeviceID = NetworkBaseDeviceID;
+
+	NetworkDeviceID++;
+	DeviceID = NetworkDeviceID;
+
+	DeviceSerial = FString::Printf(TEXT("Remote %s%s:%d"), bInUseTCP ? TEXT("tcp://") : TEXT(""), *InHost, InPort);
+	const auto SerialConverter = StringCast<ANSICHAR>(*DeviceSerial);
+	DeviceSerialAnsi.Append(SerialConverter.Get(), SerialConverter.Length() + 1);
+
+	CurrentDeviceInfo = &DeviceInfo;
+	DeviceInfo = {0};
+	DeviceInfo.size = sizeof(LEAP_DEVICE_INFO);
+	DeviceInfo.pid = eLeapDevicePID_Unknown;
+	DeviceInfo.serial = DeviceSerialAnsi.GetData();
+	DeviceInfo.serial_length = DeviceSerialAnsi.Num();
+
+	// opens the connection
+	Device = MakeShared<FUltraleapDevice>((IHandTrackingWrapper*) this, (ITrackingDeviceWrapper*) this, false);
+}
+
+FNetworkToLeapWrapper::~FNetworkToLeapWrapper()
+{
+	CloseConnection();
+}
+
+LEAP_CONNECTION* FNetworkToLeapWrapper::OpenConnection(LeapWrapperCallbackInterface* InCallbackDelegate, bool UseMultiDeviceMode)
+{
+	if (InCallbackDelegate != nullptr)
+	{
+		CallbackDelegate = InCallbackDelegate;
+	}
+	// called again when the tracking source option changes, the connection is already up
+	if (Receiver.IsStarted() || !Receiver.Start())
+	{
+		return nullptr;
+	}
+	bIsConnected = true;
+
+	if (CallbackDelegate)
+	{
+		CallbackDelegate->OnDeviceFound(&DeviceInfo);
+	}
+	return nullptr;
+}
+
+void FNetworkToLeapWrapper::CloseConnection()
+{
+	Receiver.Shutdown();
+	bIsConnected = false;
+}
+
+LEAP_TRACKING_EVENT* FNetworkToLeapWrapper::GetFrame()
+{
+	return Receiver.GetFrame();
+}
+
+LEAP_TRACKING_EVENT* FNetworkToLeapWrapper::GetInterpolatedFrameAtTime(int64 TimeStamp)
+{
+	return Receiver.GetInterpolatedFrameAtTime(TimeStamp);
+}
+
+int64_t FNetworkToLeapWrapper::GetNow()
+{
+	return FLeapStreamReceiver::GetNow();
+}
+
+int64 FNetworkToLeapWrapper::GetClockOffset() const
+{
+	return Receiver.GetClockOffset();
+}
+
+LEAP_DEVICE_INFO* FNetworkToLeapWrapper::GetDeviceProperties()
+{
+	return CurrentDeviceInfo;
+}
+
+IHandTrackingDevice* FNetworkToLeapWrapper::GetDevice()
+{
+	return Device.Get();
+}
@@ -0,0 +1,173 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "LeapWrapper.h"
+
+class FSocket;
+class FInternetAddr;
+class FRunnableThread;
+
+/**
+ * Receives the frames a remote FLeapFrameStreamer sends and keeps the latest few as LeapC tracking events on the local clock.
+ *
+ * Remote timestamps are mapped onto the local clock with a windowed minimum of (arrival - remote send clock), which
+ * converges on the clock offset plus the fastest one way latency and follows drift as the window slides. A large step
+ * back in remote timestamps is the remote restarting, which clears the buffered frames and the offset window.
+ *
+ * Packets are decoded straight out of the socket receive buffer into a ring of preallocated frames, nothing is
+ * allocated per frame. Frames are LeapC tracking space as the remote device reported them, so they go through the
+ * same transforms as a local device's.
+ */
+class FLeapStreamReceiver : public FRunnable
+{
+public:
+	FLeapStreamReceiver(const FString& InHost, const int32 InPort, const bool bInUseTCP);
+	virtual ~FLeapStreamReceiver();
+
+	/** Resolves the host and starts receiving on a worker thread, false if the host doesn't resolve */
+	bool Start();
+	void Shutdown();
+	bool IsStarted() const
+	{
+		return Thread != nullptr;
+	}
+
+	/** The newest frame, null until one arrives. Valid until the next call, which must come from the same thread */
+	LEAP_TRACKING_EVENT* GetFrame();
+	/** Interpolated between the frames either side of TimeStamp on the local clock, extrapolating at most 50ms */
+	LEAP_TRACKING_EVENT* GetInterpolatedFrameAtTime(const int64 TimeStamp);
+
+	/** Estimated local minus remote tracking clock in microseconds, including the fastest one way latency */
+	int64 GetClockOffset() const;
+
+	/** The local clock in microseconds that received frames are mapped onto */
+	static int64 GetNow();
+
+	// FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	struct FFrameSlot
+	{
+		LEAP_TRACKING_EVENT Event;
+		LEAP_HAND Hands[2];
+	};
+
+	bool Connect();
+	void Disconnect();
+	void SendSubscribe();
+	void ReceiveUdp();
+	bool ReceiveTcp();
+	bool DecodePacket(const uint8* Data, const int32 Num, const int64 ArrivalTime);
+	void UpdateClockOffset(const int64 Sample);
+	void ResetRemoteClock();
+
+	static void CopySlot(const FFrameSlot& Source, FFrameSlot& Dest);
+	static void InterpolateHand(const LEAP_HAND& HandA, const LEAP_HAND& HandB, const float Alpha, LEAP_HAND& OutHand);
+
+	FString Host;
+	int32 Port;
+	bool bUseTCP;
+	bool bIsMulticast;
+	FString Description;
+
+	// Received frames, the worker decodes into the slot after Head, which readers never touch
+	static const int32 NumSlots = 8;
+	FFrameSlot Slots[NumSlots];
+	int32 Head;
+	int32 NumCommitted;
+	FCriticalSection SlotLock;
+
+	// Returned from GetFrame and GetInterpolatedFrameAtTime
+	FFrameSlot OutputSlot;
+	FFrameSlot InterpolatedSlot;
+
+	// Worker only
+	FSocket* Socket;
+	TSharedPtr<FInternetAddr> RemoteAddress;
+	TArray<uint8> ReceiveBuffer;
+	int32 ReceivedBytes;
+	double LastSubscribeTime;
+	int64 LastRemoteTimeStamp;
+	float FrameRate;
+	TArray<int64> OffsetSamples;
+	int32 NextOffsetSample;
+
+	FThreadSafeCounter64 ClockOffset;
+	FRunnableThread* Thread;
+	FThreadSafeBool bStopping;
+
+	// The streamer forgets UDP subscribers after 5s without a keep alive
+	static constexpr double SubscribeInterval = 1.0;
+	static constexpr float ReconnectInterval = 1.0f;
+	static const uint32 PollIntervalInMS = 10;
+	// Window of the clock offset estimate, about 1.5s at 90fps
+	static const int32 NumOffsetSamples = 128;
+	// Interpolation requests further than this past the newest frame hold it rather than extrapolate
+	static const int64 MaxExtrapolationInMicros = 50000;
+	// Older timestamps are reordered datagrams within this, and the remote restarting beyond it
+	static const int64 RestartThresholdInMicros = 1000000;
+};
+
+/**
+ * A tracking device on another machine, presenting the frames a FLeapStreamReceiver gets from it as LeapC tracking
+ * events so FUltraleapDevice treats it like a local device. GetNow() and frame timestamps are on the same clock, so
+ * interpolation and timewarp work as they do locally.
+ *
+ * Point it at 127.0.0.1 and a local FLeapFrameStreamer to test without a second machine.
+ */
+class FNetworkToLeapWrapper : public FLeapWrapperBase
+{
+public:
+	FNetworkToLeapWrapper(const FString& InHost, const int32 InPort, const bool bInUseTCP);
+	virtual ~FNetworkToLeapWrapper();
+
+	// FLeapWrapperBase overrides
+	virtual LEAP_CONNECTION* OpenConnection(LeapWrapperCallbackInterface* InCallbackDelegate, bool UseMultiDeviceMode) override;
+	virtual void CloseConnection() override;
+	virtual LEAP_TRACKING_EVENT* GetFrame() override;
+	virtual LEAP_TRACKING_EVENT* GetInterpolatedFrameAtTime(int64 TimeStamp) override;
+	virtual LEAP_DEVICE_INFO* GetDeviceProperties() override;
+	virtual int64_t GetNow() override;
+	virtual uint32_t GetDeviceID() override
+	{
+		return DeviceID;
+	}
+	virtual FString GetDeviceSerial() override
+	{
+		return DeviceSerial;
+	}
+	virtual EDeviceType GetDeviceType() override
+	{
+		return DEVICE_TYPE_NETWORK;
+	}
+	virtual IHandTrackingDevice* GetDevice() override;
+
+	/** Estimated local minus remote tracking clock in microseconds, including the fastest one way latency */
+	int64 GetClockOffset() const;
+
+private:
+	FLeapStreamReceiver Receiver;
+
+	FString DeviceSerial;
+	TArray<ANSICHAR> DeviceSerialAnsi;
+	LEAP_DEVICE_INFO DeviceInfo;
+
+	int32 DeviceID = 0;
+	TSharedPtr<class FUltraleapDevice> Device;
+
+	// prevent overlap with Leap and OpenXR device IDs
+	static const int32 NetworkBaseDeviceID = 20000;
+};
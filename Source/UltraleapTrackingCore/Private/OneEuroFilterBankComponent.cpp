@@ -0,0 +1,319 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "OneEuroFilterBankComponent.h"
+
+#include "LeapHandDataUtils.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "UltraleapTrackingStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Leap Hand Filter Bank"), STAT_LeapHandFilterBank, STATGROUP_UltraleapTracking);
+
+#if ENGINE_MAJOR_VERSION >= 5
+typedef VectorRegister4Float FFilterRegister;
+#else
+typedef VectorRegister FFilterRegister;
+#endif
+
+/************************************************************************/
+// 1 Euro filter smoothing algorithm
+// http://cristal.univ-lille.fr/~casiez/1euro/
+//
+// Same filter as UOneEuroFilterComponent, the speed estimate is per second
+/************************************************************************/
+
+namespace
+{
+void WritePoint(float* Lanes, const int32 Point, const FVector& Value)
+{
+	Lanes[Point * 3] = Value.X;
+	Lanes[Point * 3 + 1] = Value.Y;
+	Lanes[Point * 3 + 2] = Value.Z;
+}
+
+FVector ReadPoint(const float* Lanes, const int32 Point)
+{
+	return FVector(Lanes[Point * 3], Lanes[Point * 3 + 1], Lanes[Point * 3 + 2]);
+}
+
+void WriteRotation(float* Lanes, const float* Previous, const int32 Rotation, const FRotator& Value)
+{
+	FQuat Quat = Value.Quaternion();
+	const int32 Lane = Rotation * 4;
+	// q and -q are the same rotation, keep to the previous hemisphere so the components filter smoothly
+	const float Dot =
+		Quat.X * Previous[Lane] + Quat.Y * Previous[Lane + 1] + Quat.Z * Previous[Lane + 2] + Quat.W * Previous[Lane + 3];
+	if (Dot < 0)
+	{
+		Quat = FQuat(-Quat.X, -Quat.Y, -Quat.Z, -Quat.W);
+	}
+	Lanes[Lane] = Quat.X;
+	Lanes[Lane + 1] = Quat.Y;
+	Lanes[Lane + 2] = Quat.Z;
+	Lanes[Lane + 3] = Quat.W;
+}
+
+FQuat ReadRotation(const float* Lanes, const int32 Rotation)
+{
+	const int32 Lane = Rotation * 4;
+	return FQuat(Lanes[Lane], Lanes[Lane + 1], Lanes[Lane + 2], Lanes[Lane + 3]).GetNormalized();
+}
+}	 // namespace
+
+FLeapOneEuroFilterBank::FLeapOneEuroFilterBank()
+{
+	const int32 NumLanes = LanesPerHand * 2;
+	Raw.SetNumZeroed(NumLanes);
+	Previous.SetNumZeroed(NumLanes);
+	PreviousDelta.SetNumZeroed(NumLanes);
+	MinCutoff.SetNumZeroed(NumLanes);
+	CutoffSlope.SetNumZeroed(NumLanes);
+	DeltaCutoff.SetNumZeroed(NumLanes);
+
+	PointJoints[0] = 0;
+	PointJoints[1] = 1;
+	PointJoints[2] = 1;
+	for (int32 Digit = 0; Digit < 5; ++Digit)
+	{
+		PointJoints[3 + Digit * 5] = GetBoneJoint(Digit, 0);
+		for (int32 Bone = 0; Bone < 4; ++Bone)
+		{
+			PointJoints[3 + Digit * 5 + 1 + Bone] = GetBoneJoint(Digit, Bone);
+		}
+	}
+	SetAllParams(FLeapOneEuroParams(), FLeapOneEuroParams());
+}
+
+void FLeapOneEuroFilterBank::SetLaneParams(const int32 Lane, const FLeapOneEuroParams& Params)
+{
+	for (int32 Slot = 0; Slot < 2; ++Slot)
+	{
+		MinCutoff[Slot * LanesPerHand + Lane] = FMath::Max(Params.MinCutoff, KINDA_SMALL_NUMBER);
+		CutoffSlope[Slot * LanesPerHand + Lane] = FMath::Max(Params.CutoffSlope, 0.0f);
+		DeltaCutoff[Slot * LanesPerHand + Lane] = FMath::Max(Params.DeltaCutoff, KINDA_SMALL_NUMBER);
+	}
+}
+
+void FLeapOneEuroFilterBank::SetJointParams(
+	const int32 Joint, const FLeapOneEuroParams& PositionParams, const FLeapOneEuroParams& RotationParams)
+{
+	if (Joint < 0 || Joint >= NumJoints)
+	{
+		return;
+	}
+	for (int32 Point = 0; Point < NumPoints; ++Point)
+	{
+		if (PointJoints[Point] == Joint)
+		{
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				SetLaneParams(Point * 3 + Axis, PositionParams);
+			}
+		}
+	}
+	for (int32 Component = 0; Component < 4; ++Component)
+	{
+		SetLaneParams(RotationLanes + Joint * 4 + Component, RotationParams);
+	}
+}
+
+void FLeapOneEuroFilterBank::SetAllParams(const FLeapOneEuroParams& PositionParams, const FLeapOneEuroParams& RotationParams)
+{
+	for (int32 Joint = 0; Joint < NumJoints; ++Joint)
+	{
+		SetJointParams(Joint, PositionParams, RotationParams);
+	}
+}
+
+void FLeapOneEuroFilterBank::Reset()
+{
+	for (FHandSlot& Slot : Slots)
+	{
+		Slot = FHandSlot();
+	}
+	LastTimeStamp = 0;
+}
+
+void FLeapOneEuroFilterBank::Gather(const FLeapHandData& Hand, float* Lanes, const float* PreviousLanes) const
+{
+	WritePoint(Lanes, 0, Hand.Palm.Position);
+	WritePoint(Lanes, 1, Hand.Arm.PrevJoint);
+	WritePoint(Lanes, 2, Hand.Arm.NextJoint);
+	for (int32 Digit = 0; Digit < 5; ++Digit)
+	{
+		const TArray<FLeapBoneData>& Bones = Hand.Digits[Digit].Bones;
+		WritePoint(Lanes, 3 + Digit * 5, Bones[0].PrevJoint);
+		for (int32 Bone = 0; Bone < 4; ++Bone)
+		{
+			WritePoint(Lanes, 3 + Digit * 5 + 1 + Bone, Bones[Bone].NextJoint);
+		}
+	}
+
+	float* RotationLanesOut = Lanes + RotationLanes;
+	const float* RotationLanesPrevious = PreviousLanes + RotationLanes;
+	WriteRotation(RotationLanesOut, RotationLanesPrevious, 0, Hand.Palm.Orientation);
+	WriteRotation(RotationLanesOut, RotationLanesPrevious, 1, Hand.Arm.Rotation);
+	for (int32 Digit = 0; Digit < 5; ++Digit)
+	{
+		for (int32 Bone = 0; Bone < 4; ++Bone)
+		{
+			WriteRotation(
+				RotationLanesOut, RotationLanesPrevious, GetBoneJoint(Digit, Bone), Hand.Digits[Digit].Bones[Bone].Rotation);
+		}
+	}
+}
+
+void FLeapOneEuroFilterBank::Scatter(FLeapHandData& Hand, const float* Lanes) const
+{
+	const float* Rotations = Lanes + RotationLanes;
+
+	// palm vectors follow the filtered position and orientation
+	const FVector PalmPosition = ReadPoint(Lanes, 0);
+	const FQuat PalmOrientation = ReadRotation(Rotations, 0);
+	const FQuat PalmCorrection = PalmOrientation * Hand.Palm.Orientation.Quaternion().Inverse();
+	Hand.Palm.StabilizedPosition += PalmPosition - Hand.Palm.Position;
+	Hand.Palm.Position = PalmPosition;
+	Hand.Palm.Direction = PalmCorrection.RotateVector(Hand.Palm.Direction);
+	Hand.Palm.Normal = PalmCorrection.RotateVector(Hand.Palm.Normal);
+	Hand.Palm.Orientation = PalmOrientation.Rotator();
+
+	Hand.Arm.PrevJoint = ReadPoint(Lanes, 1);
+	Hand.Arm.NextJoint = ReadPoint(Lanes, 2);
+	Hand.Arm.Rotation = ReadRotation(Rotations, 1).Rotator();
+
+	for (int32 Digit = 0; Digit < 5; ++Digit)
+	{
+		for (int32 Bone = 0; Bone < 4; ++Bone)
+		{
+			// bones share joints, the previous joint is the end of the previous bone
+			const FVector PrevJoint = ReadPoint(Lanes, 3 + Digit * 5 + Bone);
+			const FVector NextJoint = ReadPoint(Lanes, 3 + Digit * 5 + 1 + Bone);
+			const FRotator Rotation = ReadRotation(Rotations, GetBoneJoint(Digit, Bone)).Rotator();
+			FLeapHandDataUtils::SetDigitBone(Hand, Digit, Bone, PrevJoint, NextJoint, Rotation);
+		}
+	}
+}
+
+void FLeapOneEuroFilterBank::FilterLanes(const int32 FirstLane, const float DeltaTime)
+{
+	const FFilterRegister One = VectorSetFloat1(1.0f);
+	const FFilterRegister InvDeltaTime = VectorSetFloat1(1.0f / DeltaTime);
+	// alpha = 1 / (1 + tau / dt) with tau = 1 / (2 pi cutoff), or r / (1 + r) with r = 2 pi cutoff dt
+	const FFilterRegister TwoPiDeltaTime = VectorSetFloat1(2.0f * PI * DeltaTime);
+
+	for (int32 Lane = FirstLane; Lane < FirstLane + LanesPerHand; Lane += 4)
+	{
+		const FFilterRegister Value = VectorLoadAligned(&Raw[Lane]);
+		const FFilterRegister Prev = VectorLoadAligned(&Previous[Lane]);
+		const FFilterRegister PrevDelta = VectorLoadAligned(&PreviousDelta[Lane]);
+
+		// smoothed speed
+		const FFilterRegister Delta = VectorMultiply(VectorSubtract(Value, Prev), InvDeltaTime);
+		const FFilterRegister DeltaR = VectorMultiply(VectorLoadAligned(&DeltaCutoff[Lane]), TwoPiDeltaTime);
+		const FFilterRegister DeltaAlpha = VectorMultiply(DeltaR, VectorReciprocal(VectorAdd(DeltaR, One)));
+		const FFilterRegister Estimated = VectorMultiplyAdd(DeltaAlpha, VectorSubtract(Delta, PrevDelta), PrevDelta);
+
+		// speed dependent cutoff
+		const FFilterRegister Cutoff =
+			VectorMultiplyAdd(VectorLoadAligned(&CutoffSlope[Lane]), VectorAbs(Estimated), VectorLoadAligned(&MinCutoff[Lane]));
+		const FFilterRegister R = VectorMultiply(Cutoff, TwoPiDeltaTime);
+		const FFilterRegister Alpha = VectorMultiply(R, VectorReciprocal(VectorAdd(R, One)));
+		const FFilterRegister Filtered = VectorMultiplyAdd(Alpha, VectorSubtract(Value, Prev), Prev);
+
+		VectorStoreAligned(Filtered, &Previous[Lane]);
+		VectorStoreAligned(Estimated, &PreviousDelta[Lane]);
+	}
+}
+
+void FLeapOneEuroFilterBank::Filter(FLeapFrameData& Frame, const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LeapHandFilterBank);
+
+	float FrameDeltaTime = DeltaTime;
+	if (bUseFrameTimestamps && LastTimeStamp > 0 && Frame.TimeStamp > LastTimeStamp)
+	{
+		FrameDeltaTime = (Frame.TimeStamp - LastTimeStamp) * 1.0e-6f;
+	}
+	if (Frame.TimeStamp > 0)
+	{
+		LastTimeStamp = Frame.TimeStamp;
+	}
+	FrameDeltaTime = FMath::Max(FrameDeltaTime, 1.0e-4f);
+
+	bool bSeen[2] = {false, false};
+	for (FLeapHandData& Hand : Frame.Hands)
+	{
+		const int32 SlotIndex = Hand.HandType == EHandType::LEAP_HAND_LEFT ? 0 : 1;
+		if (bSeen[SlotIndex] || !FLeapHandDataUtils::HasAllBones(Hand))
+		{
+			continue;
+		}
+		bSeen[SlotIndex] = true;
+
+		FHandSlot& Slot = Slots[SlotIndex];
+		const int32 FirstLane = SlotIndex * LanesPerHand;
+		const bool bNewHand = !Slot.bTracked || Slot.HandId != Hand.Id;
+		Gather(Hand, &Raw[FirstLane], &Previous[FirstLane]);
+		if (bNewHand)
+		{
+			// nothing to smooth against yet
+			FMemory::Memcpy(&Previous[FirstLane], &Raw[FirstLane], LanesPerHand * sizeof(float));
+			FMemory::Memzero(&PreviousDelta[FirstLane], LanesPerHand * sizeof(float));
+			Slot.HandId = Hand.Id;
+			continue;
+		}
+		FilterLanes(FirstLane, FrameDeltaTime);
+		Scatter(Hand, &Previous[FirstLane]);
+	}
+	// hands that weren't tracked this frame start over when they return
+	Slots[0].bTracked = bSeen[0];
+	Slots[1].bTracked = bSeen[1];
+}
+
+UOneEuroFilterBankComponent::UOneEuroFilterBankComponent() : bUseFrameTimestamps(true)
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	RotationParams.CutoffSlope = 1.0f;
+}
+
+void UOneEuroFilterBankComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	Bank.SetUseFrameTimestamps(bUseFrameTimestamps);
+	Bank.SetAllParams(PositionParams, RotationParams);
+}
+
+void UOneEuroFilterBankComponent::FilterFrame(const FLeapFrameData& InFrame, FLeapFrameData& OutFrame, const float DeltaTime)
+{
+	OutFrame = InFrame;
+	Bank.Filter(OutFrame, DeltaTime);
+}
+
+void UOneEuroFilterBankComponent::SetJointParams(
+	const int32 Joint, const FLeapOneEuroParams& InPositionParams, const FLeapOneEuroParams& InRotationParams)
+{
+	Bank.SetJointParams(Joint, InPositionParams, InRotationParams);
+}
+
+void UOneEuroFilterBankComponent::SetAllParams(const FLeapOneEuroParams& InPositionParams, const FLeapOneEuroParams& InRotationParams)
+{
+	PositionParams = InPositionParams;
+	RotationParams = InRotationParams;
+	Bank.SetAllParams(PositionParams, RotationParams);
+}
+
+int32 UOneEuroFilterBankComponent::GetBoneJoint(const int32 Digit, const int32 Bone)
+{
+	return FLeapOneEuroFilterBank::GetBoneJoint(FMath::Clamp(Digit, 0, 4), FMath::Clamp(Bone, 0, 3));
+}
+
+void UOneEuroFilterBankComponent::Reset()
+{
+	Bank.Reset();
+}
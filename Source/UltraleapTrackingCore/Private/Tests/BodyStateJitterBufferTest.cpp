@@ -0,0 +1,226 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "BodyStateSkeletonJitterBuffer.h"
+#include "Math/RandomStream.h"
+#include "Tests/UltraleapTestFlags.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+const double SendInterval = 1.0 / 60.0;
+const double SampleInterval = 1.0 / 90.0;
+// sender clock is unrelated to the receiver's
+const double SenderClockOffset = 1000.0;
+// cm/s, linear so interpolation and extrapolation are exact and any error is the buffer's
+const float WristSpeed = 30.0f;
+
+void MakeSnapshot(const double SenderTime, FNamedSkeletonData& Snapshot)
+{
+	Snapshot.TimeStamp = SenderTime;
+	Snapshot.TrackedBasicBones.SetNum(1);
+	Snapshot.TrackedBasicBones[0].Name = EBodyStateBasicBoneType::BONE_HAND_WRIST_L;
+	Snapshot.TrackedBasicBones[0].Transform = FTransform(FVector((float) (SenderTime - SenderClockOffset) * WristSpeed, 0, 0));
+}
+
+float GetWristX(const FNamedSkeletonData& Skeleton)
+{
+	return Skeleton.TrackedBasicBones[0].Transform.GetLocation().X;
+}
+
+struct FInFlight
+{
+	double ArrivalTime;
+	FNamedSkeletonData Data;
+};
+
+/** Lossy transport, drops every DropEvery'th packet and delays the rest by a random latency so they reorder */
+struct FSimulatedTransport
+{
+	FRandomStream Random;
+	int32 DropEvery;
+	double MinLatency;
+	double MaxLatency;
+	int32 NumSent = 0;
+	TArray<FInFlight> InFlight;
+
+	FSimulatedTransport(const int32 Seed, const int32 DropEveryIn, const double MinLatencyIn, const double MaxLatencyIn)
+		: Random(Seed), DropEvery(DropEveryIn), MinLatency(MinLatencyIn), MaxLatency(MaxLatencyIn)
+	{
+	}
+
+	void Send(const double Now, const FNamedSkeletonData& Data)
+	{
+		if (DropEvery > 0 && (++NumSent % DropEvery) == 0)
+		{
+			return;
+		}
+		InFlight.Add({Now + Random.FRandRange(MinLatency, MaxLatency), Data});
+	}
+
+	// delivers in arrival order, which differs from send order when latency varies
+	void Deliver(const double Now, FBodyStateSkeletonJitterBuffer& Buffer)
+	{
+		InFlight.Sort([](const FInFlight& A, const FInFlight& B) { return A.ArrivalTime < B.ArrivalTime; });
+		int32 NumDelivered = 0;
+		while (NumDelivered < InFlight.Num() && InFlight[NumDelivered].ArrivalTime <= Now)
+		{
+			Buffer.AddSnapshot(InFlight[NumDelivered].Data, InFlight[NumDelivered].ArrivalTime);
+			NumDelivered++;
+		}
+		InFlight.RemoveAt(0, NumDelivered);
+	}
+};
+}	 // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyStateJitterBufferLossyTransportTest, "UltraleapTracking.BodyState.JitterBufferLossyTransport",
+	ULTRALEAP_TEST_FLAGS)
+
+bool FBodyStateJitterBufferLossyTransportTest::RunTest(const FString& Parameters)
+{
+	FBodyStateSkeletonJitterBuffer Buffer;
+	Buffer.Delay = 0.1f;
+
+	// 20-60ms latency reorders packets sent 16ms apart, one in five is lost
+	FSimulatedTransport Transport(32, 5, 0.02, 0.06);
+
+	double NextSend = 0;
+	double LastTimeStamp = -1;
+	float MaxError = 0;
+	int32 NumSamples = 0;
+	FNamedSkeletonData Snapshot;
+	FNamedSkeletonData Rendered;
+
+	for (double Now = 0; Now < 10.0; Now += SampleInterval)
+	{
+		while (NextSend <= Now)
+		{
+			MakeSnapshot(NextSend + SenderClockOffset, Snapshot);
+			Transport.Send(NextSend, Snapshot);
+			NextSend += SendInterval;
+		}
+		Transport.Deliver(Now, Buffer);
+
+		if (!Buffer.Sample(Now, Rendered) || Now < 1.0)
+		{
+			continue;
+		}
+		TestTrue(TEXT("Render time never rewinds"), Rendered.TimeStamp >= LastTimeStamp);
+		LastTimeStamp = Rendered.TimeStamp;
+
+		// the rendered pose must be the sender's pose at the rendered time
+		const float Expected = (float) (Rendered.TimeStamp - SenderClockOffset) * WristSpeed;
+		MaxError = FMath::Max(MaxError, FMath::Abs(GetWristX(Rendered) - Expected));
+
+		// latency stays well under the delay, so the buffer never runs dry
+		const double Lag = (Now + SenderClockOffset) - Rendered.TimeStamp;
+		TestTrue(TEXT("Rendered behind the sender by the delay plus the transport latency"),
+			Lag >= Buffer.Delay + Transport.MinLatency && Lag <= Buffer.Delay + Transport.MaxLatency);
+		NumSamples++;
+	}
+
+	const FBodyStateJitterBufferStats& Stats = Buffer.GetStats();
+	AddInfo(FString::Printf(TEXT("%d samples, max error %.4fcm, late %d, extrapolated %d, held %d"), NumSamples, MaxError,
+		Stats.LateSnapshots, Stats.ExtrapolatedFrames, Stats.HeldFrames));
+
+	TestTrue(TEXT("Sampled throughout"), NumSamples > 700);
+	TestTrue(TEXT("Interpolated pose matches the sender"), MaxError < 0.01f);
+	TestEqual(TEXT("No late snapshots"), Stats.LateSnapshots, 0);
+	TestEqual(TEXT("No extrapolation"), Stats.ExtrapolatedFrames, 0);
+	TestEqual(TEXT("No held frames"), Stats.HeldFrames, 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyStateJitterBufferLateTest, "UltraleapTracking.BodyState.JitterBufferLateSnapshots",
+	ULTRALEAP_TEST_FLAGS)
+
+bool FBodyStateJitterBufferLateTest::RunTest(const FString& Parameters)
+{
+	FBodyStateSkeletonJitterBuffer Buffer;
+	Buffer.Delay = 0.05f;
+
+	// latency spikes past the delay, those packets arrive after their time was rendered
+	FSimulatedTransport Transport(33, 0, 0.0, 0.15);
+
+	double NextSend = 0;
+	double LastTimeStamp = -1;
+	FNamedSkeletonData Snapshot;
+	FNamedSkeletonData Rendered;
+	for (double Now = 0; Now < 5.0; Now += SampleInterval)
+	{
+		while (NextSend <= Now)
+		{
+			MakeSnapshot(NextSend + SenderClockOffset, Snapshot);
+			Transport.Send(NextSend, Snapshot);
+			NextSend += SendInterval;
+		}
+		Transport.Deliver(Now, Buffer);
+
+		if (Buffer.Sample(Now, Rendered))
+		{
+			TestTrue(TEXT("Render time never rewinds"), Rendered.TimeStamp >= LastTimeStamp);
+			LastTimeStamp = Rendered.TimeStamp;
+		}
+	}
+	TestTrue(TEXT("Late snapshots are counted and discarded"), Buffer.GetStats().LateSnapshots > 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyStateJitterBufferStopTest, "UltraleapTracking.BodyState.JitterBufferSenderStops",
+	ULTRALEAP_TEST_FLAGS)
+
+bool FBodyStateJitterBufferStopTest::RunTest(const FString& Parameters)
+{
+	FBodyStateSkeletonJitterBuffer Buffer;
+	Buffer.Delay = 0.1f;
+	Buffer.MaxExtrapolation = 0.1f;
+
+	// ideal transport for a second, then the sender stops
+	const double StopTime = 1.0;
+	FNamedSkeletonData Snapshot;
+	FNamedSkeletonData Newest;
+	for (double SendTime = 0; SendTime < StopTime; SendTime += SendInterval)
+	{
+		MakeSnapshot(SendTime + SenderClockOffset, Snapshot);
+		Buffer.AddSnapshot(Snapshot, SendTime);
+		Newest = Snapshot;
+	}
+
+	FNamedSkeletonData Rendered;
+	float PreviousX = 0;
+	float MaxStep = 0;
+	float MaxOvershoot = 0;
+	bool bFirst = true;
+	for (double Now = StopTime - 0.2; Now < StopTime + 1.0; Now += SampleInterval)
+	{
+		if (!TestTrue(TEXT("Sampled"), Buffer.Sample(Now, Rendered)))
+		{
+			return false;
+		}
+		const float X = GetWristX(Rendered);
+		if (!bFirst)
+		{
+			MaxStep = FMath::Max(MaxStep, FMath::Abs(X - PreviousX));
+		}
+		MaxOvershoot = FMath::Max(MaxOvershoot, X - GetWristX(Newest));
+		PreviousX = X;
+		bFirst = false;
+	}
+
+	const FBodyStateJitterBufferStats& Stats = Buffer.GetStats();
+	TestTrue(TEXT("Extrapolated when the buffer ran dry"), Stats.ExtrapolatedFrames > 0);
+	TestTrue(TEXT("Held once extrapolation ran out"), Stats.HeldFrames > 0);
+	TestEqual(TEXT("Holds the last received pose"), GetWristX(Rendered), GetWristX(Newest));
+	TestTrue(TEXT("Extrapolation is limited"), MaxOvershoot <= Buffer.MaxExtrapolation * WristSpeed + 0.01f);
+	// never moves faster than the tracked motion, so there is no pop when the hold starts
+	TestTrue(TEXT("No pops"), MaxStep <= SampleInterval * WristSpeed + 0.01f);
+	return true;
+}
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,375 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "Math/RandomStream.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+#include "Skeleton/BodyStateSkeleton.h"
+#include "Tests/UltraleapTestFlags.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+// error bounds documented in BodyStateSkeleton.cpp
+const float MaxRotationErrorInDegrees = 0.13f;
+const float MaxPositionErrorPerAxis = 0.0051f;
+const float MaxAlphaError = 0.5f / 255.0f;
+
+FTransform MakeRandomTransform(FRandomStream& Random, const FVector& Origin, const float Extent)
+{
+	const FQuat Rotation = FQuat(Random.GetUnitVector(), Random.FRandRange(-PI, PI));
+	return FTransform(Rotation, Origin + Random.GetUnitVector() * Random.FRandRange(0.0f, Extent));
+}
+
+// a wrist, its fingers and a few body bones, with two tracking types sharing the meta table
+void MakeSkeleton(FRandomStream& Random, FNamedSkeletonData& Skeleton)
+{
+	Skeleton.TimeStamp = 12.5;
+
+	const FVector WristPosition = FVector(Random.FRandRange(-500.0f, 500.0f), Random.FRandRange(-500.0f, 500.0f), 120.0f);
+
+	FKeyedTransform& Wrist = Skeleton.TrackedBasicBones.AddDefaulted_GetRef();
+	Wrist.Name = EBodyStateBasicBoneType::BONE_HAND_WRIST_L;
+	Wrist.Transform = MakeRandomTransform(Random, WristPosition, 0.0f);
+
+	for (int32 Bone = (int32) EBodyStateBasicBoneType::BONE_INDEX_0_METACARPAL_L;
+		 Bone <= (int32) EBodyStateBasicBoneType::BONE_THUMB_2_DISTAL_L; Bone++)
+	{
+		FKeyedTransform& Finger = Skeleton.TrackedBasicBones.AddDefaulted_GetRef();
+		Finger.Name = (EBodyStateBasicBoneType) Bone;
+		Finger.Transform = MakeRandomTransform(Random, WristPosition, 20.0f);
+	}
+
+	FNamedBoneData& Head = Skeleton.TrackedAdvancedBones.AddDefaulted_GetRef();
+	Head.Name = EBodyStateBasicBoneType::BONE_HEAD;
+	Head.Data.Transform = MakeRandomTransform(Random, FVector::ZeroVector, 1000.0f);
+	Head.Data.Transform.SetScale3D(FVector(1.0f, 2.0f, 0.5f));
+	Head.Data.Alpha = 0.37f;
+	Head.Data.Length = 11.25f;
+
+	FNamedBoneData& Root = Skeleton.TrackedAdvancedBones.AddDefaulted_GetRef();
+	Root.Name = EBodyStateBasicBoneType::BONE_ROOT;
+	Root.Data.Transform = MakeRandomTransform(Random, FVector::ZeroVector, 1000.0f);
+	Root.Data.Alpha = 1.0f;
+	Root.Data.Length = 0.0f;
+
+	for (int32 Index = 0; Index < 4; Index++)
+	{
+		FNamedBoneMeta& Meta = Skeleton.UniqueMetas.AddDefaulted_GetRef();
+		Meta.Name = (EBodyStateBasicBoneType) ((int32) EBodyStateBasicBoneType::BONE_INDEX_0_METACARPAL_L + Index);
+		Meta.Meta.TrackingType = Index < 2 ? TEXT("Ultraleap") : TEXT("OpenXR");
+		Meta.Meta.TrackingTags = {TEXT("Hand"), TEXT("Left")};
+		Meta.Meta.Confidence = Index * 0.25f;
+		Meta.Meta.Accuracy = 0.5f;
+		Meta.Meta.TimeStamp = 3.0f;
+		Meta.Meta.ParentDistinctMeta = Index == 1;
+	}
+}
+
+float RotationErrorInDegrees(const FTransform& A, const FTransform& B)
+{
+	return FMath::RadiansToDegrees(A.GetRotation().AngularDistance(B.GetRotation()));
+}
+
+bool PositionWithinBound(const FTransform& A, const FTransform& B)
+{
+	const FVector Delta = (A.GetLocation() - B.GetLocation()).GetAbs();
+	return Delta.GetMax() <= MaxPositionErrorPerAxis;
+}
+
+// sends the skeleton through NetSerialize, returns the packet size in bits or INDEX_NONE if it didn't survive
+int64 RoundTrip(FNamedSkeletonData& Sent, FNamedSkeletonData& Received)
+{
+	FBitWriter Writer(0, true);
+	bool bSuccess = false;
+	Sent.NetSerialize(Writer, nullptr, bSuccess);
+	if (!bSuccess || Writer.IsError())
+	{
+		return INDEX_NONE;
+	}
+	FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+	Received.NetSerialize(Reader, nullptr, bSuccess);
+	if (!bSuccess || Reader.IsError() || Reader.GetBitsLeft() != 0)
+	{
+		return INDEX_NONE;
+	}
+	return Writer.GetNumBits();
+}
+
+// the default property serialization the skeleton RPCs used before NetSerialize: a name byte and a full FTransform
+// per bone, every meta with its own strings
+int64 GetLegacyBits(FNamedSkeletonData& Skeleton)
+{
+	FBitWriter Writer(0, true);
+	Writer << Skeleton.TimeStamp;
+	int32 NumBasic = Skeleton.TrackedBasicBones.Num();
+	Writer << NumBasic;
+	for (FKeyedTransform& Bone : Skeleton.TrackedBasicBones)
+	{
+		uint8 Name = (uint8) Bone.Name;
+		Writer << Name << Bone.Transform;
+	}
+	int32 NumAdvanced = Skeleton.TrackedAdvancedBones.Num();
+	Writer << NumAdvanced;
+	for (FNamedBoneData& Bone : Skeleton.TrackedAdvancedBones)
+	{
+		uint8 Name = (uint8) Bone.Name;
+		Writer << Name << Bone.Data.Transform << Bone.Data.Alpha << Bone.Data.Length;
+	}
+	int32 NumMetas = Skeleton.UniqueMetas.Num();
+	Writer << NumMetas;
+	for (FNamedBoneMeta& Meta : Skeleton.UniqueMetas)
+	{
+		uint8 Name = (uint8) Meta.Name;
+		Writer << Name << Meta.Meta.TrackingType << Meta.Meta.TrackingTags << Meta.Meta.Confidence << Meta.Meta.Accuracy
+			   << Meta.Meta.TimeStamp << Meta.Meta.ParentDistinctMeta;
+	}
+	return Writer.GetNumBits();
+}
+
+void MoveTransform(FRandomStream& Random, FTransform& Transform, const float MaxDegrees, const float MaxDistance)
+{
+	const FQuat Turn(Random.GetUnitVector(), FMath::DegreesToRadians(Random.FRandRange(0.0f, MaxDegrees)));
+	Transform.SetRotation(Turn * Transform.GetRotation());
+	Transform.AddToTranslation(Random.GetUnitVector() * Random.FRandRange(0.0f, MaxDistance));
+}
+
+// the skeleton a frame or few after the keyframe, with one bone of each kind too far from it for the delta encoding
+void MoveSkeleton(FRandomStream& Random, FNamedSkeletonData& Skeleton)
+{
+	Skeleton.TimeStamp += 0.1;
+	for (int32 Index = 0; Index < Skeleton.TrackedBasicBones.Num(); Index++)
+	{
+		const bool bFar = Index == 1;
+		MoveTransform(Random, Skeleton.TrackedBasicBones[Index].Transform, bFar ? 90.0f : 10.0f, bFar ? 50.0f : 3.0f);
+	}
+	for (int32 Index = 0; Index < Skeleton.TrackedAdvancedBones.Num(); Index++)
+	{
+		const bool bFar = Index == 0;
+		MoveTransform(Random, Skeleton.TrackedAdvancedBones[Index].Data.Transform, bFar ? 90.0f : 10.0f, bFar ? 50.0f : 3.0f);
+	}
+}
+}	 // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyStateSkeletonSerializeRoundTripTest, "UltraleapTracking.BodyState.SerializeRoundTrip",
+	ULTRALEAP_TEST_FLAGS)
+
+bool FBodyStateSkeletonSerializeRoundTripTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(31);
+	float WorstRotationError = 0;
+	int64 WorstBits = 0;
+
+	for (int32 Iteration = 0; Iteration < 200; Iteration++)
+	{
+		FNamedSkeletonData Sent;
+		MakeSkeleton(Random, Sent);
+
+		FBitWriter Writer(0, true);
+		bool bSuccess = false;
+		Sent.NetSerialize(Writer, nullptr, bSuccess);
+		if (!TestTrue(TEXT("Write succeeded"), bSuccess && !Writer.IsError()))
+		{
+			return false;
+		}
+		WorstBits = FMath::Max(WorstBits, Writer.GetNumBits());
+
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		FNamedSkeletonData Received;
+		Received.NetSerialize(Reader, nullptr, bSuccess);
+		if (!TestTrue(TEXT("Read succeeded"), bSuccess && !Reader.IsError()) ||
+			!TestEqual(TEXT("All bits consumed"), Reader.GetBitsLeft(), (int64) 0) ||
+			!TestEqual(TEXT("Basic bone count"), Received.TrackedBasicBones.Num(), Sent.TrackedBasicBones.Num()) ||
+			!TestEqual(TEXT("Advanced bone count"), Received.TrackedAdvancedBones.Num(), Sent.TrackedAdvancedBones.Num()) ||
+			!TestEqual(TEXT("Meta count"), Received.UniqueMetas.Num(), Sent.UniqueMetas.Num()))
+		{
+			return false;
+		}
+		TestEqual(TEXT("TimeStamp"), Received.TimeStamp, Sent.TimeStamp);
+
+		for (int32 Index = 0; Index < Sent.TrackedBasicBones.Num(); Index++)
+		{
+			const FKeyedTransform& A = Sent.TrackedBasicBones[Index];
+			const FKeyedTransform& B = Received.TrackedBasicBones[Index];
+			TestTrue(TEXT("Basic bone name"), A.Name == B.Name);
+			TestTrue(TEXT("Basic bone position within 0.005cm"), PositionWithinBound(A.Transform, B.Transform));
+			WorstRotationError = FMath::Max(WorstRotationError, RotationErrorInDegrees(A.Transform, B.Transform));
+		}
+		for (int32 Index = 0; Index < Sent.TrackedAdvancedBones.Num(); Index++)
+		{
+			const FNamedBoneData& A = Sent.TrackedAdvancedBones[Index];
+			const FNamedBoneData& B = Received.TrackedAdvancedBones[Index];
+			TestTrue(TEXT("Advanced bone name"), A.Name == B.Name);
+			TestTrue(TEXT("Advanced bone position within 0.005cm"), PositionWithinBound(A.Data.Transform, B.Data.Transform));
+			TestTrue(TEXT("Advanced bone scale"), A.Data.Transform.GetScale3D().Equals(B.Data.Transform.GetScale3D(), 0.0f));
+			TestTrue(TEXT("Advanced bone alpha"), FMath::IsNearlyEqual(A.Data.Alpha, B.Data.Alpha, MaxAlphaError));
+			TestTrue(TEXT("Advanced bone length"), FMath::IsNearlyEqual(A.Data.Length, B.Data.Length, A.Data.Length * 1e-3f));
+			WorstRotationError = FMath::Max(WorstRotationError, RotationErrorInDegrees(A.Data.Transform, B.Data.Transform));
+		}
+		for (int32 Index = 0; Index < Sent.UniqueMetas.Num(); Index++)
+		{
+			const FBodyStateBoneMeta& A = Sent.UniqueMetas[Index].Meta;
+			const FBodyStateBoneMeta& B = Received.UniqueMetas[Index].Meta;
+			TestEqual(TEXT("Meta tracking type"), B.TrackingType, A.TrackingType);
+			TestTrue(TEXT("Meta tracking tags"), A.TrackingTags == B.TrackingTags);
+			TestEqual(TEXT("Meta parent distinct"), B.ParentDistinctMeta, A.ParentDistinctMeta);
+			TestTrue(TEXT("Meta confidence"), FMath::IsNearlyEqual(A.Confidence, B.Confidence, MaxAlphaError));
+		}
+	}
+
+	AddInfo(FString::Printf(TEXT("Worst rotation error %.4f degrees, largest packet %lld bits"), WorstRotationError, WorstBits));
+	TestTrue(TEXT("Rotation error within bound"), WorstRotationError <= MaxRotationErrorInDegrees);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyStateSkeletonSerializeDeltaTest, "UltraleapTracking.BodyState.SerializeDelta",
+	ULTRALEAP_TEST_FLAGS)
+
+bool FBodyStateSkeletonSerializeDeltaTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(33);
+	float WorstRotationError = 0;
+
+	for (int32 Iteration = 0; Iteration < 200; Iteration++)
+	{
+		// deltas are made against the keyframe as the receiver has it
+		FNamedSkeletonData Keyframe;
+		MakeSkeleton(Random, Keyframe);
+		Keyframe.KeyframeId = 7;
+		FNamedSkeletonData ReceivedKeyframe;
+		if (!TestTrue(TEXT("Keyframe round trip"), RoundTrip(Keyframe, ReceivedKeyframe) != INDEX_NONE))
+		{
+			return false;
+		}
+
+		FNamedSkeletonData Moved = ReceivedKeyframe;
+		Moved.KeyframeId = 0;
+		MoveSkeleton(Random, Moved);
+		FNamedSkeletonData Delta = Moved;
+		FNamedSkeletonData Received;
+		if (!TestTrue(TEXT("Delta made"), Delta.MakeDelta(ReceivedKeyframe)) ||
+			!TestEqual(TEXT("Delta refers to the keyframe"), (int32) Delta.DeltaKeyframeId, 7) ||
+			!TestTrue(TEXT("Delta round trip"), RoundTrip(Delta, Received) != INDEX_NONE))
+		{
+			return false;
+		}
+
+		FNamedSkeletonData WrongKeyframe = ReceivedKeyframe;
+		WrongKeyframe.KeyframeId = 8;
+		FNamedSkeletonData Unresolved = Received;
+		TestFalse(TEXT("Delta needs its own keyframe"), Unresolved.ApplyDelta(WrongKeyframe));
+		if (!TestTrue(TEXT("Delta applied"), Received.ApplyDelta(ReceivedKeyframe)))
+		{
+			return false;
+		}
+		TestEqual(TEXT("TimeStamp"), Received.TimeStamp, Moved.TimeStamp);
+
+		for (int32 Index = 0; Index < Moved.TrackedBasicBones.Num(); Index++)
+		{
+			const FKeyedTransform& A = Moved.TrackedBasicBones[Index];
+			const FKeyedTransform& B = Received.TrackedBasicBones[Index];
+			TestTrue(TEXT("Basic bone name from the keyframe"), A.Name == B.Name);
+			TestTrue(TEXT("Basic bone position within 0.005cm"), PositionWithinBound(A.Transform, B.Transform));
+			WorstRotationError = FMath::Max(WorstRotationError, RotationErrorInDegrees(A.Transform, B.Transform));
+		}
+		for (int32 Index = 0; Index < Moved.TrackedAdvancedBones.Num(); Index++)
+		{
+			const FNamedBoneData& A = Moved.TrackedAdvancedBones[Index];
+			const FNamedBoneData& B = Received.TrackedAdvancedBones[Index];
+			TestTrue(TEXT("Advanced bone name from the keyframe"), A.Name == B.Name);
+			TestTrue(TEXT("Advanced bone position within 0.005cm"), PositionWithinBound(A.Data.Transform, B.Data.Transform));
+			TestTrue(TEXT("Advanced bone scale"), A.Data.Transform.GetScale3D().Equals(B.Data.Transform.GetScale3D(), 0.0f));
+			TestTrue(TEXT("Advanced bone alpha"), FMath::IsNearlyEqual(A.Data.Alpha, B.Data.Alpha, MaxAlphaError));
+			WorstRotationError = FMath::Max(WorstRotationError, RotationErrorInDegrees(A.Data.Transform, B.Data.Transform));
+		}
+	}
+
+	AddInfo(FString::Printf(TEXT("Worst delta rotation error %.4f degrees"), WorstRotationError));
+	TestTrue(TEXT("Rotation error within bound"), WorstRotationError <= MaxRotationErrorInDegrees);
+
+	// a changed bone set can't be a delta
+	FNamedSkeletonData Keyframe;
+	MakeSkeleton(Random, Keyframe);
+	Keyframe.KeyframeId = 1;
+	FNamedSkeletonData Fewer = Keyframe;
+	Fewer.TrackedBasicBones.Pop();
+	TestFalse(TEXT("No delta across bone changes"), Fewer.MakeDelta(Keyframe));
+	TestEqual(TEXT("Left as is"), (int32) Fewer.DeltaKeyframeId, 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyStateSkeletonSerializeSizeTest, "UltraleapTracking.BodyState.SerializeSize",
+	ULTRALEAP_TEST_FLAGS)
+
+bool FBodyStateSkeletonSerializeSizeTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(34);
+	for (const bool bMetas : {true, false})
+	{
+		FNamedSkeletonData Keyframe;
+		MakeSkeleton(Random, Keyframe);
+		if (!bMetas)
+		{
+			Keyframe.UniqueMetas.Empty();
+		}
+		Keyframe.KeyframeId = 1;
+		const int64 LegacyBits = GetLegacyBits(Keyframe);
+		FNamedSkeletonData ReceivedKeyframe;
+		const int64 KeyframeBits = RoundTrip(Keyframe, ReceivedKeyframe);
+
+		// hands move a few cm between keyframes, only the far bones fall back to the absolute encoding
+		FNamedSkeletonData Delta = ReceivedKeyframe;
+		Delta.KeyframeId = 0;
+		MoveSkeleton(Random, Delta);
+		Delta.MakeDelta(ReceivedKeyframe);
+		FNamedSkeletonData Received;
+		const int64 DeltaBits = RoundTrip(Delta, Received);
+		if (!TestTrue(TEXT("Round trips"), KeyframeBits != INDEX_NONE && DeltaBits != INDEX_NONE))
+		{
+			return false;
+		}
+
+		const TCHAR* Kind = bMetas ? TEXT("with metas") : TEXT("bones only");
+		AddInfo(FString::Printf(TEXT("%s: legacy %lld bytes, keyframe %lld bytes (%.0f%%), delta %lld bytes (%.0f%% of the keyframe)"),
+			Kind, (LegacyBits + 7) / 8, (KeyframeBits + 7) / 8, 100.0 * KeyframeBits / LegacyBits, (DeltaBits + 7) / 8,
+			100.0 * DeltaBits / KeyframeBits));
+		// a full FTransform is 40 bytes even with float components, a quantized bone 12
+		TestTrue(FString::Printf(TEXT("%s keyframe at most 40%% of the legacy encoding"), Kind), KeyframeBits <= 0.4 * LegacyBits);
+		TestTrue(FString::Printf(TEXT("%s delta smaller than the keyframe"), Kind), DeltaBits < KeyframeBits);
+		if (!bMetas)
+		{
+			// names and the full rotation and position encoding take about a quarter of each bone
+			TestTrue(TEXT("Bone deltas at most 80% of the keyframe"), DeltaBits <= 0.8 * KeyframeBits);
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyStateSkeletonSerializeTruncatedTest, "UltraleapTracking.BodyState.SerializeTruncated",
+	ULTRALEAP_TEST_FLAGS)
+
+bool FBodyStateSkeletonSerializeTruncatedTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(32);
+	FNamedSkeletonData Sent;
+	MakeSkeleton(Random, Sent);
+
+	FBitWriter Writer(0, true);
+	bool bSuccess = false;
+	Sent.NetSerialize(Writer, nullptr, bSuccess);
+
+	// a short packet must fail cleanly rather than produce a skeleton
+	FBitReader Reader(Writer.GetData(), Writer.GetNumBits() / 2);
+	FNamedSkeletonData Received;
+	Received.NetSerialize(Reader, nullptr, bSuccess);
+	TestFalse(TEXT("Truncated read fails"), bSuccess);
+	return true;
+}
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,305 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "LeapClickPredictor.h"
+#include "Math/RandomStream.h"
+#include "Tests/UltraleapTestFlags.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+const double FrameInterval = 1.0 / 90.0;
+// poke settings from ULeapWidgetInteractionComponent, depth in cm past the touch distance
+const float PokeReleaseOffset = 2.0f;
+const float LeadTime = 0.03f;
+const float PokeOnsetVelocity = 15.0f;
+// pinch settings, strength 0-1
+const float PinchPressStrength = 0.8f;
+const float PinchReleaseStrength = 0.5f;
+const float PinchOnsetVelocity = 1.5f;
+const float PinchSpeed = 4.0f;
+
+const float StartDepth = -8.0f;
+const float HoldTime = 0.1f;
+// tracking jitter on the fingertip, cm
+const float Noise = 0.05f;
+
+/** Fingertip depth easing in to Peak and back out again, a poke if Peak is past the widget, a near miss if not */
+struct FPokeTrajectory
+{
+	float Peak;
+	float ApproachTime;
+
+	FPokeTrajectory(const float InPeak, const float AverageSpeed)
+		: Peak(InPeak), ApproachTime(FMath::Abs(InPeak - StartDepth) / AverageSpeed)
+	{
+	}
+
+	float GetDuration() const
+	{
+		return 2.0f * ApproachTime + HoldTime + 0.2f;
+	}
+
+	float GetDepth(const float Time) const
+	{
+		if (Time < ApproachTime)
+		{
+			return StartDepth + (Peak - StartDepth) * 0.5f * (1.0f - FMath::Cos(PI * Time / ApproachTime));
+		}
+		if (Time < ApproachTime + HoldTime)
+		{
+			return Peak;
+		}
+		if (Time < 2.0f * ApproachTime + HoldTime)
+		{
+			const float Retract = Time - ApproachTime - HoldTime;
+			return Peak + (StartDepth - Peak) * 0.5f * (1.0f - FMath::Cos(PI * Retract / ApproachTime));
+		}
+		return StartDepth;
+	}
+};
+
+struct FPokeResult
+{
+	int32 Presses = 0;
+	int32 Clicks = 0;
+	int32 Cancels = 0;
+	// seconds the first press came before the fingertip reached the widget
+	double Lead = 0;
+	bool bStuck = false;
+};
+
+FPokeResult RunTrajectory(FRandomStream& Random, const FPokeTrajectory& Trajectory)
+{
+	FLeapClickPredictor Predictor;
+	Predictor.Configure(0.0f, -PokeReleaseOffset, LeadTime, PokeOnsetVelocity);
+
+	FPokeResult Result;
+	double FirstPressTime = -1;
+	double ContactTime = -1;
+	for (double Time = 0; Time < Trajectory.GetDuration(); Time += FrameInterval)
+	{
+		const float Depth = Trajectory.GetDepth((float) Time);
+		if (Depth >= 0 && ContactTime < 0)
+		{
+			ContactTime = Time;
+		}
+		switch (Predictor.AddSample(Time, Depth + Random.FRandRange(-Noise, Noise), FVector::ZeroVector, FVector::ForwardVector))
+		{
+			case ELeapClickPrediction::Press:
+				Result.Presses++;
+				FirstPressTime = FirstPressTime < 0 ? Time : FirstPressTime;
+				break;
+			case ELeapClickPrediction::Release:
+				Result.Clicks++;
+				break;
+			case ELeapClickPrediction::Cancel:
+				Result.Cancels++;
+				break;
+			default:
+				break;
+		}
+	}
+	Result.bStuck = Predictor.IsPressed();
+	if (FirstPressTime >= 0 && ContactTime >= 0)
+	{
+		Result.Lead = ContactTime - FirstPressTime;
+	}
+	return Result;
+}
+
+struct FPinchResult
+{
+	int32 Clicks = 0;
+	int32 Cancels = 0;
+	bool bPressedBeforePinch = false;
+	bool bStuck = false;
+};
+
+// pinch strength ramping from 0.2 to Peak and back, driving the predictor as ULeapWidgetInteractionComponent does in
+// FAR mode: pinch and unpinch events at the press and release strengths confirm and release, the prediction only
+// presses early and takes back presses that no pinch confirmed
+FPinchResult RunPinch(const float Peak)
+{
+	FLeapClickPredictor Predictor;
+	Predictor.Configure(PinchPressStrength, PinchReleaseStrength, LeadTime, PinchOnsetVelocity);
+
+	FPinchResult Result;
+	bool bPressed = false;
+	bool bPinchConfirmed = false;
+	const float RampTime = (Peak - 0.2f) / PinchSpeed;
+	for (double Time = 0; Time < 2.0 * RampTime + 0.2; Time += FrameInterval)
+	{
+		const float Strength = Time < RampTime ? 0.2f + PinchSpeed * (float) Time
+											   : FMath::Max(Peak - PinchSpeed * (float) (Time - RampTime), 0.2f);
+
+		const ELeapClickPrediction Prediction = FLeapClickPredictor::FilterConfirmed(
+			Predictor.AddSample(Time, Strength, FVector::ZeroVector, FVector::ForwardVector), bPinchConfirmed);
+		if (Prediction == ELeapClickPrediction::Press && !bPressed)
+		{
+			bPressed = true;
+			Result.bPressedBeforePinch = Strength < PinchPressStrength;
+		}
+		else if (Prediction == ELeapClickPrediction::Cancel && bPressed)
+		{
+			bPressed = false;
+			Result.Cancels++;
+		}
+
+		// OnLeapPinch
+		if (Strength >= PinchPressStrength && !bPinchConfirmed)
+		{
+			bPinchConfirmed = true;
+			bPressed = true;
+		}
+		// OnLeapUnPinch
+		if (Strength < PinchReleaseStrength && bPinchConfirmed)
+		{
+			bPinchConfirmed = false;
+			Predictor.Reset();
+			if (bPressed)
+			{
+				bPressed = false;
+				Result.Clicks++;
+			}
+		}
+	}
+	Result.bStuck = bPressed;
+	return Result;
+}
+}	 // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLeapClickPredictorPokePrecisionRecallTest,
+	"UltraleapTracking.Widget.ClickPredictorPokePrecisionRecall", ULTRALEAP_TEST_FLAGS)
+
+bool FLeapClickPredictorPokePrecisionRecallTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(46);
+
+	int32 NumPokes = 0;
+	int32 PokesClicked = 0;
+	int32 NearMissesClicked = 0;
+	int32 NumPresses = 0;
+	int32 PressesOnPokes = 0;
+	int32 NumCancels = 0;
+	double TotalLead = 0;
+
+	for (int32 Index = 0; Index < 400; Index++)
+	{
+		// pokes go 0.5-2cm past the widget, near misses stop 0.5-1.5cm short of it, both at 10-60cm/s
+		const bool bPoke = (Index % 2) == 0;
+		const float Peak = bPoke ? Random.FRandRange(0.5f, 2.0f) : Random.FRandRange(-1.5f, -0.5f);
+		const FPokeResult Result = RunTrajectory(Random, FPokeTrajectory(Peak, Random.FRandRange(10.0f, 60.0f)));
+
+		TestFalse(TEXT("Every press ends"), Result.bStuck);
+		NumPresses += Result.Presses;
+		NumCancels += Result.Cancels;
+		if (bPoke)
+		{
+			NumPokes++;
+			PressesOnPokes += Result.Presses;
+			PokesClicked += Result.Clicks > 0 ? 1 : 0;
+			TotalLead += Result.Lead;
+			TestEqual(TEXT("A poke clicks once"), Result.Clicks, 1);
+		}
+		else
+		{
+			NearMissesClicked += Result.Clicks;
+			TestEqual(TEXT("A near miss press is cancelled"), Result.Cancels, Result.Presses);
+		}
+	}
+
+	const float ClickPrecision = (float) PokesClicked / FMath::Max(PokesClicked + NearMissesClicked, 1);
+	const float Recall = (float) PokesClicked / NumPokes;
+	const float PressPrecision = (float) PressesOnPokes / FMath::Max(NumPresses, 1);
+	const double MeanLead = TotalLead / NumPokes;
+	AddInfo(FString::Printf(TEXT("click precision %.3f, recall %.3f, press precision %.3f, %d cancelled, mean lead %.1fms"),
+		ClickPrecision, Recall, PressPrecision, NumCancels, MeanLead * 1000.0));
+
+	TestEqual(TEXT("Every poke clicks"), Recall, 1.0f);
+	TestEqual(TEXT("No near miss clicks"), ClickPrecision, 1.0f);
+	// the cost of pressing early is taking back presses on near misses, which the user sees as the cursor shrinking
+	TestTrue(TEXT("Most presses are pokes"), PressPrecision >= 0.85f);
+	TestTrue(TEXT("Presses come before contact"), MeanLead >= 0.5 * LeadTime);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLeapClickPredictorCancelTest, "UltraleapTracking.Widget.ClickPredictorCancel",
+	ULTRALEAP_TEST_FLAGS)
+
+bool FLeapClickPredictorCancelTest::RunTest(const FString& Parameters)
+{
+	FLeapClickPredictor Predictor;
+	Predictor.Configure(0.0f, -PokeReleaseOffset, LeadTime, PokeOnsetVelocity);
+
+	// 60cm/s towards the widget, 1cm short of it is predicted to reach it within the lead time
+	double Time = 0;
+	ELeapClickPrediction Prediction = ELeapClickPrediction::None;
+	for (float Depth = -4.0f; Depth <= -1.0f && Prediction == ELeapClickPrediction::None; Depth += 60.0f * (float) FrameInterval)
+	{
+		Prediction = Predictor.AddSample(Time, Depth, FVector::ZeroVector, FVector::ForwardVector);
+		Time += FrameInterval;
+	}
+	if (!TestTrue(TEXT("Press predicted before contact"), Prediction == ELeapClickPrediction::Press))
+	{
+		return false;
+	}
+	TestFalse(TEXT("Only predicted"), Predictor.HasReachedPressThreshold());
+
+	// the finger stops short and pulls back
+	for (int32 Frame = 0; Frame < 10 && Predictor.IsPressed(); Frame++)
+	{
+		Prediction = Predictor.AddSample(Time, -1.0f - Frame * 0.5f, FVector::ZeroVector, FVector::ForwardVector);
+		Time += FrameInterval;
+	}
+	TestTrue(TEXT("Taken back rather than released"), Prediction == ELeapClickPrediction::Cancel);
+
+	// a press that reaches the widget is released as usual
+	Predictor.Reset();
+	TestTrue(TEXT("Contact presses"),
+		Predictor.AddSample(Time, 0.5f, FVector::ZeroVector, FVector::ForwardVector) == ELeapClickPrediction::Press);
+	TestTrue(TEXT("Confirmed"), Predictor.HasReachedPressThreshold());
+	Time += FrameInterval;
+	TestTrue(TEXT("Released past the hysteresis"),
+		Predictor.AddSample(Time, -PokeReleaseOffset - 0.5f, FVector::ZeroVector, FVector::ForwardVector) ==
+			ELeapClickPrediction::Release);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLeapClickPredictorPinchTest, "UltraleapTracking.Widget.ClickPredictorPinch", ULTRALEAP_TEST_FLAGS)
+
+bool FLeapClickPredictorPinchTest::RunTest(const FString& Parameters)
+{
+	// a full pinch is pressed early and clicks once, on the unpinch rather than the predictor's release
+	const FPinchResult Pinch = RunPinch(1.0f);
+	TestTrue(TEXT("Pinch pressed before the pinch event"), Pinch.bPressedBeforePinch);
+	TestEqual(TEXT("Pinch clicks once"), Pinch.Clicks, 1);
+	TestEqual(TEXT("Pinch not cancelled"), Pinch.Cancels, 0);
+	TestFalse(TEXT("Pinch released"), Pinch.bStuck);
+
+	// a pinch that stops short is pressed early but never confirmed, so the press is taken back
+	const FPinchResult NearMiss = RunPinch(0.75f);
+	TestTrue(TEXT("Near miss pressed early"), NearMiss.bPressedBeforePinch);
+	TestEqual(TEXT("Near miss doesn't click"), NearMiss.Clicks, 0);
+	TestEqual(TEXT("Near miss cancelled"), NearMiss.Cancels, 1);
+	TestFalse(TEXT("Near miss released"), NearMiss.bStuck);
+
+	// the predictor's own release and cancel belong to the pinch events once they have confirmed the press
+	TestTrue(TEXT("Confirmed release left to unpinch"),
+		FLeapClickPredictor::FilterConfirmed(ELeapClickPrediction::Release, true) == ELeapClickPrediction::None);
+	TestTrue(TEXT("Confirmed cancel left to unpinch"),
+		FLeapClickPredictor::FilterConfirmed(ELeapClickPrediction::Cancel, true) == ELeapClickPrediction::None);
+	TestTrue(TEXT("Unconfirmed release cancels"),
+		FLeapClickPredictor::FilterConfirmed(ELeapClickPrediction::Release, false) == ELeapClickPrediction::Cancel);
+	TestTrue(TEXT("Press passes through"),
+		FLeapClickPredictor::FilterConfirmed(ELeapClickPrediction::Press, false) == ELeapClickPrediction::Press);
+	return true;
+}
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,124 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "LeapFramePacer.h"
+#include "Math/RandomStream.h"
+#include "Tests/UltraleapTestFlags.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+const float FrameTime = 1.0f / 90.0f;
+
+float GetOffset(const FLeapFramePacer& Pacer)
+{
+	return Pacer.GetInterpolationOffset() * 1.0e-6f;
+}
+}	 // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLeapFramePacerSmoothingTest, "UltraleapTracking.Pacing.FramePacerSmoothing", ULTRALEAP_TEST_FLAGS)
+
+bool FLeapFramePacerSmoothingTest::RunTest(const FString& Parameters)
+{
+	FLeapFramePacer Pacer;
+	Pacer.SetLimits(1.0f, 100.0f);
+
+	// the first measurement is taken as is
+	Pacer.Update(FrameTime, 0.02f);
+	TestEqual(TEXT("First estimate"), Pacer.GetDisplayLatency(), 0.02f);
+	TestEqual(TEXT("First offset"), GetOffset(Pacer), 0.02f, 1.0e-6f);
+
+	// then each one moves the estimate a little of the way
+	Pacer.Update(FrameTime, 0.04f);
+	TestEqual(TEXT("Smoothed step"), Pacer.GetDisplayLatency(), 0.02f + FLeapFramePacer::LatencySmoothing * 0.02f, 1.0e-6f);
+
+	// jittery frame times around 40ms settle on 40ms
+	FRandomStream Random(50);
+	float MinLatency = MAX_flt;
+	float MaxLatency = 0;
+	for (int32 Frame = 0; Frame < 900; Frame++)
+	{
+		Pacer.Update(FrameTime, 0.04f + Random.FRandRange(-0.01f, 0.01f));
+		if (Frame > 300)
+		{
+			MinLatency = FMath::Min(MinLatency, Pacer.GetDisplayLatency());
+			MaxLatency = FMath::Max(MaxLatency, Pacer.GetDisplayLatency());
+		}
+	}
+	AddInfo(FString::Printf(TEXT("10ms of frame time jitter leaves %.2fms in the estimate"), (MaxLatency - MinLatency) * 1000.0f));
+	TestTrue(TEXT("Settles on the mean"), FMath::Abs(Pacer.GetDisplayLatency() - 0.04f) < 0.004f);
+	TestTrue(TEXT("Jitter is smoothed"), MaxLatency - MinLatency < 0.008f);
+
+	// a hitch only counts as far as the measurement limit
+	const float Before = Pacer.GetDisplayLatency();
+	Pacer.Update(FrameTime, 1.0f);
+	const float Limit = Before + FLeapFramePacer::LatencySmoothing * (FLeapFramePacer::MaxMeasuredLatency - Before);
+	TestTrue(TEXT("Hitch is limited"), Pacer.GetDisplayLatency() <= Limit + 1.0e-6f);
+
+	// frames without a time don't count
+	const float Latency = Pacer.GetDisplayLatency();
+	Pacer.Update(0.0f, 0.09f);
+	TestEqual(TEXT("Zero delta time ignored"), Pacer.GetDisplayLatency(), Latency);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLeapFramePacerStepLimitTest, "UltraleapTracking.Pacing.FramePacerStepLimit", ULTRALEAP_TEST_FLAGS)
+
+bool FLeapFramePacerStepLimitTest::RunTest(const FString& Parameters)
+{
+	FLeapFramePacer Pacer;
+	Pacer.SetLimits(1.0f, 60.0f);
+	Pacer.Update(FrameTime, 0.005f);
+
+	// latency jumps from 5ms to 50ms, the offset has to walk there
+	float Previous = GetOffset(Pacer);
+	float LargestStep = 0;
+	int32 FramesToSettle = -1;
+	for (int32 Frame = 0; Frame < 300; Frame++)
+	{
+		Pacer.Update(FrameTime, 0.05f);
+		const float Offset = GetOffset(Pacer);
+		LargestStep = FMath::Max(LargestStep, FMath::Abs(Offset - Previous));
+		if (!TestTrue(TEXT("Offset only moves towards the latency"), Offset >= Previous - 1.0e-6f))
+		{
+			return false;
+		}
+		if (FramesToSettle < 0 && FMath::Abs(Offset - 0.05f) < 0.0005f)
+		{
+			FramesToSettle = Frame;
+		}
+		Previous = Offset;
+	}
+	AddInfo(FString::Printf(TEXT("Largest step %.3fms, settled after %d frames"), LargestStep * 1000.0f, FramesToSettle));
+	// smoothing alone would move it 2.25ms on the first frame. Offsets are whole microseconds
+	TestTrue(TEXT("Moves at most 1ms per frame"), LargestStep <= FLeapFramePacer::MaxOffsetStep + 2.0e-6f);
+	TestTrue(TEXT("Reaches the new latency"), FramesToSettle > 0);
+
+	// scale and lead limit
+	Pacer.SetLimits(0.5f, 60.0f);
+	for (int32 Frame = 0; Frame < 300; Frame++)
+	{
+		Pacer.Update(FrameTime, 0.05f);
+	}
+	TestEqual(TEXT("Scaled"), GetOffset(Pacer), 0.025f, 2.0e-6f);
+	Pacer.SetLimits(1.0f, 30.0f);
+	for (int32 Frame = 0; Frame < 300; Frame++)
+	{
+		Pacer.Update(FrameTime, 0.05f);
+	}
+	TestEqual(TEXT("Capped at the max lead"), GetOffset(Pacer), 0.03f, 2.0e-6f);
+
+	FLeapStats Stats;
+	Pacer.GetStats(Stats);
+	TestEqual(TEXT("Reported offset"), Stats.InterpolationOffsetInMS, 30.0f, 0.01f);
+	TestEqual(TEXT("Reported latency"), Stats.DisplayLatencyInMS, 50.0f, 0.01f);
+	return true;
+}
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
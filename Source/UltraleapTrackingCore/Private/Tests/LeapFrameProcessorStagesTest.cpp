@@ -0,0 +1,206 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "LeapFrameProcessor.h"
+#include "Tests/UltraleapTestFlags.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+const FVector Palm(30.0f, 10.0f, 20.0f);
+// clamp box the scaled palm leaves on X only
+const FBox Bounds(FVector(-50.0f, -50.0f, -50.0f), FVector(50.0f, 50.0f, 50.0f));
+
+// a left hand turned off every axis so mirroring changes all of it, fingers 3cm bones along the palm's forward axis
+void MakeFrame(FLeapFrameData& Frame)
+{
+	const FQuat Rotation = FRotator(20.0f, 35.0f, -15.0f).Quaternion();
+	Frame.Hands.SetNum(1);
+	Frame.LeftHandVisible = true;
+	Frame.RightHandVisible = false;
+	FLeapHandData& Hand = Frame.Hands[0];
+	Hand.InitFromEmpty(EHandType::LEAP_HAND_LEFT, 1);
+	Hand.Palm.Position = Palm;
+	Hand.Palm.StabilizedPosition = Palm;
+	Hand.Palm.Velocity = FVector(5.0f, -3.0f, 1.0f);
+	Hand.Palm.Orientation = Rotation.Rotator();
+	Hand.Palm.Direction = Rotation.GetForwardVector();
+	Hand.Palm.Normal = -Rotation.GetUpVector();
+	Hand.Arm.PrevJoint = Palm + Rotation.RotateVector(FVector(-30.0f, 0, 0));
+	Hand.Arm.NextJoint = Palm + Rotation.RotateVector(FVector(-6.0f, 0, 0));
+	Hand.Arm.Rotation = Hand.Palm.Orientation;
+	for (int32 Digit = 0; Digit < 5; ++Digit)
+	{
+		FVector Joint = Palm + Rotation.RotateVector(FVector(-4.0f, (Digit - 2) * 2.0f, 0));
+		for (int32 Bone = 0; Bone < 4; ++Bone)
+		{
+			FLeapBoneData& BoneData = Hand.Digits[Digit].Bones[Bone];
+			BoneData.PrevJoint = Joint;
+			Joint += Rotation.RotateVector(FVector(3.0f, 0, 0));
+			BoneData.NextJoint = Joint;
+			BoneData.Rotation = Hand.Palm.Orientation;
+		}
+	}
+	Hand.UpdateFromDigits();
+}
+
+bool RotatorsEqual(const FRotator& A, const FRotator& B)
+{
+	return A.Quaternion().AngularDistance(B.Quaternion()) < 1.0e-3f;
+}
+
+void TestHandsEqual(FAutomationTestBase& Test, const TCHAR* What, const FLeapHandData& A, const FLeapHandData& B)
+{
+	bool bEqual = A.HandType == B.HandType && A.Palm.Position.Equals(B.Palm.Position, 1.0e-3f) &&
+				  A.Palm.Velocity.Equals(B.Palm.Velocity, 1.0e-3f) && A.Palm.Normal.Equals(B.Palm.Normal, 1.0e-4f) &&
+				  A.Palm.Direction.Equals(B.Palm.Direction, 1.0e-4f) && RotatorsEqual(A.Palm.Orientation, B.Palm.Orientation) &&
+				  A.Arm.PrevJoint.Equals(B.Arm.PrevJoint, 1.0e-3f) && A.Arm.NextJoint.Equals(B.Arm.NextJoint, 1.0e-3f);
+	for (int32 Digit = 0; Digit < 5; ++Digit)
+	{
+		for (int32 Bone = 0; Bone < 4; ++Bone)
+		{
+			const FLeapBoneData& BoneA = A.Digits[Digit].Bones[Bone];
+			const FLeapBoneData& BoneB = B.Digits[Digit].Bones[Bone];
+			bEqual &= BoneA.PrevJoint.Equals(BoneB.PrevJoint, 1.0e-3f) && BoneA.NextJoint.Equals(BoneB.NextJoint, 1.0e-3f) &&
+					  RotatorsEqual(BoneA.Rotation, BoneB.Rotation);
+		}
+	}
+	Test.TestTrue(What, bEqual);
+}
+
+// the hand's shape, every joint relative to the palm
+bool SameShape(const FLeapHandData& A, const FLeapHandData& B, const float Scale)
+{
+	bool bSame = true;
+	for (int32 Digit = 0; Digit < 5; ++Digit)
+	{
+		for (int32 Bone = 0; Bone < 4; ++Bone)
+		{
+			const FVector OffsetA = A.Digits[Digit].Bones[Bone].NextJoint - A.Palm.Position;
+			const FVector OffsetB = B.Digits[Digit].Bones[Bone].NextJoint - B.Palm.Position;
+			bSame &= OffsetB.Equals(OffsetA * Scale, 1.0e-3f);
+		}
+	}
+	return bSame;
+}
+}	 // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLeapMirrorFrameProcessorTest, "UltraleapTracking.Processing.MirrorStage", ULTRALEAP_TEST_FLAGS)
+
+bool FLeapMirrorFrameProcessorTest::RunTest(const FString& Parameters)
+{
+	FLeapFrameData Original;
+	MakeFrame(Original);
+	FLeapFrameData Frame = Original;
+	FLeapMirrorFrameProcessor Mirror;
+
+	Mirror.Process(Frame, 0.011f);
+	const FLeapHandData& Mirrored = Frame.Hands[0];
+	TestTrue(TEXT("Becomes a right hand"), Mirrored.HandType == EHandType::LEAP_HAND_RIGHT);
+	TestTrue(TEXT("Visibility swapped"), Frame.RightHandVisible && !Frame.LeftHandVisible);
+	TestEqual(TEXT("Palm mirrored across XZ"), Mirrored.Palm.Position, FVector(Palm.X, -Palm.Y, Palm.Z));
+	// a reflection keeps bone lengths
+	TestEqual(TEXT("Bone length kept"), FVector::Dist(Mirrored.Index.Distal.PrevJoint, Mirrored.Index.Distal.NextJoint), 3.0f,
+		1.0e-3f);
+	// rotations are mirrored to match the joints: the mirrored palm rotation takes forward to the mirrored direction
+	TestTrue(TEXT("Orientation follows the joints"),
+		Mirrored.Palm.Orientation.Quaternion().GetForwardVector().Equals(Mirrored.Palm.Direction, 1.0e-3f));
+
+	Mirror.Process(Frame, 0.011f);
+	TestHandsEqual(*this, TEXT("Mirroring twice gives the original hand"), Frame.Hands[0], Original.Hands[0]);
+	TestTrue(TEXT("Mirroring twice gives the original visibility"), Frame.LeftHandVisible && !Frame.RightHandVisible);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLeapClampScaleFrameProcessorTest, "UltraleapTracking.Processing.ClampAndScaleStages",
+	ULTRALEAP_TEST_FLAGS)
+
+bool FLeapClampScaleFrameProcessorTest::RunTest(const FString& Parameters)
+{
+	FLeapFrameData Original;
+	MakeFrame(Original);
+
+	// scale is about the tracking origin, the whole hand grows
+	FLeapScaleFrameProcessor Scale;
+	Scale.SetScale(2.0f);
+	FLeapFrameData Frame = Original;
+	Scale.Process(Frame, 0.011f);
+	TestEqual(TEXT("Palm scaled"), Frame.Hands[0].Palm.Position, Palm * 2.0f);
+	TestTrue(TEXT("Hand scaled"), SameShape(Original.Hands[0], Frame.Hands[0], 2.0f));
+
+	// clamp moves the hand back inside without changing its shape
+	FLeapClampFrameProcessor Clamp;
+	Clamp.SetBounds(Bounds);
+	const FLeapHandData Scaled = Frame.Hands[0];
+	Clamp.Process(Frame, 0.011f);
+	TestEqual(TEXT("Scaled then clamped palm"), Frame.Hands[0].Palm.Position, FVector(50.0f, 20.0f, 40.0f));
+	TestTrue(TEXT("Clamp keeps the shape"), SameShape(Scaled, Frame.Hands[0], 1.0f));
+
+	// inside the box, or without one, the hand is left alone
+	Frame = Original;
+	Clamp.Process(Frame, 0.011f);
+	TestHandsEqual(*this, TEXT("Hand inside the bounds untouched"), Frame.Hands[0], Original.Hands[0]);
+	FLeapClampFrameProcessor Unbounded;
+	Frame = Original;
+	Frame.Hands[0].TranslateHand(FVector(1000.0f, 0, 0));
+	const FLeapHandData Far = Frame.Hands[0];
+	Unbounded.Process(Frame, 0.011f);
+	TestHandsEqual(*this, TEXT("No bounds, no clamp"), Frame.Hands[0], Far);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLeapFrameProcessorChainOrderTest, "UltraleapTracking.Processing.ChainOrder", ULTRALEAP_TEST_FLAGS)
+
+bool FLeapFrameProcessorChainOrderTest::RunTest(const FString& Parameters)
+{
+	TSharedPtr<FLeapScaleFrameProcessor> Scale = MakeShareable(new FLeapScaleFrameProcessor());
+	Scale->SetScale(2.0f);
+	TSharedPtr<FLeapClampFrameProcessor> Clamp = MakeShareable(new FLeapClampFrameProcessor());
+	Clamp->SetBounds(Bounds);
+	TSharedPtr<FLeapMirrorFrameProcessor> Mirror = MakeShareable(new FLeapMirrorFrameProcessor());
+	TSharedPtr<FLeapMirrorFrameProcessor> OtherMirror = MakeShareable(new FLeapMirrorFrameProcessor());
+
+	FLeapFrameData Original;
+	MakeFrame(Original);
+
+	// stages run in the order they were added: the palm is scaled out of the box, then clamped back
+	FLeapFrameProcessorChain Chain;
+	Chain.Add(Scale);
+	Chain.Add(Clamp);
+	FLeapFrameData Frame = Original;
+	Chain.Process(Frame, 0.011f);
+	TestEqual(TEXT("Scale then clamp"), Frame.Hands[0].Palm.Position, FVector(50.0f, 20.0f, 40.0f));
+
+	// the other way round the palm is inside the box when clamped, then scaled past it
+	Chain.Empty();
+	Chain.Add(Clamp);
+	Chain.Add(Scale);
+	Frame = Original;
+	Chain.Process(Frame, 0.011f);
+	TestEqual(TEXT("Clamp then scale"), Frame.Hands[0].Palm.Position, Palm * 2.0f);
+
+	// mirror twice anywhere in the chain cancels out, invalid stages aren't added
+	Chain.Empty();
+	Chain.Add(Mirror);
+	Chain.Add(nullptr);
+	Chain.Add(OtherMirror);
+	TestEqual(TEXT("Invalid stage skipped"), Chain.Num(), 2);
+	Frame = Original;
+	Chain.Process(Frame, 0.011f);
+	TestHandsEqual(*this, TEXT("Mirror twice in a chain"), Frame.Hands[0], Original.Hands[0]);
+
+	TestTrue(TEXT("Stage removed"), Chain.Remove(OtherMirror));
+	TestEqual(TEXT("One mirror left"), Chain.Num(), 1);
+	Frame = Original;
+	Chain.Process(Frame, 0.011f);
+	TestTrue(TEXT("Single mirror swaps the hand"), Frame.Hands[0].HandType == EHandType::LEAP_HAND_RIGHT);
+	return true;
+}
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
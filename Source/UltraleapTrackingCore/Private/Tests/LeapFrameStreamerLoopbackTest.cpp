@@ -0,0 +1,346 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "Common/TcpSocketBuilder.h"
+#include "Common/UdpSocketBuilder.h"
+#include "LeapFrameStreamer.h"
+#include "Serialization/MemoryReader.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+#include "Tests/UltraleapTestFlags.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+const int32 FirstTestPort = 47391;
+const int32 NumPortsToTry = 8;
+const double ReceiveTimeout = 2.0;
+// throughput run, frames pushed once a millisecond, well past any tracking rate
+const double ThroughputRunTime = 1.0;
+const double PushInterval = 0.001;
+
+const int32 HeaderSize = 28;
+const int32 HandSize = 616;
+// id, type, extended bits, reserved, then 7 floats
+const int32 PalmPositionOffset = 36;
+
+struct FTestFrame
+{
+	LEAP_TRACKING_EVENT Event;
+	LEAP_HAND Hands[2];
+};
+
+void SetLeapVector(LEAP_VECTOR& Vector, const float X, const float Y, const float Z)
+{
+	Vector.x = X;
+	Vector.y = Y;
+	Vector.z = Z;
+}
+
+void MakeFrame(FTestFrame& Frame)
+{
+	FMemory::Memzero(Frame);
+	Frame.Event.pHands = Frame.Hands;
+	Frame.Event.nHands = 2;
+	Frame.Event.tracking_frame_id = 1234;
+	Frame.Event.info.timestamp = 987654321;
+	Frame.Hands[0].id = 11;
+	Frame.Hands[0].type = eLeapHandType_Left;
+	SetLeapVector(Frame.Hands[0].palm.position, 100.0f, -200.0f, 300.0f);
+	Frame.Hands[1].id = 12;
+	Frame.Hands[1].type = eLeapHandType_Right;
+	SetLeapVector(Frame.Hands[1].palm.position, -50.0f, 250.0f, 125.0f);
+}
+
+FLeapFrameStreamer* StartStreamer(TUniquePtr<FLeapFrameStreamer>& Streamer, int32& OutPort)
+{
+	// another process may hold the port, so try a few
+	Streamer = MakeUnique<FLeapFrameStreamer>();
+	for (OutPort = FirstTestPort; OutPort < FirstTestPort + NumPortsToTry; OutPort++)
+	{
+		if (Streamer->Start(OutPort, true, FString()))
+		{
+			return Streamer.Get();
+		}
+	}
+	return nullptr;
+}
+
+TSharedRef<FInternetAddr> MakeLoopbackAddress(const int32 Port)
+{
+	TSharedRef<FInternetAddr> Address = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+	Address->SetLoopbackAddress();
+	Address->SetPort(Port);
+	return Address;
+}
+
+// subscribers are picked up by the worker thread, frames pushed before then are skipped
+bool WaitForSubscribers(FLeapFrameStreamer& Streamer, const int32 NumExpected)
+{
+	const double Deadline = FPlatformTime::Seconds() + ReceiveTimeout;
+	FLeapStats Stats;
+	while (FPlatformTime::Seconds() < Deadline)
+	{
+		Streamer.GetStats(Stats);
+		if (Stats.StreamSubscribers >= NumExpected)
+		{
+			return true;
+		}
+		FPlatformProcess::Sleep(0.005f);
+	}
+	return false;
+}
+
+bool ReceiveExactly(FSocket& Socket, uint8* Data, const int32 Num)
+{
+	int32 Received = 0;
+	const double Deadline = FPlatformTime::Seconds() + ReceiveTimeout;
+	while (Received < Num && FPlatformTime::Seconds() < Deadline)
+	{
+		int32 BytesRead = 0;
+		if (Socket.Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(10)) &&
+			Socket.Recv(Data + Received, Num - Received, BytesRead) && BytesRead > 0)
+		{
+			Received += BytesRead;
+		}
+	}
+	return Received == Num;
+}
+
+FVector ReadVector(FMemoryReader& Reader)
+{
+	float X, Y, Z;
+	Reader << X << Y << Z;
+	return FVector(X, Y, Z);
+}
+
+// checks a packet without its TCP length prefix against MakeFrame
+void TestPacket(FAutomationTestBase& Test, const TArray<uint8>& Packet, const FTestFrame& Frame)
+{
+	if (!Test.TestEqual(TEXT("Packet size"), Packet.Num(), HeaderSize + 2 * HandSize))
+	{
+		return;
+	}
+	FMemoryReader Reader(Packet);
+	uint32 Magic = 0;
+	uint16 Version = 0;
+	uint8 NumHands = 0;
+	uint8 Reserved = 0;
+	int32 FrameId = 0;
+	int64 TimeStamp = 0;
+	int64 SendTime = 0;
+	Reader << Magic << Version << NumHands << Reserved << FrameId << TimeStamp << SendTime;
+	Test.TestEqual(TEXT("Magic"), Magic, FLeapFrameStreamer::StreamMagic);
+	Test.TestEqual(TEXT("Version"), Version, FLeapFrameStreamer::StreamVersion);
+	Test.TestEqual(TEXT("Hand count"), (int32) NumHands, 2);
+	Test.TestEqual(TEXT("Frame id"), FrameId, (int32) Frame.Event.tracking_frame_id);
+	Test.TestEqual(TEXT("Timestamp"), TimeStamp, Frame.Event.info.timestamp);
+
+	for (int32 Hand = 0; Hand < 2; Hand++)
+	{
+		Reader.Seek(HeaderSize + Hand * HandSize);
+		int32 Id = 0;
+		uint8 HandType = 0;
+		Reader << Id << HandType;
+		Test.TestEqual(TEXT("Hand id"), Id, (int32) Frame.Hands[Hand].id);
+		Test.TestEqual(TEXT("Hand type"), (int32) HandType, Hand);
+
+		Reader.Seek(HeaderSize + Hand * HandSize + PalmPositionOffset);
+		// LeapC tracking space as the device reported it
+		const LEAP_VECTOR& Palm = Frame.Hands[Hand].palm.position;
+		Test.TestEqual(TEXT("Palm position"), ReadVector(Reader), FVector(Palm.x, Palm.y, Palm.z));
+	}
+}
+}	 // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLeapFrameStreamerUdpLoopbackTest, "UltraleapTracking.Streaming.UdpLoopback", ULTRALEAP_TEST_FLAGS)
+
+bool FLeapFrameStreamerUdpLoopbackTest::RunTest(const FString& Parameters)
+{
+	TUniquePtr<FLeapFrameStreamer> Streamer;
+	int32 Port = 0;
+	if (!TestNotNull(TEXT("Streamer started"), StartStreamer(Streamer, Port)))
+	{
+		return false;
+	}
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	FSocket* Client = FUdpSocketBuilder(TEXT("UltraleapStreamTestUdp")).AsNonBlocking().BoundToPort(0).Build();
+	if (!TestNotNull(TEXT("Client socket"), Client))
+	{
+		return false;
+	}
+
+	// any datagram subscribes
+	uint8 Subscribe = 1;
+	int32 BytesSent = 0;
+	Client->SendTo(&Subscribe, 1, BytesSent, *MakeLoopbackAddress(Port));
+	TestTrue(TEXT("Subscribed"), WaitForSubscribers(*Streamer, 1));
+
+	FTestFrame Frame;
+	MakeFrame(Frame);
+	Streamer->PushFrame(Frame.Event, Frame.Event.info.timestamp + 100);
+
+	TArray<uint8> Datagram;
+	Datagram.SetNumUninitialized(2048);
+	int32 BytesRead = 0;
+	TSharedRef<FInternetAddr> Sender = SocketSubsystem->CreateInternetAddr();
+	const bool bReceived = Client->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromSeconds(ReceiveTimeout)) &&
+						   Client->RecvFrom(Datagram.GetData(), Datagram.Num(), BytesRead, *Sender);
+	if (TestTrue(TEXT("Datagram received"), bReceived))
+	{
+		Datagram.SetNum(BytesRead);
+		TestPacket(*this, Datagram, Frame);
+	}
+
+	// the worker counts after sending, so read the counters once it has exited
+	Streamer->Shutdown();
+	FLeapStats Stats;
+	Streamer->GetStats(Stats);
+	TestEqual(TEXT("Frames sent"), Stats.StreamFramesSent, 1);
+	TestEqual(TEXT("Frames dropped"), Stats.StreamFramesDropped, 0);
+
+	SocketSubsystem->DestroySocket(Client);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FLeapFrameStreamerUdpThroughputTest, "UltraleapTracking.Streaming.UdpThroughput", ULTRALEAP_TEST_FLAGS)
+
+bool FLeapFrameStreamerUdpThroughputTest::RunTest(const FString& Parameters)
+{
+	TUniquePtr<FLeapFrameStreamer> Streamer;
+	int32 Port = 0;
+	if (!TestNotNull(TEXT("Streamer started"), StartStreamer(Streamer, Port)))
+	{
+		return false;
+	}
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	FSocket* Client = FUdpSocketBuilder(TEXT("UltraleapStreamTestUdpThroughput"))
+						  .AsNonBlocking()
+						  .BoundToPort(0)
+						  .WithReceiveBufferSize(256 * 1024)
+						  .Build();
+	if (!TestNotNull(TEXT("Client socket"), Client))
+	{
+		return false;
+	}
+	uint8 Subscribe = 1;
+	int32 BytesSent = 0;
+	Client->SendTo(&Subscribe, 1, BytesSent, *MakeLoopbackAddress(Port));
+	TestTrue(TEXT("Subscribed"), WaitForSubscribers(*Streamer, 1));
+
+	// pushed from this thread as the game thread would, received here as well so the socket buffer never fills
+	FTestFrame Frame;
+	MakeFrame(Frame);
+	TArray<uint8> Datagram;
+	Datagram.SetNumUninitialized(2048);
+	TSharedRef<FInternetAddr> Sender = SocketSubsystem->CreateInternetAddr();
+	int32 NumPushed = 0;
+	int32 NumReceived = 0;
+	const double Start = FPlatformTime::Seconds();
+	while (FPlatformTime::Seconds() - Start < ThroughputRunTime)
+	{
+		Frame.Event.tracking_frame_id++;
+		Frame.Event.info.timestamp += 1000;
+		Streamer->PushFrame(Frame.Event, Frame.Event.info.timestamp + 100);
+		NumPushed++;
+
+		// spun rather than slept, sleeps can be far coarser than a millisecond
+		const double NextPush = Start + NumPushed * PushInterval;
+		while (FPlatformTime::Seconds() < NextPush)
+		{
+			int32 BytesRead = 0;
+			if (Client->RecvFrom(Datagram.GetData(), Datagram.Num(), BytesRead, *Sender) && BytesRead > 0)
+			{
+				NumReceived++;
+			}
+		}
+	}
+	// let the last packets arrive
+	const double Deadline = FPlatformTime::Seconds() + 0.1;
+	while (FPlatformTime::Seconds() < Deadline)
+	{
+		int32 BytesRead = 0;
+		if (Client->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(10)) &&
+			Client->RecvFrom(Datagram.GetData(), Datagram.Num(), BytesRead, *Sender) && BytesRead > 0)
+		{
+			NumReceived++;
+		}
+	}
+	const double Elapsed = FPlatformTime::Seconds() - Start;
+
+	FLeapStats Stats;
+	Streamer->GetStats(Stats);
+	Streamer->Shutdown();
+	SocketSubsystem->DestroySocket(Client);
+
+	const double SentPerSecond = Stats.StreamFramesSent / Elapsed;
+	AddInfo(FString::Printf(TEXT("%d frames pushed in %.2fs: %.0f sent/s, %.0f received/s, %d dropped, queue to send %.3fms"),
+		NumPushed, Elapsed, SentPerSecond, NumReceived / Elapsed, Stats.StreamFramesDropped, Stats.StreamLatencyInMS));
+	// loose so a loaded machine doesn't fail it, the worker should keep up with several times the fastest tracking rate
+	TestTrue(TEXT("Streams at least 200 frames per second"), SentPerSecond >= 200.0);
+	TestTrue(TEXT("Received most of what was sent"), NumReceived >= Stats.StreamFramesSent * 9 / 10);
+	TestTrue(TEXT("Queue to send under 5ms"), Stats.StreamLatencyInMS < 5.0f);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLeapFrameStreamerTcpLoopbackTest, "UltraleapTracking.Streaming.TcpLoopback", ULTRALEAP_TEST_FLAGS)
+
+bool FLeapFrameStreamerTcpLoopbackTest::RunTest(const FString& Parameters)
+{
+	TUniquePtr<FLeapFrameStreamer> Streamer;
+	int32 Port = 0;
+	if (!TestNotNull(TEXT("Streamer started"), StartStreamer(Streamer, Port)))
+	{
+		return false;
+	}
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	FSocket* Client = FTcpSocketBuilder(TEXT("UltraleapStreamTestTcp")).Build();
+	if (!TestNotNull(TEXT("Client socket"), Client) || !TestTrue(TEXT("Connected"), Client->Connect(*MakeLoopbackAddress(Port))))
+	{
+		if (Client)
+		{
+			SocketSubsystem->DestroySocket(Client);
+		}
+		return false;
+	}
+	TestTrue(TEXT("Accepted"), WaitForSubscribers(*Streamer, 1));
+
+	// two frames back to back, each framed by its length
+	FTestFrame Frame;
+	MakeFrame(Frame);
+	for (int32 Index = 0; Index < 2; Index++)
+	{
+		// repeats of a timestamp are skipped
+		Frame.Event.tracking_frame_id = 1234 + Index;
+		Frame.Event.info.timestamp += 11111;
+		Streamer->PushFrame(Frame.Event, Frame.Event.info.timestamp + 100);
+
+		uint16 Length = 0;
+		TArray<uint8> Packet;
+		if (!TestTrue(TEXT("Length received"), ReceiveExactly(*Client, (uint8*) &Length, sizeof(Length))))
+		{
+			break;
+		}
+		Packet.SetNumUninitialized(Length);
+		if (TestTrue(TEXT("Packet received"), ReceiveExactly(*Client, Packet.GetData(), Length)))
+		{
+			TestPacket(*this, Packet, Frame);
+		}
+	}
+
+	Streamer->Shutdown();
+	SocketSubsystem->DestroySocket(Client);
+	return true;
+}
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
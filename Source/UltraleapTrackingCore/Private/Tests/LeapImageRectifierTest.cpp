@@ -0,0 +1,245 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "HAL/PlatformTime.h"
+#include "LeapImageRectifier.h"
+#include "Tests/UltraleapTestFlags.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+const int32 ImageSize = 64;
+// slope range covered by the distortion grid, see LeapImageRectifier.cpp
+const float GridSlopeRange = 4.f;
+
+// A calibration where normalized image position is linear in ray slope, XOffset shifts it off the sensor
+void MakeLinearMatrix(LEAP_DISTORTION_MATRIX& Matrix, const float XOffset)
+{
+	const int32 N = LEAP_DISTORTION_MATRIX_N;
+	for (int32 Row = 0; Row < N; Row++)
+	{
+		for (int32 Column = 0; Column < N; Column++)
+		{
+			Matrix.matrix[Row][Column].x = (float) Column / (N - 1) + XOffset;
+			Matrix.matrix[Row][Column].y = (float) Row / (N - 1);
+		}
+	}
+}
+
+// Smooth gradient so a 1/256 weight step is never more than one grey level
+void MakeGradientImage(TArray<uint8>& Image)
+{
+	Image.SetNumUninitialized(ImageSize * ImageSize);
+	for (int32 Y = 0; Y < ImageSize; Y++)
+	{
+		for (int32 X = 0; X < ImageSize; X++)
+		{
+			Image[Y * ImageSize + X] = (uint8) (X * 2 + Y);
+		}
+	}
+}
+
+// Float bilinear sample at pixel centre coordinates, the golden the fixed point remap is checked against
+float SampleBilinear(const TArray<uint8>& Image, const float X, const float Y)
+{
+	const float ClampedX = FMath::Clamp(X, 0.f, ImageSize - 1.f);
+	const float ClampedY = FMath::Clamp(Y, 0.f, ImageSize - 1.f);
+	const int32 X0 = FMath::Min(FMath::FloorToInt(ClampedX), ImageSize - 2);
+	const int32 Y0 = FMath::Min(FMath::FloorToInt(ClampedY), ImageSize - 2);
+	const float Fx = ClampedX - X0;
+	const float Fy = ClampedY - Y0;
+	const float Top = FMath::Lerp((float) Image[Y0 * ImageSize + X0], (float) Image[Y0 * ImageSize + X0 + 1], Fx);
+	const float Bottom =
+		FMath::Lerp((float) Image[(Y0 + 1) * ImageSize + X0], (float) Image[(Y0 + 1) * ImageSize + X0 + 1], Fx);
+	return FMath::Lerp(Top, Bottom, Fy);
+}
+}	 // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FLeapImageRectifierIdentityTest, "UltraleapTracking.Images.Rectifier.Identity", ULTRALEAP_TEST_FLAGS)
+
+bool FLeapImageRectifierIdentityTest::RunTest(const FString& Parameters)
+{
+	// the whole grid range onto an image the size of the source is a 1:1 remap
+	LEAP_DISTORTION_MATRIX* Matrix = new LEAP_DISTORTION_MATRIX;
+	MakeLinearMatrix(*Matrix, 0.f);
+	const FLeapImageRectifier::FLookupTablePtr Table =
+		FLeapImageRectifier::BuildLookupTable(*Matrix, 1, ImageSize, ImageSize, ImageSize, ImageSize, GridSlopeRange);
+	delete Matrix;
+
+	TArray<uint8> Source;
+	MakeGradientImage(Source);
+	TArray<uint8> Rectified;
+	Rectified.SetNumZeroed(ImageSize * ImageSize);
+	FLeapImageRectifier::Rectify(Source.GetData(), *Table, Rectified.GetData());
+
+	int32 MaxError = 0;
+	for (int32 Index = 0; Index < Source.Num(); Index++)
+	{
+		MaxError = FMath::Max(MaxError, FMath::Abs((int32) Rectified[Index] - (int32) Source[Index]));
+	}
+	TestTrue(FString::Printf(TEXT("Identity remap within one grey level (max error %d)"), MaxError), MaxError <= 1);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FLeapImageRectifierGoldenTest, "UltraleapTracking.Images.Rectifier.Golden", ULTRALEAP_TEST_FLAGS)
+
+bool FLeapImageRectifierGoldenTest::RunTest(const FString& Parameters)
+{
+	// half the field of view magnifies the centre of the image 2x onto a non square output
+	const int32 Width = 48;
+	const int32 Height = 40;
+	const float MaxSlope = GridSlopeRange * 0.5f;
+	LEAP_DISTORTION_MATRIX* Matrix = new LEAP_DISTORTION_MATRIX;
+	MakeLinearMatrix(*Matrix, 0.f);
+	const FLeapImageRectifier::FLookupTablePtr Table =
+		FLeapImageRectifier::BuildLookupTable(*Matrix, 1, ImageSize, ImageSize, Width, Height, MaxSlope);
+	delete Matrix;
+
+	TestEqual(TEXT("Table width"), Table->Width, Width);
+	TestEqual(TEXT("Table height"), Table->Height, Height);
+	TestEqual(TEXT("Table entries"), Table->Entries.Num(), Width * Height);
+
+	TArray<uint8> Source;
+	MakeGradientImage(Source);
+	TArray<uint8> Rectified;
+	Rectified.SetNumZeroed(Width * Height);
+	FLeapImageRectifier::Rectify(Source.GetData(), *Table, Rectified.GetData());
+
+	int32 MaxError = 0;
+	for (int32 Y = 0; Y < Height; Y++)
+	{
+		const float SlopeY = ((Y + 0.5f) / Height * 2.f - 1.f) * MaxSlope;
+		const float SrcY = (SlopeY / (2.f * GridSlopeRange) + 0.5f) * ImageSize - 0.5f;
+		for (int32 X = 0; X < Width; X++)
+		{
+			const float SlopeX = ((X + 0.5f) / Width * 2.f - 1.f) * MaxSlope;
+			const float SrcX = (SlopeX / (2.f * GridSlopeRange) + 0.5f) * ImageSize - 0.5f;
+			const int32 Golden = FMath::RoundToInt(SampleBilinear(Source, SrcX, SrcY));
+			MaxError = FMath::Max(MaxError, FMath::Abs((int32) Rectified[Y * Width + X] - Golden));
+		}
+	}
+	TestTrue(FString::Printf(TEXT("Remap matches float bilinear golden (max error %d)"), MaxError), MaxError <= 1);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FLeapImageRectifierMaskTest, "UltraleapTracking.Images.Rectifier.MissedRaysMasked", ULTRALEAP_TEST_FLAGS)
+
+bool FLeapImageRectifierMaskTest::RunTest(const FString& Parameters)
+{
+	// shifted half a sensor left, rays on the left half of the grid miss the sensor
+	LEAP_DISTORTION_MATRIX* Matrix = new LEAP_DISTORTION_MATRIX;
+	MakeLinearMatrix(*Matrix, -0.5f);
+	const FLeapImageRectifier::FLookupTablePtr Table =
+		FLeapImageRectifier::BuildLookupTable(*Matrix, 1, ImageSize, ImageSize, ImageSize, ImageSize, GridSlopeRange);
+	delete Matrix;
+
+	TArray<uint8> Source;
+	Source.Init(200, ImageSize * ImageSize);
+	TArray<uint8> Rectified;
+	Rectified.SetNumZeroed(ImageSize * ImageSize);
+	FLeapImageRectifier::Rectify(Source.GetData(), *Table, Rectified.GetData());
+
+	bool bLeftMasked = true;
+	bool bRightSampled = true;
+	for (int32 Y = 0; Y < ImageSize; Y++)
+	{
+		// stay a pixel clear of the boundary, the grid is bilinear across it
+		for (int32 X = 0; X < ImageSize / 2 - 1; X++)
+		{
+			bLeftMasked &= Rectified[Y * ImageSize + X] == 0;
+		}
+		for (int32 X = ImageSize / 2 + 1; X < ImageSize; X++)
+		{
+			bRightSampled &= Rectified[Y * ImageSize + X] == 200;
+		}
+	}
+	TestTrue(TEXT("Rays off the sensor are black"), bLeftMasked);
+	TestTrue(TEXT("Rays on the sensor are sampled"), bRightSampled);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FLeapImageRectifierBenchmarkTest, "UltraleapTracking.Images.Rectifier.Benchmark", ULTRALEAP_TEST_FLAGS)
+
+bool FLeapImageRectifierBenchmarkTest::RunTest(const FString& Parameters)
+{
+	// a full size camera image onto the default output, against resampling each pixel from the grid in float as it would
+	// be done without a table
+	const int32 SrcWidth = 640;
+	const int32 SrcHeight = 240;
+	const int32 Width = 400;
+	const int32 Height = 400;
+	const float MaxSlope = 1.f;
+	const int32 Iterations = 20;
+	LEAP_DISTORTION_MATRIX* Matrix = new LEAP_DISTORTION_MATRIX;
+	MakeLinearMatrix(*Matrix, 0.f);
+	const FLeapImageRectifier::FLookupTablePtr Table =
+		FLeapImageRectifier::BuildLookupTable(*Matrix, 1, SrcWidth, SrcHeight, Width, Height, MaxSlope);
+
+	TArray<uint8> Source;
+	Source.SetNumUninitialized(SrcWidth * SrcHeight);
+	for (int32 Index = 0; Index < Source.Num(); Index++)
+	{
+		Source[Index] = (uint8) ((Index * 7) ^ (Index >> 5));
+	}
+	TArray<uint8> Rectified;
+	Rectified.SetNumZeroed(Width * Height);
+	TArray<uint8> Reference;
+	Reference.SetNumZeroed(Width * Height);
+
+	double Start = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+	{
+		FLeapImageRectifier::Rectify(Source.GetData(), *Table, Rectified.GetData());
+	}
+	const double TableTime = (FPlatformTime::Seconds() - Start) / Iterations;
+
+	Start = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+	{
+		for (int32 Y = 0; Y < Height; Y++)
+		{
+			const float SlopeY = ((Y + 0.5f) / Height * 2.f - 1.f) * MaxSlope;
+			for (int32 X = 0; X < Width; X++)
+			{
+				const float SlopeX = ((X + 0.5f) / Width * 2.f - 1.f) * MaxSlope;
+				const FVector2D Normalized = FLeapImageRectifier::SlopeToImage(*Matrix, SlopeX, SlopeY);
+				const float SrcX = FMath::Clamp((float) Normalized.X * SrcWidth - 0.5f, 0.f, SrcWidth - 1.001f);
+				const float SrcY = FMath::Clamp((float) Normalized.Y * SrcHeight - 0.5f, 0.f, SrcHeight - 1.001f);
+				const int32 X0 = FMath::FloorToInt(SrcX);
+				const int32 Y0 = FMath::FloorToInt(SrcY);
+				const uint8* P = Source.GetData() + Y0 * SrcWidth + X0;
+				const float Top = FMath::Lerp((float) P[0], (float) P[1], SrcX - X0);
+				const float Bottom = FMath::Lerp((float) P[SrcWidth], (float) P[SrcWidth + 1], SrcX - X0);
+				Reference[Y * Width + X] = (uint8) FMath::RoundToInt(FMath::Lerp(Top, Bottom, SrcY - Y0));
+			}
+		}
+	}
+	const double ReferenceTime = (FPlatformTime::Seconds() - Start) / Iterations;
+	delete Matrix;
+
+	int32 MaxError = 0;
+	for (int32 Index = 0; Index < Rectified.Num(); Index++)
+	{
+		MaxError = FMath::Max(MaxError, FMath::Abs((int32) Rectified[Index] - (int32) Reference[Index]));
+	}
+	AddInfo(FString::Printf(TEXT("%dx%d from %dx%d: table %.3fms (%.0f Mpixel/s), per pixel float %.3fms, %.1fx faster"), Width,
+		Height, SrcWidth, SrcHeight, TableTime * 1000.0, Width * Height / TableTime * 1e-6, ReferenceTime * 1000.0,
+		ReferenceTime / FMath::Max(TableTime, 1e-9)));
+	// weights are rounded to 1/256 on a noisy image, a step between neighbours can be a few grey levels
+	TestTrue(FString::Printf(TEXT("Same image as the float resample (max error %d)"), MaxError), MaxError <= 4);
+	// loose so a loaded machine doesn't fail it, in practice the table is several times faster
+	TestTrue(TEXT("Table remap faster than resampling per pixel"), TableTime < ReferenceTime);
+	return true;
+}
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,313 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "LeapFrameProcessor.h"
+#include "Math/RandomStream.h"
+#include "Tests/UltraleapTestFlags.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+const int64 FrameIntervalInMicros = 11111;
+const double Duration = 6.0;
+// the horizon is smoothed towards the latency, leave it time to settle before measuring
+const double WarmUp = 1.0;
+const float HorizonsInMS[] = {10.0f, 20.0f, 30.0f, 40.0f, 50.0f};
+// tracking jitter on the whole hand, cm
+const float Noise = 0.05f;
+
+typedef void (*FTrajectory)(const double Time, FVector& OutPalm, FQuat& OutRotation);
+
+struct FNamedTrajectory
+{
+	const TCHAR* Name;
+	FTrajectory Trajectory;
+};
+
+// 32cm/s while turning at 90 degrees/s
+void Linear(const double Time, FVector& OutPalm, FQuat& OutRotation)
+{
+	OutPalm = FVector(20.0f, 0, 0) + FVector(30.0f, 10.0f, 0) * (float) Time;
+	OutRotation = FQuat(FVector::UpVector, HALF_PI * (float) Time);
+}
+
+// 10cm radius once a second, 63cm/s with constant change of direction
+void Circle(const double Time, FVector& OutPalm, FQuat& OutRotation)
+{
+	const float Angle = 2.0f * PI * (float) Time;
+	OutPalm = FVector(20.0f + 10.0f * FMath::Cos(Angle), 10.0f * FMath::Sin(Angle), 0);
+	OutRotation = FQuat::Identity;
+}
+
+// 25cm reaches that ease in and out, stop, then return, where extrapolating overshoots
+void ReachAndStop(const double Time, FVector& OutPalm, FQuat& OutRotation)
+{
+	const FVector Start(20.0f, 0, 0);
+	const FVector End(45.0f, 0, 0);
+	const float Phase = FMath::Fmod((float) Time, 1.4f);
+	float Alpha = 0;
+	if (Phase < 0.4f)
+	{
+		Alpha = 0.5f * (1.0f - FMath::Cos(PI * Phase / 0.4f));
+	}
+	else if (Phase < 0.7f)
+	{
+		Alpha = 1.0f;
+	}
+	else if (Phase < 1.1f)
+	{
+		Alpha = 0.5f * (1.0f + FMath::Cos(PI * (Phase - 0.7f) / 0.4f));
+	}
+	OutPalm = FMath::Lerp(Start, End, Alpha);
+	OutRotation = FQuat(FVector::RightVector, 0.3f * Alpha);
+}
+
+// fingers are 3cm bones starting along the palm's forward axis, each bent Curl radians from the one before, so a
+// flat hand at 0. The thumb metacarpal has no length as tracked
+void MakeHand(FLeapHandData& Hand, const FVector& Palm, const FQuat& Rotation, const float Curl = 0.0f)
+{
+	Hand.InitFromEmpty(EHandType::LEAP_HAND_LEFT, 1);
+	Hand.Palm.Position = Palm;
+	Hand.Palm.StabilizedPosition = Palm;
+	Hand.Palm.Orientation = Rotation.Rotator();
+	Hand.Palm.Direction = Rotation.GetForwardVector();
+	Hand.Palm.Normal = -Rotation.GetUpVector();
+	Hand.Arm.PrevJoint = Palm + Rotation.RotateVector(FVector(-30.0f, 0, 0));
+	Hand.Arm.NextJoint = Palm + Rotation.RotateVector(FVector(-6.0f, 0, 0));
+	Hand.Arm.Rotation = Hand.Palm.Orientation;
+	for (int32 Digit = 0; Digit < 5; ++Digit)
+	{
+		FVector Joint = Palm + Rotation.RotateVector(FVector(-4.0f, (Digit - 2) * 2.0f, 0));
+		for (int32 Bone = 0; Bone < 4; ++Bone)
+		{
+			FLeapBoneData& BoneData = Hand.Digits[Digit].Bones[Bone];
+			const FQuat BoneRotation = Rotation * FQuat(FVector::RightVector, Curl * Bone);
+			BoneData.PrevJoint = Joint;
+			Joint += BoneRotation.RotateVector(FVector(Digit == 0 && Bone == 0 ? 0.0f : 3.0f, 0, 0));
+			BoneData.NextJoint = Joint;
+			BoneData.Rotation = BoneRotation.Rotator();
+		}
+	}
+	Hand.UpdateFromDigits();
+}
+
+// fingers curl to 60 degrees a joint and open again twice a second
+float Curl(const double Time)
+{
+	return FMath::DegreesToRadians(30.0f) * (1.0f - FMath::Cos(4.0f * PI * (float) Time));
+}
+
+// palm and finger tips in mm, the points the processor reports its error over
+float GetError(const FLeapHandData& A, const FLeapHandData& B)
+{
+	float Error = FVector::Dist(A.Palm.Position, B.Palm.Position);
+	for (int32 Digit = 0; Digit < 5; ++Digit)
+	{
+		Error += FVector::Dist(A.Digits[Digit].Bones[3].NextJoint, B.Digits[Digit].Bones[3].NextJoint);
+	}
+	return Error * 10.0f / 6.0f;
+}
+
+struct FHarnessResult
+{
+	// mean over the run in mm
+	float PredictedError = 0;
+	// error of showing the tracked hand as is
+	float HeldError = 0;
+	// the processor's own running estimate
+	float ReportedError = 0;
+};
+
+// replays the trajectory through the processor predicting Horizon ahead, comparing against where the hand really is
+FHarnessResult RunHarness(const FTrajectory Trajectory, const float Horizon, const float NoiseInCm)
+{
+	FRandomStream Random(49);
+	FLeapPredictFrameProcessor Processor;
+	Processor.SetHorizonLimits(1.0f, Horizon);
+
+	FHarnessResult Result;
+	FLeapFrameData Frame;
+	Frame.Hands.SetNum(1);
+	Frame.LeftHandVisible = true;
+	Frame.FrameRate = 90;
+	FLeapHandData Truth;
+	FLeapHandData Tracked;
+	FVector Palm;
+	FQuat Rotation;
+	int32 NumSamples = 0;
+	for (int64 TimeStamp = FrameIntervalInMicros; TimeStamp * 1.0e-6 < Duration; TimeStamp += FrameIntervalInMicros)
+	{
+		const double Time = TimeStamp * 1.0e-6;
+		Trajectory(Time, Palm, Rotation);
+		MakeHand(Tracked, Palm + Random.GetUnitVector() * Random.FRandRange(0.0f, NoiseInCm), Rotation);
+		Frame.Hands[0] = Tracked;
+		Frame.TimeStamp = TimeStamp;
+
+		// all the latency is tracking latency, it doesn't matter which for the horizon
+		Processor.SetLatency(Horizon, 0.0f);
+		Processor.Process(Frame, FrameIntervalInMicros * 1.0e-6f);
+		if (Time < WarmUp)
+		{
+			continue;
+		}
+		Trajectory(Time + Horizon, Palm, Rotation);
+		MakeHand(Truth, Palm, Rotation);
+		Result.PredictedError += GetError(Frame.Hands[0], Truth);
+		Result.HeldError += GetError(Tracked, Truth);
+		NumSamples++;
+	}
+	Result.PredictedError /= NumSamples;
+	Result.HeldError /= NumSamples;
+
+	FLeapStats Stats;
+	Processor.GetStats(Stats);
+	Result.ReportedError = Stats.PredictionErrorInMM;
+	return Result;
+}
+}	 // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLeapPredictFrameProcessorHorizonTest, "UltraleapTracking.Processing.PredictErrorByHorizon",
+	ULTRALEAP_TEST_FLAGS)
+
+bool FLeapPredictFrameProcessorHorizonTest::RunTest(const FString& Parameters)
+{
+	const FNamedTrajectory Trajectories[] = {
+		{TEXT("linear"), &Linear}, {TEXT("circle"), &Circle}, {TEXT("reach and stop"), &ReachAndStop}};
+
+	for (const FNamedTrajectory& Trajectory : Trajectories)
+	{
+		float LastError = 0;
+		for (const float HorizonInMS : HorizonsInMS)
+		{
+			const FHarnessResult Result = RunHarness(Trajectory.Trajectory, HorizonInMS / 1000.0f, Noise);
+			AddInfo(FString::Printf(TEXT("%s %2.0fms: predicted %.2fmm, held %.2fmm, reported %.2fmm"), Trajectory.Name,
+				HorizonInMS, Result.PredictedError, Result.HeldError, Result.ReportedError));
+
+			TestTrue(FString::Printf(TEXT("%s %.0fms prediction at most half the error of no prediction"), Trajectory.Name,
+						 HorizonInMS),
+				Result.PredictedError <= 0.5f * Result.HeldError);
+			// jitter is amplified as well, but never by more than a fraction of a mm between horizons
+			TestTrue(FString::Printf(TEXT("%s %.0fms error grows with the horizon"), Trajectory.Name, HorizonInMS),
+				Result.PredictedError >= LastError - 0.1f);
+			LastError = Result.PredictedError;
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLeapPredictFrameProcessorReportedErrorTest, "UltraleapTracking.Processing.PredictReportedError",
+	ULTRALEAP_TEST_FLAGS)
+
+bool FLeapPredictFrameProcessorReportedErrorTest::RunTest(const FString& Parameters)
+{
+	// without jitter, on motions whose error is steady, the running estimate should match the true error. Measured
+	// against the first frame after the predicted time instead of interpolating, it is off by up to a frame of motion
+	const FNamedTrajectory Trajectories[] = {{TEXT("linear"), &Linear}, {TEXT("circle"), &Circle}};
+	for (const FNamedTrajectory& Trajectory : Trajectories)
+	{
+		for (const float HorizonInMS : HorizonsInMS)
+		{
+			const FHarnessResult Result = RunHarness(Trajectory.Trajectory, HorizonInMS / 1000.0f, 0.0f);
+			TestTrue(FString::Printf(TEXT("%s %.0fms reported %.2fmm, measured %.2fmm"), Trajectory.Name, HorizonInMS,
+						 Result.ReportedError, Result.PredictedError),
+				FMath::Abs(Result.ReportedError - Result.PredictedError) <= 0.2f * Result.PredictedError + 0.2f);
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLeapPredictFrameProcessorArticulationTest, "UltraleapTracking.Processing.PredictArticulation",
+	ULTRALEAP_TEST_FLAGS)
+
+bool FLeapPredictFrameProcessorArticulationTest::RunTest(const FString& Parameters)
+{
+	const float Horizon = 0.05f;
+	// the default, then tighter than the tracked curl so it has to hold the fingers back
+	const float JointLimitsInDegrees[] = {100.0f, 40.0f};
+	for (const float JointLimit : JointLimitsInDegrees)
+	{
+		FRandomStream Random(49);
+		FLeapPredictFrameProcessor Processor;
+		Processor.SetHorizonLimits(1.0f, Horizon);
+		Processor.SetJointLimit(JointLimit);
+
+		FLeapFrameData Frame;
+		Frame.Hands.SetNum(1);
+		Frame.LeftHandVisible = true;
+		Frame.FrameRate = 90;
+		FLeapHandData Tracked;
+		FLeapHandData Truth;
+		const FVector Palm(20.0f, 0, 0);
+		float LargestLengthError = 0;
+		float LargestGap = 0;
+		float LargestBend = 0;
+		float PredictedError = 0;
+		float HeldError = 0;
+		int32 NumSamples = 0;
+		for (int64 TimeStamp = FrameIntervalInMicros; TimeStamp * 1.0e-6 < Duration; TimeStamp += FrameIntervalInMicros)
+		{
+			const double Time = TimeStamp * 1.0e-6;
+			MakeHand(Tracked, Palm + Random.GetUnitVector() * Random.FRandRange(0.0f, Noise), FQuat::Identity, Curl(Time));
+			Frame.Hands[0] = Tracked;
+			Frame.TimeStamp = TimeStamp;
+			Processor.SetLatency(Horizon, 0.0f);
+			Processor.Process(Frame, FrameIntervalInMicros * 1.0e-6f);
+			if (Time < WarmUp)
+			{
+				continue;
+			}
+
+			// every bone keeps its tracked length, joined to the one before, bent from it no more than the limit
+			const FLeapHandData& Predicted = Frame.Hands[0];
+			for (int32 Digit = 0; Digit < 5; ++Digit)
+			{
+				FVector ParentDirection = FVector::ZeroVector;
+				for (int32 Bone = 0; Bone < 4; ++Bone)
+				{
+					const FLeapBoneData& BoneData = Predicted.Digits[Digit].Bones[Bone];
+					const FLeapBoneData& TrackedBone = Tracked.Digits[Digit].Bones[Bone];
+					const FVector BoneVector = BoneData.NextJoint - BoneData.PrevJoint;
+					LargestLengthError = FMath::Max(LargestLengthError,
+						FMath::Abs(BoneVector.Size() - FVector::Dist(TrackedBone.PrevJoint, TrackedBone.NextJoint)));
+					if (Bone > 0)
+					{
+						LargestGap = FMath::Max(
+							LargestGap, FVector::Dist(BoneData.PrevJoint, Predicted.Digits[Digit].Bones[Bone - 1].NextJoint));
+					}
+					const FVector Direction = BoneVector.GetSafeNormal();
+					if (!ParentDirection.IsZero() && !Direction.IsZero())
+					{
+						LargestBend = FMath::Max(LargestBend,
+							FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(ParentDirection | Direction, -1.0f, 1.0f))));
+					}
+					ParentDirection = Direction;
+				}
+			}
+
+			MakeHand(Truth, Palm, FQuat::Identity, Curl(Time + Horizon));
+			PredictedError += GetError(Predicted, Truth);
+			HeldError += GetError(Tracked, Truth);
+			NumSamples++;
+		}
+		AddInfo(FString::Printf(TEXT("%.0f degree limit: largest bend %.1f degrees, predicted %.2fmm, held %.2fmm"), JointLimit,
+			LargestBend, PredictedError / NumSamples, HeldError / NumSamples));
+
+		TestTrue(FString::Printf(TEXT("%.0f degree limit keeps bone lengths"), JointLimit), LargestLengthError < 1.0e-3f);
+		TestTrue(FString::Printf(TEXT("%.0f degree limit keeps digits joined"), JointLimit), LargestGap < 1.0e-3f);
+		TestTrue(FString::Printf(TEXT("%.0f degree limit respected"), JointLimit), LargestBend <= JointLimit + 0.1f);
+		if (JointLimit < 60.0f)
+		{
+			// the tracked curl goes past the limit, the predicted one stops at it
+			TestTrue(TEXT("Limit is reached"), LargestBend >= JointLimit - 0.1f);
+		}
+	}
+	return true;
+}
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
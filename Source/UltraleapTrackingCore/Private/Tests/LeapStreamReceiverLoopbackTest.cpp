@@ -0,0 +1,292 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#include "LeapFrameStreamer.h"
+#include "NetworkToLeapWrapper.h"
+#include "Tests/UltraleapTestFlags.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+const int32 FirstTestPort = 47411;
+const int32 NumPortsToTry = 8;
+const double ReceiveTimeout = 2.0;
+
+// the remote tracking clock runs this far behind the local one
+const int64 RemoteClockBehind = 100 * 1000000ll;
+// frames are captured this long before they are sent
+const int64 CaptureToSend = 5000;
+// loopback latency plus scheduling on a busy machine
+const int64 MaxLatency = 50000;
+const int64 FramePeriod = 11111;
+
+struct FTestFrame
+{
+	LEAP_TRACKING_EVENT Event;
+	LEAP_HAND Hands[2];
+};
+
+LEAP_VECTOR MakeLeapVector(const float X, const float Y, const float Z)
+{
+	LEAP_VECTOR Vector;
+	Vector.x = X;
+	Vector.y = Y;
+	Vector.z = Z;
+	return Vector;
+}
+
+LEAP_QUATERNION MakeLeapQuat(const FQuat& Quat)
+{
+	LEAP_QUATERNION Ret;
+	Ret.x = Quat.X;
+	Ret.y = Quat.Y;
+	Ret.z = Quat.Z;
+	Ret.w = Quat.W;
+	return Ret;
+}
+
+// a hand in LeapC tracking space, mm above the device, PalmX moves it sideways
+void MakeHand(LEAP_HAND& Hand, const uint32 Id, const eLeapHandType Type, const float PalmX)
+{
+	FMemory::Memzero(Hand);
+	Hand.id = Id;
+	Hand.type = Type;
+	Hand.confidence = 0.9f;
+	Hand.grab_strength = 0.25f;
+	Hand.pinch_strength = 0.75f;
+	Hand.pinch_distance = 32.0f;
+	Hand.visible_time = 1500000;
+	Hand.palm.position = MakeLeapVector(PalmX, 200.0f, -30.0f);
+	Hand.palm.stabilized_position = Hand.palm.position;
+	Hand.palm.normal = MakeLeapVector(0.0f, -1.0f, 0.0f);
+	Hand.palm.direction = MakeLeapVector(0.0f, 0.0f, -1.0f);
+	Hand.palm.width = 85.0f;
+	Hand.palm.orientation = MakeLeapQuat(FQuat(FVector(0, 1, 0), 0.3f));
+
+	for (int32 DigitIndex = 0; DigitIndex < 5; DigitIndex++)
+	{
+		LEAP_DIGIT& Digit = Hand.digits[DigitIndex];
+		Digit.finger_id = DigitIndex;
+		Digit.is_extended = DigitIndex != 2;
+		for (int32 BoneIndex = 0; BoneIndex < 4; BoneIndex++)
+		{
+			LEAP_BONE& Bone = Digit.bones[BoneIndex];
+			Bone.prev_joint = MakeLeapVector(PalmX + DigitIndex * 20.0f, 200.0f, -30.0f - BoneIndex * 25.0f);
+			Bone.next_joint = MakeLeapVector(PalmX + DigitIndex * 20.0f, 200.0f, -55.0f - BoneIndex * 25.0f);
+			Bone.rotation = MakeLeapQuat(FQuat(FVector(1, 0, 0), 0.1f * (BoneIndex + DigitIndex)));
+			Bone.width = 18.0f - DigitIndex;
+		}
+	}
+	Hand.arm.prev_joint = MakeLeapVector(PalmX, 200.0f, 250.0f);
+	Hand.arm.next_joint = MakeLeapVector(PalmX, 200.0f, 20.0f);
+	Hand.arm.rotation = MakeLeapQuat(FQuat(FVector(0, 0, 1), -0.2f));
+	Hand.arm.width = 60.0f;
+}
+
+void MakeFrame(FTestFrame& Frame, const int64 FrameId, const int64 RemoteTimeStamp, const float PalmX)
+{
+	FMemory::Memzero(Frame.Event);
+	Frame.Event.pHands = Frame.Hands;
+	Frame.Event.nHands = 2;
+	Frame.Event.tracking_frame_id = FrameId;
+	Frame.Event.info.frame_id = FrameId;
+	Frame.Event.info.timestamp = RemoteTimeStamp;
+	MakeHand(Frame.Hands[0], 7, eLeapHandType_Left, PalmX);
+	MakeHand(Frame.Hands[1], 8, eLeapHandType_Right, -PalmX);
+}
+
+bool StartStreamer(FLeapFrameStreamer& Streamer, const bool bUseTCP, int32& OutPort)
+{
+	// another process may hold the port, so try a few
+	for (OutPort = FirstTestPort; OutPort < FirstTestPort + NumPortsToTry; OutPort++)
+	{
+		if (Streamer.Start(OutPort, bUseTCP, FString()))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool WaitForSubscriber(FLeapFrameStreamer& Streamer)
+{
+	const double Deadline = FPlatformTime::Seconds() + ReceiveTimeout;
+	FLeapStats Stats;
+	while (FPlatformTime::Seconds() < Deadline)
+	{
+		Streamer.GetStats(Stats);
+		if (Stats.StreamSubscribers > 0)
+		{
+			return true;
+		}
+		FPlatformProcess::Sleep(0.005f);
+	}
+	return false;
+}
+
+// sends a frame captured CaptureToSend ago on the remote clock and waits for the receiver to commit it
+LEAP_TRACKING_EVENT* SendAndReceive(FLeapFrameStreamer& Streamer, FLeapStreamReceiver& Receiver, FTestFrame& Frame,
+	const int64 RemoteClockOffset, int64& OutLocalCaptureTime)
+{
+	const int64 LocalNow = FLeapStreamReceiver::GetNow();
+	OutLocalCaptureTime = LocalNow - CaptureToSend;
+	Frame.Event.info.timestamp = OutLocalCaptureTime - RemoteClockOffset;
+	Streamer.PushFrame(Frame.Event, LocalNow - RemoteClockOffset);
+
+	const double Deadline = FPlatformTime::Seconds() + ReceiveTimeout;
+	while (FPlatformTime::Seconds() < Deadline)
+	{
+		LEAP_TRACKING_EVENT* Received = Receiver.GetFrame();
+		if (Received && Received->tracking_frame_id == Frame.Event.tracking_frame_id)
+		{
+			return Received;
+		}
+		FPlatformProcess::Sleep(0.002f);
+	}
+	return nullptr;
+}
+
+bool LeapVectorEqual(const LEAP_VECTOR& A, const LEAP_VECTOR& B, const float Tolerance = 0.0f)
+{
+	return FMath::Abs(A.x - B.x) <= Tolerance && FMath::Abs(A.y - B.y) <= Tolerance && FMath::Abs(A.z - B.z) <= Tolerance;
+}
+
+bool LeapQuatEqual(const LEAP_QUATERNION& A, const LEAP_QUATERNION& B)
+{
+	// 16 bit packing
+	return FQuat(A.x, A.y, A.z, A.w).Equals(FQuat(B.x, B.y, B.z, B.w), 1e-4f);
+}
+
+void TestHand(FAutomationTestBase& Test, const LEAP_HAND& Sent, const LEAP_HAND& Received)
+{
+	Test.TestEqual(TEXT("Hand id"), Received.id, Sent.id);
+	Test.TestTrue(TEXT("Hand type"), Received.type == Sent.type);
+	Test.TestEqual(TEXT("Confidence"), Received.confidence, Sent.confidence);
+	Test.TestEqual(TEXT("Grab strength"), Received.grab_strength, Sent.grab_strength);
+	Test.TestEqual(TEXT("Pinch strength"), Received.pinch_strength, Sent.pinch_strength);
+	Test.TestEqual(TEXT("Pinch distance in mm"), Received.pinch_distance, Sent.pinch_distance);
+	Test.TestTrue(TEXT("Visible time"), FMath::Abs((int64) Received.visible_time - (int64) Sent.visible_time) < 1000);
+
+	// tracking space values must come through untouched, the receiving device applies its own transforms
+	Test.TestTrue(TEXT("Palm position in tracking space"), LeapVectorEqual(Received.palm.position, Sent.palm.position));
+	Test.TestTrue(TEXT("Palm normal"), LeapVectorEqual(Received.palm.normal, Sent.palm.normal));
+	Test.TestTrue(TEXT("Palm direction"), LeapVectorEqual(Received.palm.direction, Sent.palm.direction));
+	Test.TestTrue(TEXT("Palm orientation"), LeapQuatEqual(Received.palm.orientation, Sent.palm.orientation));
+	Test.TestEqual(TEXT("Palm width"), Received.palm.width, Sent.palm.width);
+
+	for (int32 DigitIndex = 0; DigitIndex < 5; DigitIndex++)
+	{
+		const LEAP_DIGIT& SentDigit = Sent.digits[DigitIndex];
+		const LEAP_DIGIT& ReceivedDigit = Received.digits[DigitIndex];
+		Test.TestEqual(TEXT("Extended"), ReceivedDigit.is_extended, SentDigit.is_extended);
+		for (int32 BoneIndex = 0; BoneIndex < 4; BoneIndex++)
+		{
+			const LEAP_BONE& SentBone = SentDigit.bones[BoneIndex];
+			const LEAP_BONE& ReceivedBone = ReceivedDigit.bones[BoneIndex];
+			Test.TestTrue(TEXT("Bone prev joint"), LeapVectorEqual(ReceivedBone.prev_joint, SentBone.prev_joint));
+			Test.TestTrue(TEXT("Bone next joint"), LeapVectorEqual(ReceivedBone.next_joint, SentBone.next_joint));
+			Test.TestTrue(TEXT("Bone rotation"), LeapQuatEqual(ReceivedBone.rotation, SentBone.rotation));
+			Test.TestEqual(TEXT("Bone width"), ReceivedBone.width, SentDigit.proximal.width);
+		}
+	}
+	Test.TestTrue(TEXT("Arm elbow"), LeapVectorEqual(Received.arm.prev_joint, Sent.arm.prev_joint));
+	Test.TestTrue(TEXT("Arm wrist"), LeapVectorEqual(Received.arm.next_joint, Sent.arm.next_joint));
+	Test.TestTrue(TEXT("Arm rotation"), LeapQuatEqual(Received.arm.rotation, Sent.arm.rotation));
+}
+
+void RunLoopback(FAutomationTestBase& Test, const bool bUseTCP)
+{
+	FLeapFrameStreamer Streamer;
+	int32 Port = 0;
+	if (!Test.TestTrue(TEXT("Streamer started"), StartStreamer(Streamer, bUseTCP, Port)))
+	{
+		return;
+	}
+	FLeapStreamReceiver Receiver(TEXT("127.0.0.1"), Port, bUseTCP);
+	if (!Test.TestTrue(TEXT("Receiver started"), Receiver.Start()) ||
+		!Test.TestTrue(TEXT("Receiver subscribed"), WaitForSubscriber(Streamer)))
+	{
+		return;
+	}
+
+	// frames arrive as sent, on the local clock
+	FTestFrame Frame;
+	int64 LocalCaptureTime = 0;
+	MakeFrame(Frame, 100, 0, 10.0f);
+	LEAP_TRACKING_EVENT* Received = SendAndReceive(Streamer, Receiver, Frame, RemoteClockBehind, LocalCaptureTime);
+	if (!Test.TestNotNull(TEXT("First frame received"), Received) || !Test.TestEqual(TEXT("Hand count"), Received->nHands, 2u))
+	{
+		return;
+	}
+	TestHand(Test, Frame.Hands[0], Received->pHands[0]);
+	TestHand(Test, Frame.Hands[1], Received->pHands[1]);
+
+	const int64 TimeError = Received->info.timestamp - LocalCaptureTime;
+	Test.TestTrue(TEXT("Timestamp mapped onto the local clock"), TimeError >= 0 && TimeError <= MaxLatency);
+	Test.TestTrue(TEXT("Clock offset"),
+		Receiver.GetClockOffset() >= RemoteClockBehind && Receiver.GetClockOffset() <= RemoteClockBehind + MaxLatency);
+
+	// a second frame one period later interpolates from the first
+	const int64 FirstTimeStamp = Received->info.timestamp;
+	FPlatformProcess::Sleep(FramePeriod * 1e-6f);
+	MakeFrame(Frame, 101, 0, 30.0f);
+	Received = SendAndReceive(Streamer, Receiver, Frame, RemoteClockBehind, LocalCaptureTime);
+	if (!Test.TestNotNull(TEXT("Second frame received"), Received))
+	{
+		return;
+	}
+	const int64 SecondTimeStamp = Received->info.timestamp;
+	LEAP_TRACKING_EVENT* Interpolated = Receiver.GetInterpolatedFrameAtTime((FirstTimeStamp + SecondTimeStamp) / 2);
+	if (Test.TestNotNull(TEXT("Interpolated"), Interpolated))
+	{
+		Test.TestTrue(TEXT("Interpolated halfway"), FMath::IsNearlyEqual(Interpolated->pHands[0].palm.position.x, 20.0f, 0.5f));
+	}
+
+	// the remote restarts and its clock is now 90s earlier, nothing buffered from before may be blended with it
+	const int64 RestartedClockBehind = RemoteClockBehind + 90 * 1000000ll;
+	MakeFrame(Frame, 1, 0, -40.0f);
+	Received = SendAndReceive(Streamer, Receiver, Frame, RestartedClockBehind, LocalCaptureTime);
+	if (!Test.TestNotNull(TEXT("Frame after restart received"), Received))
+	{
+		return;
+	}
+	Test.TestTrue(TEXT("Clock offset re-estimated after restart"),
+		Receiver.GetClockOffset() >= RestartedClockBehind && Receiver.GetClockOffset() <= RestartedClockBehind + MaxLatency);
+	Test.TestTrue(TEXT("Timestamp mapped onto the local clock after restart"),
+		Received->info.timestamp >= LocalCaptureTime && Received->info.timestamp <= LocalCaptureTime + MaxLatency);
+
+	// only the new frame is buffered, so any time before it holds it rather than blending in the old session
+	Interpolated = Receiver.GetInterpolatedFrameAtTime(FirstTimeStamp);
+	if (Test.TestNotNull(TEXT("Interpolated after restart"), Interpolated))
+	{
+		Test.TestEqual(TEXT("Old frames cleared"), Interpolated->pHands[0].palm.position.x, -40.0f);
+	}
+
+	Receiver.Shutdown();
+	Streamer.Shutdown();
+}
+}	 // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLeapStreamReceiverUdpLoopbackTest, "UltraleapTracking.Streaming.ReceiverUdpLoopback", ULTRALEAP_TEST_FLAGS)
+
+bool FLeapStreamReceiverUdpLoopbackTest::RunTest(const FString& Parameters)
+{
+	RunLoopback(*this, false);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLeapStreamReceiverTcpLoopbackTest, "UltraleapTracking.Streaming.ReceiverTcpLoopback", ULTRALEAP_TEST_FLAGS)
+
+bool FLeapStreamReceiverTcpLoopbackTest::RunTest(const FString& Parameters)
+{
+	RunLoopback(*this, true);
+	return true;
+}
+
+#endif	  // WITH_DEV_AUTOMATION_TESTS
@@ -42,6 +42,7 @@ void FLeapFrameData::SetFromLeapFrame(
 	FrameRate = frame->framerate;
 
 	TimeStamp = frame->info.timestamp;
+	TrackingTimeStamp = frame->info.timestamp;
 
 	// Copy hand data
 	if (Hands.Num() != NumberOfHandsVisible)	// always clear the hand data if number of hands changed
@@ -75,6 +76,7 @@ void FLeapFrameData::SetFromLeapFrame(
 	}
 
 	FrameId = frame->tracking_frame_id;
+	DeviceFrameId = frame->info.frame_id;
 }
 
 void FLeapFrameData::SetInterpolationPartialFromLeapFrame(
@@ -245,6 +247,11 @@ void FLeapHandData::ScaleHand(float InScale)
 	Thumb.ScaleDigit(InScale);
 
 	Palm.ScalePalm(InScale);
+
+	for (auto& Digit : Digits)
+	{
+		Digit.ScaleDigit(InScale);
+	}
 }
 
 void FLeapHandData::RotateHand(const FRotator& InRotation)
@@ -437,6 +444,8 @@ FLeapOptions::FLeapOptions()
 	TimewarpFactor = 1.f;
 	HandInterpFactor = 0.f;
 	FingerInterpFactor = 0.f;
+	AdaptiveLatencyScale = 1.0f;
+	AdaptiveMaxLeadInMS = 30.0f;
 	// in mm
 //	HMDPositionOffset = FVector(90.0, 0, 0);	// Vive default, for oculus use 80,0,0
 //	HMDRotationOffset = FRotator(0, 0, 0);		// If imperfectly mounted it might need to sag
@@ -448,13 +457,58 @@ FLeapOptions::FLeapOptions()
 	GrabTimeout = 100000;
 	PinchTimeout = 100000;
 	bUseOpenXRAsSource = false;
+	bRectifyImages = false;
+	ImageHistorySize = 0;
+	ImageDownsampleFactor = 1;
+	bImageHandRegionOfInterest = false;
+	ImageRegionOfInterestSize = 128;
+	bStreamFrames = false;
+	StreamPort = 9760;
+	bStreamOverTCP = false;
+	StreamMaxRate = 0;
+	StreamBackPressure = ELeapStreamBackPressure::LEAP_STREAM_LATEST_ONLY;
+	bSmoothHands = false;
+	HandSmoothingMinCutoff = 1.0f;
+	HandSmoothingCutoffSlope = 0.05f;
+	HandSmoothingRotationCutoffSlope = 1.0f;
+	ProcessorClampBounds = FBox(FVector(-100.f), FVector(100.f));
+	ProcessorScale = 1.0f;
+	PredictionLatencyScale = 1.0f;
+	MaxPredictionInMS = 50.0f;
+	PredictionJointLimit = 100.0f;
 
 	HMDPositionOffset = FVector(80.f, 0, 0);
 	HMDRotationOffset = FRotator(0, 0, 0);
 	// bEnableImageStreaming = false;		//default image streaming to off
 }
 
-FLeapStats::FLeapStats() : FrameExtrapolationInMS(0)
+FLeapStats::FLeapStats()
+	: FrameExtrapolationInMS(0)
+	, ImagesReceived(0)
+	, ImagesDropped(0)
+	, ImageFramesMissed(0)
+	, ImagesOverwritten(0)
+	, StreamSubscribers(0)
+	, StreamFramesSent(0)
+	, StreamFramesDropped(0)
+	, StreamLatencyInMS(0)
+	, PredictionHorizonInMS(0)
+	, PredictionErrorInMM(0)
+	, DisplayLatencyInMS(0)
+	, InterpolationOffsetInMS(0)
+{
+}
+
+FLeapImagePair::FLeapImagePair() : FrameId(0), TimeStamp(0), Width(0), Height(0)
+{
+}
+
+FLeapCombinedSourceStats::FLeapCombinedSourceStats()
+	: TimeSkewInMS(0), FrameRate(0), DroppedFrames(0), LastFrameAgeInMS(0), Freshness(0)
+{
+}
+
+FLeapDeviceExtrinsics::FLeapDeviceExtrinsics() : DeviceOrigin(FTransform::Identity), Residual(0), NumSamples(0)
 {
 }
 
@@ -12,6 +12,7 @@
 #include "UltraleapTrackingData.h"
 #include "LeapC.h"
 
+class ILeapFrameProcessor;
 class ULeapComponent;
 
 
@@ -37,6 +38,9 @@ public:
 	virtual bool GetJointOcclusionConfidences(const FString& DeviceSerial, TArray<float>& Left, TArray<float>& Right) = 0;
 	virtual void GetDebugInfo(int32& NumCombinedLeft, int32& NumCombinedRight) = 0;
 	virtual int32 GetBodyStateDeviceID() = 0;
+	virtual bool GetImagesForFrame(const int64 FrameId, FLeapImagePair& OutImages) = 0;
+	virtual void AddFrameProcessor(const TSharedPtr<ILeapFrameProcessor>& Processor) = 0;
+	virtual void RemoveFrameProcessor(const TSharedPtr<ILeapFrameProcessor>& Processor) = 0;
 };
 class ITrackingDeviceWrapper
 {
@@ -73,7 +77,8 @@ public:
 	enum EDeviceType
 	{
 		DEVICE_TYPE_LEAP,
-		DEVICE_TYPE_OPENXR
+		DEVICE_TYPE_OPENXR,
+		DEVICE_TYPE_NETWORK
 	};
 
 	virtual ~IHandTrackingWrapper()
@@ -134,6 +139,12 @@ public:
 	 * @param LeapDeviceID - Device ID to set the hints
 	 */
 	virtual void SetDeviceHints(TArray<FString>& Hints, const uint32_t DeviceID = 0) = 0;
+
+	/** Pixel in the raw image of CameraIndex (0 left, 1 right) hit by Ray, a direction [x, y, 1] in that camera's space.
+	 * Returns false if the device has no camera model, only valid once an image has been received */
+	virtual bool RectilinearToPixel(const int32 CameraIndex, const LEAP_VECTOR& Ray, FVector2D& OutPixel) = 0;
+	/** Transform from the space of CameraIndex to LeapC tracking space (mm), returns false if the device has no camera model */
+	virtual bool GetCameraToTrackingTransform(const int32 CameraIndex, FMatrix& OutCameraToTracking) = 0;
 };
 class ILeapConnectorCallbacks
 {
@@ -203,6 +214,23 @@ public:
 		return FLeapStats();
 	};
 
+	/** Find the raw image pair of a device frame (FLeapFrameData::DeviceFrameId), requires FLeapOptions::ImageHistorySize */
+	virtual bool GetImagesForFrame(const FString& DeviceSerial, const int64 FrameId, FLeapImagePair& OutImages)
+	{
+		return false;
+	};
+
+	/** Run a processor on a device's frames after the built in FLeapOptions::FrameProcessors, see LeapFrameProcessor.h */
+	virtual bool AddFrameProcessor(const FString& DeviceSerial, const TSharedPtr<ILeapFrameProcessor>& Processor)
+	{
+		return false;
+	};
+
+	virtual bool RemoveFrameProcessor(const FString& DeviceSerial, const TSharedPtr<ILeapFrameProcessor>& Processor)
+	{
+		return false;
+	};
+
 	/** Set Leap Options such as time warp, interpolation and tracking modes */
 	virtual void SetOptions(const FLeapOptions& InOptions, const TArray<FString>& DeviceSerials){};
 
@@ -0,0 +1,159 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+
+#include "GrabBroadphaseSubsystem.generated.h"
+
+class UPrimitiveComponent;
+
+/** Uniform grid of axis aligned boxes, the spatial half of the grab broadphase.
+ * Items are identified by the id returned from Add, ids are reused after Remove */
+class ULTRALEAPTRACKING_API FIEGrabBroadphaseGrid
+{
+public:
+	explicit FIEGrabBroadphaseGrid(const float InCellSize = 20.0f);
+
+	/** Change the cell size in cm, all items are re-inserted */
+	void SetCellSize(const float InCellSize);
+	float GetCellSize() const
+	{
+		return CellSize;
+	}
+
+	int32 Add(const FBox& Box);
+	void Update(const int32 Id, const FBox& Box);
+	void Remove(const int32 Id);
+	void Reset();
+
+	/** Gather each item whose box overlaps QueryBox once, OutIds is reset first */
+	void Query(const FBox& QueryBox, TArray<int32>& OutIds);
+
+	const FBox& GetBox(const int32 Id) const
+	{
+		return Items[Id].Box;
+	}
+	int32 Num() const
+	{
+		return NumItems;
+	}
+
+private:
+	struct FItem
+	{
+		FBox Box;
+		FIntVector MinCell;
+		FIntVector MaxCell;
+		uint32 QueryStamp = 0;
+		bool bOversized = false;
+		bool bUsed = false;
+	};
+
+	FIntVector ToCell(const FVector& Location) const;
+	void Link(const int32 Id);
+	void Unlink(const int32 Id);
+	void Visit(const int32 Id, const FBox& QueryBox, TArray<int32>& OutIds);
+
+	float CellSize;
+	float InvCellSize;
+
+	TArray<FItem> Items;
+	TArray<int32> FreeIds;
+	TMap<FIntVector, TArray<int32>> Cells;
+	// items spanning more than MaxCellsPerItem cells (floors, tables) are tested on every query instead
+	TArray<int32> Oversized;
+	uint32 QueryStamp = 0;
+	int32 NumItems = 0;
+
+	static const int32 MaxCellsPerItem = 64;
+};
+
+/** A probe overlapping a graspable, see UIEGrabBroadphaseSubsystem::QueryProbeContacts */
+struct FIEProbeContact
+{
+	int32 ProbeIndex;
+	UPrimitiveComponent* Primitive;
+};
+
+/** Registry of graspable primitives shared by the grab classifier and Interaction Engine blueprints.
+ * Replaces per fingertip overlap events with one grid query per hand per tick. Movable primitives that are
+ * awake and have moved get their bounds refreshed at most once per frame on first query, and graspables
+ * destroyed without unregistering are pruned */
+UCLASS()
+class ULTRALEAPTRACKING_API UIEGrabBroadphaseSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UIEGrabBroadphaseSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual void Deinitialize() override;
+
+	/** Add a primitive to the broadphase, registering twice is harmless */
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap IE")
+	void RegisterGraspable(UPrimitiveComponent* Primitive);
+
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap IE")
+	void UnregisterGraspable(UPrimitiveComponent* Primitive);
+
+	UFUNCTION(BlueprintPure, Category = "Ultraleap IE")
+	bool IsGraspableRegistered(UPrimitiveComponent* Primitive) const;
+
+	UFUNCTION(BlueprintPure, Category = "Ultraleap IE")
+	int32 GetNumGraspables() const;
+
+	/** Grid cell size in cm, roughly the size of a hand works best */
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap IE")
+	void SetCellSize(const float CellSize);
+
+	/** Graspables whose bounds overlap the sphere, e.g. for hover and proximity checks */
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap IE")
+	void QuerySphere(const FVector& Center, const float Radius, TArray<UPrimitiveComponent*>& OutPrimitives);
+
+	/** Batched probe test, the grid is walked once for the region covering all probes.
+	 * OutHits[i] is the first collision enabled graspable probe i overlaps, or null */
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap IE")
+	void QueryProbes(const TArray<FVector>& Locations, const TArray<float>& Radii, TArray<UPrimitiveComponent*>& OutHits);
+
+	/** As QueryProbes but reports every graspable each probe overlaps, for classifying several objects per hand */
+	void QueryProbeContacts(const TArray<FVector>& Locations, const TArray<float>& Radii, TArray<FIEProbeContact>& OutContacts);
+
+	/** Test probes against the collision shape of candidates rather than only their bounds */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ultraleap IE")
+	bool bPreciseOverlap = true;
+
+private:
+	void RefreshBounds();
+	void RemoveById(const int32 Id);
+	bool GatherProbeCandidates(const TArray<FVector>& Locations, const TArray<float>& Radii);
+	bool ProbeOverlaps(UPrimitiveComponent* Primitive, const FBox& Box, const FVector& Location, const float Radius) const;
+
+	FIEGrabBroadphaseGrid Grid;
+
+	struct FGraspable
+	{
+		TWeakObjectPtr<UPrimitiveComponent> Primitive;
+		// kept so stale entries can still be found in GridIds
+		TObjectKey<UPrimitiveComponent> Key;
+	};
+
+	// indexed by grid id
+	TArray<FGraspable> GridPrimitives;
+	TMap<TObjectKey<UPrimitiveComponent>, int32> GridIds;
+	// grid ids of movable primitives, static ones never need their bounds refreshed
+	TArray<int32> MovableIds;
+	// grid ids queries found destroyed, removed on the next refresh so query loops never change the grid
+	TArray<int32> StaleIds;
+
+	uint64 LastRefreshFrame = MAX_uint64;
+	TArray<int32> ScratchIds;
+};
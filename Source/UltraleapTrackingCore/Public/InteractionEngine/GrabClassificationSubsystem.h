@@ -0,0 +1,147 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InteractionEngine/GrabBroadphaseSubsystem.h"
+#include "InteractionEngine/GrabClassifierComponent.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "UObject/ObjectKey.h"
+
+#include "GrabClassificationSubsystem.generated.h"
+
+/** A grab or release edge from the grab classification pass */
+USTRUCT(BlueprintType)
+struct FIEGrabEvent
+{
+	GENERATED_BODY()
+
+	/** Id returned from RegisterHand */
+	UPROPERTY(BlueprintReadOnly, Category = "Ultraleap IE")
+	int32 HandId = INDEX_NONE;
+
+	/** Null on the release sent when the object was destroyed while held, release whatever the hand holds */
+	UPROPERTY(BlueprintReadOnly, Category = "Ultraleap IE")
+	UPrimitiveComponent* Object = nullptr;
+
+	/** True for grab, false for release */
+	UPROPERTY(BlueprintReadOnly, Category = "Ultraleap IE")
+	bool IsGrabbing = false;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FIEGrabEvents, const TArray<FIEGrabEvent>&, Events);
+DECLARE_MULTICAST_DELEGATE_OneParam(FIEGrabEventsNative, const TArray<FIEGrabEvent>&);
+
+/** Central grab classifier, evaluates every hand against every object it touches in one pass per frame.
+ * Same logic as UIEGrabClassifierComponent but with one classifier per hand/object pair as in the Unity
+ * Interaction Engine. Hand, probe and pair state is stored in flat arrays rather than per probe UObjects,
+ * contacts come from UIEGrabBroadphaseSubsystem, so graspables must be registered there */
+UCLASS()
+class ULTRALEAPTRACKING_API UIEGrabClassificationSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	static UIEGrabClassificationSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject, ticks after actors so hands updated this frame are classified this frame
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	/** Probes per hand, thumb first */
+	static const int32 NumProbes = 5;
+
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap IE")
+	int32 RegisterHand(const FGrabClassifierParams& Params);
+
+	/** Remove a hand and its classifiers, no release events are sent */
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap IE")
+	void UnregisterHand(const int32 HandId);
+
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap IE")
+	void SetHandParams(const int32 HandId, const FGrabClassifierParams& Params);
+
+	/** Supply this frame's hand and fingertip probes (thumb first), hands not updated in a frame keep their state */
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap IE")
+	void UpdateHand(const int32 HandId, const USceneComponent* Hand, const TArray<FVector>& ProbeLocations,
+		const TArray<FVector>& ProbeDirections, const bool IgnoreTemporal);
+
+	/** Drop all grab state for a hand without events, see UIEGrabClassifierComponent::ForceReset */
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap IE")
+	void ForceResetHand(const int32 HandId);
+
+	UFUNCTION(BlueprintPure, Category = "Ultraleap IE")
+	bool IsHandGrabbing(const int32 HandId, UPrimitiveComponent* Object) const;
+
+	/** Grab and release edges from the last pass */
+	UFUNCTION(BlueprintPure, Category = "Ultraleap IE")
+	TArray<FIEGrabEvent> GetGrabEvents() const
+	{
+		return GrabEvents;
+	}
+
+	/** Called once per pass with all edges, only when there are any */
+	UPROPERTY(BlueprintAssignable, Category = "Ultraleap IE")
+	FIEGrabEvents OnGrabEvents;
+
+	FIEGrabEventsNative OnGrabEventsNative;
+
+private:
+	bool IsValidHand(const int32 HandId) const;
+	int32 FindOrAddPair(const int32 HandId, UPrimitiveComponent* Object);
+	void RemovePair(const int32 PairIndex);
+
+	void UpdateCurls();
+	void UpdateContacts();
+	void ClassifyPairs(const float DeltaTime);
+	void CullPairs();
+
+	// Per hand, indexed by hand id
+	TArray<bool> HandUsed;
+	TArray<int32> FreeHandIds;
+	TArray<FGrabClassifierParams> HandParams;
+	TArray<FVector> HandForward;
+	TArray<FVector> HandRight;
+	TArray<bool> HandIgnoreTemporal;
+	TArray<uint64> HandUpdatedFrame;
+	// bit per probe touching any object this frame
+	TArray<uint8> HandContacts;
+
+	// Per hand probe, indexed by hand id * NumProbes + probe
+	TArray<FVector> ProbeLocations;
+	TArray<FVector> ProbeDirections;
+	TArray<float> ProbeCurls;
+	TArray<float> ProbePrevCurls;
+	TArray<float> ProbeCurlVelocities;
+
+	// Per hand/object classifier
+	TArray<int32> PairHand;
+	TArray<TWeakObjectPtr<UPrimitiveComponent>> PairObject;
+	TArray<TObjectKey<UPrimitiveComponent>> PairObjectKey;
+	// bit per probe
+	TArray<uint8> PairContacts;
+	TArray<uint8> PairInside;
+	TArray<bool> PairGrabbing;
+	TArray<float> PairCoolDown;
+	// indexed by pair * NumProbes + probe, the curl a probe must uncurl past to leave the object
+	TArray<float> PairStickyCurls;
+	TMap<TPair<int32, TObjectKey<UPrimitiveComponent>>, int32> PairLookup;
+
+	TArray<FIEGrabEvent> GrabEvents;
+
+	// scratch for the per hand broadphase query
+	TArray<FVector> QueryLocations;
+	TArray<float> QueryRadii;
+	TArray<FIEProbeContact> QueryContacts;
+};
@@ -13,6 +13,8 @@
 
 #include "GrabClassifierComponent.generated.h"
 
+class UPrimitiveComponent;
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(
 	FGrabClassifierGrabStateChanged, UIEGrabClassifierComponent*, Source, bool, IsGrabbing);
 
@@ -94,7 +96,8 @@ public:
 	TArray<USceneComponent*> CandidateColliders;
 };
 
-/** Manages logic for Grabbing, based on the Unity Interaction Engine equivalent */
+/** Manages logic for Grabbing, based on the Unity Interaction Engine equivalent
+ * UIEGrabClassificationSubsystem runs the same logic for all hands and objects in one pass */
 UCLASS(BlueprintType, Blueprintable, meta = (BlueprintSpawnableComponent))
 class UIEGrabClassifierComponent : public UActorComponent
 {
@@ -125,6 +128,11 @@ public:
 	UPROPERTY(BlueprintReadOnly, Category = "Ultraleap IE")
 	int NumInside;
 
+	/** Find probe contacts with one UIEGrabBroadphaseSubsystem query per hand instead of the probes' CandidateColliders,
+	 * graspables must be registered with the subsystem */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ultraleap IE")
+	bool UseBroadphase;
+
 	/**  called when the grab state has changed */
 	UPROPERTY(BlueprintAssignable, EditAnywhere, Category = "Ultraleap IE")
 	FGrabClassifierGrabStateChanged OnIsGrabbingChanged;
@@ -140,6 +148,11 @@ public:
 	void ForceReset();
 
 private:
+	// scratch for the batched broadphase query, kept to avoid per tick allocations
+	TArray<FVector> BroadphaseLocations;
+	TArray<float> BroadphaseRadii;
+	TArray<UPrimitiveComponent*> BroadphaseHits;
+
 	/**  notify if changed */
 	void NotifyControllerGrabbing();
 };
@@ -13,6 +13,7 @@
 #include "GraspedMovementHandler.h"
 #include "Curves/CurveFloat.h"
 #include "Engine/World.h"
+#include "PhysicsEngine/BodyInstance.h"
 #include "NonKinematicGraspedMovement.generated.h"
 
 
@@ -28,6 +29,10 @@ public:
 protected:
 	
 public:	
+	/** Solve the held velocities in each physics substep against the target interpolated to the substep time,
+	 * rather than once per game tick. Keeps holding stable with substepping and variable frame rates */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ultraleap IE")
+	bool bSolveInPhysicsSubsteps = true;
 
 protected:
 	// override for specific implementations
@@ -39,8 +44,37 @@ protected:
 	UCurveFloat* StrengthByDistance;
 
 private:
-	
+	// Per grasped body, written on the game thread and only read or advanced by its substeps
+	struct FGraspedBodyState
+	{
+		// solved targets from the previous and current game tick, substeps interpolate between them
+		FVector PrevTargetPosition = FVector::ZeroVector;
+		FQuat PrevTargetRotation = FQuat::Identity;
+		FVector TargetPosition = FVector::ZeroVector;
+		FQuat TargetRotation = FQuat::Identity;
+		FVector RelativeCenterOfMass = FVector::ZeroVector;
+		// centre of mass of the current target, how far short of it the body ends up sets the next follow strength
+		FVector TargetCenterOfMass = FVector::ZeroVector;
+		// evaluated from StrengthByDistance on the game thread, curves aren't safe to read from the physics thread
+		float FollowStrength = 1.0f;
+		float MaxScaledVelocity = 0.0f;
+		// physics time the substeps of this tick cover, and how much of it has been simulated so far
+		float StepTime = 0.0f;
+		float SubstepTime = 0.0f;
+		uint64 LastMoveFrame = 0;
+	};
+
+	static void SolveVelocities(const FTransform& Current, const FVector& RelativeCenterOfMass, const FVector& TargetPosition,
+		const FQuat& TargetRotation, const FVector& CurrentVelocity, const FVector& CurrentAngularVelocityInDegrees,
+		const float DeltaTime, const float Strength, const float MaxScaledVelocity, FVector& OutVelocity,
+		FVector& OutAngularVelocityInDegrees);
+
+	// Called for each physics substep of a body registered in MoveToImpl
+	void SubstepMoveTo(float DeltaTime, FBodyInstance* BodyInstance);
 
-	FVector LastSolvedCoMPosition = FVector::ZeroVector;
-		
+	// Keyed by body instance so substeps can find their state without resolving the owning component
+	TMap<const FBodyInstance*, FGraspedBodyState> GraspedBodies;
+	// substeps can run on the physics thread
+	FCriticalSection GraspedBodiesLock;
+	FCalculateCustomPhysics OnCalculateCustomPhysics;
 };
@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2021.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "Components/SceneComponent.h"
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "UltraleapTrackingData.h"
+
+#include "PhysicsHandsComponent.generated.h"
+
+class UPrimitiveComponent;
+class ULeapSubsystem;
+
+/** Physical proxy for the tracked hands, a capsule per finger bone plus a palm box driven towards the tracked
+ * pose with velocity targets so contacts with scene objects are solved by the physics engine. Pushing, poking and
+ * two hand lifts work without grab classifiers.
+ *
+ * Bodies are pooled at BeginPlay (MaxBodiesPerHand per hand, palm and fingertips first), ignore each other through
+ * HandCollisionChannel, and are put to sleep with collision off while a hand is untracked or out of range, or when no
+ * frame has arrived for TrackingTimeout.
+ * Attach to the tracking origin (e.g. the VR origin) unless frames are already in world space */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class ULTRALEAPTRACKING_API UIEPhysicsHandsComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+public:
+	UIEPhysicsHandsComponent();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Bodies per hand, the palm then distal, intermediate, proximal and metacarpal bones. Applied at BeginPlay */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Ultraleap IE", meta = (ClampMin = "1", ClampMax = "20"))
+	int32 MaxBodiesPerHand = 16;
+
+	/** Mass of each hand body in kg */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ultraleap IE")
+	float BoneMass = 0.5f;
+
+	/** Fastest a hand body is driven at in cm/s, limits how hard fast hands hit objects */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ultraleap IE")
+	float MaxVelocity = 500.0f;
+
+	/** Bodies further than this from their bone (e.g. blocked by a wall) are teleported back */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ultraleap IE")
+	float TeleportDistance = 10.0f;
+
+	/** Hands whose palm is further than this from the component are put to sleep */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ultraleap IE")
+	float MaxHandDistance = 150.0f;
+
+	/** Seconds without a tracking frame before both hands are put to sleep */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ultraleap IE")
+	float TrackingTimeout = 0.25f;
+
+	/** Object type of the hand bodies, they ignore this channel so fingers don't collide with each other.
+	 * A dedicated object channel is recommended */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Ultraleap IE")
+	TEnumAsByte<ECollisionChannel> HandCollisionChannel = ECC_Pawn;
+
+	/** Set when the LeapSubsystem already delivers frames in world space (pawn origin), otherwise hand data is
+	 * relative to this component */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ultraleap IE")
+	bool bFramesInWorldSpace = false;
+
+	/** Feed a frame directly, frames from the LeapSubsystem are used otherwise */
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap IE")
+	void UpdateHands(const FLeapFrameData& Frame);
+
+	UFUNCTION(BlueprintPure, Category = "Ultraleap IE")
+	bool IsHandAwake(TEnumAsByte<EHandType> HandType) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap IE")
+	void GetHandBodies(TEnumAsByte<EHandType> HandType, TArray<UPrimitiveComponent*>& OutBodies) const;
+
+private:
+	struct FHandSlot
+	{
+		bool bAwake = false;
+		int32 HandId = INDEX_NONE;
+	};
+	struct FTrackedHand
+	{
+		FLeapHandData Hand;
+		bool bTracked = false;
+	};
+
+	void OnLeapTrackingData(const FLeapFrameData& Frame);
+	void CreateBodyPool();
+	void WakeHand(const int32 HandIndex, const FLeapHandData& Hand);
+	void SleepHand(const int32 HandIndex);
+	void DriveHand(const int32 HandIndex, const FLeapHandData& Hand, const float DeltaTime);
+
+	// world space target and shape for body slot BodySlot of a hand, returns false for degenerate bones
+	bool GetBodyTarget(const FLeapHandData& Hand, const int32 BodySlot, FTransform& OutTarget, FVector& OutShape) const;
+
+	UPROPERTY(Transient)
+	TArray<UPrimitiveComponent*> Bodies;
+
+	int32 BodiesPerHand = 0;
+	FHandSlot HandSlots[2];
+	// latest frame's hands, left then right
+	FTrackedHand TrackedHands[2];
+	// world real time of the latest frame, negative before the first
+	double LastFrameTime = -1.0;
+
+	UPROPERTY()
+	ULeapSubsystem* LeapSubsystem;
+};
@@ -37,6 +37,12 @@ class ULTRALEAPTRACKING_API ULeapBlueprintFunctionLibrary : public UBlueprintFun
 	UFUNCTION(BlueprintCallable, Category = "Ultraleap Tracking Functions", meta = (AutoCreateRefTerm = "DeviceSerial"))
 	static void GetLeapStats(FLeapStats& OutStats, const FString& DeviceSerial);
 
+	/** Get the raw image pair the frame's hands were tracked from. Takes the frame as its device frame id is int64, which
+	 * blueprint doesn't support. Requires FLeapOptions::ImageHistorySize, returns false if the images have already left
+	 * the history */
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap Tracking Functions", meta = (AutoCreateRefTerm = "DeviceSerial"))
+	static bool GetImagesForFrame(const FLeapFrameData& Frame, FLeapImagePair& OutImages, const FString& DeviceSerial);
+
 	/** Change leap policy */
 	UFUNCTION(BlueprintCallable, Category = "Ultraleap Tracking Functions", meta = (AutoCreateRefTerm = "DeviceSerials"))
 	static void SetLeapPolicy(ELeapPolicyFlag Flag, bool Enable, const TArray<FString>& DeviceSerials);
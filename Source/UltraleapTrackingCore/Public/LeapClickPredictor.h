@@ -0,0 +1,106 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class ELeapClickPrediction : uint8
+{
+	None,
+	Press,
+	Release,
+	// a predicted press the signal never confirmed, lift it without clicking
+	Cancel
+};
+
+/**
+ * Predicts press/release of a rising signal (pinch strength, or finger depth into a widget) from its velocity over
+ * a short history, so the press fires when the signal is expected to cross PressThreshold LeadTime seconds from now
+ * rather than a frame or two after it has. The ray at the start of the rise is kept so the click can be sent where
+ * the user was aiming before the hand drifted
+ */
+class ULTRALEAPTRACKING_API FLeapClickPredictor
+{
+public:
+	/**
+	 * @param InPressThreshold - press when the signal reaches (or is predicted to reach) this
+	 * @param InReleaseThreshold - release when the signal drops below this, lower than the press threshold
+	 * @param InLeadTime - how far ahead in seconds to predict, roughly the tracking to display latency
+	 * @param InOnsetVelocity - signal velocity per second that counts as the start of a press
+	 */
+	void Configure(
+		const float InPressThreshold, const float InReleaseThreshold, const float InLeadTime, const float InOnsetVelocity);
+
+	/** Forget the history and press state, e.g. when the hand is lost. The caller sends any release */
+	void Reset();
+
+	/** Feed the signal for a tracking frame, Time in seconds. Returns the press/release/cancel to send, if any */
+	ELeapClickPrediction AddSample(const double Time, const float Value, const FVector& RayStart, const FVector& RayDirection);
+
+	bool IsPressed() const
+	{
+		return bPressed;
+	}
+
+	/** Whether the signal has reached the press threshold since the press, false while a press is only predicted */
+	bool HasReachedPressThreshold() const
+	{
+		return bReachedPressThreshold;
+	}
+
+	/** Signal velocity per second over the history */
+	float GetVelocity() const
+	{
+		return Velocity;
+	}
+
+	/** Ray at the start of the current rise, false if the signal isn't rising towards a press */
+	bool GetOnsetRay(FVector& OutStart, FVector& OutDirection) const;
+
+	/** For presses that other events confirm and release, such as pinch events: the prediction only presses early and
+	 * takes back a press that was never confirmed */
+	static ELeapClickPrediction FilterConfirmed(const ELeapClickPrediction Prediction, const bool bConfirmed)
+	{
+		if (Prediction == ELeapClickPrediction::Release || Prediction == ELeapClickPrediction::Cancel)
+		{
+			return bConfirmed ? ELeapClickPrediction::None : ELeapClickPrediction::Cancel;
+		}
+		return Prediction;
+	}
+
+private:
+	static constexpr int32 HistoryLength = 6;
+
+	struct FSample
+	{
+		double Time = 0;
+		float Value = 0;
+		FVector RayStart = FVector::ZeroVector;
+		FVector RayDirection = FVector::ForwardVector;
+	};
+
+	const FSample& GetSample(const int32 Age) const;
+	float FitVelocity() const;
+	void FindOnset();
+
+	FSample History[HistoryLength];
+	int32 NumSamples = 0;
+	int32 NextSample = 0;
+
+	float PressThreshold = 0.8f;
+	float ReleaseThreshold = 0.5f;
+	float LeadTime = 0.03f;
+	float OnsetVelocity = 1.0f;
+
+	float Velocity = 0;
+	bool bPressed = false;
+	bool bReachedPressThreshold = false;
+	bool bHasOnset = false;
+	FSample Onset;
+};
@@ -0,0 +1,190 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OneEuroFilterBankComponent.h"
+#include "Stats/Stats.h"
+#include "UltraleapTrackingData.h"
+
+/**
+ * A stage run on a device's tracking frame before it is published to components, the subsystem, LiveLink and
+ * BodyState, so the work is done once per device instead of once per listener. Processors run on the game thread
+ * in chain order and should keep their state preallocated, they are called every tracking frame
+ */
+class ULTRALEAPTRACKING_API ILeapFrameProcessor
+{
+public:
+	virtual ~ILeapFrameProcessor()
+	{
+	}
+
+	/** Modify the frame in place. DeltaTime is the time since the previous frame in seconds */
+	virtual void Process(FLeapFrameData& Frame, const float DeltaTime) = 0;
+
+	/** Forget any history, e.g. on device or tracking source change */
+	virtual void Reset()
+	{
+	}
+
+	/** Cycle stat the chain times this processor with */
+	virtual TStatId GetStatId() const = 0;
+};
+
+/** Smooths every joint, see FLeapOneEuroFilterBank */
+class ULTRALEAPTRACKING_API FLeapFilterFrameProcessor : public ILeapFrameProcessor
+{
+public:
+	virtual void Process(FLeapFrameData& Frame, const float DeltaTime) override;
+	virtual void Reset() override;
+	virtual TStatId GetStatId() const override;
+
+	FLeapOneEuroFilterBank& GetFilterBank()
+	{
+		return FilterBank;
+	}
+
+private:
+	FLeapOneEuroFilterBank FilterBank;
+};
+
+/** Moves hands whose palm leaves a box back inside it, keeping the hand's shape */
+class ULTRALEAPTRACKING_API FLeapClampFrameProcessor : public ILeapFrameProcessor
+{
+public:
+	virtual void Process(FLeapFrameData& Frame, const float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void SetBounds(const FBox& InBounds)
+	{
+		Bounds = InBounds;
+	}
+
+private:
+	FBox Bounds = FBox(ForceInit);
+};
+
+/** Mirrors left to right (across the XZ plane) and swaps hand types */
+class ULTRALEAPTRACKING_API FLeapMirrorFrameProcessor : public ILeapFrameProcessor
+{
+public:
+	virtual void Process(FLeapFrameData& Frame, const float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+};
+
+/** Scales hands about the tracking origin */
+class ULTRALEAPTRACKING_API FLeapScaleFrameProcessor : public ILeapFrameProcessor
+{
+public:
+	virtual void Process(FLeapFrameData& Frame, const float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void SetScale(const float InScale)
+	{
+		Scale = InScale;
+	}
+
+private:
+	float Scale = 1.0f;
+};
+
+/**
+ * Predicts hands ahead by the measured latency between a tracking frame and it being displayed. Joint velocity and
+ * acceleration and bone angular velocity are estimated over frames. Predicted digits are rebuilt from the wrist out
+ * with their tracked bone lengths and a bend limit between bones, and decelerating joints aren't carried past where
+ * they would stop, so direction changes don't overshoot the way extrapolating the whole frame does.
+ * Prediction error is measured against the tracked hand interpolated to the predicted time
+ */
+class ULTRALEAPTRACKING_API FLeapPredictFrameProcessor : public ILeapFrameProcessor
+{
+public:
+	virtual void Process(FLeapFrameData& Frame, const float DeltaTime) override;
+	virtual void Reset() override;
+	virtual TStatId GetStatId() const override;
+
+	/** Latency of the next frame in seconds, its age when processed and the time until it is displayed */
+	void SetLatency(const float TrackingLatency, const float DisplayLatency);
+
+	/** Scale applied to the measured latency and the furthest ahead to predict in seconds */
+	void SetHorizonLimits(const float InLatencyScale, const float InMaxHorizon);
+
+	/** Largest angle in degrees a predicted bone can bend from the bone before it */
+	void SetJointLimit(const float InJointLimitDegrees)
+	{
+		JointLimit = FMath::DegreesToRadians(FMath::Clamp(InJointLimitDegrees, 0.0f, 180.0f));
+	}
+
+	void GetStats(FLeapStats& OutStats) const;
+
+private:
+	// same joint layout as FLeapOneEuroFilterBank, palm, elbow, wrist then per digit its base and the bone ends
+	static constexpr int32 NumPoints = 3 + 5 * 5;
+	static constexpr int32 NumRotations = 2 + 5 * 4;
+	// palm and finger tips, for measuring prediction error
+	static constexpr int32 NumErrorPoints = 6;
+
+	struct FHandState
+	{
+		int32 HandId = INDEX_NONE;
+		bool bTracked = false;
+		FVector Position[NumPoints];
+		FVector Velocity[NumPoints];
+		FVector Acceleration[NumPoints];
+		FQuat Rotation[NumRotations];
+		FVector AngularVelocity[NumRotations];
+		// frame time of Position in seconds
+		double PositionTime = 0;
+
+		bool bPredictionPending = false;
+		double PredictionTime = 0;
+		FVector PredictedErrorPoints[NumErrorPoints];
+	};
+
+	void Gather(const FLeapHandData& Hand, FVector* OutPoints, FQuat* OutRotations, const FHandState& State) const;
+	void Estimate(FHandState& State, const FVector* Points, const FQuat* Rotations, const float DeltaTime) const;
+	// before Estimate, State still holds the previous frame to interpolate from
+	void MeasureError(FHandState& State, const FVector* Points);
+	void Predict(FLeapHandData& Hand, FHandState& State, const FVector* Points, const FQuat* Rotations);
+
+	FHandState Hands[2];
+	// scratch for the hand being processed
+	FVector MeasuredPoints[NumPoints];
+	FQuat MeasuredRotations[NumRotations];
+	FVector PredictedPoints[NumPoints];
+	FQuat PredictedRotations[NumRotations];
+
+	int64 LastTimeStamp = 0;
+	double FrameTime = 0;
+	float Horizon = 0;
+	float LatencyScale = 1.0f;
+	float MaxHorizon = 0.05f;
+	float JointLimit = PI * 100.0f / 180.0f;
+	float ErrorInMM = 0;
+	bool bHasError = false;
+};
+
+/** Ordered list of processors run on a device's frame */
+class ULTRALEAPTRACKING_API FLeapFrameProcessorChain
+{
+public:
+	void Add(const TSharedPtr<ILeapFrameProcessor>& Processor);
+	bool Remove(const TSharedPtr<ILeapFrameProcessor>& Processor);
+	void Empty();
+
+	int32 Num() const
+	{
+		return Processors.Num();
+	}
+
+	void Process(FLeapFrameData& Frame, const float DeltaTime);
+	void Reset();
+
+private:
+	TArray<TSharedPtr<ILeapFrameProcessor>> Processors;
+};
@@ -26,6 +26,19 @@ public:
 	UPROPERTY(config, EditAnywhere, Category = "Ultraleap Settings")
 	TArray<FString> UltraleapHints;
 
+	/** Publish tracked hands over LiveLink in packaged builds, LiveLink is always available in the editor */
+	UPROPERTY(config, EditAnywhere, Category = "Ultraleap Settings")
+	bool bEnableLiveLinkInPackagedBuilds = false;
+
+	/** Most LiveLink frames published per second regardless of game frame rate, 0 publishes every update */
+	UPROPERTY(config, EditAnywhere, Category = "Ultraleap Settings", meta = (ClampMin = "0"))
+	float LiveLinkMaxPublishRate = 60.0f;
+
+	/** Tracking devices on other machines streaming with bStreamFrames, as host:port for UDP or tcp://host:port.
+	 * Multicast group addresses join the group instead of subscribing */
+	UPROPERTY(config, EditAnywhere, Category = "Ultraleap Settings")
+	TArray<FString> RemoteTrackingDevices;
+
 #if WITH_EDITOR
 	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif
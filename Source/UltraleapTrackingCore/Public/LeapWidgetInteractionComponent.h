@@ -14,7 +14,9 @@
 #include "Engine/StaticMeshActor.h"
 #include "GameFramework/Pawn.h"
 #include "Kismet/GameplayStatics.h"
+#include "LeapClickPredictor.h"
 #include "LeapSubsystem.h"
+#include "LeapWidgetInteractionSubsystem.h"
 #include "Materials/Material.h"
 #include "Materials/MaterialInstanceDynamic.h"
 #include "Engine/World.h"
@@ -42,7 +44,7 @@ public:
 	 * Called every frame to draw the cursor
 	 * @param Hand - hand data from the api
 	 */
-	void DrawLeapCursor(FLeapHandData& Hand);
+	void DrawLeapCursor(const FLeapHandData& Hand);
 	virtual void BeginPlay() override;
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void InitializeComponent() override;
@@ -125,6 +127,49 @@ public:
 	UPROPERTY(BlueprintReadOnly, Category = "UltraLeap UI")
 	float ModeChangeThreshold;
 
+	/** Reuse the last widget hit test while the ray stays within the tolerances below
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "UltraLeap UI Performance")
+	bool bCacheHitTests;
+	/** Ray origin movement in cm that triggers a new hit test
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "UltraLeap UI Performance")
+	float RayPositionTolerance;
+	/** Ray direction change in degrees that triggers a new hit test
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "UltraLeap UI Performance")
+	float RayAngleTolerance;
+	/** Frames a cached hit test is reused for at most, so widget content changes are picked up
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "UltraLeap UI Performance")
+	int32 MaxCachedHitTestFrames;
+	/** Skip the world trace when the ray misses every widget on actors tagged UltraleapUMG
+	 * (or registered with the LeapWidgetInteractionSubsystem). Off by default, widgets on actors that are neither
+	 * can't be hit with it on
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "UltraLeap UI Performance")
+	bool bUseWidgetIndex;
+
+	/** Press when a pinch or poke is predicted to complete rather than after it has, and send the press along the ray
+	 * from when the pinch or poke started so small targets aren't missed as the hand drifts. A press that doesn't
+	 * complete is taken back without clicking
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "UltraLeap UI Prediction")
+	bool bPredictClicks;
+	/** How far ahead in seconds presses are predicted, roughly the tracking latency
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "UltraLeap UI Prediction",
+	 meta = (ClampMin = "0", ClampMax = "0.1", UIMin = "0", UIMax = "0.1"))
+	float ClickPredictionTime;
+	/** Pinch strength change per second that counts as the start of a pinch
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "UltraLeap UI Prediction")
+	float PinchOnsetVelocity;
+	/** Index finger speed towards the widget in cm/s that counts as the start of a poke
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "UltraLeap UI Prediction")
+	float PokeOnsetVelocity;
+
 
 	/** Event on rays visibility changed
 	 */
@@ -134,11 +179,15 @@ public:
 	* @param TmpHand - Hand data 
 	* @param Position - will return the position updated with the relative neck offset
 	 */
-	FVector GetHandRayDirection(FLeapHandData& TmpHand, FVector& Position);
+	FVector GetHandRayDirection(const FLeapHandData& TmpHand, FVector& Position);
 	/** Estimates the relative neck offset
 	 */
 	FVector GetNeckOffset();
 
+protected:
+	/** Hit test with the cached result and widget index, falls back to the engine trace */
+	virtual FWidgetTraceResult PerformTrace() const override;
+
 private:
 	/**
 	 * Used to spawn a mesh at a location
@@ -157,6 +206,22 @@ private:
 	void ScaleUpCursorAndClickButton(const FKey Button = EKeys::LeftMouseButton);
 	void ScaleDownCursorAndUnclickButton(const FKey Button = EKeys::LeftMouseButton);
 
+	/**
+	 * Sends the press, release or cancel a predictor asked for, a press is aimed along the ray from the predicted onset
+	 * @param Prediction - result of the last sample
+	 * @param Predictor - pinch or poke predictor
+	 * @param bPressedState - bIsPinched or bHandTouchWidget
+	 */
+	void ApplyClickPrediction(ELeapClickPrediction Prediction, const FLeapClickPredictor& Predictor, bool& bPressedState);
+	/** Lifts a press that never happened off the widget without it seeing a release, so nothing is clicked */
+	void CancelPredictedPress();
+	/**
+	 * Ends any press from a predictor that is no longer being fed, and resets it
+	 * @param bConfirmed - release the press if true, otherwise cancel it
+	 */
+	void EndPredictedPress(FLeapClickPredictor& Predictor, bool& bPressedState, const bool bConfirmed);
+	void ReleasePredictedClicks();
+
 	/**
 	 * Used to switch between FAR/NEAR modes, depending on the distance of the hand
 	 * from the widget
@@ -197,4 +262,23 @@ private:
 
 	bool bHidden;
 
+	UPROPERTY()
+	ULeapWidgetInteractionSubsystem* WidgetSubsystem;
+
+	// last hit test, PerformTrace is const
+	mutable FWidgetTraceResult CachedTraceResult;
+	mutable FVector CachedTraceStart;
+	mutable FVector CachedTraceDirection;
+	mutable uint32 CachedWidgetsVersion;
+	mutable uint64 CachedTraceFrame;
+	mutable bool bHasCachedTrace;
+
+	FLeapClickPredictor PinchPredictor;
+	FLeapClickPredictor PokePredictor;
+	// time of the tracking frame being processed in seconds
+	double FrameTime;
+	// the pinch events reported a pinch, so a predicted pinch press is real
+	bool bPinchConfirmed;
+	// PerformTrace hits nothing while a cancelled press is lifted
+	bool bBlankTrace;
 };
@@ -0,0 +1,132 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InteractionEngine/GrabBroadphaseSubsystem.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+
+#include "LeapWidgetInteractionSubsystem.generated.h"
+
+class APlayerCameraManager;
+class UWidgetComponent;
+
+/** Hand ray and widget hit test cost over the last frame, summed over all hand rays */
+USTRUCT(BlueprintType)
+struct ULTRALEAPTRACKING_API FLeapWidgetInteractionStats
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Hit tests that went through to a world trace */
+	UPROPERTY(BlueprintReadOnly, Category = "UltraLeap UI")
+	int32 TracesPerformed = 0;
+
+	/** Hit tests answered from the previous result because the ray hadn't moved */
+	UPROPERTY(BlueprintReadOnly, Category = "UltraLeap UI")
+	int32 TracesSkipped = 0;
+
+	/** Hit tests answered by the widget index because the ray missed every widget */
+	UPROPERTY(BlueprintReadOnly, Category = "UltraLeap UI")
+	int32 TracesRejected = 0;
+
+	/** Game thread time spent on hand rays and hit tests */
+	UPROPERTY(BlueprintReadOnly, Category = "UltraLeap UI")
+	float CostInMS = 0;
+};
+
+/** Camera state hand rays are built from, captured once per frame and shared by both hands */
+struct FLeapHandRayFrame
+{
+	FVector CameraLocation = FVector::ZeroVector;
+	FRotator CameraRotation = FRotator::ZeroRotator;
+	FVector CameraForward = FVector::ForwardVector;
+	FVector CameraRight = FVector::RightVector;
+};
+
+/**
+ * Shared state for the hand ray widget interaction components: a per frame camera snapshot and
+ * a spatial index of interactable widget bounds so rays that can't reach a widget skip the world trace.
+ * Widgets on actors tagged "UltraleapUMG" are indexed automatically, others can be registered
+ */
+UCLASS()
+class ULTRALEAPTRACKING_API ULeapWidgetInteractionSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static ULeapWidgetInteractionSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual void Deinitialize() override;
+
+	UFUNCTION(BlueprintCallable, Category = "UltraLeap UI")
+	void RegisterWidget(UWidgetComponent* Widget);
+
+	UFUNCTION(BlueprintCallable, Category = "UltraLeap UI")
+	void UnregisterWidget(UWidgetComponent* Widget);
+
+	/** Index the widgets of every actor tagged UltraleapUMG, including ones spawned later */
+	void RegisterTaggedWidgets();
+
+	/** Camera snapshot for this frame, captured on first use */
+	const FLeapHandRayFrame& GetRayFrame(APlayerCameraManager* PlayerCameraManager);
+
+	/** Refresh moved widget bounds, at most once per frame */
+	void RefreshWidgets();
+
+	/** False if the segment misses every indexed widget */
+	bool MayHitWidget(const FVector& Start, const FVector& End);
+
+	/** Changes whenever an indexed widget moves, is added or removed */
+	uint32 GetWidgetsVersion() const
+	{
+		return WidgetsVersion;
+	}
+
+	void RecordHitTest(const bool bSkipped, const bool bRejected);
+	void RecordCost(const double Seconds);
+
+	UFUNCTION(BlueprintPure, Category = "UltraLeap UI")
+	FLeapWidgetInteractionStats GetStats() const
+	{
+		return LastFrameStats;
+	}
+
+private:
+	void OnActorSpawned(AActor* Actor);
+	void RegisterActorWidgets(AActor* Actor);
+	void BeginStatsFrame();
+
+	FIEGrabBroadphaseGrid Grid;
+	struct FIndexedWidget
+	{
+		TWeakObjectPtr<UWidgetComponent> Widget;
+		// kept so stale entries can still be found in GridIds
+		TObjectKey<UWidgetComponent> Key;
+		bool bUsed = false;
+	};
+
+	void RemoveById(const int32 Id);
+
+	// indexed by grid id
+	TArray<FIndexedWidget> GridWidgets;
+	TMap<TObjectKey<UWidgetComponent>, int32> GridIds;
+	uint32 WidgetsVersion = 0;
+	uint64 LastRefreshFrame = MAX_uint64;
+	TArray<int32> ScratchIds;
+
+	FLeapHandRayFrame RayFrame;
+	uint64 RayFrameNumber = MAX_uint64;
+
+	FLeapWidgetInteractionStats CurrentFrameStats;
+	FLeapWidgetInteractionStats LastFrameStats;
+	uint64 StatsFrame = MAX_uint64;
+
+	FDelegateHandle ActorSpawnedHandle;
+};
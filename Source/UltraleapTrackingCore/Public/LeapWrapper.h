@@ -161,6 +161,15 @@ public:
 	{
 	}
 
+	virtual bool RectilinearToPixel(const int32 CameraIndex, const LEAP_VECTOR& Ray, FVector2D& OutPixel) override
+	{
+		return false;
+	}
+	virtual bool GetCameraToTrackingTransform(const int32 CameraIndex, FMatrix& OutCameraToTracking) override
+	{
+		return false;
+	}
+
  protected:
 	LeapWrapperCallbackInterface* CallbackDelegate = nullptr;
 	UWorld* CurrentWorld = nullptr;
@@ -279,6 +288,16 @@ public:
 	 */
 	virtual void SetDeviceHints(TArray<FString>& Hints, const uint32_t DeviceID = 0) override;
 
+	// the connector isn't a device, each device wrapper projects for itself
+	virtual bool RectilinearToPixel(const int32 CameraIndex, const LEAP_VECTOR& Ray, FVector2D& OutPixel) override
+	{
+		return false;
+	}
+	virtual bool GetCameraToTrackingTransform(const int32 CameraIndex, FMatrix& OutCameraToTracking) override
+	{
+		return false;
+	}
+
 private:
 	void CloseConnectionHandle(LEAP_CONNECTION* ConnectionHandle);
 	void Millisleep(int Milliseconds);
@@ -352,6 +371,8 @@ private:
 	void RemoveDevice(const uint32_t DeviceID);
 
 	void AddOpenXRDevice(LeapWrapperCallbackInterface* InCallbackDelegate);
+	// Address is host:port for UDP or tcp://host:port
+	void AddNetworkDevice(const FString& Address);
 
 	IHandTrackingWrapper* GetSingularDeviceBySerial(const FString& DeviceSerial);
 	LEAP_DEVICE GetDeviceHandleFromDeviceID(const uint32_t DeviceID);
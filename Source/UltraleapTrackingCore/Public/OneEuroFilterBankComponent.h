@@ -0,0 +1,150 @@
+/******************************************************************************
+ * Copyright (C) Ultraleap, Inc. 2011-2024.                                   *
+ *                                                                            *
+ * Use subject to the terms of the Apache License 2.0 available at            *
+ * http://www.apache.org/licenses/LICENSE-2.0, or another agreement           *
+ * between Ultraleap and you, your company or other organization.             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "CoreMinimal.h"
+#include "UltraleapTrackingData.h"
+
+#include "OneEuroFilterBankComponent.generated.h"
+
+/** 1 Euro filter settings for one channel */
+USTRUCT(BlueprintType)
+struct ULTRALEAPTRACKING_API FLeapOneEuroParams
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Cutoff frequency in Hz when still, lower values remove more jitter */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ultraleap Smoothing")
+	float MinCutoff = 1.0f;
+
+	/** Cutoff increase per unit of speed, higher values reduce lag when moving */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ultraleap Smoothing")
+	float CutoffSlope = 0.05f;
+
+	/** Cutoff frequency in Hz used to smooth the speed estimate */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ultraleap Smoothing")
+	float DeltaCutoff = 1.0f;
+};
+
+/**
+ * 1 Euro filter over every joint of both hands. Joint positions (cm) and rotations (quaternion components) are laid
+ * out as contiguous float lanes with per lane parameters and filtered four lanes at a time.
+ *
+ * Joints for per joint parameters: 0 palm, 1 arm, then 2 + Digit * 4 + Bone for the digit bones (thumb first,
+ * metacarpal first), see GetBoneJoint
+ */
+class ULTRALEAPTRACKING_API FLeapOneEuroFilterBank
+{
+public:
+	static constexpr int32 NumJoints = 2 + 5 * 4;
+
+	FLeapOneEuroFilterBank();
+
+	static int32 GetBoneJoint(const int32 Digit, const int32 Bone)
+	{
+		return 2 + Digit * 4 + Bone;
+	}
+
+	void SetJointParams(const int32 Joint, const FLeapOneEuroParams& PositionParams, const FLeapOneEuroParams& RotationParams);
+	void SetAllParams(const FLeapOneEuroParams& PositionParams, const FLeapOneEuroParams& RotationParams);
+
+	/** Time frames apart by their TimeStamp rather than the DeltaTime passed in, follows the tracking rate */
+	void SetUseFrameTimestamps(const bool bInUseFrameTimestamps)
+	{
+		bUseFrameTimestamps = bInUseFrameTimestamps;
+	}
+
+	/** Smooth all hands in the frame in place. New hands (by id) start unfiltered */
+	void Filter(FLeapFrameData& Frame, const float DeltaTime);
+
+	void Reset();
+
+private:
+	static constexpr int32 NumPoints = 3 + 5 * 5;
+	static constexpr int32 NumRotations = NumJoints;
+	static constexpr int32 LanesPerHand = NumPoints * 3 + NumRotations * 4;
+	static constexpr int32 RotationLanes = NumPoints * 3;
+
+	struct FHandSlot
+	{
+		int32 HandId = INDEX_NONE;
+		// filtered last frame
+		bool bTracked = false;
+	};
+
+	void Gather(const FLeapHandData& Hand, float* Lanes, const float* Previous) const;
+	void Scatter(FLeapHandData& Hand, const float* Lanes) const;
+	void SetLaneParams(const int32 Lane, const FLeapOneEuroParams& Params);
+	void FilterLanes(const int32 FirstLane, const float DeltaTime);
+
+	typedef TArray<float, TAlignedHeapAllocator<16>> FLaneArray;
+
+	// one block of LanesPerHand per hand slot, left then right
+	FLaneArray Raw;
+	FLaneArray Previous;
+	FLaneArray PreviousDelta;
+	FLaneArray MinCutoff;
+	FLaneArray CutoffSlope;
+	FLaneArray DeltaCutoff;
+
+	// joint each point lane belongs to
+	int32 PointJoints[NumPoints];
+
+	FHandSlot Slots[2];
+	int64 LastTimeStamp = 0;
+	bool bUseFrameTimestamps = true;
+};
+
+/** Blueprint access to FLeapOneEuroFilterBank, one component smooths both hands instead of a filter per joint */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class ULTRALEAPTRACKING_API UOneEuroFilterBankComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UOneEuroFilterBankComponent();
+
+	virtual void BeginPlay() override;
+
+	/** Default for joint positions, in cm */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ultraleap Smoothing")
+	FLeapOneEuroParams PositionParams;
+
+	/** Default for joint rotations */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ultraleap Smoothing")
+	FLeapOneEuroParams RotationParams;
+
+	/** Use the frame TimeStamp to time samples instead of DeltaTime */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ultraleap Smoothing")
+	bool bUseFrameTimestamps;
+
+	/** Smooth a frame, DeltaTime is only used if timestamps are off or unavailable */
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap Smoothing")
+	void FilterFrame(const FLeapFrameData& InFrame, FLeapFrameData& OutFrame, const float DeltaTime);
+
+	/** Parameters for one joint, 0 palm, 1 arm, see GetBoneJoint for the digit bones */
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap Smoothing")
+	void SetJointParams(const int32 Joint, const FLeapOneEuroParams& InPositionParams, const FLeapOneEuroParams& InRotationParams);
+
+	/** Reset every joint to PositionParams and RotationParams */
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap Smoothing")
+	void SetAllParams(const FLeapOneEuroParams& InPositionParams, const FLeapOneEuroParams& InRotationParams);
+
+	/** Joint index of a digit bone, digits from thumb (0) to pinky (4), bones from metacarpal (0) to distal (3) */
+	UFUNCTION(BlueprintPure, Category = "Ultraleap Smoothing")
+	static int32 GetBoneJoint(const int32 Digit, const int32 Bone);
+
+	/** Forget filter state, the next frame passes through unfiltered */
+	UFUNCTION(BlueprintCallable, Category = "Ultraleap Smoothing")
+	void Reset();
+
+private:
+	FLeapOneEuroFilterBank Bank;
+};
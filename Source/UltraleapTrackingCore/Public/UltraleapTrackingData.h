@@ -46,7 +46,8 @@ enum ELeapTrackingFidelity
 	LEAP_LOW_LATENCY,
 	LEAP_NORMAL,
 	LEAP_SMOOTH,
-	LEAP_WIRELESS
+	LEAP_WIRELESS,
+	LEAP_ADAPTIVE	 // Interpolation offset follows the measured display latency, see AdaptiveLatencyScale
 };
 
 UENUM(BlueprintType)
@@ -75,6 +76,25 @@ enum ELeapMultiDeviceMode
 	LEAP_MULTI_DEVICE_COMBINED
 };
 
+/** What the frame streamer does when consumers can't keep up */
+UENUM(BlueprintType)
+enum class ELeapStreamBackPressure : uint8
+{
+	LEAP_STREAM_LATEST_ONLY,	// Unsent frames are replaced by newer ones, lowest latency
+	LEAP_STREAM_QUEUE			// Frames queue up to a limit before the oldest are dropped, for consumers that want every frame
+};
+
+/** Built in stages a device can run on each tracking frame before it is published */
+UENUM(BlueprintType)
+enum class ELeapFrameProcessor : uint8
+{
+	LEAP_PROCESSOR_FILTER,	  // 1 Euro filter on every joint, uses the smoothing options
+	LEAP_PROCESSOR_CLAMP,	  // Keep palms inside ProcessorClampBounds
+	LEAP_PROCESSOR_MIRROR,	  // Mirror left to right and swap hand types
+	LEAP_PROCESSOR_SCALE,	  // Scale hands by ProcessorScale about the tracking origin
+	LEAP_PROCESSOR_PREDICT	  // Predict hands ahead by the measured tracking and display latency
+};
+
 struct EKeysLeap
 {
 	static const FKey LeapPinchL;
@@ -119,7 +139,9 @@ enum ELeapDeviceCombinerClass
 {
 	LEAP_DEVICE_COMBINER_UNKNOWN,
 	LEAP_DEVICE_COMBINER_CONFIDENCE,
-	LEAP_DEVICE_COMBINER_ANGULAR
+	LEAP_DEVICE_COMBINER_ANGULAR,
+	LEAP_DEVICE_COMBINER_SPATIAL,
+	LEAP_DEVICE_COMBINER_KALMAN
 	// add your custom classes here and add them to the class factory in LeapWrapper
 };
 	USTRUCT(BlueprintType)
@@ -167,6 +189,37 @@ struct ULTRALEAPTRACKING_API FLeapDevice
 	void SetFromLeapDevice(struct _LEAP_DEVICE_INFO* LeapInfo);
 };
 
+/** Read only stats for one of the source devices feeding a combined (multi device) device. */
+USTRUCT(BlueprintType)
+struct ULTRALEAPTRACKING_API FLeapCombinedSourceStats
+{
+	GENERATED_USTRUCT_BODY()
+	FLeapCombinedSourceStats();
+
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	FString DeviceSerial;
+
+	/** How far the source's latest frame was ahead of the common timestamp all sources were resampled to. */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	float TimeSkewInMS;
+
+	/** Tracking frame rate reported (or measured) for the source. */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	float FrameRate;
+
+	/** Frames the source skipped since the combined device was created. */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	int32 DroppedFrames;
+
+	/** Time since the source last produced a new frame. */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	float LastFrameAgeInMS;
+
+	/** 1 when the source is fresh, falling to 0 when it is stale and excluded from the combined hands. */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	float Freshness;
+};
+
 /** Read only stats from the plugin such as version and prediction interval. */
 USTRUCT(BlueprintType)
 struct ULTRALEAPTRACKING_API FLeapStats
@@ -182,6 +235,89 @@ struct ULTRALEAPTRACKING_API FLeapStats
 
 	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
 	float FrameExtrapolationInMS;
+
+	/** Per source stats, only filled in for combined devices */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	TArray<FLeapCombinedSourceStats> CombinedSources;
+
+	/** Image pairs received from the service */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	int32 ImagesReceived;
+
+	/** Image pairs not uploaded because the previous ones were still in flight */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	int32 ImagesDropped;
+
+	/** Image pairs the service skipped, from gaps in the image frame ids */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	int32 ImageFramesMissed;
+
+	/** Image pairs evicted from the image history without being looked up */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	int32 ImagesOverwritten;
+
+	/** UDP subscribers, TCP clients and multicast groups being streamed to */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	int32 StreamSubscribers;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	int32 StreamFramesSent;
+
+	/** Frames not streamed because consumers or the network were behind */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	int32 StreamFramesDropped;
+
+	/** Time from a frame being queued to it being handed to the sockets */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	float StreamLatencyInMS;
+
+	/** How far ahead the predict stage is predicting, 0 when it isn't in Options.FrameProcessors */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	float PredictionHorizonInMS;
+
+	/** Average distance of predicted palm and finger tips from where they were tracked at the predicted time */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	float PredictionErrorInMM;
+
+	/** Estimated time from tracking being sampled to the frame being displayed, from engine frame timing. 0 unless
+	 * adaptive fidelity or the predict stage is using it */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	float DisplayLatencyInMS;
+
+	/** How far ahead of now adaptive fidelity is interpolating, 0 at other fidelities or while predicting */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Stats")
+	float InterpolationOffsetInMS;
+};
+
+/** A raw stereo IR image pair and the tracking frame it was captured with */
+USTRUCT(BlueprintType)
+struct ULTRALEAPTRACKING_API FLeapImagePair
+{
+	GENERATED_USTRUCT_BODY()
+
+	FLeapImagePair();
+
+	/** Device frame of the exposure, matches FLeapFrameData::DeviceFrameId of the hands tracked from it. int64 not supported
+	 * by blueprint, so this will only be accessible inside c++ */
+	UPROPERTY()
+	int64 FrameId;
+
+	// int64 not supported by blueprint, so this will only be accessible inside c++
+	UPROPERTY()
+	int64 TimeStamp;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Image")
+	int32 Width;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Image")
+	int32 Height;
+
+	/** 8 bit greyscale, Width * Height bytes */
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Image")
+	TArray<uint8> Left;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Leap Image")
+	TArray<uint8> Right;
 };
 
 USTRUCT(BlueprintType)
@@ -195,8 +331,8 @@ struct ULTRALEAPTRACKING_API FLeapOptions
 	UPROPERTY(BlueprintReadWrite, Category = "Leap Options")
 	TEnumAsByte<ELeapMode> Mode;
 
-	/** Set your tracking fidelity from low latency to smooth. If not set to custom, some of the low level settings may be
-	 * overwritten */
+	/** Set your tracking fidelity from low latency to smooth, or adaptive to follow the measured display latency. If not
+	 * set to custom, some of the low level settings may be overwritten */
 	UPROPERTY(BlueprintReadWrite, Category = "Leap Options")
 	TEnumAsByte<ELeapTrackingFidelity> TrackingFidelity;
 
@@ -232,6 +368,14 @@ struct ULTRALEAPTRACKING_API FLeapOptions
 	UPROPERTY(BlueprintReadWrite, Category = "Leap Options")
 	float FingerInterpFactor;
 
+	/** With adaptive fidelity, fraction of the estimated display latency to interpolate hands and fingers ahead by */
+	UPROPERTY(BlueprintReadWrite, Category = "Leap Options")
+	float AdaptiveLatencyScale;
+
+	/** With adaptive fidelity, furthest ahead of now to interpolate */
+	UPROPERTY(BlueprintReadWrite, Category = "Leap Options")
+	float AdaptiveMaxLeadInMS;
+
 	/** Fixed offset in leap space for all tracking data. Useful for setting Leap->HMD real world offset */
 	UPROPERTY(BlueprintReadWrite, Category = "Leap Options")
 	FVector HMDPositionOffset;
@@ -269,6 +413,91 @@ struct ULTRALEAPTRACKING_API FLeapOptions
 
 	UPROPERTY(BlueprintReadWrite, Category = "Leap Options")
 	TArray<FString> LeapHints;
+
+	/** Undistort IR images using the device calibration before they are published to OnImageEvent */
+	UPROPERTY(BlueprintReadWrite, Category = "Image Options")
+	bool bRectifyImages;
+
+	/** Number of raw image pairs kept for lookup by device frame id (FLeapFrameData::DeviceFrameId), 0 disables the history */
+	UPROPERTY(BlueprintReadWrite, Category = "Image Options")
+	int32 ImageHistorySize;
+
+	/** Box filter images down by 1, 2 or 4 before upload, e.g. for picture in picture display */
+	UPROPERTY(BlueprintReadWrite, Category = "Image Options")
+	int32 ImageDownsampleFactor;
+
+	/** Only publish a region of each image centred on the tracked hands */
+	UPROPERTY(BlueprintReadWrite, Category = "Image Options")
+	bool bImageHandRegionOfInterest;
+
+	/** Size in source pixels of the hand region of interest */
+	UPROPERTY(BlueprintReadWrite, Category = "Image Options")
+	int32 ImageRegionOfInterestSize;
+
+	/** Stream tracking frames to external applications, see LeapFrameStreamer.h for the packet format */
+	UPROPERTY(BlueprintReadWrite, Category = "Streaming Options")
+	bool bStreamFrames;
+
+	/** UDP port consumers subscribe on, also the TCP port if enabled */
+	UPROPERTY(BlueprintReadWrite, Category = "Streaming Options")
+	int32 StreamPort;
+
+	/** Also accept TCP connections, for consumers that can't tolerate loss */
+	UPROPERTY(BlueprintReadWrite, Category = "Streaming Options")
+	bool bStreamOverTCP;
+
+	/** Optional multicast group address, e.g. 239.0.0.1 */
+	UPROPERTY(BlueprintReadWrite, Category = "Streaming Options")
+	FString StreamMulticastGroup;
+
+	/** Frames per second streamed at most, 0 streams every frame */
+	UPROPERTY(BlueprintReadWrite, Category = "Streaming Options")
+	float StreamMaxRate;
+
+	UPROPERTY(BlueprintReadWrite, Category = "Streaming Options")
+	ELeapStreamBackPressure StreamBackPressure;
+
+	/** Smooth every joint of both hands with a 1 Euro filter before tracking data is sent out. Adds the filter stage
+	 * in front of FrameProcessors if it isn't listed there */
+	UPROPERTY(BlueprintReadWrite, Category = "Smoothing Options")
+	bool bSmoothHands;
+
+	/** Cutoff frequency in Hz when the hand is still, lower values remove more jitter */
+	UPROPERTY(BlueprintReadWrite, Category = "Smoothing Options")
+	float HandSmoothingMinCutoff;
+
+	/** Cutoff increase per cm/s of joint speed, higher values reduce lag when moving */
+	UPROPERTY(BlueprintReadWrite, Category = "Smoothing Options")
+	float HandSmoothingCutoffSlope;
+
+	/** Cutoff increase per unit/s of joint rotation change */
+	UPROPERTY(BlueprintReadWrite, Category = "Smoothing Options")
+	float HandSmoothingRotationCutoffSlope;
+
+	/** Stages run in order on each tracking frame, once per device, before it reaches any listener */
+	UPROPERTY(BlueprintReadWrite, Category = "Processing Options")
+	TArray<ELeapFrameProcessor> FrameProcessors;
+
+	/** Palm positions are kept inside this box by the clamp stage, in cm in tracking space */
+	UPROPERTY(BlueprintReadWrite, Category = "Processing Options")
+	FBox ProcessorClampBounds;
+
+	/** Scale applied by the scale stage */
+	UPROPERTY(BlueprintReadWrite, Category = "Processing Options")
+	float ProcessorScale;
+
+	/** Multiplier on the measured latency the predict stage predicts ahead by. HandInterpFactor and
+	 * FingerInterpFactor are set to 0 while predicting so the frame isn't extrapolated twice */
+	UPROPERTY(BlueprintReadWrite, Category = "Processing Options")
+	float PredictionLatencyScale;
+
+	/** Furthest ahead the predict stage predicts */
+	UPROPERTY(BlueprintReadWrite, Category = "Processing Options")
+	float MaxPredictionInMS;
+
+	/** Largest angle in degrees a predicted finger bone can bend from the bone before it */
+	UPROPERTY(BlueprintReadWrite, Category = "Processing Options")
+	float PredictionJointLimit;
 };
 
 USTRUCT(BlueprintType)
@@ -447,6 +676,11 @@ struct ULTRALEAPTRACKING_API FLeapFrameData
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ultraleap Tracking Data")
 	int32 FrameId;
 
+	// Device frame the newest tracking frame came from, the key for the image history. FrameId counts tracking frames,
+	// which the images don't carry
+	UPROPERTY()
+	int64 DeviceFrameId;
+
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ultraleap Tracking Data")
 	bool LeftHandVisible;
 
@@ -457,6 +691,11 @@ struct ULTRALEAPTRACKING_API FLeapFrameData
 	UPROPERTY()
 	int64 TimeStamp;
 
+	// Timestamp of the newest tracking frame the data came from. With interpolation TimeStamp is the time the hands
+	// were interpolated to, which moves on every tick whether or not the device sent a new frame
+	UPROPERTY()
+	int64 TrackingTimeStamp;
+
 	UPROPERTY()
 	FRotator FinalRotationAdjustment;
 
@@ -511,4 +750,47 @@ struct ULTRALEAPTRACKING_API FAnalytics
 
 	UPROPERTY()
 	FTelemetry telemetry;
-};
\ No newline at end of file
+};
+/** Solved device to world transform for a single tracking device, persisted between sessions keyed by serial */
+USTRUCT()
+struct ULTRALEAPTRACKING_API FLeapDeviceExtrinsics
+{
+	GENERATED_BODY()
+
+	FLeapDeviceExtrinsics();
+
+	UPROPERTY()
+	FString DeviceSerial;
+
+	/** Serial of the device this one was aligned against */
+	UPROPERTY()
+	FString ReferenceDeviceSerial;
+
+	/** Device origin in UE space, as passed to ULeapComponent::UpdateDeviceOrigin */
+	UPROPERTY()
+	FTransform DeviceOrigin;
+
+	/** Mean joint distance in cm between the two devices' hands when alignment completed */
+	UPROPERTY()
+	float Residual;
+
+	/** Number of joint correspondences the residual was measured over */
+	UPROPERTY()
+	int32 NumSamples;
+
+	/** UTC time of calibration in ISO 8601 */
+	UPROPERTY()
+	FString CalibrationTime;
+};
+
+USTRUCT()
+struct ULTRALEAPTRACKING_API FLeapDeviceExtrinsicsFile
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Version = 0;
+
+	UPROPERTY()
+	TArray<FLeapDeviceExtrinsics> Devices;
+};
@@ -145,6 +145,8 @@ namespace UnrealBuildTool.Rules
 					"Niagara",
 					"NiagaraShader",
 					"NavigationSystem",
+					"Sockets",
+					"Networking",
 					// ... add private dependencies that you statically link with here ...
                 }
 				);